@@ -43,6 +43,7 @@
 #include "stir/CartesianCoordinate3D.h"
 #include "stir/VoxelsOnCartesianGrid.h"
 #include "stir/ProjDataFromStream.h"
+#include "stir/ProjDataMemoryMapped.h"
 #include "stir/ProjDataInfoCylindricalArcCorr.h"
 #include "stir/Scanner.h"
 #include "stir/Succeeded.h"
@@ -545,10 +546,47 @@ write_basic_interfile(const string& filename,
 }
 
 
+//! construct a ProjDataFromStream (or ProjDataMemoryMapped) for the data file
+static ProjDataFromStream*
+create_PDFS(shared_ptr<ExamInfo> const& exam_info_sptr,
+            shared_ptr<ProjDataInfo> const& proj_data_info_sptr,
+            const char * const full_data_file_name,
+            const ios::openmode open_mode,
+            const bool memory_mapped,
+            const std::streamoff offset_in_file,
+            const vector<int>& segment_sequence,
+            const ProjDataFromStream::StorageOrder storage_order,
+            const NumericType data_type,
+            const ByteOrder byte_order,
+            const float scale_factor)
+{
+  if (memory_mapped)
+    return new ProjDataMemoryMapped(exam_info_sptr, proj_data_info_sptr,
+                                    full_data_file_name, open_mode,
+                                    offset_in_file, segment_sequence,
+                                    storage_order, data_type, byte_order, scale_factor);
+
+  shared_ptr<iostream> data_in(new fstream (full_data_file_name, open_mode | ios::binary));
+  if (!data_in->good())
+    {
+      warning("interfile parsing: error opening file %s",full_data_file_name);
+      return 0;
+    }
+
+  ProjDataFromStream * const proj_data_ptr =
+    new ProjDataFromStream(exam_info_sptr, proj_data_info_sptr,
+                           data_in, offset_in_file, segment_sequence,
+                           storage_order, data_type, byte_order, scale_factor);
+  if (open_mode & ios::in)
+    proj_data_ptr->set_file_for_positional_reads(full_data_file_name);
+  return proj_data_ptr;
+}
+
 static ProjDataFromStream* 
 read_interfile_PDFS_SPECT(istream& input,
 		    const string& directory_for_data,
-		    const ios::openmode open_mode)
+		    const ios::openmode open_mode,
+		    const bool memory_mapped)
 {
   
   InterfilePDFSHeaderSPECT hdr;  
@@ -572,31 +610,25 @@ read_interfile_PDFS_SPECT(istream& input,
   
   assert(!is_null_ptr(hdr.data_info_sptr));
 
-   shared_ptr<iostream> data_in(new fstream (full_data_file_name, open_mode | ios::binary));
-   if (!data_in->good())
-     {
-       warning("interfile parsing: error opening file %s",full_data_file_name);
-       return 0;
-     }
-
-   return new ProjDataFromStream(hdr.get_exam_info_sptr(), 
-				 hdr.data_info_sptr,
-				 data_in,
-				 hdr.data_offset_each_dataset[0],
-				 segment_sequence,
-				 hdr.storage_order,
-				 hdr.type_of_numbers,
-				 hdr.file_byte_order,
-				 static_cast<float>(hdr.image_scaling_factors[0][0]));
+   return create_PDFS(hdr.get_exam_info_sptr(),
+                      hdr.data_info_sptr,
+                      full_data_file_name, open_mode, memory_mapped,
+                      hdr.data_offset_each_dataset[0],
+                      segment_sequence,
+                      hdr.storage_order,
+                      hdr.type_of_numbers,
+                      hdr.file_byte_order,
+                      static_cast<float>(hdr.image_scaling_factors[0][0]));
 
 
 }
 
 
-ProjDataFromStream*
+static ProjDataFromStream*
 read_interfile_PDFS_Siemens(istream& input,
   const string& directory_for_data,
-  const ios::openmode open_mode)
+  const ios::openmode open_mode,
+  const bool memory_mapped)
 {
   InterfilePDFSHeaderSiemens hdr;
   if (!hdr.parse(input))
@@ -611,32 +643,26 @@ read_interfile_PDFS_Siemens(istream& input,
   strcpy(full_data_file_name, hdr.data_file_name.c_str());
   prepend_directory_name(full_data_file_name, directory_for_data.c_str());
 
-  shared_ptr<iostream> data_in(new fstream(full_data_file_name, open_mode | ios::binary));
-  if (!data_in->good())
-    {
-    warning("interfile parsing: error opening file %s", full_data_file_name);
-    return 0;
-    }
-
   if (hdr.compression)
     warning("Siemens projection data is compressed. Reading of raw data will fail.");
 
-  return new ProjDataFromStream(hdr.get_exam_info_sptr(),
+  return create_PDFS(hdr.get_exam_info_sptr(),
     hdr.data_info_ptr->create_shared_clone(),
-    data_in,
+    full_data_file_name, open_mode, memory_mapped,
     hdr.data_offset_each_dataset[0],
     hdr.segment_sequence,
     hdr.storage_order,
     hdr.type_of_numbers,
     hdr.file_byte_order,
-    1.);
+    1.F);
 
 }
 
 ProjDataFromStream* 
 read_interfile_PDFS(istream& input,
 		    const string& directory_for_data,
-		    const ios::openmode open_mode)
+		    const ios::openmode open_mode,
+		    const bool memory_mapped)
 {
   
   {
@@ -653,12 +679,12 @@ read_interfile_PDFS(istream& input,
       {
         // spect data
         input.seekg(offset);
-        return read_interfile_PDFS_SPECT(input, directory_for_data, open_mode); 
+        return read_interfile_PDFS_SPECT(input, directory_for_data, open_mode, memory_mapped); 
       }
 	  if (!hdr.siemens_mi_version.empty())
       {
 		     input.seekg(offset);
-         return read_interfile_PDFS_Siemens(input, directory_for_data, open_mode);
+         return read_interfile_PDFS_Siemens(input, directory_for_data, open_mode, memory_mapped);
       }
 	}
     
@@ -688,22 +714,15 @@ read_interfile_PDFS(istream& input,
   
    assert(hdr.data_info_ptr !=0);
 
-   shared_ptr<iostream> data_in(new fstream (full_data_file_name, open_mode | ios::binary));
-   if (!data_in->good())
-     {
-       warning("interfile parsing: error opening file %s",full_data_file_name);
-       return 0;
-     }
-
-   return new ProjDataFromStream(hdr.get_exam_info_sptr(),
-				 hdr.data_info_ptr->create_shared_clone(),
-				 data_in,
-				 hdr.data_offset_each_dataset[0],
-				 hdr.segment_sequence,
-				 hdr.storage_order,
-				 hdr.type_of_numbers,
-				 hdr.file_byte_order,
-				 static_cast<float>(hdr.image_scaling_factors[0][0]));
+   return create_PDFS(hdr.get_exam_info_sptr(),
+                      hdr.data_info_ptr->create_shared_clone(),
+                      full_data_file_name, open_mode, memory_mapped,
+                      hdr.data_offset_each_dataset[0],
+                      hdr.segment_sequence,
+                      hdr.storage_order,
+                      hdr.type_of_numbers,
+                      hdr.file_byte_order,
+                      static_cast<float>(hdr.image_scaling_factors[0][0]));
 
 
 }
@@ -711,7 +730,8 @@ read_interfile_PDFS(istream& input,
 
 ProjDataFromStream*
 read_interfile_PDFS(const string& filename,
-		    const ios::openmode open_mode)
+		    const ios::openmode open_mode,
+		    const bool memory_mapped)
 {
   ifstream image_stream(filename.c_str());
   if (!image_stream)
@@ -722,7 +742,7 @@ read_interfile_PDFS(const string& filename,
   char directory_name[max_filename_length];
   get_directory_name(directory_name, filename.c_str());
   
-  return read_interfile_PDFS(image_stream, directory_name, open_mode);
+  return read_interfile_PDFS(image_stream, directory_name, open_mode, memory_mapped);
 }
 
 
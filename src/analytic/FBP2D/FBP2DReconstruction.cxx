@@ -31,9 +31,11 @@
 #include "stir/VoxelsOnCartesianGrid.h"
 #include "stir/RelatedViewgrams.h"
 #include "stir/recon_buildblock/BackProjectorByBinUsingInterpolation.h"
+#include "stir/recon_buildblock/ImageAccumulationBuffers.h"
 #include "stir/ProjDataInfoCylindricalArcCorr.h"
 #include "stir/ArcCorrection.h"
 #include "stir/analytic/FBP2D/RampFilter.h"
+#include "stir/numerics/FourierTransformPlan.h"
 #include "stir/SSRB.h"
 #include "stir/ProjDataInMemory.h"
 // #include "stir/ProjDataInterfile.h"
@@ -66,6 +68,8 @@ set_defaults()
   pad_in_s=1;
   display_level=0; // no display
   num_segments_to_combine = -1;
+  max_memory_for_accumulation_buffers_in_MB =
+    static_cast<int>(ImageAccumulationBuffers::default_max_memory_in_MB);
   back_projector_sptr.reset(new BackProjectorByBinUsingInterpolation(
 								     /*use_piecewise_linear_interpolation = */true, 
 								     /*use_exact_Jacobian = */ false));
@@ -84,6 +88,8 @@ FBP2DReconstruction::initialise_keymap()
   parser.add_key("Cut-off for Ramp filter (in cycles)",&fc_ramp);
   parser.add_key("Transaxial extension for FFT", &pad_in_s);
   parser.add_key("Display level",&display_level);
+  parser.add_key("maximum memory for back projection buffers (MB)",
+                 &max_memory_for_accumulation_buffers_in_MB);
 
   parser.add_parsing_key("Back projector type", &back_projector_sptr);
 }
@@ -141,6 +147,13 @@ bool FBP2DReconstruction::post_processing_only_FBP2D_parameters()
       warning("Transaxial extension for FFT:=0 should ONLY be used when the non-zero data\n"
 	      "occupy only half of the FOV. Otherwise aliasing will occur!");
 
+  if (max_memory_for_accumulation_buffers_in_MB<0)
+    {
+      warning("maximum memory for back projection buffers (MB) has to be non-negative, but is %d\n",
+              max_memory_for_accumulation_buffers_in_MB);
+      return true;
+    }
+
   if (num_segments_to_combine>=0 && num_segments_to_combine%2==0)
     {
       warning("num_segments_to_combine has to be odd (or -1), but is %d\n", num_segments_to_combine);
@@ -296,8 +309,14 @@ actual_reconstruct(shared_ptr<DiscretisedDensity<3,float> > const & density_ptr)
 
 
   // set ramp filter with appropriate sizes
+#ifdef NRFFT
   const int fft_size = 
     round(pow(2., ceil(log((double)(pad_in_s + 1)* arc_corrected_proj_data_info_sptr->get_num_tangential_poss()) / log(2.))));
+#else
+  // no need to go to a power of 2, just use a length for which the DFT is efficient
+  const int fft_size = 
+    find_efficient_fourier_length((pad_in_s + 1)* arc_corrected_proj_data_info_sptr->get_num_tangential_poss());
+#endif
   
   RampFilter filter(tangential_sampling,
                     fft_size, 
@@ -310,16 +329,17 @@ actual_reconstruct(shared_ptr<DiscretisedDensity<3,float> > const & density_ptr)
     symmetries_sptr(back_projector_sptr->get_symmetries_used()->clone());
     
   set_num_threads();
+  // threads add to a limited number of images, such that memory use does not grow with the number of threads
+  ImageAccumulationBuffers
+    buffers(*density_ptr,
+            ImageAccumulationBuffers::
+              get_default_num_buffers(*density_ptr,
+                                      static_cast<std::size_t>(max_memory_for_accumulation_buffers_in_MB)));
 #ifdef STIR_OPENMP
-  std::vector< shared_ptr<DiscretisedDensity<3,float> > > local_output_image_sptrs;
-#pragma omp parallel shared(symmetries_sptr, local_output_image_sptrs)
+#pragma omp parallel shared(symmetries_sptr, buffers)
 #endif
   {
 #ifdef STIR_OPENMP
-#pragma omp single
-    {
-      local_output_image_sptrs.resize(omp_get_num_threads(), shared_ptr<DiscretisedDensity<3,float> >());
-    }
 #pragma omp for schedule(runtime)  
 #endif
     for (int view_num=proj_data_ptr->get_min_view_num(); view_num <= proj_data_ptr->get_max_view_num(); ++view_num) 
@@ -365,26 +385,14 @@ actual_reconstruct(shared_ptr<DiscretisedDensity<3,float> > const & density_ptr)
         if(display_level>1) 
           display( viewgrams,viewgrams.find_max(),"Ramp filter");
 
-#ifdef STIR_OPENMP 
-        const int thread_num=omp_get_thread_num();
-        if(is_null_ptr(local_output_image_sptrs[thread_num]))
-          local_output_image_sptrs[thread_num].reset(density_ptr->get_empty_copy());
-
-        back_projector_sptr->back_project(*(local_output_image_sptrs[thread_num]), viewgrams);	  
-#else
         //  and backproject
-        back_projector_sptr->back_project(*density_ptr, viewgrams);
-#endif
+        const int buffer_num = buffers.acquire();
+        back_projector_sptr->back_project(buffers.get_buffer(buffer_num), viewgrams);	  
+        buffers.release(buffer_num);
       } 
   } // end of OPENMP pragma
-#ifdef STIR_OPENMP
   // "reduce" data constructed by threads
-  {
-    for (int i=0; i<static_cast<int>(local_output_image_sptrs.size()); ++i)
-      if(!is_null_ptr(local_output_image_sptrs[i])) // only accumulate if a thread filled something in
-        *density_ptr += *(local_output_image_sptrs[i]);
-  }
-#endif
+  buffers.accumulate();
  
   // Normalise the image
   const ProjDataInfoCylindrical& proj_data_info_cyl =
@@ -87,6 +87,7 @@
 #include "stir/Succeeded.h"
 
 #include "stir/analytic/FBP3DRP/ColsherFilter.h" 
+#include "stir/numerics/FourierTransformPlan.h"
 #include "stir/display.h"
 //#include "stir/recon_buildblock/distributable.h"
 //#include "stir/FBP3DRP/process_viewgrams.h"
@@ -874,8 +875,14 @@ void FBP3DRPReconstruction::do_colsher_filter_view( RelatedViewgrams<float> & vi
     const int nrings = viewgrams.get_num_axial_poss(); 
     const int nprojs = viewgrams.get_num_tangential_poss();
     
+#ifdef NRFFT
     const int width = (int) pow(2., ((int) ceil(log((PadS + 1.) * nprojs) / log(2.))));
     const int height = (int) pow(2., ((int) ceil(log((PadZ + 1.) * nrings) / log(2.))));	
+#else
+    // no need to go to a power of 2, just use sizes for which the DFT is efficient
+    const int width = find_efficient_fourier_length((PadS + 1) * nprojs);
+    const int height = find_efficient_fourier_length((PadZ + 1) * nrings);
+#endif
     
     
     const float theta_max = atan(viewgrams.get_proj_data_info_ptr()->get_tantheta(Bin(max_segment_num_to_process,0,0,0)));
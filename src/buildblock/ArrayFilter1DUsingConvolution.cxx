@@ -66,6 +66,22 @@ is_trivial() const
      filter_coefficients[0] == 1);
 }
 
+template <typename elemT>
+const VectorWithOffset<elemT>&
+ArrayFilter1DUsingConvolution<elemT>::
+get_filter_coefficients() const
+{
+  return filter_coefficients;
+}
+
+template <typename elemT>
+BoundaryConditions::BC
+ArrayFilter1DUsingConvolution<elemT>::
+get_boundary_condition() const
+{
+  return _bc;
+}
+
 
 template <typename elemT>
 Succeeded 
@@ -58,6 +58,14 @@ is_trivial() const
      filter_coefficients[0] == 1);
 }
 
+template <typename elemT>
+const VectorWithOffset<elemT>&
+ArrayFilter1DUsingConvolutionSymmetricKernel<elemT>::
+get_filter_coefficients() const
+{
+  return filter_coefficients;
+}
+
 // TODO generalise to arbitrary index ranges
 template <typename elemT>
 void
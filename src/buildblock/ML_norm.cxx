@@ -28,9 +28,13 @@
 #include "stir/ML_norm.h"
 #include "stir/display.h"
 #include "stir/SegmentBySinogram.h"
+#include "stir/Scanner.h"
+#include "stir/IndexRange2D.h"
+#include "stir/unique_ptr.h"
 #include "stir/stream.h"
 
 #include <algorithm>
+#include <vector>
 using std::min;
 using std::max;
 
@@ -764,15 +768,21 @@ void make_fan_data(FanProjData& fan_data,
   fan_data = FanProjData(num_rings, num_detectors_per_ring, max_delta, 2*half_fan_size+1);
 
   shared_ptr<SegmentBySinogram<float> > segment_ptr;      
-  Bin bin;
 
-  for (bin.segment_num() = proj_data.get_min_segment_num(); bin.segment_num() <= proj_data.get_max_segment_num();  ++ bin.segment_num())
+  // we read one segment at a time to keep memory usage low
+  for (int segment_num = proj_data.get_min_segment_num(); segment_num <= proj_data.get_max_segment_num();  ++segment_num)
   {
-    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(bin.segment_num())));
+    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(segment_num)));
     
-    for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
-	 bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
-	 ++bin.axial_pos_num())
+    // every bin corresponds to a different detector pair, so different threads write to different elements
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int axial_pos_num = proj_data.get_min_axial_pos_num(segment_num);
+	 axial_pos_num <= proj_data.get_max_axial_pos_num(segment_num);
+	 ++axial_pos_num)
+    {
+       Bin bin(segment_num, 0, axial_pos_num, 0);
        for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
           for (bin.tangential_pos_num() = -half_fan_size;
 	       bin.tangential_pos_num() <= half_fan_size;
@@ -787,6 +797,7 @@ void make_fan_data(FanProjData& fan_data,
 	      fan_data(rb, b, ra, a) =
               (*segment_ptr)[bin.axial_pos_num()][bin.view_num()][bin.tangential_pos_num()];
           }
+    }
   }
 }
 
@@ -806,16 +817,20 @@ void set_fan_data(ProjData& proj_data,
   assert(num_detectors_per_ring == fan_data.get_num_detectors_per_ring());
 
     
-  Bin bin;
   shared_ptr<SegmentBySinogram<float> > segment_ptr;    
  
-  for (bin.segment_num() = proj_data.get_min_segment_num(); bin.segment_num() <= proj_data.get_max_segment_num();  ++ bin.segment_num())
+  for (int segment_num = proj_data.get_min_segment_num(); segment_num <= proj_data.get_max_segment_num();  ++segment_num)
   {
-    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_empty_segment_by_sinogram(bin.segment_num())));
+    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_empty_segment_by_sinogram(segment_num)));
     
-    for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
-	 bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
-	 ++bin.axial_pos_num())
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int axial_pos_num = proj_data.get_min_axial_pos_num(segment_num);
+	 axial_pos_num <= proj_data.get_max_axial_pos_num(segment_num);
+	 ++axial_pos_num)
+    {
+       Bin bin(segment_num, 0, axial_pos_num, 0);
        for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
           for (bin.tangential_pos_num() = -half_fan_size;
 	       bin.tangential_pos_num() <= half_fan_size;
@@ -829,11 +844,112 @@ void set_fan_data(ProjData& proj_data,
             (*segment_ptr)[bin.axial_pos_num()][bin.view_num()][bin.tangential_pos_num()] =
               fan_data(ra, a, rb, b);
           }
+    }
     proj_data.set_segment(*segment_ptr);
   }
 }
 
 
+void set_randoms_from_efficiencies(ProjData& proj_data,
+                                   const DetectorEfficiencies& efficiencies)
+{
+  const ProjDataInfoCylindricalNoArcCorr * const proj_data_info_ptr = 
+    dynamic_cast<const ProjDataInfoCylindricalNoArcCorr * const>
+    (proj_data.get_proj_data_info_ptr());
+  if (proj_data_info_ptr == 0)
+    error("set_randoms_from_efficiencies: Can only process not arc-corrected data\n");
+  if (proj_data.get_min_view_num()!=0)
+    error("set_randoms_from_efficiencies: Can only handle min_view_num==0\n");
+
+  const int num_detectors_per_ring = 
+    proj_data_info_ptr->get_scanner_ptr()->get_num_detectors_per_ring();
+  const int mashing_factor = proj_data_info_ptr->get_view_mashing_factor();
+  const int min_tangential_pos_num = proj_data_info_ptr->get_min_tangential_pos_num();
+  const int max_tangential_pos_num = proj_data_info_ptr->get_max_tangential_pos_num();
+  const int max_uncompressed_view_num = (proj_data.get_max_view_num()+1)*mashing_factor - 1;
+
+  // find detector numbers for every uncompressed view and tangential position
+  Array<2,int> det1_nums(IndexRange2D(0, max_uncompressed_view_num,
+                                      min_tangential_pos_num, max_tangential_pos_num));
+  Array<2,int> det2_nums(det1_nums.get_index_range());
+  {
+    shared_ptr<Scanner> scanner_sptr(new Scanner(*proj_data_info_ptr->get_scanner_ptr()));
+    // detector numbers do not depend on the segment, so we use only segment 0
+    unique_ptr<ProjDataInfo> uncompressed_proj_data_info_uptr
+      (ProjDataInfo::construct_proj_data_info(scanner_sptr,
+                                              /*span=*/1, /*max_delta=*/0,
+                                              /*num_views=*/num_detectors_per_ring / 2,
+                                              scanner_sptr->get_max_num_non_arccorrected_bins(),
+                                              /*arccorrection=*/false));
+    const ProjDataInfoCylindricalNoArcCorr& uncompressed_proj_data_info =
+      dynamic_cast<const ProjDataInfoCylindricalNoArcCorr&>(*uncompressed_proj_data_info_uptr);
+    for (int view_num = 0; view_num <= max_uncompressed_view_num; ++view_num)
+      for (int tangential_pos_num = min_tangential_pos_num;
+           tangential_pos_num <= max_tangential_pos_num;
+           ++tangential_pos_num)
+        {
+          int det1_num = 0, det2_num = 0;
+          uncompressed_proj_data_info.
+            get_det_num_pair_for_view_tangential_pos_num(det1_num, det2_num,
+                                                         view_num, tangential_pos_num);
+          det1_nums[view_num][tangential_pos_num] = det1_num;
+          det2_nums[view_num][tangential_pos_num] = det2_num % num_detectors_per_ring;
+        }
+  }
+
+  for (int segment_num = proj_data.get_min_segment_num(); 
+       segment_num <= proj_data.get_max_segment_num();
+       ++segment_num)
+    {
+      SegmentBySinogram<float> segment =
+        proj_data_info_ptr->get_empty_segment_by_sinogram(segment_num);
+      const int min_axial_pos_num = segment.get_min_axial_pos_num();
+      const int max_axial_pos_num = segment.get_max_axial_pos_num();
+
+      // find all ring pairs first, as this function is not thread-safe
+      std::vector<ProjDataInfoCylindrical::RingNumPairs>
+        ring_pairs(max_axial_pos_num - min_axial_pos_num + 1);
+      for (int axial_pos_num = min_axial_pos_num; axial_pos_num <= max_axial_pos_num; ++axial_pos_num)
+        ring_pairs[axial_pos_num - min_axial_pos_num] =
+          proj_data_info_ptr->get_all_ring_pairs_for_segment_axial_pos_num(segment_num, axial_pos_num);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int axial_pos_num = min_axial_pos_num; axial_pos_num <= max_axial_pos_num; ++axial_pos_num)
+        {
+          const ProjDataInfoCylindrical::RingNumPairs& ring_pairs_for_sinogram =
+            ring_pairs[axial_pos_num - min_axial_pos_num];
+          Array<2,float>& sinogram = segment[axial_pos_num];
+          for (int view_num = sinogram.get_min_index(); view_num <= sinogram.get_max_index(); ++view_num)
+            {
+              Array<1,float>& sinogram_row = sinogram[view_num];
+              for (int uncompressed_view_num = view_num*mashing_factor;
+                   uncompressed_view_num < (view_num+1)*mashing_factor;
+                   ++uncompressed_view_num)
+                {
+                  const Array<1,int>& det1_nums_row = det1_nums[uncompressed_view_num];
+                  const Array<1,int>& det2_nums_row = det2_nums[uncompressed_view_num];
+                  for (ProjDataInfoCylindrical::RingNumPairs::const_iterator rings_iter = ring_pairs_for_sinogram.begin();
+                       rings_iter != ring_pairs_for_sinogram.end();
+                       ++rings_iter)
+                    {
+                      const Array<1,float>& efficiencies_ring1 = efficiencies[rings_iter->first];
+                      const Array<1,float>& efficiencies_ring2 = efficiencies[rings_iter->second];
+                      for (int tangential_pos_num = min_tangential_pos_num;
+                           tangential_pos_num <= max_tangential_pos_num;
+                           ++tangential_pos_num)
+                        sinogram_row[tangential_pos_num] +=
+                          efficiencies_ring1[det1_nums_row[tangential_pos_num]] *
+                          efficiencies_ring2[det2_nums_row[tangential_pos_num]];
+                    }
+                }
+            }
+        }
+      proj_data.set_segment(segment);
+    }
+}
+
 void apply_block_norm(FanProjData& fan_data, const BlockData3D& block_data, const bool apply)
 {
   const int num_axial_detectors = fan_data.get_num_rings();
@@ -845,6 +961,10 @@ void apply_block_norm(FanProjData& fan_data, const BlockData3D& block_data, cons
   const int num_tangential_crystals_per_block = num_tangential_detectors/num_tangential_blocks;
   assert(num_tangential_blocks * num_tangential_crystals_per_block == num_tangential_detectors);
   
+  // all elements with ring ra and rb>=ra are stored in fan_data[ra], so we can parallelise over ra
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
@@ -898,6 +1018,10 @@ void apply_geo_norm(FanProjData& fan_data, const GeoData& geo_data, const bool a
 void apply_efficiencies(FanProjData& fan_data, const DetectorEfficiencies& efficiencies, const bool apply)
 {
   const int num_detectors_per_ring = fan_data.get_num_detectors_per_ring();
+  // all elements with ring ra and rb>=ra are stored in fan_data[ra], so we can parallelise over ra
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
@@ -917,6 +1041,9 @@ void apply_efficiencies(FanProjData& fan_data, const DetectorEfficiencies& effic
 
 void make_fan_sum_data(Array<2,float>& data_fan_sums, const FanProjData& fan_data)
 {
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       data_fan_sums[ra][a] = fan_data.sum(ra,a);
@@ -972,6 +1099,9 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
   const int num_detectors_per_ring = 
     data_fan_sums[0].get_length();
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = data_fan_sums.get_min_index(); ra <= data_fan_sums.get_max_index(); ++ra)
     for (int a = data_fan_sums[ra].get_min_index(); a <= data_fan_sums[ra].get_max_index(); ++a)
       {
@@ -996,18 +1126,28 @@ void make_block_data(BlockData3D& block_data, const FanProjData& fan_data)
   assert(num_transaxial_blocks * num_transaxial_crystals_per_block == num_transaxial_detectors);
   
   block_data.fill(0);
-  for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
+  // As rb>=ra, all contributions from the rings in one axial block go to block_data[axial_block_num].
+  // We therefore parallelise over axial blocks, such that different threads add to different elements.
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int axial_block_num = 0; axial_block_num < num_axial_blocks; ++axial_block_num)
+  for (int ra = axial_block_num*num_axial_crystals_per_block;
+       ra < (axial_block_num+1)*num_axial_crystals_per_block;
+       ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
       for (int rb = max(ra,fan_data.get_min_rb(ra)); rb <= fan_data.get_max_rb(ra); ++rb)
         for (int b = fan_data.get_min_b(a); b <= fan_data.get_max_b(a); ++b)      
         {
-          block_data(ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block,
+          block_data(axial_block_num,a/num_transaxial_crystals_per_block,
                      rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block) +=
 	  fan_data(ra,a,rb,b);
         }  
 }
 
+// Note: efficiencies are updated in place, i.e. the update for detector (ra,a) uses
+// the new values of all detectors before it. The loop over detectors is therefore serial.
 void iterate_efficiencies(DetectorEfficiencies& efficiencies,
 			  const Array<2,float>& data_fan_sums,
 			  const FanProjData& model)
@@ -1086,6 +1226,9 @@ void iterate_block_norm(BlockData3D& norm_block_data,
   make_block_data(norm_block_data, model);
   //norm_block_data = measured_block_data / norm_block_data;
   const float threshold = measured_block_data.find_max()/10000.F;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = norm_block_data.get_min_ra(); ra <= norm_block_data.get_max_ra(); ++ra)
     for (int a = norm_block_data.get_min_a(); a <= norm_block_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
@@ -1103,7 +1246,12 @@ void iterate_block_norm(BlockData3D& norm_block_data,
 
 float KL(const FanProjData& d1, const FanProjData& d2, const float threshold)
 {
-  double sum=0;
+  // compute the sum for every ra in parallel, but add them in a fixed order
+  // such that the result does not depend on the number of threads
+  std::vector<double> sums_per_ring(d1.get_max_ra() - d1.get_min_ra() + 1, 0.);
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (int ra = d1.get_min_ra(); ra <= d1.get_max_ra(); ++ra)
     {
       double asum=0;
@@ -1119,8 +1267,11 @@ float KL(const FanProjData& d1, const FanProjData& d2, const float threshold)
             }
           asum += rbsum;
         }
-      sum += asum;
+      sums_per_ring[ra - d1.get_min_ra()] = asum;
     }
+  double sum=0;
+  for (std::vector<double>::const_iterator iter = sums_per_ring.begin(); iter != sums_per_ring.end(); ++iter)
+    sum += *iter;
   return static_cast<float>(sum);
 }
 
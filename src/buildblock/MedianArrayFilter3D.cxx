@@ -34,12 +34,7 @@
 */
 #include "stir/MedianArrayFilter3D.h"
 #include "stir/Coordinate3D.h"
-
-#include <algorithm>
-
-#ifndef STIR_NO_NAMESPACES
-using std::nth_element;
-#endif
+#include "stir/detail/SlidingWindowRankFilter3D.h"
 
 START_NAMESPACE_STIR
 
@@ -68,35 +63,6 @@ MedianArrayFilter3D<elemT>::MedianArrayFilter3D()
 }
 
 
-template <typename elemT>
-int
-MedianArrayFilter3D<elemT>::
-extract_neighbours(Array<1,elemT>& neigbours,const Array<3,elemT>& in_array,const Coordinate3D<int>& c_pixel) const
-{  
-  int index=0;
-  
-  for (int zi =-mask_radius_z;zi<= mask_radius_z;++zi)
-    {
-      const int z = c_pixel[1]+zi;
-      if (z<in_array.get_min_index() || z> in_array.get_max_index())
-	continue;
-      for (int yi =-mask_radius_y;yi<= mask_radius_y;++yi)
-	{
-	  const int y = c_pixel[2]+yi;
-	  if (y<in_array[z].get_min_index() || y> in_array[z].get_max_index())
-	    continue;
-	  for( int xi=-mask_radius_x;xi<= mask_radius_x;++xi)
-	    {
-	      const int x = c_pixel[3]+xi;
-	      if (x<in_array[z][y].get_min_index() || x> in_array[z][y].get_max_index())
-		continue;
-	      neigbours[index++] = in_array[z][y][x];
-	    }
-	}
-    }
-  return index;
-}
-
 template <typename elemT>
 void
 MedianArrayFilter3D<elemT>::
@@ -104,23 +70,9 @@ do_it(Array<3,elemT>& out_array, const Array<3,elemT>& in_array) const
 {
   assert(out_array.get_index_range() == in_array.get_index_range());
 
-  Array<1,elemT> neighbours (0,(2*mask_radius_x+1)*(2*mask_radius_y+1)*(2*mask_radius_z+1)-1);
-
-  for (int z=out_array.get_min_index();z<= out_array.get_max_index();++z)
-   for (int y=out_array[z].get_min_index();y <= out_array[z].get_max_index();++y)
-     for (int x=out_array[z][y].get_min_index();x <= out_array[z][y].get_max_index();++x)
-     {
-       const int num_neighbours =
-	 extract_neighbours(neighbours,in_array,Coordinate3D<int>(z,y,x));
-       if (num_neighbours==0)
-         continue;
-       nth_element(neighbours.begin(), neighbours.begin()+num_neighbours/2, neighbours.end());
-       if (num_neighbours%2==1)
-	 out_array[z][y][x] = neighbours[num_neighbours/2]; 
-       else
-	 out_array[z][y][x] = (neighbours[num_neighbours/2]+
-			       neighbours[num_neighbours/2 - 1])/2; 
-     } 
+  detail::apply_sliding_window_rank_filter_3d(out_array, in_array,
+                                              mask_radius_z, mask_radius_y, mask_radius_x,
+                                              detail::median_of_sorted());
 }
 
 
@@ -84,7 +84,10 @@ START_NAMESPACE_STIR
    Currently supported:
    <ul>
    <li> GE VOLPET data (via class ProjDataVOLPET)
-   <li> Interfile (using  read_interfile_PDFS())
+   <li> Interfile (using  read_interfile_PDFS()). If the filename is followed by
+        <tt>,mmap</tt> (e.g. <tt>sino.hs,mmap</tt>), the data file is mapped into memory
+        (see ProjDataMemoryMapped). As this is part of the filename, it can also be used in
+        parameter files.
    <li> ECAT 7 3D sinograms and attenuation files 
    </ul>
 
@@ -97,11 +100,13 @@ read_from_file(const string& filename,
 	       const std::ios::openmode openmode)
 {
   std::string actual_filename = filename;
+  std::string options;
   // parse filename to see if it's like filename,options
   {
     const std::size_t comma_pos = filename.find(',');
     if (comma_pos != std::string::npos)
       {
+	options = filename.substr(comma_pos+1);
 	actual_filename.resize(comma_pos);
       }
   }
@@ -184,7 +189,10 @@ read_from_file(const string& filename,
 #ifndef NDEBUG
     warning("ProjData::read_from_file trying to read %s as Interfile", filename.c_str());
 #endif
-    shared_ptr<ProjData> ptr(read_interfile_PDFS(filename, openmode));
+    if (!options.empty() && options != "mmap")
+      error("ProjData::read_from_file: unsupported option '%s' for Interfile data %s",
+            options.c_str(), actual_filename.c_str());
+    shared_ptr<ProjData> ptr(read_interfile_PDFS(actual_filename, openmode, options == "mmap"));
     if (!is_null_ptr(ptr))
       return ptr;
   }
@@ -42,10 +42,17 @@
 #include "stir/IO/interfile.h"
 #include "stir/IO/write_data.h"
 #include "stir/IO/read_data.h"
+#include "stir/IO/MemoryStreamBuffer.h"
 #include "stir/is_null_ptr.h"
 #include <numeric>
 #include <iostream>
 #include <fstream>
+#ifdef __OS_UNIX__
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 #ifndef STIR_NO_NAMESPACES
 using std::find;
@@ -67,6 +74,142 @@ using std::vector;
 #endif
 
 START_NAMESPACE_STIR
+
+//---------------------------------------------------------
+// positional reads
+//---------------------------------------------------------
+
+/* Wrapper around a file descriptor used with pread().
+   This only exists such that the file gets closed when the last ProjDataFromStream
+   object referring to it is deleted.
+*/
+class ProjDataFromStream::PositionalReadFile
+{
+public:
+  explicit PositionalReadFile(const int fd)
+    : fd(fd)
+  {}
+  ~PositionalReadFile()
+  {
+#ifdef __OS_UNIX__
+    close(fd);
+#endif
+  }
+
+  //! read \a num_bytes starting at position \a pos in the file
+  Succeeded read(char * buffer, std::size_t num_bytes, streamoff pos) const
+  {
+#ifdef __OS_UNIX__
+    while (num_bytes > 0)
+      {
+        const ssize_t num_read = pread(fd, buffer, num_bytes, static_cast<off_t>(pos));
+        if (num_read < 0 && errno == EINTR)
+          continue;
+        if (num_read <= 0)
+          return Succeeded::no;
+        buffer += num_read;
+        num_bytes -= static_cast<std::size_t>(num_read);
+        pos += num_read;
+      }
+    return Succeeded::yes;
+#else
+    return Succeeded::no;
+#endif
+  }
+
+private:
+  const int fd;
+};
+
+Succeeded
+ProjDataFromStream::
+set_file_for_positional_reads(const std::string& data_filename)
+{
+#ifdef __OS_UNIX__
+  const int fd = open(data_filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      warning("ProjDataFromStream: cannot open %s for positional reads. Reads will use the stream.",
+              data_filename.c_str());
+      return Succeeded::no;
+    }
+  positional_read_file_sptr.reset(new PositionalReadFile(fd));
+  positional_read_data_ptr = 0;
+  return Succeeded::yes;
+#else
+  return Succeeded::no;
+#endif
+}
+
+void
+ProjDataFromStream::
+set_memory_for_positional_reads(const char * const data_ptr)
+{
+  positional_read_file_sptr.reset();
+  positional_read_data_ptr = data_ptr;
+}
+
+bool
+ProjDataFromStream::
+has_positional_reads() const
+{
+  return positional_read_data_ptr != 0 || !is_null_ptr(positional_read_file_sptr);
+}
+
+template <class ArrayT>
+Succeeded
+ProjDataFromStream::
+positional_read(ArrayT& data, const streamoff pos) const
+{
+  const std::size_t num_bytes = data.size_all() * on_disk_data_type.size_in_bytes();
+  if (num_bytes == 0)
+    return Succeeded::yes;
+
+  // we use read_data() on a stream wrapping the raw data to handle data type and byte order
+  std::vector<char> buffer;
+  char * data_ptr;
+  if (positional_read_data_ptr != 0)
+    {
+      // the stream will only be used for reading, so we can cast the const away
+      data_ptr = const_cast<char *>(positional_read_data_ptr) + pos;
+    }
+  else
+    {
+      buffer.resize(num_bytes);
+      if (positional_read_file_sptr->read(&buffer[0], num_bytes, pos) == Succeeded::no)
+        {
+          warning("ProjDataFromStream: error reading %lu bytes at position %ld",
+                  static_cast<unsigned long>(num_bytes), static_cast<long>(pos));
+          return Succeeded::no;
+        }
+      data_ptr = &buffer[0];
+    }
+  MemoryStreamBuffer stream_buffer(data_ptr, num_bytes);
+  std::istream s(&stream_buffer);
+  float scale = float(1);
+  if (read_data(s, data, on_disk_data_type, scale, on_disk_byte_order) == Succeeded::no)
+    return Succeeded::no;
+  if (scale != 1)
+    {
+      warning("ProjDataFromStream: error reading data: scale factor returned by read_data should be 1");
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
+template <class ArrayT>
+Succeeded
+ProjDataFromStream::
+positional_read_rows(ArrayT& data, streamoff pos, const streamoff row_stride) const
+{
+  for (typename ArrayT::iterator iter = data.begin(); iter != data.end(); ++iter, pos += row_stride)
+    {
+      if (positional_read(*iter, pos) == Succeeded::no)
+        return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
 //---------------------------------------------------------
 // constructors
 //---------------------------------------------------------
@@ -87,7 +230,8 @@ ProjDataFromStream::ProjDataFromStream(shared_ptr<ExamInfo> const& exam_info_spt
                                        storage_order(o),
                                        on_disk_data_type(data_type),
                                        on_disk_byte_order(byte_order),
-                                       scale_factor(scale_factor)
+                                       scale_factor(scale_factor),
+                                       positional_read_data_ptr(0)
 {
   assert(storage_order != Unsupported);
   assert(!(data_type == NumericType::UNKNOWN_TYPE));
@@ -106,7 +250,8 @@ ProjDataFromStream::ProjDataFromStream(shared_ptr<ExamInfo> const& exam_info_spt
                                        storage_order(o),
                                        on_disk_data_type(data_type),
                                        on_disk_byte_order(byte_order),
-                                       scale_factor(scale_factor)
+                                       scale_factor(scale_factor),
+                                       positional_read_data_ptr(0)
 {
   assert(storage_order != Unsupported);
   assert(!(data_type == NumericType::UNKNOWN_TYPE));
@@ -145,6 +290,17 @@ ProjDataFromStream::get_viewgram(const int view_num, const int segment_num,
   float scale = float(1);
   Succeeded succeeded = Succeeded::yes;
   
+  if (has_positional_reads())
+    {
+      const streamoff pos = segment_offset + beg_view_offset;
+      if (get_storage_order() == Segment_AxialPos_View_TangPos)
+        succeeded =
+          positional_read_rows(viewgram, pos,
+                               intra_views_offset + get_num_tangential_poss() * on_disk_data_type.size_in_bytes());
+      else
+        succeeded = positional_read(viewgram, pos);
+    }
+  else
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJDATAFROMSTREAMIO)
 #endif
@@ -490,7 +646,17 @@ ProjDataFromStream::get_sinogram(const int ax_pos_num, const int segment_num,
   float scale = float(1);
   Succeeded succeeded = Succeeded::yes;
 
-  if (get_storage_order() == Segment_AxialPos_View_TangPos)
+  if (has_positional_reads())
+    {
+      const streamoff pos = segment_offset + beg_ax_pos_offset;
+      if (get_storage_order() == Segment_AxialPos_View_TangPos)
+        succeeded = positional_read(sinogram, pos);
+      else
+        succeeded =
+          positional_read_rows(sinogram, pos,
+                               intra_ax_pos_offset + get_num_tangential_poss() * on_disk_data_type.size_in_bytes());
+    }
+  else if (get_storage_order() == Segment_AxialPos_View_TangPos)
     {    
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJDATAFROMSTREAMIO)
@@ -713,6 +879,9 @@ ProjDataFromStream::get_segment_by_sinogram(const int segment_num) const
       SegmentBySinogram<float> segment(proj_data_info_ptr,segment_num);
       float scale = float(1);
       Succeeded succeeded = Succeeded::yes;
+      if (has_positional_reads())
+        succeeded = positional_read(segment, segment_offset);
+      else
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJDATAFROMSTREAMIO)
 #endif
@@ -761,6 +930,9 @@ ProjDataFromStream::get_segment_by_view(const int segment_num) const
     streamoff segment_offset = get_offset_segment(segment_num);
     float scale = float(1);
     Succeeded succeeded = Succeeded::yes;  
+    if (has_positional_reads())
+      succeeded = positional_read(segment, segment_offset);
+    else
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJDATAFROMSTREAMIO)
 #endif
@@ -31,22 +31,14 @@
 #include "stir/SegmentByView.h"
 #include "stir/ProjDataInterfile.h"
 #include "stir/Bin.h"
+#include "stir/IO/MemoryStreamBuffer.h"
 #include <fstream>
-
-
-#ifdef STIR_USE_OLD_STRSTREAM
-#include <strstream>
-#else
-#include <sstream>
-#endif
+#include <algorithm>
 
 #ifndef STIR_NO_NAMESPACES
 using std::fstream;
 using std::iostream;
 using std::ios;
-#ifdef STIR_USE_OLD_STRSTREAM
-using std::strstream;
-#endif
 using std::string;
 #endif
 
@@ -62,31 +54,7 @@ ProjDataInMemory(shared_ptr<ExamInfo> const& exam_info_sptr,
   :
   ProjDataFromStream(exam_info_sptr, proj_data_info_ptr, shared_ptr<iostream>()) // trick: first initialise sino_stream_ptr to 0
 {
-  
-#ifdef STIR_USE_OLD_STRSTREAM
-  const size_t buffer_size = get_size_of_buffer();
-  //buffer = unique_ptr<char>(new char[buffer_size]);
-  buffer.reset(new char[buffer_size]);
-  sino_stream.reset(new strstream(buffer.get(), buffer_size, ios::in | ios::out | ios::trunc | ios::binary));
-#else
-  // it would be advantageous to preallocate memory as well
-  // the only way to do this is by passing a string of the appropriate size
-  // However, if basic_string doesn't do reference counting, we would have
-  // temporarily 2 strings of a (potentially large) size in memory.
-  // todo?
-  sino_stream.reset(new std::stringstream(ios::in | ios::out | ios::binary));
-#endif
-
-  if (!*sino_stream)
-    error("ProjDataInMemory error initialising stream\n");
-
-  if (initialise_with_0)
-  {
-    for (int segment_num = proj_data_info_ptr->get_min_segment_num();
-         segment_num <= proj_data_info_ptr->get_max_segment_num();
-         ++segment_num)
-      set_segment(proj_data_info_ptr->get_empty_segment_by_view(segment_num));
-  }
+  create_buffer(initialise_with_0);
 }
 
 ProjDataInMemory::
@@ -94,22 +62,7 @@ ProjDataInMemory(const ProjData& proj_data)
   : ProjDataFromStream(proj_data.get_exam_info_sptr(),
 		       proj_data.get_proj_data_info_ptr()->create_shared_clone(), shared_ptr<iostream>())
 {
-#ifdef STIR_USE_OLD_STRSTREAM
-  const size_t buffer_size = get_size_of_buffer();
-  //buffer = unique_ptr<char>(new char[buffer_size]);
-  buffer.reset(new char[buffer_size]);
-  sino_stream.reset(new strstream(buffer.get(), buffer_size, ios::in | ios::out | ios::binary));
-#else
-  // it would be advantageous to preallocate memory as well
-  // the only way to do this is by passing a string of the appropriate size
-  // However, if basic_string doesn't do reference counting, we would have
-  // temporarily 2 strings of a (potentially large) size in memory.
-  // todo?
-  sino_stream.reset(new std::stringstream(ios::in | ios::out | ios::binary));
-#endif
-
-  if (!*sino_stream)
-    error("ProjDataInMemory error initialising stream");
+  create_buffer(false);
 
   // copy data
   // (note: cannot use fill(projdata) as that uses virtual functions, which won't work in a constructor
@@ -119,6 +72,22 @@ ProjDataInMemory(const ProjData& proj_data)
     set_segment(proj_data.get_segment_by_view(segment_num));
 }
 
+void
+ProjDataInMemory::
+create_buffer(const bool initialise_with_0)
+{
+  const size_t buffer_size = get_size_of_buffer();
+  buffer.reset(new char[buffer_size]);
+  if (initialise_with_0)
+    std::fill(buffer.get(), buffer.get() + buffer_size, static_cast<char>(0));
+  sino_stream.reset(new MemoryIOStream(buffer.get(), buffer_size));
+
+  if (!*sino_stream)
+    error("ProjDataInMemory error initialising stream");
+
+  this->set_memory_for_positional_reads(buffer.get());
+}
+
 size_t
 ProjDataInMemory::
 get_size_of_buffer() const
@@ -80,6 +80,8 @@ create_stream(const string& filename, const ios::openmode open_mode)
   {
     error("ProjDataInterfile: error opening output file %s\n", data_name.c_str());
   }
+  if (open_mode & ios::in)
+    this->set_file_for_positional_reads(data_name);
 #if 0
   delete[] header_name;
   delete[] data_name;
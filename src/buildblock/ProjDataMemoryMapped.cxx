@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup projdata
+  \brief Implementations for non-inline functions of class stir::ProjDataMemoryMapped
+*/
+
+#include "stir/ProjDataMemoryMapped.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/ExamInfo.h"
+#include "stir/Succeeded.h"
+#include "stir/IO/MemoryStreamBuffer.h"
+#include "stir/error.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifndef STIR_NO_NAMESPACES
+using std::iostream;
+using std::ios;
+using std::string;
+using std::vector;
+using std::streamoff;
+#endif
+
+START_NAMESPACE_STIR
+
+ProjDataMemoryMapped::
+ProjDataMemoryMapped(shared_ptr<ExamInfo> const& exam_info_sptr,
+                     shared_ptr<ProjDataInfo> const& proj_data_info_sptr,
+                     const string& data_filename,
+                     const ios::openmode open_mode,
+                     const streamoff offset_in_file,
+                     const vector<int>& segment_sequence_in_file,
+                     StorageOrder o,
+                     NumericType data_type,
+                     ByteOrder byte_order,
+                     float scale_factor)
+  : ProjDataFromStream(exam_info_sptr, proj_data_info_sptr, shared_ptr<iostream>(), // stream is set below
+                       offset_in_file, segment_sequence_in_file,
+                       o, data_type, byte_order, scale_factor)
+{
+  std::size_t num_sinograms = 0;
+  for (vector<int>::const_iterator iter = segment_sequence_in_file.begin();
+       iter != segment_sequence_in_file.end();
+       ++iter)
+    num_sinograms += proj_data_info_sptr->get_num_axial_poss(*iter);
+  const std::size_t size_needed =
+    static_cast<std::size_t>(offset_in_file) +
+    num_sinograms *
+    proj_data_info_sptr->get_num_views() *
+    proj_data_info_sptr->get_num_tangential_poss() *
+    data_type.size_in_bytes();
+
+  const bool writable = (open_mode & ios::out) != 0;
+  const boost::interprocess::mode_t mode =
+    writable ? boost::interprocess::read_write : boost::interprocess::read_only;
+  try
+    {
+      this->file_mapping_sptr.reset(new boost::interprocess::file_mapping(data_filename.c_str(), mode));
+      this->region_sptr.reset(new boost::interprocess::mapped_region(*this->file_mapping_sptr, mode));
+    }
+  catch (boost::interprocess::interprocess_exception& e)
+    {
+      error("ProjDataMemoryMapped: error mapping file %s: %s", data_filename.c_str(), e.what());
+    }
+  if (this->region_sptr->get_size() < size_needed)
+    error("ProjDataMemoryMapped: file %s is too small (%lu bytes, but %lu needed)",
+          data_filename.c_str(),
+          static_cast<unsigned long>(this->region_sptr->get_size()),
+          static_cast<unsigned long>(size_needed));
+
+  char * const data_ptr = static_cast<char *>(this->region_sptr->get_address());
+  this->sino_stream.reset(new MemoryIOStream(data_ptr, size_needed, writable));
+  this->set_memory_for_positional_reads(data_ptr);
+}
+
+Succeeded
+ProjDataMemoryMapped::
+flush()
+{
+  return this->region_sptr->flush() ? Succeeded::yes : Succeeded::no;
+}
+
+END_NAMESPACE_STIR
@@ -59,7 +59,8 @@ SegmentBySinogram(const Array<3,elemT>& v,
 template <typename elemT>  
 SegmentBySinogram<elemT> ::
 SegmentBySinogram(const shared_ptr<ProjDataInfo>& pdi_ptr,
-		  const int segment_num)
+		  const int segment_num,
+                  const bool contiguous)
   : 
   Segment<elemT>(pdi_ptr, segment_num), 
   Array<3,elemT>(IndexRange3D(pdi_ptr->get_min_axial_pos_num(segment_num),
@@ -67,7 +68,8 @@ SegmentBySinogram(const shared_ptr<ProjDataInfo>& pdi_ptr,
                               pdi_ptr->get_min_view_num(),
                               pdi_ptr->get_max_view_num(),
                               pdi_ptr->get_min_tangential_pos_num(),
-                              pdi_ptr->get_max_tangential_pos_num()))
+                              pdi_ptr->get_max_tangential_pos_num()),
+                 contiguous)
 {}
 
 template <typename elemT>
@@ -77,7 +79,8 @@ SegmentBySinogram(const SegmentByView<elemT>& s_v )
                    s_v.get_segment_num()),	      
    Array<3,elemT> (IndexRange3D (s_v.get_min_axial_pos_num(), s_v.get_max_axial_pos_num(),
 		                 s_v.get_min_view_num(), s_v.get_max_view_num(),
-		                 s_v.get_min_tangential_pos_num(), s_v.get_max_tangential_pos_num()))
+		                 s_v.get_min_tangential_pos_num(), s_v.get_max_tangential_pos_num()),
+                   s_v.is_contiguous())
 {
   
   for (int r=get_min_axial_pos_num(); r<= get_max_axial_pos_num(); r++)
@@ -58,7 +58,8 @@ SegmentByView(const Array<3,elemT>& v,
 template <typename elemT>
 SegmentByView<elemT>::
 SegmentByView(const shared_ptr<ProjDataInfo>& pdi_ptr,
-              const int segment_num)
+              const int segment_num,
+              const bool contiguous)
   :
   Segment<elemT>(pdi_ptr, segment_num),
   Array<3,elemT>(IndexRange3D(pdi_ptr->get_min_view_num(),
@@ -66,7 +67,8 @@ SegmentByView(const shared_ptr<ProjDataInfo>& pdi_ptr,
 		              pdi_ptr->get_min_axial_pos_num(segment_num),
                               pdi_ptr->get_max_axial_pos_num(segment_num),
 		              pdi_ptr->get_min_tangential_pos_num(),
-                              pdi_ptr->get_max_tangential_pos_num()))
+                              pdi_ptr->get_max_tangential_pos_num()),
+                 contiguous)
 {}
 
 template <typename elemT>
@@ -76,7 +78,8 @@ SegmentByView<elemT>::SegmentByView(const SegmentBySinogram<elemT>& s_s)
 	       
     Array<3,elemT> (IndexRange3D(s_s.get_min_view_num(),s_s.get_max_view_num(),
 		                 s_s.get_min_axial_pos_num(),s_s.get_max_axial_pos_num(),
-		                 s_s.get_min_tangential_pos_num(), s_s.get_max_tangential_pos_num()))
+		                 s_s.get_min_tangential_pos_num(), s_s.get_max_tangential_pos_num()),
+                    s_s.is_contiguous())
 {  
   
   for (int v=get_min_view_num(); v<= get_max_view_num(); v++)
@@ -29,10 +29,177 @@
 
 #include "stir/SeparableArrayFunctionObject.h"
 #include "stir/ArrayFunction.h"
+#include "stir/ArrayFilter1DUsingConvolution.h"
+#include "stir/ArrayFilter1DUsingConvolutionSymmetricKernel.h"
+#include "stir/IndexRange.h"
 #include "stir/is_null_ptr.h"
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
 
 START_NAMESPACE_STIR
 
+namespace detail
+{
+  /* Convolution kernel for one index, such that
+       out[i] = sum_{j=min_index}^{max_index} coefficients[j-min_index] * in[i-j]
+     with in[i] for i outside the index range either 0 or equal to the nearest element.
+  */
+  template <typename elemT>
+  struct SeparableConvolutionKernel
+  {
+    std::vector<elemT> coefficients;
+    int min_index;
+    int max_index;
+    bool constant_boundary_conditions;
+  };
+
+  /* Sets the kernel if the 1D function object is one of the convolution filters.
+     Returns false otherwise.
+  */
+  template <typename elemT>
+  static bool
+  get_separable_convolution_kernel(SeparableConvolutionKernel<elemT>& kernel,
+                                   const ArrayFunctionObject<1,elemT>& function_object)
+  {
+    if (const ArrayFilter1DUsingConvolution<elemT> * const conv_ptr =
+        dynamic_cast<const ArrayFilter1DUsingConvolution<elemT> *>(&function_object))
+      {
+        const VectorWithOffset<elemT>& coefficients = conv_ptr->get_filter_coefficients();
+        if (conv_ptr->get_boundary_condition() != BoundaryConditions::zero &&
+            conv_ptr->get_boundary_condition() != BoundaryConditions::constant)
+          return false;
+        kernel.constant_boundary_conditions =
+          conv_ptr->get_boundary_condition() == BoundaryConditions::constant;
+        kernel.min_index = coefficients.get_min_index();
+        kernel.max_index = coefficients.get_max_index();
+        kernel.coefficients.assign(coefficients.begin(), coefficients.end());
+        return true;
+      }
+    if (const ArrayFilter1DUsingConvolutionSymmetricKernel<elemT> * const conv_ptr =
+        dynamic_cast<const ArrayFilter1DUsingConvolutionSymmetricKernel<elemT> *>(&function_object))
+      {
+        // only half of the kernel is stored, starting from index 0
+        const VectorWithOffset<elemT>& coefficients = conv_ptr->get_filter_coefficients();
+        const int half_length = coefficients.get_length()-1;
+        kernel.constant_boundary_conditions = false;
+        kernel.min_index = -half_length;
+        kernel.max_index = half_length;
+        kernel.coefficients.resize(2*half_length+1);
+        for (int j=-half_length; j<=half_length; ++j)
+          kernel.coefficients[j+half_length] = coefficients[std::abs(j)];
+        return true;
+      }
+    return false;
+  }
+
+  /* Fill a padded copy of a line, such that padded[m*stride] corresponds to in[m+first_index]
+     (using the boundary conditions for indices outside [0,length)).
+     The line is given by in[i*in_stride], and blocks of width elements are copied.
+  */
+  template <typename elemT>
+  static void
+  fill_padded_lines(elemT * padded, const elemT * in,
+                    const int first_index, const int padded_length,
+                    const int length, const std::ptrdiff_t in_stride,
+                    const int width,
+                    const bool constant_boundary_conditions)
+  {
+    for (int m=0; m<padded_length; ++m, padded += width)
+      {
+        int i = m+first_index;
+        if (i<0 || i>=length)
+          {
+            if (!constant_boundary_conditions)
+              {
+                std::fill(padded, padded+width, elemT(0));
+                continue;
+              }
+            i = i<0 ? 0 : length-1;
+          }
+        std::copy(in + i*in_stride, in + i*in_stride + width, padded);
+      }
+  }
+
+  /* In-place convolution along one index of a contiguous array.
+     The array is considered as a 3D array of sizes (outer_size, length, inner_size),
+     and the convolution is performed along the middle index.
+
+     If inner_size>1, neighbouring lines are adjacent in memory. We then process blocks of
+     lines at the same time, such that the innermost loop runs over the lines (which
+     is suitable for SIMD instructions, and accesses memory contiguously).
+     If inner_size==1, the innermost loop runs over the elements in the line.
+  */
+  template <typename elemT>
+  static void
+  convolve_along_index(elemT * data,
+                       const std::size_t outer_size, const int length, const std::size_t inner_size,
+                       const SeparableConvolutionKernel<elemT>& kernel)
+  {
+    const int block_width = 64;
+    const int num_coefficients = static_cast<int>(kernel.coefficients.size());
+    // padded[m] corresponds to in[m-kernel.max_index], such that
+    // out[i] = sum_c coefficients[c] * padded[i + num_coefficients-1 - c]
+    const int padded_length = length + num_coefficients - 1;
+    const std::size_t num_blocks_per_outer = (inner_size + block_width - 1)/block_width;
+    const long num_blocks = static_cast<long>(outer_size*num_blocks_per_outer);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel if (num_blocks > 1)
+#endif
+    {
+      std::vector<elemT> padded(static_cast<std::size_t>(padded_length)*std::min<std::size_t>(block_width, inner_size));
+
+#ifdef STIR_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (long block=0; block<num_blocks; ++block)
+        {
+          const std::size_t outer = block / num_blocks_per_outer;
+          const std::size_t first_inner = (block % num_blocks_per_outer)*block_width;
+          const int width = static_cast<int>(std::min<std::size_t>(block_width, inner_size-first_inner));
+          elemT * const line_ptr = data + outer*length*inner_size + first_inner;
+          const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(inner_size);
+
+          fill_padded_lines(&padded[0], line_ptr, -kernel.max_index, padded_length,
+                            length, stride, width, kernel.constant_boundary_conditions);
+
+          if (width == 1)
+            {
+              // loop over elements in the line
+              elemT * const out = line_ptr;
+              std::fill(out, out+length, elemT(0));
+              for (int c=0; c<num_coefficients; ++c)
+                {
+                  const elemT coefficient = kernel.coefficients[c];
+                  const elemT * const in = &padded[num_coefficients-1-c];
+                  for (int i=0; i<length; ++i)
+                    out[i] += coefficient * in[i];
+                }
+            }
+          else
+            {
+              // loop over lines
+              for (int i=0; i<length; ++i)
+                {
+                  elemT * const out = line_ptr + i*stride;
+                  std::fill(out, out+width, elemT(0));
+                  for (int c=0; c<num_coefficients; ++c)
+                    {
+                      const elemT coefficient = kernel.coefficients[c];
+                      const elemT * const in = &padded[static_cast<std::size_t>(i + num_coefficients-1-c)*width];
+                      for (int k=0; k<width; ++k)
+                        out[k] += coefficient * in[k];
+                    }
+                }
+            }
+        }
+    }
+  }
+
+} // end of namespace detail
+
 template <int num_dim, typename elemT>
 SeparableArrayFunctionObject<num_dim, elemT>::
 SeparableArrayFunctionObject()
@@ -64,12 +231,59 @@ do_it(Array<num_dim,elemT>& array) const
 	    ++iter)
 	assert(!is_null_ptr(*iter));
 #endif
+
+      if (this->do_it_using_separable_convolution(array))
+        return;
+
        in_place_apply_array_functions_on_each_index(array, 
 						    all_1d_array_filters.begin(), 
 						    all_1d_array_filters.end());
     }
 }
 
+template <int num_dim, typename elemT>
+bool
+SeparableArrayFunctionObject<num_dim, elemT>::
+do_it_using_separable_convolution(Array<num_dim,elemT>& array) const
+{
+  if (!array.is_contiguous())
+    return false;
+  BasicCoordinate<num_dim, int> min_indices, max_indices;
+  if (!array.get_regular_range(min_indices, max_indices))
+    return false;
+
+  // find kernels for all dimensions
+  std::vector<detail::SeparableConvolutionKernel<elemT> > kernels(num_dim);
+  std::vector<bool> is_trivial_dimension(num_dim);
+  for (int d=0; d<num_dim; ++d)
+    {
+      const shared_ptr<ArrayFunctionObject<1,elemT> >& filter_sptr =
+        *(all_1d_array_filters.begin() + d);
+      is_trivial_dimension[d] = is_null_ptr(filter_sptr) || filter_sptr->is_trivial();
+      if (!is_trivial_dimension[d] &&
+          !detail::get_separable_convolution_kernel(kernels[d], *filter_sptr))
+        return false;
+    }
+
+  elemT * const data_ptr = array.get_full_data_ptr();
+  for (int d=0; d<num_dim; ++d)
+    {
+      if (is_trivial_dimension[d])
+        continue;
+      std::size_t outer_size = 1;
+      for (int d_outer=1; d_outer<=d; ++d_outer)
+        outer_size *= max_indices[d_outer] - min_indices[d_outer] + 1;
+      std::size_t inner_size = 1;
+      for (int d_inner=d+2; d_inner<=num_dim; ++d_inner)
+        inner_size *= max_indices[d_inner] - min_indices[d_inner] + 1;
+      const int length = max_indices[d+1] - min_indices[d+1] + 1;
+      if (length <= 0 || outer_size*inner_size == 0)
+        break;
+      detail::convolve_along_index(data_ptr, outer_size, length, inner_size, kernels[d]);
+    }
+  return true;
+}
+
 #if 0
 // TODO insert
 template <int num_dimensions, typename elemT>
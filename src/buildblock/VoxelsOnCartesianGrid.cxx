@@ -202,8 +202,8 @@ VoxelsOnCartesianGrid<elemT>::VoxelsOnCartesianGrid(const ProjDataInfo& proj_dat
                       -(y_size_used/2), -(y_size_used/2) + y_size_used-1,
                       -(x_size_used/2), -(x_size_used/2) + x_size_used-1);
 
-
-  this->grow(range);
+  // store all voxels contiguously, as the DiscretisedDensity constructor does
+  this->init(range, /*data_ptr=*/0, /*initialise_with_0=*/true);
 }
 
 /*!
@@ -0,0 +1,24 @@
+# Find the single precision FFTW3 library (http://www.fftw.org)
+#
+# This sets FFTW3_FOUND, FFTW3_INCLUDE_DIRS and FFTW3_LIBRARIES.
+# Set FFTW3_ROOT_DIR (or the environment variable) if it is not found.
+# Note that FFTW is distributed under the GPL.
+
+ if (NOT FFTW3_ROOT_DIR AND NOT $ENV{FFTW3_ROOT_DIR} STREQUAL "")
+    set(FFTW3_ROOT_DIR $ENV{FFTW3_ROOT_DIR})
+  endif(NOT FFTW3_ROOT_DIR AND NOT $ENV{FFTW3_ROOT_DIR} STREQUAL "")
+
+  IF( FFTW3_ROOT_DIR )
+    file(TO_CMAKE_PATH ${FFTW3_ROOT_DIR} FFTW3_ROOT_DIR)
+  ENDIF( FFTW3_ROOT_DIR )
+
+  find_path(FFTW3_INCLUDE_DIRS NAME fftw3.h HINTS ${FFTW3_ROOT_DIR} PATH_SUFFIXES include
+        DOC "location of FFTW3 include files")
+
+  find_library(FFTW3_LIBRARIES NAME fftw3f HINTS ${FFTW3_ROOT_DIR} PATH_SUFFIXES lib
+        DOC "location of single precision FFTW3 library")
+
+# handle the QUIETLY and REQUIRED arguments and set FFTW3_FOUND to TRUE if 
+# all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(FFTW3 "FFTW3 (single precision) library not found. If you do have it, set the missing variables" FFTW3_LIBRARIES FFTW3_INCLUDE_DIRS)
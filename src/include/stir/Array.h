@@ -41,6 +41,7 @@
 #include "stir/NumericVectorWithOffset.h"
 #include "stir/ByteOrder.h"
 #include "stir/IndexRange.h"   
+#include "boost/shared_array.hpp"
 
 START_NAMESPACE_STIR
 class NumericType;
@@ -72,6 +73,28 @@ Array inherits its numeric operators from NumericVectorWithOffset.
 In particular this means that operator+= etc. potentially grow
 the object. However, as grow() is a virtual function, Array::grow is
 called, which initialises new elements first to 0.
+
+\par Contiguous storage
+
+By default, every 1D row of an Array allocates its own memory. An Array can
+instead store all its elements in a single block of memory, in the order in
+which a full_iterator runs through them, by passing \c contiguous=true to the
+constructor that takes an index range. The elements can then be accessed via
+a plain pointer, see get_full_data_ptr(). This is useful to pass the data to
+other libraries, and for loops over all elements that the compiler can
+vectorise. The block is aligned to Array::alignment_in_bytes.
+
+A copy of a contiguous Array is contiguous as well. Resizing a non-empty array
+(or one of its elements) will in general break contiguity, so use
+is_contiguous() to check.
+
+DiscretisedDensity (and therefore all images) always uses contiguous storage.
+Viewgram, Sinogram, SegmentBySinogram and SegmentByView have a \c contiguous
+argument in their constructors from a ProjDataInfo, which defaults to \c false.
+
+There are no strided views (e.g. a column of a contiguous array as a 1D object).
+Code that needs these can use get_full_data_ptr() and the index range to
+compute the strides itself (see for instance SeparableArrayFunctionObject).
 */
 
 template <int num_dimensions, typename elemT>
@@ -130,10 +153,20 @@ public:
 
   //! Construct an Array of given range of indices, elements are initialised to 0
   inline explicit Array(const IndexRange<num_dimensions>&);
+
+  //! Construct an Array of given range of indices, elements are initialised to 0
+  /*! If \a contiguous is \c true, all elements are stored in a single block of memory,
+      see is_contiguous().
+  */
+  inline Array(const IndexRange<num_dimensions>&, const bool contiguous);
   
 #ifndef SWIG
   //! Construct an Array from an object of its base_type
   inline Array(const base_type& t);
+
+  //! Copy constructor
+  /*! The copy is contiguous if \a t is contiguous, see is_contiguous(). */
+  inline Array(const self& t);
 #else
   // swig 2.0.4 gets confused by base_type (due to numeric template arguments)
   // therefore, we declare this constructor using the "self" type, 
@@ -145,6 +178,13 @@ public:
   //! virtual destructor, frees up any allocated memory
   inline virtual ~Array();
 
+  //! assignment operator
+  /*! Copies the elements. If both arrays have the same index range, \c *this
+      is not reallocated, so if it was contiguous, it will remain so. Otherwise,
+      \c *this will be contiguous if \a t is contiguous.
+  */
+  inline self& operator=(const self& t);
+
   /*! @name functions returning full_iterators*/
   //@{
   //! start value for iterating through all elements in the array, see full_iterator
@@ -193,6 +233,35 @@ public:
   //! Fill elements with value n (overrides VectorWithOffset::fill)
   inline void fill(const elemT &n);
 
+  /*! @name access to the elements via a pointer */
+  //@{
+  //! alignment (in bytes) of the first element of a contiguous array allocated by this class
+  /*! This is sufficient for SIMD loads of the first element (e.g. AVX). Note that rows
+      after the first one are in general not aligned.
+  */
+  static const std::size_t alignment_in_bytes = 32;
+
+  //! checks if all elements are stored in a single block of memory
+  /*! Empty elements (e.g. rows of length 0) are ignored.
+      This function checks the actual storage of all elements (as opposed to
+      remembering how the array was constructed), as resize() could have been called
+      on an element of the array.
+  */
+  inline bool is_contiguous() const;
+
+  //! return a pointer to the first element of a contiguous array
+  /*! Elements are stored in the same order as used by full_iterator.
+      Calls error() if the array is not contiguous, and returns 0 for an empty array.
+
+      The pointer is only valid as long as the array is not resized (or destroyed).
+  */
+  inline elemT* get_full_data_ptr();
+
+  //! return a const pointer to the first element of a contiguous array
+  /*! \see get_full_data_ptr() */
+  inline const elemT* get_const_full_data_ptr() const;
+  //@}
+
   //! checks if the index range is 'regular'
   /*! Implementation note: this works by calling get_index_range().is_regular().
       We cannot rely on remembering if it was a regular range at construction (or
@@ -239,6 +308,32 @@ public:
   inline const elemT&
     at(const BasicCoordinate<num_dimensions,int> &c) const;
   //@}
+
+#ifndef SWIG
+ protected:
+  // allow Array<num_dimensions+1, elemT> to call init() etc
+  template <int, typename> friend class Array;
+#endif
+  //! set a new index range, using (uninitialised) existing memory if \a data_ptr is non-zero
+  /*! If \a data_ptr is zero, a new block of memory for all elements is allocated.
+      Otherwise, \a data_ptr has to point to a block with at least \c range.size_all()
+      elements, which has to remain valid for as long as this array uses it.
+      Previous elements are discarded.
+  */
+  inline void init(const IndexRange<num_dimensions>& range, elemT * const data_ptr,
+                   const bool initialise_with_0);
+
+  //! pointer to the first element (or 0 if the array is empty), without checking contiguity
+  inline const elemT* _get_first_elem_ptr() const;
+
+ private:
+  //! block of memory allocated by init() (if any)
+  /*! This is kept here for deallocation only. It is not copied by the copy constructor or
+      operator=. */
+  boost::shared_array<elemT> _allocated_full_data_sptr;
+
+  //! copy the elements of \a t, which has to have the same index range as \c *this
+  inline void copy_elements(const self& t);
 };
 
 
@@ -298,6 +393,12 @@ public:
   
   //! constructor given an IndexRange<1>, initialising elements to 0
   inline explicit Array(const IndexRange<1>& range);
+
+  //! constructor given an IndexRange<1>, initialising elements to 0
+  /*! \a contiguous is ignored, as a 1D array is always contiguous. This constructor
+      is provided such that the same code can be used for all dimensions.
+  */
+  inline Array(const IndexRange<1>& range, const bool contiguous);
   		
   //! constructor given first and last indices, initialising elements to 0
   inline Array(const int min_index, const int max_index);
@@ -356,6 +457,18 @@ public:
   
   //! checks if the index range is 'regular' (always \c true as this is the 1D case)
   inline bool is_regular() const;
+
+  //! checks if all elements are stored in a single block of memory (always \c true for the 1D case)
+  inline bool is_contiguous() const;
+
+  //! return a pointer to the first element (or 0 for an empty array)
+  /*! In contrast to VectorWithOffset::get_data_ptr(), this does not need to be released.
+      The pointer is only valid as long as the array is not resized (or destroyed).
+  */
+  inline elemT* get_full_data_ptr();
+
+  //! return a const pointer to the first element (or 0 for an empty array)
+  inline const elemT* get_const_full_data_ptr() const;
   
   //! find regular range, returns \c false if the range is not regular
   bool get_regular_range(
@@ -426,7 +539,18 @@ public:
     at(const BasicCoordinate<1,int> &c) const;
   //@}
 
-  
+#ifndef SWIG
+ protected:
+  // allow Array<2, elemT> to call init() etc
+  template <int, typename> friend class Array;
+#endif
+  //! set a new index range, using (uninitialised) existing memory if \a data_ptr is non-zero
+  /*! \see Array<num_dimensions,elemT>::init() */
+  inline void init(const IndexRange<1>& range, elemT * const data_ptr,
+                   const bool initialise_with_0);
+
+  //! pointer to the first element (or 0 if the array is empty)
+  inline const elemT* _get_first_elem_ptr() const;
 };
 
 
@@ -31,13 +31,94 @@
 // include for min,max definitions
 #include <algorithm>
 #include "stir/assign.h"
+#include "stir/error.h"
+#include <memory>
+#include <new>
 
 START_NAMESPACE_STIR
 
+namespace detail
+{
+  //! deleter for the aligned block of memory allocated by allocate_aligned_array()
+  template <typename elemT>
+  class AlignedArrayDeleter
+  {
+  public:
+    AlignedArrayDeleter(void * const raw_ptr, const std::size_t size)
+      : _raw_ptr(raw_ptr), _size(size)
+    {}
+    void operator()(elemT * const data_ptr) const
+    {
+      for (std::size_t i=0; i<_size; ++i)
+        data_ptr[i].~elemT();
+      ::operator delete(_raw_ptr);
+    }
+  private:
+    void * _raw_ptr;
+    std::size_t _size;
+  };
+
+  //! allocate a block of \a size elements, with the first one aligned to \a alignment bytes
+  /*! Elements are initialised with elemT(). \a alignment has to be a power of 2. */
+  template <typename elemT>
+  inline boost::shared_array<elemT>
+  allocate_aligned_array(const std::size_t size, const std::size_t alignment)
+  {
+    if (size == 0)
+      return boost::shared_array<elemT>();
+    void * const raw_ptr = ::operator new(size*sizeof(elemT) + alignment - 1);
+    elemT * const data_ptr =
+      reinterpret_cast<elemT *>((reinterpret_cast<std::size_t>(raw_ptr) + alignment - 1) & ~(alignment - 1));
+    try
+      {
+        std::uninitialized_fill(data_ptr, data_ptr + size, elemT());
+      }
+    catch (...)
+      {
+        ::operator delete(raw_ptr);
+        throw;
+      }
+    return boost::shared_array<elemT>(data_ptr, AlignedArrayDeleter<elemT>(raw_ptr, size));
+  }
+} // end of namespace detail
+
 /**********************************************
  inlines for Array<num_dimensions, elemT>
  **********************************************/
 
+template <int num_dimensions, typename elemT>
+void 
+Array<num_dimensions, elemT>::
+init(const IndexRange<num_dimensions>& range, elemT * const data_ptr,
+     const bool initialise_with_0)
+{
+  elemT * current_data_ptr = data_ptr;
+  if (data_ptr == 0)
+    {
+      // allocate a single (aligned) block for all elements
+      this->_allocated_full_data_sptr =
+        detail::allocate_aligned_array<elemT>(range.size_all(), alignment_in_bytes);
+      current_data_ptr = this->_allocated_full_data_sptr.get();
+    }
+  // discard all current elements (such that resize() does not need to copy them)
+  this->recycle();
+  base_type::resize(range.get_min_index(), range.get_max_index());
+  typename base_type::iterator iter = this->begin();
+  typename IndexRange<num_dimensions>::const_iterator range_iter = range.begin();
+  for (;
+       iter != this->end(); 
+       ++iter, ++range_iter)
+    {
+      (*iter).init(*range_iter, current_data_ptr, initialise_with_0);
+      current_data_ptr += range_iter->size_all();
+    }
+  if (data_ptr != 0)
+    {
+      // the data are owned by somebody else, so we can drop any previous block
+      this->_allocated_full_data_sptr.reset();
+    }
+}
+
 template <int num_dimensions, typename elemT>
 void 
 Array<num_dimensions, elemT>::
@@ -73,14 +154,73 @@ Array<num_dimensions, elemT>::Array(const IndexRange<num_dimensions>& range)
 }
 
 template <int num_dimensions, typename elemT>
-#ifdef SWIG
-// swig-specific work-around (see Array.h)
-Array<num_dimensions, elemT>::Array(const self& t)
-#else
+Array<num_dimensions, elemT>::Array(const IndexRange<num_dimensions>& range,
+                                    const bool contiguous)
+: base_type()
+{
+  if (contiguous)
+    this->init(range, 0, true);
+  else
+    grow(range);
+}
+
+#ifndef SWIG
+template <int num_dimensions, typename elemT>
 Array<num_dimensions, elemT>::Array(const base_type& t)
-#endif
 :  base_type(t)
 {}
+#endif
+
+template <int num_dimensions, typename elemT>
+Array<num_dimensions, elemT>::Array(const self& t)
+: base_type()
+{
+  if (t.is_contiguous())
+    {
+      this->init(t.get_index_range(), 0, false);
+      this->copy_elements(t);
+    }
+  else
+    base_type::operator=(t);
+}
+
+template <int num_dimensions, typename elemT>
+void
+Array<num_dimensions, elemT>::copy_elements(const self& t)
+{
+  if (t.is_contiguous() && this->is_contiguous())
+    std::copy(t._get_first_elem_ptr(), t._get_first_elem_ptr() + t.size_all(),
+              const_cast<elemT *>(this->_get_first_elem_ptr()));
+  else
+    std::copy(t.begin_all(), t.end_all(), this->begin_all());
+}
+
+template <int num_dimensions, typename elemT>
+Array<num_dimensions, elemT>&
+Array<num_dimensions, elemT>::operator=(const self& t)
+{
+  if (this == &t)
+    return *this;
+  const IndexRange<num_dimensions> range = t.get_index_range();
+  if (this->get_index_range() == range)
+    {
+      // copy elements in place
+      base_type::operator=(t);
+      return *this;
+    }
+  if (t.is_contiguous())
+    {
+      // reallocate, such that the result is contiguous
+      this->init(range, 0, false);
+      this->copy_elements(t);
+      return *this;
+    }
+  // discard all current elements, such that we can release the block of memory (if any)
+  this->recycle();
+  this->_allocated_full_data_sptr.reset();
+  base_type::operator=(t);
+  return *this;
+}
 
 template <int num_dimensions, typename elemT>
 Array<num_dimensions, elemT>::~Array()
@@ -208,6 +348,11 @@ elemT
 Array<num_dimensions, elemT>::find_max() const
 {
   this->check_state();
+  if (this->size_all() > 0 && this->is_contiguous())
+  {
+    const elemT * const data_ptr = this->_get_first_elem_ptr();
+    return *std::max_element(data_ptr, data_ptr + this->size_all());
+  }
   if (this->size() > 0)
   {
     elemT maxval= this->num[this->get_min_index()].find_max();
@@ -229,6 +374,11 @@ elemT
 Array<num_dimensions, elemT>::find_min() const
 {
   this->check_state();
+  if (this->size_all() > 0 && this->is_contiguous())
+  {
+    const elemT * const data_ptr = this->_get_first_elem_ptr();
+    return *std::min_element(data_ptr, data_ptr + this->size_all());
+  }
   if (this->size() > 0)
   {
     elemT minval= this->num[this->get_min_index()].find_min();
@@ -254,11 +404,67 @@ void
 Array<num_dimensions, elemT>::fill(const elemT &n) 
 {
   this->check_state();
+  if (this->is_contiguous())
+    {
+      elemT * const data_ptr = const_cast<elemT *>(this->_get_first_elem_ptr());
+      std::fill(data_ptr, data_ptr + this->size_all(), n);
+      return;
+    }
   for(int i=this->get_min_index(); i<=this->get_max_index();  i++)
     this->num[i].fill(n);
   this->check_state();
 }
 
+template <int num_dimensions, typename elemT>
+const elemT*
+Array<num_dimensions, elemT>::_get_first_elem_ptr() const
+{
+  for (const_iterator iter = this->begin(); iter != this->end(); ++iter)
+    {
+      const elemT * const ptr = iter->_get_first_elem_ptr();
+      if (ptr != 0)
+        return ptr;
+    }
+  return 0;
+}
+
+template <int num_dimensions, typename elemT>
+bool
+Array<num_dimensions, elemT>::is_contiguous() const
+{
+  const elemT * next_ptr = 0;
+  for (const_iterator iter = this->begin(); iter != this->end(); ++iter)
+    {
+      if (!iter->is_contiguous())
+        return false;
+      const elemT * const ptr = iter->_get_first_elem_ptr();
+      if (ptr == 0)
+        continue; // empty
+      if (next_ptr != 0 && ptr != next_ptr)
+        return false;
+      next_ptr = ptr + iter->size_all();
+    }
+  return true;
+}
+
+template <int num_dimensions, typename elemT>
+elemT*
+Array<num_dimensions, elemT>::get_full_data_ptr()
+{
+  if (!this->is_contiguous())
+    error("Array::get_full_data_ptr() called for a non-contiguous array");
+  return const_cast<elemT *>(this->_get_first_elem_ptr());
+}
+
+template <int num_dimensions, typename elemT>
+const elemT*
+Array<num_dimensions, elemT>::get_const_full_data_ptr() const
+{
+  if (!this->is_contiguous())
+    error("Array::get_const_full_data_ptr() called for a non-contiguous array");
+  return this->_get_first_elem_ptr();
+}
+
 template <int num_dimensions, typename elemT>
 bool
 Array<num_dimensions, elemT>::is_regular() const
@@ -361,6 +567,24 @@ Array<1, elemT>::resize(const int min_index, const int max_index)
   this->check_state();  
 }
 
+template <class elemT>
+void
+Array<1, elemT>::init(const IndexRange<1>& range, elemT * const data_ptr,
+                      const bool initialise_with_0)
+{
+  if (data_ptr == 0)
+    {
+      this->recycle();
+      // resize() initialises all elements to 0 in this case
+      this->resize(range.get_min_index(), range.get_max_index());
+      return;
+    }
+  this->init_from_existing_data(range.get_min_index(), range.get_max_index(), data_ptr);
+  if (initialise_with_0)
+    for (int i=this->get_min_index(); i<=this->get_max_index(); i++)
+      assign(this->num[i], 0);
+}
+
 template <class elemT>
 void
 Array<1, elemT>::resize(const IndexRange<1>& range) 
@@ -395,6 +619,13 @@ Array<1, elemT>::Array(const IndexRange<1>& range)
   grow(range);
 }
 
+template <class elemT>
+Array<1, elemT>::Array(const IndexRange<1>& range, const bool)
+: base_type()
+{
+  grow(range);
+}
+
 template <class elemT>
 Array<1, elemT>::Array(const int min_index, const int max_index)
 : base_type()
@@ -548,6 +779,34 @@ Array<1, elemT>::is_regular() const
   return true;
 }
 
+template <typename elemT>
+bool
+Array<1, elemT>::is_contiguous() const
+{
+  return true;
+}
+
+template <typename elemT>
+const elemT*
+Array<1, elemT>::_get_first_elem_ptr() const
+{
+  return this->size()==0 ? 0 : &this->num[this->get_min_index()];
+}
+
+template <typename elemT>
+elemT*
+Array<1, elemT>::get_full_data_ptr()
+{
+  return const_cast<elemT *>(this->_get_first_elem_ptr());
+}
+
+template <typename elemT>
+const elemT*
+Array<1, elemT>::get_const_full_data_ptr() const
+{
+  return this->_get_first_elem_ptr();
+}
+
 template <typename elemT>
 bool
 Array<1, elemT>::get_regular_range(
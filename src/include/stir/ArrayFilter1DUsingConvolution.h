@@ -101,6 +101,11 @@ public:
     */
   bool is_trivial() const;
 
+  //! get the kernel coefficients
+  const VectorWithOffset<elemT>& get_filter_coefficients() const;
+  //! get the boundary conditions
+  BoundaryConditions::BC get_boundary_condition() const;
+
   virtual Succeeded 
     get_influencing_indices(IndexRange<1>& influencing_indices, 
                             const IndexRange<1>& output_indices) const;
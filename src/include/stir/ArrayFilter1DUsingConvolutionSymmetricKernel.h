@@ -72,6 +72,9 @@ public:
     */
   bool is_trivial() const;
 
+  //! get the kernel coefficients (as passed to the constructor)
+  const VectorWithOffset<elemT>& get_filter_coefficients() const;
+
 private:
   VectorWithOffset< elemT> filter_coefficients;
   void do_it(Array<1,elemT>& out_array, const Array<1,elemT>& in_array) const;
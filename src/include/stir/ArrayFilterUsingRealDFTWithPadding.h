@@ -93,7 +93,8 @@ public:
       twice as long as the input and output arrays.
 
       As this function uses fourier_for_real_data(), see there for restrictions 
-      on the possible kernel length, but at time of writing, it has to be a power of 2.
+      on the possible kernel length. At time of writing, it has to be even in the last dimension.
+      Lengths that only have factors 2, 3 and 5 are fastest, see find_efficient_fourier_length().
   */
   Succeeded 
     set_kernel(const Array<num_dimensions, elemT>& real_filter_kernel);
@@ -108,7 +109,8 @@ public:
       twice as long as the input and output arrays.
 
       See fourier() for restrictions on the possible
-      kernel length, but at time of writing, it has to be a power of 2.
+      kernel length. At time of writing, the 'real' kernel has to have an even length in
+      the last dimension.
   */
   Succeeded
     set_kernel_in_frequency_space(const Array<num_dimensions, std::complex<elemT> >& kernel_in_frequency_space);
@@ -136,17 +136,46 @@ in_place_abs(Array<num_dimensions, elemT>& v)
 }
 
 
+namespace detail
+{
+  // generic case: use full_iterators
+  template <class T, class FUNCTION>
+  inline void
+  in_place_apply_function_help(T& v, FUNCTION& f, const void *)
+  {
+    typename T::full_iterator iter = v.begin_all();
+    const typename T::full_iterator end_iter = v.end_all();
+    while (iter != end_iter)
+      {
+        *iter = f(*iter);
+        ++iter;
+      }
+  }
+
+  // T is (derived from) an Array of floats: use a simple loop over contiguous memory if possible.
+  // (This is restricted to float, as for other element types, classes such as
+  // ParametricDiscretisedDensity define full_iterator differently from Array.)
+  template <class T, class FUNCTION, int num_dimensions>
+  inline void
+  in_place_apply_function_help(T& v, FUNCTION& f, Array<num_dimensions, float> * array_ptr)
+  {
+    if (!array_ptr->is_contiguous())
+      {
+        in_place_apply_function_help(v, f, static_cast<const void *>(0));
+        return;
+      }
+    float * const data_ptr = array_ptr->get_full_data_ptr();
+    const size_t size = array_ptr->size_all();
+    for (size_t i=0; i<size; ++i)
+      data_ptr[i] = f(data_ptr[i]);
+  }
+} // end of namespace detail
+
 template <class T, class FUNCTION>
 inline T& 
 in_place_apply_function(T& v, FUNCTION f)  
 {      
-  typename T::full_iterator iter = v.begin_all();
-  const typename T::full_iterator end_iter = v.end_all();
-  while (iter != end_iter)
-    {
-      *iter = f(*iter);
-       ++iter;
-    }
+  detail::in_place_apply_function_help(v, f, &v);
   return v; 
 }
 
@@ -123,6 +123,7 @@ public:
   inline DiscretisedDensity();
   
   //! Construct DiscretisedDensity of a given range of indices & origin
+  /*! All elements are stored contiguously, see Array::is_contiguous(). */
   inline DiscretisedDensity(const IndexRange<num_dimensions>& range,
     const CartesianCoordinate3D<float>& origin);	
   
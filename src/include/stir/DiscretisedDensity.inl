@@ -44,7 +44,7 @@ template<int num_dimensions, typename elemT>
 DiscretisedDensity<num_dimensions, elemT>::
 DiscretisedDensity(const IndexRange<num_dimensions>& range_v,
 		   const CartesianCoordinate3D<float>& origin_v)
-  : Array<num_dimensions,elemT>(range_v),
+  : Array<num_dimensions,elemT>(range_v, /*contiguous=*/true),
     origin(origin_v)    
 {}
 
@@ -10,6 +10,7 @@
 */
 /*
     Copyright (C) 2003- 2011, Hammersmith Imanet Ltd
+    Copyright (C) 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -44,9 +45,11 @@ START_NAMESPACE_STIR
     the function to find out what the size of the record is. In that case, all IO
     handling is completely generic and is implemented in this class.
 
-    Current implementation needs a \c max_size_of_record to allocate enough memory 
-    (on the stack) before reading. This is efficient in many cases, but impractical 
-    in others.
+    Data are read from the stream in large blocks into an internal buffer.
+    Records are then decoded directly from this buffer, such that reading a
+    record does not need any memory allocation or a call to the stream.
+    The buffer is allocated once (its size is at least a few times the
+    \c max_size_of_record).
 
     \par Requirements
     \c RecordT needs to have the following member functions
@@ -61,7 +64,9 @@ START_NAMESPACE_STIR
                          const OptionsT options);
     \endcode
 
-    \todo Allow choosing between allocation with \c new or on the stack.
+    \warning As data are read ahead, the stream position reported by the stream
+    itself does not correspond to the position of the next record. Use
+    save_get_position() and set_get_position() instead.
 */
 template <class RecordT, class OptionsT>
 class InputStreamWithRecords
@@ -94,6 +99,26 @@ public:
   virtual 
     Succeeded get_next_record(RecordT& record) const;
 
+  //! read a number of records in one go
+  /*! Will read at most \c records.size() records, starting at \c records[0].
+      \return the number of records read. If this is less than \c records.size(),
+      the end of the data was reached (or there was a read error).
+  */
+  inline
+    std::size_t get_next_records(std::vector<RecordT>& records) const;
+
+  //! read a number of records in one go, given (smart) pointers to them
+  /*! Will read at most one record for every element of the range [\a begin, \a end).
+      \a IterT has to be an iterator with elements that are pointers to RecordT, or
+      to a base class of RecordT (the objects then have to be of type RecordT).
+      This is used by CListModeData classes to read records without a virtual
+      function call per record.
+      \return the number of records read.
+  */
+  template <class IterT>
+  inline
+    std::size_t get_next_records_from_pointers(IterT begin, IterT end) const;
+
   //! go back to starting position
   inline
     Succeeded reset();
@@ -109,6 +134,13 @@ public:
   inline
   Succeeded set_get_position(const SavedPosition&);
 
+  //! save current "get" position, overwriting a previously saved value
+  /*! This can be used when a position has to be saved often, such that the
+      internal array does not keep growing.
+  */
+  inline
+  Succeeded update_saved_get_position(const SavedPosition&);
+
   //! Function that enables the user to store the saved get_positions
   /*! Together with set_saved_get_positions(), this allows 
       reinstating the saved get_positions when 
@@ -127,6 +159,18 @@ public:
 
 private:
 
+  //! Makes sure that at least \a num_bytes are available in the buffer
+  /*! If not, remaining data are moved to the start of the buffer and the rest
+      is filled from the stream.
+      \return \c false if not enough data could be read.
+  */
+  inline
+    bool fill_buffer(const std::size_t num_bytes) const;
+
+  //! Empties the buffer and sets the position to where the stream currently is
+  inline
+    void discard_buffer();
+
   const std::string filename;
   shared_ptr<std::istream> stream_ptr;
   std::streampos starting_stream_position;
@@ -136,6 +180,15 @@ private:
   const std::size_t max_size_of_record;
 
   const OptionsT options;
+
+  //! internal buffer
+  mutable std::vector<char> buffer;
+  //! position in \c buffer of the next record
+  mutable std::size_t buffer_pos;
+  //! number of valid bytes in \c buffer
+  mutable std::size_t buffer_end;
+  //! position in the stream corresponding to the start of the buffer
+  mutable std::streampos buffer_stream_position;
 };
 
 END_NAMESPACE_STIR
@@ -8,6 +8,7 @@
 /*
     Copyright (C) 2003-2011, Hammersmith Imanet Ltd
     Copyright (C) 2012-2013, Kris Thielemans
+    Copyright (C) 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -28,8 +29,9 @@
 #include "stir/Succeeded.h"
 #include "stir/is_null_ptr.h"
 #include "stir/shared_ptr.h"
-#include "boost/shared_array.hpp"
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 
 START_NAMESPACE_STIR
 template <class RecordT, class OptionsT>
@@ -41,7 +43,10 @@ InputStreamWithRecords(const shared_ptr<std::istream>& stream_ptr,
   : stream_ptr(stream_ptr),
     size_of_record_signature(size_of_record_signature),
     max_size_of_record(max_size_of_record),
-    options(options)
+    options(options),
+    buffer(std::max(std::size_t(1048576), 16*max_size_of_record)),
+    buffer_pos(0),
+    buffer_end(0)
 {
   assert(size_of_record_signature<=max_size_of_record);
   if (is_null_ptr(stream_ptr))
@@ -49,6 +54,7 @@ InputStreamWithRecords(const shared_ptr<std::istream>& stream_ptr,
   starting_stream_position = stream_ptr->tellg();
   if (!stream_ptr->good())
     error("InputStreamWithRecords: error in tellg()\n");
+  buffer_stream_position = starting_stream_position;
 }
 
 template <class RecordT, class OptionsT>
@@ -62,7 +68,10 @@ InputStreamWithRecords(const std::string& filename,
     starting_stream_position(start_of_data),
     size_of_record_signature(size_of_record_signature),
     max_size_of_record(max_size_of_record),
-    options(options)
+    options(options),
+    buffer(std::max(std::size_t(1048576), 16*max_size_of_record)),
+    buffer_pos(0),
+    buffer_end(0)
 {
   assert(size_of_record_signature<=max_size_of_record);
   std::fstream* s_ptr = new std::fstream;
@@ -73,6 +82,45 @@ InputStreamWithRecords(const std::string& filename,
 	  filename.c_str());
 }
 
+template <class RecordT, class OptionsT>
+bool
+InputStreamWithRecords<RecordT, OptionsT>::
+fill_buffer(const std::size_t num_bytes) const
+{
+  if (this->buffer_end - this->buffer_pos >= num_bytes)
+    return true;
+
+  // move remaining data to the start of the buffer
+  const std::size_t num_remaining = this->buffer_end - this->buffer_pos;
+  if (num_remaining > 0)
+    std::memmove(&this->buffer[0], &this->buffer[this->buffer_pos], num_remaining);
+  this->buffer_stream_position += static_cast<std::streamoff>(this->buffer_pos);
+  this->buffer_pos = 0;
+  this->buffer_end = num_remaining;
+
+  if (stream_ptr->eof())
+    return false;
+  stream_ptr->read(&this->buffer[num_remaining],
+                   static_cast<std::streamsize>(this->buffer.size() - num_remaining));
+  this->buffer_end += static_cast<std::size_t>(stream_ptr->gcount());
+  if (stream_ptr->bad())
+    { 
+      warning("Error after reading from list mode stream in get_next_record");
+      return false; 
+    }
+  return this->buffer_end >= num_bytes;
+}
+
+template <class RecordT, class OptionsT>
+void
+InputStreamWithRecords<RecordT, OptionsT>::
+discard_buffer()
+{
+  this->buffer_pos = 0;
+  this->buffer_end = 0;
+  this->buffer_stream_position = stream_ptr->tellg();
+}
+
 template <class RecordT, class OptionsT>
 Succeeded
 InputStreamWithRecords<RecordT, OptionsT>::
@@ -81,30 +129,51 @@ get_next_record(RecordT& record) const
   if (is_null_ptr(stream_ptr))
     return Succeeded::no;
 
-  // rely on file caching by the C++ library or the OS
   assert(this->size_of_record_signature <= this->max_size_of_record);
-  boost::shared_array<char> data_sptr(new char[this->max_size_of_record]);
-  char * data_ptr = data_sptr.get();
-  stream_ptr->read(data_ptr, this->size_of_record_signature);
-  if (stream_ptr->gcount()<static_cast<std::streamsize>(this->size_of_record_signature))
+  if (!this->fill_buffer(this->size_of_record_signature))
     return Succeeded::no; 
-  const std::size_t size_of_record = record.size_of_record_at_ptr(data_ptr, this->size_of_record_signature,options);
+  const std::size_t size_of_record =
+    record.size_of_record_at_ptr(&this->buffer[this->buffer_pos], this->size_of_record_signature,options);
   assert(size_of_record <= this->max_size_of_record);
-  if (size_of_record > this->size_of_record_signature)
-    stream_ptr->read(data_ptr + this->size_of_record_signature,
-                     size_of_record - this->size_of_record_signature);
-  if (stream_ptr->eof())
+  if (!this->fill_buffer(size_of_record))
     return Succeeded::no; 
-  else if (stream_ptr->bad())
-    { 
-      warning("Error after reading from list mode stream in get_next_record");
-      return Succeeded::no; 
-    }
+  const char * const data_ptr = &this->buffer[this->buffer_pos];
+  this->buffer_pos += size_of_record;
   return 
     record.init_from_data_ptr(data_ptr, size_of_record,options);
 }
 
+template <class RecordT, class OptionsT>
+std::size_t
+InputStreamWithRecords<RecordT, OptionsT>::
+get_next_records(std::vector<RecordT>& records) const
+{
+  std::size_t num_records_read = 0;
+  for (typename std::vector<RecordT>::iterator iter = records.begin();
+       iter != records.end();
+       ++iter, ++num_records_read)
+    {
+      if (this->get_next_record(*iter) == Succeeded::no)
+        break;
+    }
+  return num_records_read;
+}
 
+template <class RecordT, class OptionsT>
+template <class IterT>
+std::size_t
+InputStreamWithRecords<RecordT, OptionsT>::
+get_next_records_from_pointers(IterT begin, IterT end) const
+{
+  std::size_t num_records_read = 0;
+  for (IterT iter = begin; iter != end; ++iter, ++num_records_read)
+    {
+      // call this class' function directly, avoiding a virtual function call
+      if (this->InputStreamWithRecords<RecordT, OptionsT>::get_next_record(static_cast<RecordT&>(**iter)) == Succeeded::no)
+        break;
+    }
+  return num_records_read;
+}
 
 template <class RecordT, class OptionsT>
 Succeeded
@@ -120,8 +189,8 @@ reset()
   stream_ptr->seekg(starting_stream_position, std::ios::beg);
   if (stream_ptr->bad())
     return Succeeded::no;
-  else
-    return Succeeded::yes;
+  this->discard_buffer();
+  return Succeeded::yes;
 }
 
 
@@ -133,12 +202,10 @@ save_get_position()
   assert(!is_null_ptr(stream_ptr));
   // TODO should somehow check if tellg() worked and return an error if it didn't
   std::streampos pos;
-  if (!stream_ptr->eof())
+  if (this->buffer_pos < this->buffer_end || !stream_ptr->eof())
     {
-      pos = stream_ptr->tellg();
-      if (!stream_ptr->good())
-	error("InputStreamWithRecords<RecordT, OptionsT>::save_get_position\n"
-	      "Error after getting position in file");
+      // position of the next record
+      pos = this->buffer_stream_position + static_cast<std::streamoff>(this->buffer_pos);
     }
   else
     {
@@ -150,6 +217,20 @@ save_get_position()
   return saved_get_positions.size()-1;
 } 
 
+template <class RecordT, class OptionsT>
+Succeeded
+InputStreamWithRecords<RecordT, OptionsT>::
+update_saved_get_position(const typename InputStreamWithRecords<RecordT, OptionsT>::SavedPosition& pos)
+{
+  if (is_null_ptr(stream_ptr) || pos >= saved_get_positions.size())
+    return Succeeded::no;
+  // save a new position, and move it to the old place
+  this->save_get_position();
+  saved_get_positions[pos] = saved_get_positions.back();
+  saved_get_positions.pop_back();
+  return Succeeded::yes;
+}
+
 template <class RecordT, class OptionsT>
 Succeeded
 InputStreamWithRecords<RecordT, OptionsT>::
@@ -167,8 +248,8 @@ set_get_position(const typename InputStreamWithRecords<RecordT, OptionsT>::Saved
     
   if (!stream_ptr->good())
     return Succeeded::no;
-  else
-    return Succeeded::yes;
+  this->discard_buffer();
+  return Succeeded::yes;
 }
 
 template <class RecordT, class OptionsT>
@@ -0,0 +1,127 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup IO
+  \brief Declaration and implementation of classes stir::MemoryStreamBuffer and stir::MemoryIOStream
+*/
+
+#ifndef __stir_IO_MemoryStreamBuffer_H__
+#define __stir_IO_MemoryStreamBuffer_H__
+
+#include "stir/common.h"
+#include <streambuf>
+#include <istream>
+#include <ios>
+#include <climits>
+#include <cstddef>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup IO
+  \brief A \c std::streambuf that reads from and writes to a fixed block of memory
+
+  In contrast to \c std::stringbuf, the memory is not owned by this object and
+  is never reallocated. The data can therefore be accessed directly via the pointer
+  passed to the constructor, for instance by several threads at the same time.
+
+  Seeking is supported for the get and put positions separately. Reading or
+  writing past the end of the block fails, as does writing when \a writable
+  is \c false.
+*/
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  MemoryStreamBuffer(char * const data_ptr, const std::size_t size, const bool writable = true)
+  {
+    this->setg(data_ptr, data_ptr, data_ptr + size);
+    if (writable)
+      this->setp(data_ptr, data_ptr + size);
+    else
+      this->setp(0, 0);
+  }
+
+protected:
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                           std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+  {
+    const bool seek_in = (which & std::ios_base::in) != 0;
+    const bool seek_out = (which & std::ios_base::out) != 0;
+    if ((!seek_in && !seek_out) || (seek_in && seek_out && dir == std::ios_base::cur))
+      return pos_type(off_type(-1));
+    if (seek_out && this->pbase() == 0)
+      return pos_type(off_type(-1));
+
+    const off_type size = this->egptr() - this->eback();
+    off_type new_pos;
+    if (dir == std::ios_base::beg)
+      new_pos = off;
+    else if (dir == std::ios_base::end)
+      new_pos = size + off;
+    else if (seek_in)
+      new_pos = (this->gptr() - this->eback()) + off;
+    else
+      new_pos = (this->pptr() - this->pbase()) + off;
+
+    if (new_pos < 0 || new_pos > size)
+      return pos_type(off_type(-1));
+
+    if (seek_in)
+      this->setg(this->eback(), this->eback() + new_pos, this->egptr());
+    if (seek_out)
+      {
+        // pbump() takes an int, so move in steps for large buffers
+        this->setp(this->pbase(), this->epptr());
+        off_type remaining = new_pos;
+        while (remaining > 0)
+          {
+            const int step = remaining > INT_MAX ? INT_MAX : static_cast<int>(remaining);
+            this->pbump(step);
+            remaining -= step;
+          }
+      }
+    return pos_type(new_pos);
+  }
+
+  virtual pos_type seekpos(pos_type pos,
+                           std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+  {
+    return this->seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+/*!
+  \ingroup IO
+  \brief A \c std::iostream on a fixed block of memory, using MemoryStreamBuffer
+*/
+class MemoryIOStream : public std::iostream
+{
+public:
+  MemoryIOStream(char * const data_ptr, const std::size_t size, const bool writable = true)
+    : std::iostream(0), stream_buffer(data_ptr, size, writable)
+  {
+    this->rdbuf(&stream_buffer);
+  }
+
+private:
+  MemoryStreamBuffer stream_buffer;
+};
+
+END_NAMESPACE_STIR
+
+#endif
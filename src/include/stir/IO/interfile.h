@@ -222,11 +222,15 @@ write_basic_interfile(const std::string& filename,
   
   \param openmode Mode for opening the data file. ios::binary will be added by the code.
 
+  \param memory_mapped If \c true, a ProjDataMemoryMapped object is returned, which
+  maps the data file into memory.
+
   \warning it is up to the caller to deallocate the object  
 */
 ProjDataFromStream* read_interfile_PDFS(std::istream& input,
  				        const std::string& directory_for_data = "",
-					const std::ios::openmode openmode = std::ios::in);
+					const std::ios::openmode openmode = std::ios::in,
+					const bool memory_mapped = false);
 
 //! This reads the first 3D sinogram from an Interfile header, given as a filename
 /*!
@@ -239,7 +243,8 @@ ProjDataFromStream* read_interfile_PDFS(std::istream& input,
   This should normally never be used. Use ProjData::read_from_file() instead.
 */
 ProjDataFromStream* read_interfile_PDFS(const std::string& filename,
-					const std::ios::openmode open_mode);
+					const std::ios::openmode open_mode,
+					const bool memory_mapped = false);
 
 //! This writes an Interfile header appropriate for the ProjDataFromStream object.
 /*!
@@ -114,6 +114,9 @@ public:
   inline bool operator==(const IndexRange<num_dimensions>&) const;
   inline bool operator!=(const IndexRange<num_dimensions>&) const;
 
+  //! return the total number of elements in this range
+  inline size_t size_all() const;
+
   //! checks if the range is 'regular'
   inline bool is_regular() const;
 
@@ -161,6 +164,8 @@ public:
   inline int get_min_index() const;
   inline int get_max_index() const;
   inline int get_length() const;
+  //! return the total number of elements in this range (i.e. get_length())
+  inline size_t size_all() const;
 
   inline bool operator==(const IndexRange<1>& range2) const;
 
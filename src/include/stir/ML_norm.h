@@ -200,6 +200,20 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
 		       const DetectorEfficiencies& efficiencies,
 		       const int max_ring_diff, const int half_fan_size);
 
+//! Sets \a proj_data to the products of the efficiencies of the detectors in every LOR
+/*! For every bin, efficiencies[ra][a]*efficiencies[rb][b] is summed over all detector pairs
+    that contribute to the bin (i.e. taking axial compression and view mashing into account).
+    When the "efficiencies" are singles rates, this gives the randoms (up to a factor 2 tau).
+
+    The detector pairs for every view and the ring pairs for every sinogram are found
+    before the loop over bins. Sinograms of a segment are computed in parallel (when
+    using OpenMP), and the result is written a segment at a time.
+
+    \warning Can only handle non arc-corrected data with <tt>min_view_num==0</tt>.
+*/
+void set_randoms_from_efficiencies(ProjData& proj_data,
+                                   const DetectorEfficiencies& efficiencies);
+
 
 void make_block_data(BlockData3D& block_data, const FanProjData& fan_data);
 
@@ -42,8 +42,11 @@ template <typename coordT> class Coordinate3D;
   The minimum value for a 1D array of 2n+1 elements is defined as the minimum element
   of the sorted array. 
 
-  For 3D images, the current filter works by extracting all neigbours (given by 
-  the mask) to a 1D array, and getting the maximal of that array.
+  For 3D images, the filter finds the maximum of all neighbours (given by the mask).
+  For every row, this is done by first computing the maximum over z and y for every
+  column of the mask, and then taking the maximum over the 2*mask_radius_x+1 columns
+  around each pixel, see detail::apply_extremum_filter_3d(). When compiled with
+  OpenMP, planes are filtered in parallel.
 
   This implementation of the maximal filter handles edges by taking the minimum of 
   all available pixels. For instance, when a 3x3 mask is used, and the 
@@ -69,11 +72,6 @@ class MaximalArrayFilter3D: public ArrayFunctionObject_2ArgumentImplementation<3
   
   virtual void do_it(Array<3,elemT>& out_array, const Array<3,elemT>& in_array) const;
 
-  //! extract all neighbours and put them in a 1D array
-  /*! \return the number of neighbours within the image range
-   */
-  int extract_neighbours(Array<1,elemT>&,const Array<3,elemT>& array, const Coordinate3D<int>&) const;
-
 };
 
 END_NAMESPACE_STIR
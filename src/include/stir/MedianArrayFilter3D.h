@@ -45,8 +45,11 @@ template <typename coordT> class Coordinate3D;
   of the sorted array. For 2n elements, we use (sorted[n-1]+sorted[n])/2
   (starting indices from 0).
 
-  For 3D images, the current filter works by extracting all neigbours (given by 
-  the mask) to a 1D array, and getting the median of that array.
+  For 3D images, the filter finds the median of all neighbours (given by the mask).
+  This is implemented by keeping a sorted list of the neighbours, which is updated
+  incrementally when moving along the x-direction, see
+  detail::apply_sliding_window_rank_filter_3d(). When compiled with OpenMP, planes are
+  filtered in parallel.
 
   This implementation of the median filter handles edges by taking a median of 
   all available pixels. For instance, when a 3x3 mask is used, and the 
@@ -72,11 +75,6 @@ private:
   
   virtual void do_it(Array<3,elemT>& out_array, const Array<3,elemT>& in_array) const;
 
-  //! extract all neighbours and put them in a 1D array
-  /*! \return the number of neighbours within the image range
-   */
-  int extract_neighbours(Array<1,elemT>&,const Array<3,elemT>& array, const Coordinate3D<int>&) const;
-
 };
 
 END_NAMESPACE_STIR
@@ -39,6 +39,7 @@
 #include "stir/shared_ptr.h"
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 START_NAMESPACE_STIR
@@ -53,6 +54,13 @@ START_NAMESPACE_STIR
   stream isn't closed yet. This is important in an interactive context, as the object
   owning the stream might not be deleted yet before we try to read the file again.
 
+  Read operations (\c get_*) can be done concurrently by several threads if
+  positional reads have been enabled, see set_file_for_positional_reads().
+  The data are then read with \c pread() from a separate file descriptor (or
+  directly from memory for ProjDataInMemory), such that the stream (and its
+  position) is not used. Otherwise, all reads and writes are serialised via an
+  OpenMP critical section. Writes always use the stream.
+
   \warning Data have to be contiguous.
   \warning The parameter \c make_num_tangential_poss_odd (used in various 
   \c get_ functions) is temporary and will be removed soon.
@@ -141,11 +149,31 @@ public:
   //! Get scale factor
   float get_scale_factor() const;  
 
-    
+  //! Use positional reads from the given file for all \c get_* functions
+  /*! \a data_filename has to be the file that the stream refers to. It is opened
+      (read-only) a second time, such that reads do not need to use (and lock) the stream.
+      Writes still go via the stream (which is flushed after every write), such that
+      subsequent reads see the new data.
+
+      \return Succeeded::no if the file cannot be opened, or if positional reads are
+      not supported on this system. Reads will then go via the stream.
+  */
+  Succeeded set_file_for_positional_reads(const std::string& data_filename);
+
+  //! Check if reads are done without using the stream
+  bool has_positional_reads() const;
+
 protected:
   //! the stream with the data
   shared_ptr<std::iostream> sino_stream;
 
+  //! Use positional reads from memory for all \c get_* functions
+  /*! \a data_ptr has to point to the start of the memory that the stream refers to
+      (i.e. data_ptr + get_offset_in_stream() corresponds to the first element).
+      The memory has to stay valid for the lifetime of this object.
+  */
+  void set_memory_for_positional_reads(const char * const data_ptr);
+
 private:
   //! offset of the whole 3d sinogram in the stream
   std::streamoff  offset;
@@ -173,8 +201,20 @@ private:
   std::vector<std::streamoff> get_offsets(const int view_num, const int segment_num) const;
   //! Calculate offsets for sinogram data
   std::vector<std::streamoff> get_offsets_sino(const int ax_pos_num, const int segment_num) const;
-    
-  
+
+  //! file used for positional reads (closed when the last copy of this object is deleted)
+  class PositionalReadFile;
+  shared_ptr<PositionalReadFile> positional_read_file_sptr;
+  //! memory used for positional reads, 0 if none
+  const char * positional_read_data_ptr;
+
+  //! Read contiguous data starting at \a pos without using the stream
+  /*! Converts from the on-disk data type and byte order, but does not apply the scale factor. */
+  template <class ArrayT>
+    Succeeded positional_read(ArrayT& data, const std::streamoff pos) const;
+  //! Read the rows of \a data, where successive rows start \a row_stride bytes apart
+  template <class ArrayT>
+    Succeeded positional_read_rows(ArrayT& data, std::streamoff pos, const std::streamoff row_stride) const;
 };
 
 END_NAMESPACE_STIR
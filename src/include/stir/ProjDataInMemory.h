@@ -31,23 +31,12 @@
 
 /* Implementation note (KT)
    
-   I first used the std::stringstream class (when available).
-   However, this class currently has a problem that you cannot preallocate
-   a buffer size. This means that when we write to the stringstream, it will
-   grow piece by piece. For some implementations (i.e. those that keep the memory
-   contiguous), this might mean multiple reallocations and copying of data.
-   Of course, for 'smart' implementations of stringstream, this wouldn't happen.
-   Still, I've decided to not take the risk, and always use old style strstream instead.
-
-  It's not clear if strstream will ever disappear from C++, but in any case, it won't happen 
-  very soon. Still, if you no longer have strstream, or don't want to use it, you can enable 
-  the stringstream implementation by removing the next line.
+   I first used the std::stringstream class (when available), and later the old style
+   strstream, as stringstream cannot preallocate a buffer size.
+   We now allocate the buffer ourselves and use a stream with a stir::MemoryStreamBuffer.
+   As the memory never moves, this allows reading directly from memory (without
+   using the stream), such that several threads can read at the same time.
 */
-//#define STIR_USE_OLD_STRSTREAM
-
-#if defined(BOOST_NO_STRINGSTREAM) && !defined(STIR_USE_OLD_STRSTREAM)
-#define STIR_USE_OLD_STRSTREAM 
-#endif
 
 START_NAMESPACE_STIR
 
@@ -59,6 +48,8 @@ class Succeeded;
 
   Mainly useful for temporary storage of projection data.
 
+  The \c get_* functions read directly from memory, and are therefore thread-safe.
+
 */
 class ProjDataInMemory : public ProjDataFromStream
 {
@@ -91,15 +82,14 @@ public:
   float get_bin_value(Bin& bin);
     
 private:
-#ifdef STIR_USE_OLD_STRSTREAM
   // an auto_ptr doesn't work in gcc 2.95.2 because of assignment problems, so we use shared_array
   // note however that the buffer is not shared. we just use it such that its memory gets 
   // deallocated automatically.
   boost::shared_array<char> buffer;
-#else
-#endif
   
   size_t get_size_of_buffer() const;
+  //! allocate the buffer and create the stream
+  void create_buffer(const bool initialise_with_0);
 };
 
 END_NAMESPACE_STIR
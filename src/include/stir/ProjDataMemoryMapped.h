@@ -0,0 +1,89 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup projdata
+  \brief Declaration of class stir::ProjDataMemoryMapped
+*/
+
+#ifndef __stir_ProjDataMemoryMapped_H__
+#define __stir_ProjDataMemoryMapped_H__
+
+#include "stir/ProjDataFromStream.h"
+#include "stir/shared_ptr.h"
+#include <string>
+#include <vector>
+
+namespace boost {
+  namespace interprocess {
+    class file_mapping;
+    class mapped_region;
+  }
+}
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup projdata
+  \brief A class which maps the raw data file of projection data into memory.
+
+  All \c get_* functions read directly from the mapped memory (converting
+  data type and byte order and applying the scale factor for the requested data
+  only), such that the data are not copied via \c iostream buffers, reads are
+  thread-safe, and the operating system can share the pages between processes
+  that read the same file.
+
+  If the file is opened with \c std::ios::out, the file is mapped read-write and the
+  \c set_* functions modify the mapped pages, which the operating system writes back
+  to the file. Call flush() to force this. The file has to be large enough already,
+  i.e. this class cannot be used to create new files.
+
+  Normally you would not construct this object yourself, but use
+  ProjData::read_from_file() with a filename like <tt>sino.hs,mmap</tt>.
+*/
+class ProjDataMemoryMapped : public ProjDataFromStream
+{
+public:
+  //! constructor taking all necessary parameters
+  /*!
+    \param data_filename the name of the file with the raw data (not the header)
+    \param open_mode currently only \c std::ios::in and \c std::ios::out are taken into account
+    See ProjDataFromStream for the other parameters. Calls error() if the file
+    cannot be mapped or is too small.
+  */
+  ProjDataMemoryMapped(shared_ptr<ExamInfo> const& exam_info_sptr,
+                       shared_ptr<ProjDataInfo> const& proj_data_info_sptr,
+                       const std::string& data_filename,
+                       const std::ios::openmode open_mode,
+                       const std::streamoff offset_in_file,
+                       const std::vector<int>& segment_sequence_in_file,
+                       StorageOrder o = Segment_View_AxialPos_TangPos,
+                       NumericType data_type = NumericType::FLOAT,
+                       ByteOrder byte_order = ByteOrder::native,
+                       float scale_factor = 1);
+
+  //! write modified pages to disk
+  Succeeded flush();
+
+private:
+  shared_ptr<boost::interprocess::file_mapping> file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> region_sptr;
+};
+
+END_NAMESPACE_STIR
+
+#endif
@@ -69,11 +69,17 @@ public:
 		    const int segment_num);
   
   //! Constructor that sets sizes via the ProjDataInfo object, initialising data to 0
+  /*!
+      If \a contiguous is \c true, all elements are stored in a single block of memory,
+      see Array::is_contiguous().
+  */
   SegmentBySinogram(const shared_ptr<ProjDataInfo>& proj_data_info_ptr_v,
-		    const int segment_num);
+		    const int segment_num,
+                    const bool contiguous = false);
 
   
   //! Conversion from 1 storage order to the other
+  /*! The result is contiguous if the argument is contiguous. */
   SegmentBySinogram (const SegmentByView<elemT>& );
   //! Get storage order 
   inline StorageOrder get_storage_order() const;
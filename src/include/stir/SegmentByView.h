@@ -68,11 +68,17 @@ public:
 		const int segment_num);
 
   //! Constructor that sets sizes via the ProjDataInfo object, initialising data to 0
+  /*!
+      If \a contiguous is \c true, all elements are stored in a single block of memory,
+      see Array::is_contiguous().
+  */
   SegmentByView(const shared_ptr<ProjDataInfo>& proj_data_info_ptr,
-		const int segment_num);
+		const int segment_num,
+                const bool contiguous = false);
 
   
   //! Conversion from 1 storage order to the other
+  /*! The result is contiguous if the argument is contiguous. */
   SegmentByView(const SegmentBySinogram<elemT>& );
   
   //TODO ? how to declare a conversion routine that works for any Segment ?
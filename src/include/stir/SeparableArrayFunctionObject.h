@@ -71,6 +71,20 @@ protected:
   VectorWithOffset< shared_ptr<ArrayFunctionObject<1,elemT> > > all_1d_array_filters;
   virtual void do_it(Array<num_dimensions,elemT>& array) const;
 
+private:
+  //! fast implementation when all 1D filters are convolutions
+  /*! This works on contiguous arrays with a regular range, and is used when
+      all (non-trivial) 1D filters are ArrayFilter1DUsingConvolution or 
+      ArrayFilter1DUsingConvolutionSymmetricKernel objects.
+      Many lines are filtered at the same time (i.e. the innermost loop is over
+      neighbouring lines when possible), and the work is distributed over
+      threads when OpenMP is enabled.
+
+      \return \c false if the conditions are not satisfied, in which case 
+      \a array is not modified.
+  */
+  bool do_it_using_separable_convolution(Array<num_dimensions,elemT>& array) const;
+
 };
 
 
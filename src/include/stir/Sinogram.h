@@ -69,8 +69,13 @@ public:
 
 public:
   //! Construct sinogram from proj_data_info pointer, ring and segment number.  Data are set to 0.
+  /*!
+      If \a contiguous is \c true, all elements are stored in a single block of memory,
+      see Array::is_contiguous().
+  */
   inline Sinogram(const shared_ptr<ProjDataInfo>& proj_data_info_ptr, 
-                  const int ax_pos_num, const int segment_num); 
+                  const int ax_pos_num, const int segment_num,
+                  const bool contiguous = false); 
 
   //! Construct sinogram with data set to the array.
   inline Sinogram(const Array<2,elemT>& p,const shared_ptr<ProjDataInfo >& proj_data_info_ptr, 
@@ -127,12 +127,14 @@ Sinogram(const Array<2,elemT>& p,
 template <typename elemT>
 Sinogram<elemT>::
 Sinogram(const shared_ptr<ProjDataInfo >& pdi_ptr, 
-         const int ax_pos_num, const int s_num) 
+         const int ax_pos_num, const int s_num,
+         const bool contiguous) 
   :
   Array<2,elemT>(IndexRange2D (pdi_ptr->get_min_view_num(),
 			       pdi_ptr->get_max_view_num(),
 			       pdi_ptr->get_min_tangential_pos_num(),
-			       pdi_ptr->get_max_tangential_pos_num())), 
+			       pdi_ptr->get_max_tangential_pos_num()),
+                 contiguous), 
   proj_data_info_ptr(pdi_ptr),
   axial_pos_num(ax_pos_num),
   segment_num(s_num)
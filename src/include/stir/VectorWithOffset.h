@@ -378,6 +378,14 @@ protected:
   
   //! pointer to (*this)[0] (taking get_min_index() into account that is).
   T *num;	
+
+  //! change the vector to use existing data (no initialisation)
+  /*! Any memory owned by the object is deallocated first. The object will not own
+      the new memory, i.e. owns_memory_for_data() will return \c false.
+      This is used by Array to allocate all its elements in one block.
+  */
+  inline void init_from_existing_data(const int min_index, const int max_index,
+                                      T * const data_ptr);
   
   //! Called internally to see if all variables are consistent
   inline void check_state() const;
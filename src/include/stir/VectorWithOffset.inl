@@ -303,6 +303,28 @@ VectorWithOffset(const int min_index, const int max_index,
   this->check_state();
 }
 
+template <class T>
+void
+VectorWithOffset<T>::
+init_from_existing_data(const int min_index, const int max_index,
+                        T * const data_ptr)
+{
+  this->check_state();
+  this->_destruct_and_deallocate();
+  this->_owns_memory_for_data = false;
+  if (max_index < min_index)
+    {
+      this->init();
+      return;
+    }
+  this->length = static_cast<unsigned>(max_index - min_index) + 1;
+  this->start = min_index;
+  this->begin_allocated_memory = data_ptr;
+  this->end_allocated_memory = data_ptr + this->length;
+  this->num = this->begin_allocated_memory - this->start;
+  this->check_state();
+}
+
 template <class T>
 VectorWithOffset<T>::~VectorWithOffset()
 { 
@@ -69,8 +69,13 @@ public:
 
 public:
   //! Construct from proj_data_info pointer, view and segment number. Data are set to 0.
+  /*!
+      If \a contiguous is \c true, all elements are stored in a single block of memory,
+      see Array::is_contiguous().
+  */
   inline Viewgram(const shared_ptr<ProjDataInfo>& proj_data_info_ptr, 
-                  const int v_num, const int s_num); 
+                  const int v_num, const int s_num,
+                  const bool contiguous = false); 
 
   //! Construct with data set to the array.
   inline Viewgram(const Array<2,elemT>& p,const shared_ptr<ProjDataInfo>& proj_data_info_ptr, 
@@ -123,12 +123,14 @@ Viewgram(const Array<2,elemT>& p,
 template <typename elemT>
 Viewgram<elemT>::
 Viewgram(const shared_ptr<ProjDataInfo>& pdi_ptr, 
-	 const int v_num, const int s_num) 
+	 const int v_num, const int s_num,
+         const bool contiguous) 
   : 
   Array<2,elemT>(IndexRange2D (pdi_ptr->get_min_axial_pos_num(s_num),
 			       pdi_ptr->get_max_axial_pos_num(s_num),
 			       pdi_ptr->get_min_tangential_pos_num(),
-			       pdi_ptr->get_max_tangential_pos_num())), 
+			       pdi_ptr->get_max_tangential_pos_num()),
+                 contiguous), 
   proj_data_info_ptr(pdi_ptr),
   view_num(v_num),
   segment_num(s_num)
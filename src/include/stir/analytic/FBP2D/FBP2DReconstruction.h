@@ -146,6 +146,11 @@ public:
       2 (filtered-viewgrams). Defaults to 0.
    */
   int display_level;
+  //! maximum amount of memory (in MB) for the extra images used by the threads during back projection
+  /*! Defaults to ImageAccumulationBuffers::default_max_memory_in_MB. Ignored without OpenMP.
+      \see ImageAccumulationBuffers
+  */
+  int max_memory_for_accumulation_buffers_in_MB;
  private:
   Succeeded actual_reconstruct(shared_ptr<DiscretisedDensity<3,float> > const & target_image_ptr);
 
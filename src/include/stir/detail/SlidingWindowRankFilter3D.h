@@ -0,0 +1,288 @@
+/*!
+  \file
+  \ingroup buildblock_detail
+  \brief Implementation of sliding-window algorithms for rank filters (median, minimum, maximum) on 3D arrays
+
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#ifndef __stir_detail_SlidingWindowRankFilter3D_H__
+#define __stir_detail_SlidingWindowRankFilter3D_H__
+
+#include "stir/Array.h"
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace stir {
+  namespace detail {
+
+    /*! \ingroup buildblock_detail
+       \brief function object returning the median of a sorted (non-empty) sequence
+
+       For an even number of elements, the average of the 2 middle elements is returned.
+    */
+    struct median_of_sorted
+    {
+      template <typename elemT>
+      elemT operator()(const elemT * sorted, const std::size_t n) const
+      {
+        if (n%2==1)
+          return sorted[n/2];
+        else
+          return (sorted[n/2]+sorted[n/2 - 1])/2;
+      }
+    };
+
+    /*! \ingroup buildblock_detail
+       \brief Finds the rows of \a in_array that are in the box around (z,y), apart from the x-range
+    */
+    template <typename elemT>
+    inline void
+    find_rows_in_box(std::vector<const Array<1,elemT>*>& rows, const Array<3,elemT>& in_array,
+                     const int z, const int y, const int mask_radius_z, const int mask_radius_y)
+    {
+      rows.clear();
+      for (int z_in=std::max(z-mask_radius_z, in_array.get_min_index());
+           z_in<=std::min(z+mask_radius_z, in_array.get_max_index());
+           ++z_in)
+        for (int y_in=std::max(y-mask_radius_y, in_array[z_in].get_min_index());
+             y_in<=std::min(y+mask_radius_y, in_array[z_in].get_max_index());
+             ++y_in)
+          rows.push_back(&in_array[z_in][y_in]);
+    }
+
+    /*! \ingroup buildblock_detail
+       \brief Applies a rank filter over a box of size (2*mask_radius_z+1, 2*mask_radius_y+1, 2*mask_radius_x+1)
+
+       For every element of \a out_array, all elements of \a in_array in the box centred
+       on the same index are collected, and \a rank_function is called with those values
+       in sorted order (as a pointer and the number of elements). Only elements within the
+       index range of \a in_array are used, so at the edges fewer elements are used.
+       Elements of \a out_array for which there are no elements in the box are not modified.
+
+       Instead of collecting and sorting all elements in the box for every voxel, a sorted
+       window is kept while moving along a row. The values in the box for a given x
+       (a "column") are sorted once. When moving to the next voxel, the column that leaves
+       the box is removed from the window and the column that enters the box is merged in,
+       all in a single pass over the window.
+
+       When compiled with OpenMP, different planes are computed by different threads.
+
+       \warning \a out_array and \a in_array cannot be the same object.
+       \warning results are undefined if \a in_array contains NaNs.
+    */
+    template <typename elemT, typename RankFunctionT>
+    void
+    apply_sliding_window_rank_filter_3d(Array<3,elemT>& out_array, const Array<3,elemT>& in_array,
+                                        const int mask_radius_z, const int mask_radius_y, const int mask_radius_x,
+                                        RankFunctionT rank_function)
+    {
+      const int min_z = out_array.get_min_index();
+      const int max_z = out_array.get_max_index();
+      const std::size_t max_column_size =
+        static_cast<std::size_t>(2*mask_radius_z+1)*(2*mask_radius_y+1);
+      const std::size_t max_window_size = max_column_size*(2*mask_radius_x+1);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int z=min_z; z<=max_z; ++z)
+        {
+          // rows of in_array that are in the box (apart from the x-range)
+          std::vector<const Array<1,elemT>*> rows;
+          // sorted columns, each stored in max_column_size elements
+          std::vector<elemT> columns;
+          std::vector<std::size_t> column_sizes;
+          // sorted values in the box, and a buffer for the next window
+          std::vector<elemT> window(max_window_size), next_window(max_window_size);
+
+          for (int y=out_array[z].get_min_index(); y<=out_array[z].get_max_index(); ++y)
+            {
+              Array<1,elemT>& out_row = out_array[z][y];
+              const int min_x = out_row.get_min_index();
+              const int max_x = out_row.get_max_index();
+              if (min_x > max_x)
+                continue;
+
+              find_rows_in_box(rows, in_array, z, y, mask_radius_z, mask_radius_y);
+              if (rows.empty())
+                continue;
+
+              // sort all columns that we need (column x_in is stored at index x_in-first_x_in)
+              const int first_x_in = min_x-mask_radius_x;
+              const int last_x_in = max_x+mask_radius_x;
+              columns.resize(static_cast<std::size_t>(last_x_in-first_x_in+1)*max_column_size);
+              column_sizes.assign(last_x_in-first_x_in+1, 0);
+              for (typename std::vector<const Array<1,elemT>*>::const_iterator row_iter = rows.begin();
+                   row_iter != rows.end(); ++row_iter)
+                {
+                  const Array<1,elemT>& row = **row_iter;
+                  for (int x_in=std::max(first_x_in, row.get_min_index());
+                       x_in<=std::min(last_x_in, row.get_max_index());
+                       ++x_in)
+                    {
+                      const std::size_t c = x_in-first_x_in;
+                      columns[c*max_column_size + column_sizes[c]++] = row[x_in];
+                    }
+                }
+              for (std::size_t c=0; c<column_sizes.size(); ++c)
+                std::sort(columns.begin() + c*max_column_size,
+                          columns.begin() + c*max_column_size + column_sizes[c]);
+
+              // fill window for the first voxel
+              std::size_t window_size = 0;
+              for (std::size_t c=0; c<static_cast<std::size_t>(2*mask_radius_x+1); ++c)
+                {
+                  std::copy(columns.begin() + c*max_column_size,
+                            columns.begin() + c*max_column_size + column_sizes[c],
+                            window.begin() + window_size);
+                  window_size += column_sizes[c];
+                }
+              std::sort(window.begin(), window.begin() + window_size);
+
+              for (int x=min_x; ; )
+                {
+                  if (window_size>0)
+                    out_row[x] = rank_function(&window[0], window_size);
+
+                  if (++x > max_x)
+                    break;
+
+                  // slide the window: remove column x-1-mask_radius_x, add column x+mask_radius_x
+                  const std::size_t c_leaving = x-1-mask_radius_x-first_x_in;
+                  const std::size_t c_entering = x+mask_radius_x-first_x_in;
+                  const elemT * leaving = &columns[0] + c_leaving*max_column_size;
+                  const elemT * const leaving_end = leaving + column_sizes[c_leaving];
+                  const elemT * entering = &columns[0] + c_entering*max_column_size;
+                  const elemT * const entering_end = entering + column_sizes[c_entering];
+                  if (leaving == leaving_end && entering == entering_end)
+                    continue;
+
+                  elemT * out = &next_window[0];
+                  for (const elemT * w = &window[0]; w != &window[0] + window_size; ++w)
+                    {
+                      // all leaving values are in the window, and both are sorted
+                      if (leaving != leaving_end && *leaving == *w)
+                        {
+                          ++leaving;
+                          continue;
+                        }
+                      while (entering != entering_end && *entering < *w)
+                        *out++ = *entering++;
+                      *out++ = *w;
+                    }
+                  out = std::copy(entering, entering_end, out);
+                  window_size = out - &next_window[0];
+                  window.swap(next_window);
+                }
+            }
+        }
+    }
+
+    /*! \ingroup buildblock_detail
+       \brief Applies a minimum or maximum filter over a box of size (2*mask_radius_z+1, 2*mask_radius_y+1, 2*mask_radius_x+1)
+
+       Edges are handled as in apply_sliding_window_rank_filter_3d(). The result is the element
+       \a v in the box for which \a compare(v,w) is \c true for all other elements \a w,
+       i.e. use \c std::less for a minimum filter and \c std::greater for a maximum filter.
+
+       The extremum over the box is found by first finding the extremum for every column,
+       and then the extremum over the columns in the box.
+
+       When compiled with OpenMP, different planes are computed by different threads.
+
+       \warning \a out_array and \a in_array cannot be the same object.
+    */
+    template <typename elemT, typename CompareT>
+    void
+    apply_extremum_filter_3d(Array<3,elemT>& out_array, const Array<3,elemT>& in_array,
+                             const int mask_radius_z, const int mask_radius_y, const int mask_radius_x,
+                             CompareT compare)
+    {
+      const int min_z = out_array.get_min_index();
+      const int max_z = out_array.get_max_index();
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int z=min_z; z<=max_z; ++z)
+        {
+          std::vector<const Array<1,elemT>*> rows;
+          // extremum for every column, and if there are any values in the column
+          std::vector<elemT> column_extrema;
+          std::vector<bool> column_is_empty;
+
+          for (int y=out_array[z].get_min_index(); y<=out_array[z].get_max_index(); ++y)
+            {
+              Array<1,elemT>& out_row = out_array[z][y];
+              const int min_x = out_row.get_min_index();
+              const int max_x = out_row.get_max_index();
+              if (min_x > max_x)
+                continue;
+
+              find_rows_in_box(rows, in_array, z, y, mask_radius_z, mask_radius_y);
+              if (rows.empty())
+                continue;
+
+              const int first_x_in = min_x-mask_radius_x;
+              const int last_x_in = max_x+mask_radius_x;
+              column_extrema.resize(last_x_in-first_x_in+1);
+              column_is_empty.assign(last_x_in-first_x_in+1, true);
+              for (typename std::vector<const Array<1,elemT>*>::const_iterator row_iter = rows.begin();
+                   row_iter != rows.end(); ++row_iter)
+                {
+                  const Array<1,elemT>& row = **row_iter;
+                  for (int x_in=std::max(first_x_in, row.get_min_index());
+                       x_in<=std::min(last_x_in, row.get_max_index());
+                       ++x_in)
+                    {
+                      const std::size_t c = x_in-first_x_in;
+                      if (column_is_empty[c] || compare(row[x_in], column_extrema[c]))
+                        {
+                          column_extrema[c] = row[x_in];
+                          column_is_empty[c] = false;
+                        }
+                    }
+                }
+
+              for (int x=min_x; x<=max_x; ++x)
+                {
+                  bool found = false;
+                  elemT extremum = elemT();
+                  for (std::size_t c=x-mask_radius_x-first_x_in; c<=static_cast<std::size_t>(x+mask_radius_x-first_x_in); ++c)
+                    {
+                      if (column_is_empty[c])
+                        continue;
+                      if (!found || compare(column_extrema[c], extremum))
+                        {
+                          extremum = column_extrema[c];
+                          found = true;
+                        }
+                    }
+                  if (found)
+                    out_row[x] = extremum;
+                }
+            }
+        }
+    }
+
+  } // end namespace detail
+} // end namespace stir
+
+#endif
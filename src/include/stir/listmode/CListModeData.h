@@ -29,6 +29,7 @@
 #include "stir/Scanner.h"
 #include "stir/shared_ptr.h"
 #include <string>
+#include <vector>
 #include <ctime>
 
 #include "stir/IO/ExamData.h"
@@ -185,6 +186,20 @@ public:
   virtual 
     Succeeded get_next_record(CListRecord& event) const = 0;
 
+  //! Gets a number of records in one go
+  /*! Reads at most \c records.size() records. Any null pointers in \a records
+      are first filled in with get_empty_record_sptr(). Therefore, if the same
+      vector is used for every call, no memory is allocated after the first call.
+
+      \return the number of records read. If this is less than \c records.size(),
+      the end of the data has been reached.
+
+      The default implementation calls get_next_record() for every element.
+      Classes that read from a stream override it to avoid a virtual function call per record.
+  */
+  virtual
+    std::size_t get_next_records(std::vector<shared_ptr<CListRecord> >& records) const;
+
   //! Call this function if you want to re-start reading at the beginning.
   virtual 
     Succeeded reset() = 0;
@@ -215,6 +230,16 @@ public:
   virtual
     Succeeded set_get_position(const SavedPosition&) = 0;
 
+  //! Save the current reading position, overwriting a previously saved position
+  /*! This can be used to avoid that the number of saved positions keeps growing when
+      a position has to be saved often.
+
+      The default implementation returns Succeeded::no, in which case the caller
+      should use save_get_position() instead.
+  */
+  virtual
+    Succeeded update_saved_get_position(const SavedPosition&);
+
   //! Get scanner pointer  
   /*! Returns a pointer to a scanner object that is appropriate for the 
       list mode data that is being read.
@@ -233,6 +258,10 @@ public:
   }
 
 protected:
+  //! Replaces null pointers in \a records by get_empty_record_sptr()
+  /*! Helper function for implementations of get_next_records(). */
+  void create_empty_records(std::vector<shared_ptr<CListRecord> >& records) const;
+
   //! Has to be set by the derived class
   shared_ptr<Scanner> scanner_sptr;
   //! Has to be set by the derived class
@@ -63,6 +63,10 @@ public:
   virtual 
     Succeeded get_next_record(CListRecord& record) const;
 
+  //! Gets a number of records in one go, without a virtual function call per record
+  virtual
+    std::size_t get_next_records(std::vector<shared_ptr<CListRecord> >& records) const;
+
   virtual 
     Succeeded reset();
 
@@ -72,6 +76,9 @@ public:
   virtual
     Succeeded set_get_position(const SavedPosition&);
 
+  virtual
+    Succeeded update_saved_get_position(const SavedPosition&);
+
   //! returns \c true, as ECAT listmode data stores delayed events (and prompts)
   /*! \todo this might depend on the acquisition parameters */
   virtual bool has_delayeds() const { return true; }
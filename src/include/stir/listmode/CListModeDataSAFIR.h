@@ -67,6 +67,8 @@ public:
 	virtual std::string get_name() const;
 	virtual shared_ptr <CListRecord> get_empty_record_sptr() const;
 	virtual Succeeded get_next_record(CListRecord& record_of_general_type) const;
+	//! Gets a number of records in one go, without a virtual function call per record
+	virtual std::size_t get_next_records(std::vector<shared_ptr<CListRecord> >& records) const;
 	virtual Succeeded reset();
 	
 	/*!
@@ -78,6 +80,8 @@ public:
 	{ return static_cast<SavedPosition>(current_lm_data_ptr->save_get_position()); }
 	virtual Succeeded set_get_position(const SavedPosition& pos)
 	{ return current_lm_data_ptr->set_get_position(pos); }
+	virtual Succeeded update_saved_get_position(const SavedPosition& pos)
+	{ return current_lm_data_ptr->update_saved_get_position(pos); }
 
 	/*! 
 	Returns just false in the moment.
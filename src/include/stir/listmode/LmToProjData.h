@@ -14,6 +14,7 @@
 */
 /*
     Copyright (C) 2000- 2009, Hammersmith Imanet Ltd
+    Copyright (C) 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -108,6 +109,12 @@ class CListTime;
     ; if you're short of RAM (i.e. a single projdata does not fit into memory),
     ; you can use this to process the list mode data in multiple passes.
     num_segments_in_memory := -1
+    ; alternatively, bin directly into memory mapped output files, such that
+    ; the list mode data is read only once (see below)
+    use memory mapped output := 0
+
+    ; bin events with multiple threads (only when compiled with OpenMP, see below)
+    parallel binning := 0
 
   End := 
   \endverbatim
@@ -143,6 +150,34 @@ class CListTime;
   </li>
   </ul>
 
+  \par Memory mapped output
+
+  When <tt>use memory mapped output</tt> is set, the output file for every time
+  frame is created with its final size and memory mapped. Events are then
+  added directly in the mapped file, i.e. all segments are processed in a single
+  pass through the list mode data, and the operating system takes care of
+  writing parts of the data to disk if they do not fit into memory.
+  \c num_segments_in_memory is then ignored. If no normalisation is used, the data
+  are stored as (signed) integers, otherwise as floats.
+
+  \par Parallel binning
+
+  When <tt>parallel binning</tt> is set (and STIR was compiled with OpenMP), 
+  records are read sequentially in batches and the events in every batch are
+  then binned by multiple threads. Every thread adds its events into its own
+  partial sinograms, which are summed at the end of the time frame. When using memory
+  mapped output, events are added atomically in the mapped file instead.
+  Time frame boundaries and the number of events are identical to the serial case.
+  When normalisation is used, batches are ended at every time tag such that the same
+  time is used for the normalisation factors as in the serial case. This mode is only
+  used when binning by time frames (not when using \c num_events_to_store) and
+  is ignored when listing event coordinates.
+
+  \warning In parallel binning mode, get_bin_from_event() and do_post_normalisation()
+  are called from multiple threads, and process_new_time_event() might be called
+  before all events preceding the time tag are binned. Derived classes
+  where this is a problem should set \c parallel_binning to \c false.
+
   \par Notes for developers
 
   The class provides several
@@ -225,6 +260,8 @@ protected:
   bool store_prompts;
   bool store_delayeds;
   int num_segments_in_memory;
+  bool use_memory_mapped_output;
+  bool parallel_binning;
   long int num_events_to_store;
   int max_segment_num_to_process;
 
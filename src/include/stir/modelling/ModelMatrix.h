@@ -67,6 +67,8 @@ public:
   //! Function to set _is_calibrated boolean true or false
    inline void set_if_uncalibrated(const bool is_uncalibrated);
    inline void set_if_in_correct_scale(const bool in_correct_scale);
+   //! Returns \c true if the model matrix has been scaled (or was set to be in the correct scale)
+   inline bool get_if_in_correct_scale() const;
   //!@}
 
   //! Function to give the threshold_value to the all elements of the model_array which lower value than the threshold_value.  
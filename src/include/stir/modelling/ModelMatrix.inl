@@ -165,6 +165,12 @@ void ModelMatrix<num_param>::
 set_if_in_correct_scale(const bool in_correct_scale) 
 {  this->_in_correct_scale=in_correct_scale; }
 
+template <int num_param> 
+bool
+ModelMatrix<num_param>::
+get_if_in_correct_scale() const
+{  return this->_in_correct_scale; }
+
 template <int num_param> 
 void ModelMatrix<num_param>::
 uncalibrate(const float cal_factor)
@@ -251,26 +257,34 @@ multiply_dynamic_image_with_model_and_add_to_input(ParametricVoxelsOnCartesianGr
   assert(dynamic_image.get_time_frame_definitions().get_num_frames()==static_cast<unsigned int> (model_array_max[2]));
   assert(model_array_max[1]-model_array_min[1]+1==num_param);
 
+  // Planes are handled by different threads. For every plane, we loop over the frames
+  // such that the parametric plane stays in cache, and the loop over voxels in a row can be vectorised.
   const int min_k_index = dynamic_image[1].get_min_index(); 
   const int max_k_index = dynamic_image[1].get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for ( int k = min_k_index; k<= max_k_index; ++k)
-    {
-      const int min_j_index = dynamic_image[1][k].get_min_index(); 
-      const int max_j_index = dynamic_image[1][k].get_max_index();
-      for ( int j = min_j_index; j<= max_j_index; ++j)
-        {
-          const int min_i_index = dynamic_image[1][k][j].get_min_index(); 
-          const int max_i_index = dynamic_image[1][k][j].get_max_index();
-          for ( int i = min_i_index; i<= max_i_index; ++i)
-            for(int param_num = model_array_min[1];param_num<=model_array_max[1] ; ++param_num)
-              {
-                float sum_over_frames=0.F;
-                for(int frame_num = model_array_min[2];frame_num<=model_array_max[2] ; ++frame_num)
-                  sum_over_frames+=this->_model_array[param_num][frame_num]*dynamic_image[frame_num][k][j][i]; 
-                parametric_image[k][j][i][param_num]+=sum_over_frames;
-              }
-        }
-    }
+    for(int frame_num = model_array_min[2];frame_num<=model_array_max[2] ; ++frame_num)
+      {
+        float model_values[num_param];
+        for(int param_num = model_array_min[1];param_num<=model_array_max[1] ; ++param_num)
+          model_values[param_num-model_array_min[1]] = this->_model_array[param_num][frame_num];
+
+        const Array<2,float>& frame_plane = dynamic_image[frame_num][k];
+        const int min_j_index = frame_plane.get_min_index(); 
+        const int max_j_index = frame_plane.get_max_index();
+        for ( int j = min_j_index; j<= max_j_index; ++j)
+          {
+            const Array<1,float>& frame_row = frame_plane[j];
+            Array<1,KineticParameters<num_param,float> >& parametric_row = parametric_image[k][j];
+            const int min_i_index = frame_row.get_min_index(); 
+            const int max_i_index = frame_row.get_max_index();
+            for ( int i = min_i_index; i<= max_i_index; ++i)
+              for(int p = 0; p<num_param; ++p)
+                parametric_row[i][p+model_array_min[1]] += model_values[p]*frame_row[i];
+          }
+      }
 }
 
 template<int num_param>
@@ -300,26 +314,37 @@ multiply_parametric_image_with_model_and_add_to_input(DynamicDiscretisedDensity
   assert(dynamic_image.get_time_frame_definitions().get_num_frames()==static_cast<unsigned int> (model_array_max[2]));
   assert(model_array_max[1]-model_array_min[1]+1==num_param);
 
+  // Planes are handled by different threads, and the loop over voxels in a row can be vectorised.
   const int min_k_index = dynamic_image[1].get_min_index(); 
   const int max_k_index = dynamic_image[1].get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for ( int k = min_k_index; k<= max_k_index; ++k)
-    {
-      const int min_j_index = dynamic_image[1][k].get_min_index(); 
-      const int max_j_index = dynamic_image[1][k].get_max_index();
-      for ( int j = min_j_index; j<= max_j_index; ++j)
-        {
-          const int min_i_index = dynamic_image[1][k][j].get_min_index(); 
-          const int max_i_index = dynamic_image[1][k][j].get_max_index();
-          for ( int i = min_i_index; i<= max_i_index; ++i)
-            for(int frame_num = model_array_min[2];frame_num<=model_array_max[2] ; ++frame_num)  
+    for(int frame_num = model_array_min[2];frame_num<=model_array_max[2] ; ++frame_num)
+      {
+        float model_values[num_param];
+        for(int param_num = model_array_min[1];param_num<=model_array_max[1] ; ++param_num)
+          model_values[param_num-model_array_min[1]] = this->_model_array[param_num][frame_num];
+
+        Array<2,float>& frame_plane = dynamic_image[frame_num][k];
+        const int min_j_index = frame_plane.get_min_index(); 
+        const int max_j_index = frame_plane.get_max_index();
+        for ( int j = min_j_index; j<= max_j_index; ++j)
           {
-            float sum_over_param=0.F;
-            for(int param_num = model_array_min[1];param_num<=model_array_max[1] ; ++param_num)
-              sum_over_param+=parametric_image[k][j][i][param_num]*this->_model_array[param_num][frame_num]; 
-            dynamic_image[frame_num][k][j][i]=sum_over_param;
+            Array<1,float>& frame_row = frame_plane[j];
+            const Array<1,KineticParameters<num_param,float> >& parametric_row = parametric_image[k][j];
+            const int min_i_index = frame_row.get_min_index(); 
+            const int max_i_index = frame_row.get_max_index();
+            for ( int i = min_i_index; i<= max_i_index; ++i)
+              {
+                float sum_over_param=0.F;
+                for(int p = 0; p<num_param; ++p)
+                  sum_over_param += parametric_row[i][p+model_array_min[1]]*model_values[p];
+                frame_row[i]=sum_over_param;
+              }
           }
-        }
-    }
+      }
 }
 
 template<int num_param>
@@ -128,9 +128,36 @@ class PatlakPlot : public RegisteredParsingObject<PatlakPlot, KineticModel>
 					      const ParametricVoxelsOnCartesianGrid & par_image) const;
 
     //! This is the common method used to estimate the parametric images from the dynamic images. 
+    /*! The linear regression uses the same x-coordinates and weights for every voxel, so the
+      slope and intercept are a weighted sum of the frames, see get_linear_regression_weights().
+      Planes are computed by different threads when using OpenMP.
+    */
     void 
       apply_linear_regression(ParametricVoxelsOnCartesianGrid & par_image, const DynamicDiscretisedDensity & dyn_image) const;
 
+    //! Adds the contribution of a single frame to the result of apply_linear_regression()
+    /*! Calling this for every frame (after setting \a par_image to 0) gives the same result as
+      apply_linear_regression(), but only a single frame needs to be in memory at any time.
+      Frames before the starting frame do not contribute.
+      \a scanner_default_bin_size is used to scale the model matrix (see DynamicDiscretisedDensity::get_scanner_default_bin_size()).
+    */
+    void
+      add_frame_to_linear_regression(ParametricVoxelsOnCartesianGrid & par_image,
+                                     const DiscretisedDensity<3,float> & frame_image,
+                                     const unsigned int frame_num,
+                                     const float scanner_default_bin_size) const;
+
+    //! Gets the weight of every frame for the slope and intercept of the linear regression
+    /*! The Patlak plot fits \f$y_f = \mathrm{slope}\ x_f + \mathrm{intercept}\f$ for frames from the
+      starting frame onwards, with \f$x_f\f$ the ratio of the 2 columns of the model matrix and \f$y_f\f$
+      the voxel value divided by the 2nd column. As the fit is linear in the data, the result
+      is \f$\sum_f w_f\ \mathrm{image}_f\f$ with the weights returned here (indexed by frame number).
+      The model matrix needs to be in the correct scale.
+    */
+    void
+      get_linear_regression_weights(VectorWithOffset<float>& slope_weights,
+                                    VectorWithOffset<float>& intercept_weights) const;
+
     void set_defaults();
 
     Succeeded set_up(); 
@@ -148,6 +175,9 @@ class PatlakPlot : public RegisteredParsingObject<PatlakPlot, KineticModel>
 
  private:
   void create_model_matrix();  //!< Creates model matrix from private members
+  //! Scales the model matrix according to the voxel size of \a image, unless this was done already
+  void scale_model_matrix_if_necessary(const DiscretisedDensity<3,float>& image,
+                                       const float scanner_default_bin_size) const;
   void initialise_keymap();
   bool post_processing();
   mutable ModelMatrix<2> _model_matrix;
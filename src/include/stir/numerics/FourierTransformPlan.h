@@ -0,0 +1,125 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+#ifndef __stir_numerics_FourierTransformPlan_H__
+#define __stir_numerics_FourierTransformPlan_H__
+/*!
+  \file
+  \ingroup DFT
+  \brief Declaration of class stir::FourierTransformPlan
+*/
+#include "stir/common.h"
+#include "stir/shared_ptr.h"
+#include <complex>
+#include <vector>
+
+START_NAMESPACE_STIR
+
+/*! \ingroup DFT
+  \brief A plan for one-dimensional discrete fourier transforms of a fixed length
+
+  The plan precomputes everything that only depends on the length and the
+  sign of the transform (e.g. the factorisation of the length and the
+  twiddle factors), such that many transforms can be done efficiently.
+  Plans can be used by several threads at the same time. Normally you would
+  get a plan via get_plan(), which caches plans, as opposed to constructing one.
+
+  The convention for the transform is as for fourier_1d(), i.e. for a vector of length \a n
+  \f[
+    r_s = \sum_{s=0}^{n-1} c_r e^{\mathrm{sign} 2\pi i r s/n}
+  \f]
+
+  By default, a built-in mixed-radix algorithm (derived from KISS FFT, see LICENSE.txt)
+  is used, which handles any length.
+  It is fastest for lengths that only have factors 2, 3 and 5 (see
+  find_efficient_fourier_length()). Other prime factors \a p are handled with
+  <i>O(n p)</i> operations.
+
+  If STIR is configured with FFTW3 (i.e. the CMake variable \c DISABLE_FFTW is switched
+  \c OFF and FFTW3 is found), the transforms are done by FFTW instead.
+  Note that FFTW is distributed under the GPL.
+*/
+class FourierTransformPlan
+{
+public:
+  //! get a plan from the cache (or construct it if it does not exist yet)
+  /*! This function is thread-safe. */
+  static shared_ptr<const FourierTransformPlan> get_plan(const int length, const int sign);
+
+  //! constructor
+  /*! \a sign has to be 1 or -1 */
+  FourierTransformPlan(const int length, const int sign);
+
+  ~FourierTransformPlan();
+
+  //! return true if the transforms are done by FFTW
+  static bool is_using_FFTW();
+
+  int get_length() const;
+  int get_sign() const;
+
+  //! return the factor <tt>exp(sign*2*pi*i*k/length)</tt> for <tt>0<=k<length</tt>
+  const std::complex<float>& get_twiddle_factor(const int k) const;
+
+  //! in-place transform of the vector <tt>data[0], data[stride], ..., data[(length-1)*stride]</tt>
+  void transform(std::complex<float>* data, const int stride = 1) const;
+
+  //! in-place transform of \a num_vectors vectors
+  /*! vector \c v starts at <tt>data+v*distance</tt>, and its elements are \a stride apart.
+      If STIR is compiled with OpenMP, the vectors are distributed over threads.
+  */
+  void transform_many(std::complex<float>* data, const int num_vectors,
+                      const int stride, const int distance) const;
+
+private:
+  int length;
+  int sign;
+  //! factorisation of length, as pairs (radix, remaining length)
+  std::vector<int> factors;
+  std::vector<std::complex<float> > twiddle_factors;
+  //! the fftwf_plan when using FFTW, 0 otherwise (declared as void* to avoid including fftw3.h here)
+  void * fftw_plan_ptr;
+
+  //! transform using a work buffer of size length
+  void transform(std::complex<float>* data, const int stride, std::complex<float>* work) const;
+
+  void transform_recursively(std::complex<float>* out, const std::complex<float>* in,
+                             const int twiddle_stride, const int in_stride,
+                             const int * factors_ptr) const;
+  void butterfly_2(std::complex<float>* out, const int twiddle_stride, const int m) const;
+  void butterfly_3(std::complex<float>* out, const int twiddle_stride, const int m) const;
+  void butterfly_4(std::complex<float>* out, const int twiddle_stride, const int m) const;
+  void butterfly_generic(std::complex<float>* out, const int twiddle_stride, const int m, const int p) const;
+
+  // no copying, as the FFTW plan would have to be copied
+  FourierTransformPlan(const FourierTransformPlan&);
+  FourierTransformPlan& operator=(const FourierTransformPlan&);
+};
+
+/*! \ingroup DFT
+  \brief find the smallest length that is at least \a min_length and that only has factors 2, 3 and 5
+
+  DFTs of such lengths are efficient. This can be used to find a size for
+  zero-padding that is smaller than the next power of 2.
+  If \a even is \c true, the result is even (as required by fourier_for_real_data()).
+*/
+int find_efficient_fourier_length(const int min_length, const bool even = true);
+
+END_NAMESPACE_STIR
+
+#endif
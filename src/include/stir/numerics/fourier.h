@@ -29,6 +29,7 @@
 #define  __stir_numerics_stir_fourier_h__
 #include "stir/VectorWithOffset.h"
 #include "stir/Array_complex_numbers.h"
+#include "stir/numerics/FourierTransformPlan.h"
 START_NAMESPACE_STIR
 
 
@@ -44,6 +45,9 @@ START_NAMESPACE_STIR
 
   \see fourier_1d for conventions and restrictions
 
+  For regular arrays of <code>std::complex\<float\></code>, all 1D transforms along one
+  dimension are done as a single batch (which is distributed over threads when using OpenMP).
+
   \warning Currently, the array has to have \c get_min_index()==0 at each dimension.
 */
 template <typename T>
@@ -85,7 +89,10 @@ inline void inverse_fourier(T& c, const int sign=1)
   \param[in] sign This can be used to implement a different convention for the DFT
 
   \warning Currently, the array has to be indexed from 0.
-  \warning Currently, the length of the array has to be a power of 2.
+  \warning For arrays of <code>std::complex\<float\></code>, any length can be used, as the
+  transforms are done by a FourierTransformPlan. They are fastest for lengths that only have
+  factors 2, 3 and 5 (see find_efficient_fourier_length()). For other element types,
+  the length of the array has to be a power of 2.
    
   The convention used is as follows.
   For a vector of length \a n, the result is
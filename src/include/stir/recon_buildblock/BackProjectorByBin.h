@@ -35,6 +35,7 @@
 #include "stir/RegisteredObject.h"
 #include "stir/TimedObject.h"
 #include "stir/shared_ptr.h"
+#include <cstddef>
 
 START_NAMESPACE_STIR
 
@@ -85,7 +86,14 @@ public:
 
  
   //! project whole proj_data into the volume
-  /*! it overwrites the data already present in the volume */
+  /*! it overwrites the data already present in the volume
+
+    With OpenMP, the related viewgrams are back projected in parallel. If
+    supports_atomic_accumulation() returns \c true, all threads add directly
+    to the output image. Otherwise, an ImageAccumulationBuffers pool is used,
+    which uses at most get_max_memory_for_accumulation_buffers_in_MB()
+    of extra memory.
+  */
   void back_project(DiscretisedDensity<3,float>&,
 	            const ProjData&);
 
@@ -107,9 +115,22 @@ public:
 		   const int min_axial_pos_num, const int max_axial_pos_num,
 		   const int min_tangential_pos_num, const int max_tangential_pos_num);
 
+  //! set the maximum amount of extra memory used for parallel back projection of a whole ProjData
+  /*! Only used when the back projector does not support atomic accumulation. See ImageAccumulationBuffers. */
+  void set_max_memory_for_accumulation_buffers_in_MB(const std::size_t max_memory_in_MB);
+  //! get the maximum amount of extra memory used for parallel back projection of a whole ProjData
+  std::size_t get_max_memory_for_accumulation_buffers_in_MB() const;
 
 protected:
 
+  //! return if actual_back_project() can be called by several threads with the same output image
+  /*! Derived classes that return \c true need to add to the image via atomic operations when
+      accumulates_atomically() returns \c true. The default implementation returns \c false.
+  */
+  virtual bool supports_atomic_accumulation() const;
+  //! return if actual_back_project() is currently called by several threads with the same output image
+  bool accumulates_atomically() const;
+
   virtual void actual_back_project(DiscretisedDensity<3,float>&,
                                    const RelatedViewgrams<float>&,
 		                   const int min_axial_pos_num, const int max_axial_pos_num,
@@ -123,6 +144,8 @@ protected:
   bool _already_set_up;
 
  private:
+  bool _accumulate_atomically;
+  std::size_t _max_memory_for_accumulation_buffers_in_MB;
   shared_ptr<ProjDataInfo> _proj_data_info_sptr;
   //! The density ptr set with set_up()
   /*! \todo it is wasteful to have to store the whole image as this uses memory that we don't need. */
@@ -92,6 +92,9 @@ protected:
 
   shared_ptr<ProjMatrixByBin> proj_matrix_ptr;
 
+  //! returns \c true, as the elements are added to the image with atomic operations if necessary
+  virtual bool supports_atomic_accumulation() const;
+
 private:
   virtual void set_defaults();
   virtual void initialise_keymap();
@@ -73,6 +73,24 @@ public:
   /*! Default version does nothing. */
   virtual Succeeded set_up(const shared_ptr<ProjDataInfo>&);
 
+  //! prepare for using factors for this time frame
+  /*! This is called by apply(ProjData&,...) and undo(ProjData&,...) before the
+      viewgrams are processed in parallel. Derived classes can use it to compute
+      time-dependent factors once (outside of the parallel region).
+      The default version does nothing.
+  */
+  virtual void precompute_for_time_frame(const double start_time, const double end_time) const;
+
+  //! check if apply() and undo() for RelatedViewgrams can be called from different threads
+  /*! This returns \c true if the factors for this time frame are available without
+      changing the object, such that concurrent calls to apply(RelatedViewgrams<float>&,...)
+      and undo(RelatedViewgrams<float>&,...) are safe. Callers can then avoid serialising these
+      calls, see distributable_computation(). Normally precompute_for_time_frame() should be
+      called first.
+      The default version returns \c false.
+  */
+  virtual bool is_thread_safe_for_time_frame(const double start_time, const double end_time) const;
+
   //! Return the 'efficiency' factor for a single bin
   /*! With the notation of the class documentation, this returns the factor
     \f$\mathrm{norm}_b \f$. 
@@ -0,0 +1,163 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup normalisation
+
+  \brief Declaration of class stir::BinNormalisationFactorsCache
+*/
+
+#ifndef __stir_recon_buildblock_BinNormalisationFactorsCache_H__
+#define __stir_recon_buildblock_BinNormalisationFactorsCache_H__
+
+#include "stir/Array.h"
+#include "stir/VectorWithOffset.h"
+#include "stir/Bin.h"
+
+START_NAMESPACE_STIR
+
+template <typename elemT> class RelatedViewgrams;
+class ProjDataInfo;
+
+/*!
+  \ingroup normalisation
+  \brief Stores normalisation factors for all bins of some projection data in memory
+
+  This is a helper class for BinNormalisation classes for which computing the factor
+  for a bin is expensive. The owner passes a pointer to its member function that
+  computes the factor for a single bin. The cache uses it to compute all factors once,
+  such that get_bin_efficiency(), apply() and undo() just use the stored factors.
+  If caching is not enabled, the factors are computed for every call.
+
+  \code
+  float MyNormalisation::get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const
+  {
+    return this->cache.get_bin_efficiency(*this, &MyNormalisation::compute_bin_efficiency,
+                                          bin, start_time, end_time);
+  }
+  \endcode
+
+  Factors can depend on the time frame (e.g. for dead-time correction). In that case,
+  the cache is only valid for the time frame for which it was filled, and it is
+  refilled when a different time frame is used. Otherwise, the cache stays valid
+  until the next set_up().
+
+  Factors are stored per segment as an array indexed by view, axial and tangential
+  position, i.e. as for SegmentByView.
+
+  \par Multi-threading
+  The cache is only filled outside of OpenMP parallel regions, such that
+  threads never read the stored factors while another thread changes them, and no
+  lock is needed. If the factors for the time frame are not available inside a
+  parallel region, they are computed without the cache. Owners should therefore call
+  fill_if_necessary() before a parallel loop (see BinNormalisation::precompute_for_time_frame()).
+  Once the cache is filled, apply() and undo() only read the stored factors, so owners can
+  return is_filled_for() from BinNormalisation::is_thread_safe_for_time_frame().
+*/
+class BinNormalisationFactorsCache
+{
+public:
+  BinNormalisationFactorsCache();
+
+  //! Allocates memory for all bins in \a proj_data_info, and marks the cache as not filled
+  /*! If \a enabled is \c false, no memory is allocated, and all factors will be computed when needed.
+      If \a time_dependent is \c true, the stored factors will only be used for the same time frame.
+  */
+  void set_up(const ProjDataInfo& proj_data_info, const bool enabled, const bool time_dependent);
+
+  //! Returns if the cache is used at all
+  bool is_enabled() const;
+
+  //! Checks if the stored factors can be used for this time frame
+  bool is_filled_for(const double start_time, const double end_time) const;
+
+  //! Computes and stores all factors for the time frame, unless they are stored already
+  /*! Returns \c true if the stored factors can be used for this time frame.
+      Returns \c false if caching is not enabled, or if the factors need to be computed
+      but this function is called inside a parallel region.
+  */
+  template <class OwnerT>
+  inline bool
+    fill_if_necessary(const OwnerT& owner,
+                      float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                      const double start_time, const double end_time);
+
+  //! Returns the factor for a bin, using the stored factors if possible
+  template <class OwnerT>
+  inline float
+    get_bin_efficiency(const OwnerT& owner,
+                       float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                       const Bin& bin, const double start_time, const double end_time);
+
+  //! Divides the viewgrams by the factors (after applying a threshold to avoid division by 0)
+  /*! This does the same as BinNormalisation::apply(RelatedViewgrams<float>&,const double, const double) const */
+  template <class OwnerT>
+  inline void
+    apply(RelatedViewgrams<float>& viewgrams,
+          const OwnerT& owner,
+          float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+          const double start_time, const double end_time);
+
+  //! Multiplies the viewgrams with the factors
+  template <class OwnerT>
+  inline void
+    undo(RelatedViewgrams<float>& viewgrams,
+         const OwnerT& owner,
+         float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+         const double start_time, const double end_time);
+
+private:
+  //! factors for every segment, indexed as [view][axial_pos][tangential_pos]
+  VectorWithOffset<Array<3,float> > _factors;
+  bool _is_enabled;
+  bool _is_filled;
+  bool _time_dependent;
+  double _start_time;
+  double _end_time;
+
+  //! Returns \c false if called inside an OpenMP parallel region
+  static bool can_fill();
+
+  //! Marks the cache as filled
+  void set_filled_for(const double start_time, const double end_time);
+
+  inline void set_bin_efficiency(const Bin& bin, const float efficiency)
+  { this->_factors[bin.segment_num()][bin.view_num()][bin.axial_pos_num()][bin.tangential_pos_num()] = efficiency; }
+
+  inline float get_stored_bin_efficiency(const Bin& bin) const
+  { return this->_factors[bin.segment_num()][bin.view_num()][bin.axial_pos_num()][bin.tangential_pos_num()]; }
+
+  //! Divides (or multiplies if \a divide is \c false) the viewgrams by the stored factors
+  void apply_or_undo_stored_factors(RelatedViewgrams<float>& viewgrams, const bool divide) const;
+
+  //! Divides (or multiplies if \a divide is \c false) the viewgrams by factors computed by the owner
+  template <class OwnerT>
+  inline void
+    apply_or_undo_computed_factors(RelatedViewgrams<float>& viewgrams,
+                                   const OwnerT& owner,
+                                   float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                                   const double start_time, const double end_time,
+                                   const bool divide) const;
+};
+
+END_NAMESPACE_STIR
+
+#include "stir/recon_buildblock/BinNormalisationFactorsCache.inl"
+
+#endif
@@ -0,0 +1,142 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup normalisation
+
+  \brief Implementation of inline and template functions of class stir::BinNormalisationFactorsCache
+*/
+
+#include "stir/RelatedViewgrams.h"
+#include <algorithm>
+
+START_NAMESPACE_STIR
+
+template <class OwnerT>
+bool
+BinNormalisationFactorsCache::
+fill_if_necessary(const OwnerT& owner,
+                  float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                  const double start_time, const double end_time)
+{
+  if (!this->_is_enabled)
+    return false;
+  if (this->is_filled_for(start_time, end_time))
+    return true;
+  // other threads might be reading the stored factors
+  if (!can_fill())
+    return false;
+
+  for (int segment_num = this->_factors.get_min_index();
+       segment_num <= this->_factors.get_max_index();
+       ++segment_num)
+    {
+      const Array<3,float>& segment_factors = this->_factors[segment_num];
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int view_num = segment_factors.get_min_index();
+           view_num <= segment_factors.get_max_index();
+           ++view_num)
+        {
+          const Array<2,float>& view_factors = segment_factors[view_num];
+          Bin bin(segment_num, view_num, 0, 0);
+          for (bin.axial_pos_num() = view_factors.get_min_index();
+               bin.axial_pos_num() <= view_factors.get_max_index();
+               ++bin.axial_pos_num())
+            for (bin.tangential_pos_num() = view_factors[bin.axial_pos_num()].get_min_index();
+                 bin.tangential_pos_num() <= view_factors[bin.axial_pos_num()].get_max_index();
+                 ++bin.tangential_pos_num())
+              this->set_bin_efficiency(bin, (owner.*compute_bin_efficiency)(bin, start_time, end_time));
+        }
+    }
+  this->set_filled_for(start_time, end_time);
+  return true;
+}
+
+template <class OwnerT>
+float
+BinNormalisationFactorsCache::
+get_bin_efficiency(const OwnerT& owner,
+                   float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                   const Bin& bin, const double start_time, const double end_time)
+{
+  if (this->fill_if_necessary(owner, compute_bin_efficiency, start_time, end_time))
+    return this->get_stored_bin_efficiency(bin);
+  return (owner.*compute_bin_efficiency)(bin, start_time, end_time);
+}
+
+template <class OwnerT>
+void
+BinNormalisationFactorsCache::
+apply(RelatedViewgrams<float>& viewgrams,
+      const OwnerT& owner,
+      float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+      const double start_time, const double end_time)
+{
+  if (this->fill_if_necessary(owner, compute_bin_efficiency, start_time, end_time))
+    this->apply_or_undo_stored_factors(viewgrams, /*divide=*/true);
+  else
+    this->apply_or_undo_computed_factors(viewgrams, owner, compute_bin_efficiency, start_time, end_time, /*divide=*/true);
+}
+
+template <class OwnerT>
+void
+BinNormalisationFactorsCache::
+undo(RelatedViewgrams<float>& viewgrams,
+     const OwnerT& owner,
+     float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+     const double start_time, const double end_time)
+{
+  if (this->fill_if_necessary(owner, compute_bin_efficiency, start_time, end_time))
+    this->apply_or_undo_stored_factors(viewgrams, /*divide=*/false);
+  else
+    this->apply_or_undo_computed_factors(viewgrams, owner, compute_bin_efficiency, start_time, end_time, /*divide=*/false);
+}
+
+template <class OwnerT>
+void
+BinNormalisationFactorsCache::
+apply_or_undo_computed_factors(RelatedViewgrams<float>& viewgrams,
+                               const OwnerT& owner,
+                               float (OwnerT::*compute_bin_efficiency)(const Bin&, const double, const double) const,
+                               const double start_time, const double end_time,
+                               const bool divide) const
+{
+  for (RelatedViewgrams<float>::iterator iter = viewgrams.begin(); iter != viewgrams.end(); ++iter)
+    {
+      Bin bin(iter->get_segment_num(), iter->get_view_num(), 0, 0);
+      for (bin.axial_pos_num() = iter->get_min_axial_pos_num();
+           bin.axial_pos_num() <= iter->get_max_axial_pos_num();
+           ++bin.axial_pos_num())
+        for (bin.tangential_pos_num() = iter->get_min_tangential_pos_num();
+             bin.tangential_pos_num() <= iter->get_max_tangential_pos_num();
+             ++bin.tangential_pos_num())
+          {
+            const float efficiency = (owner.*compute_bin_efficiency)(bin, start_time, end_time);
+            float& value = (*iter)[bin.axial_pos_num()][bin.tangential_pos_num()];
+            if (divide)
+              value /= std::max(1.E-20F, efficiency);
+            else
+              value *= efficiency;
+          }
+    }
+}
+
+END_NAMESPACE_STIR
@@ -37,6 +37,7 @@
 #include "stir/data/SinglesRates.h"
 #include "stir/Scanner.h"
 #include "stir/Array.h"
+#include "stir/recon_buildblock/BinNormalisationFactorsCache.h"
 #include "stir/IO/stir_ecat_common.h"
 #include <string>
 
@@ -67,9 +68,21 @@ START_NAMESPACE_ECAT
   ; use_dead_time:=1
   ; use_geometric_factors:=1
   ; use_crystal_interference_factors:=1
+  ; next keyword can be used to compute all factors once and keep them in memory
+  ; cache normalisation factors:=0
   End Bin Normalisation From ECAT8:=
   \endverbatim
 
+  \par Caching of the factors
+  Computing the factor for a bin needs a loop over all detector pairs that contribute
+  to it, which is slow. When <tt>cache normalisation factors</tt> is set, the factors
+  for all bins are computed once and stored in memory (see BinNormalisationFactorsCache),
+  such that apply() and undo() just multiply with the stored factors.
+  If dead-time correction is used, the factors depend on the time frame, and they are
+  recomputed whenever a different time frame is used (but not inside a parallel region,
+  see BinNormalisationFactorsCache). Otherwise, they are computed in set_up().
+  This needs memory for a float for every bin of the projection data.
+
   \todo dead-time is not yet implemented
 
  
@@ -95,6 +108,18 @@ public:
   virtual Succeeded set_up(const shared_ptr<ProjDataInfo>&);
   float get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const;
 
+  // import all apply and undo functions from the base class, as we override some of them
+  using BinNormalisation::apply;
+  using BinNormalisation::undo;
+  //! Divides the viewgrams by the normalisation factors, using the stored factors if caching is enabled
+  virtual void apply(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const;
+  //! Multiplies the viewgrams with the normalisation factors, using the stored factors if caching is enabled
+  virtual void undo(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const;
+  //! Computes the factors for this time frame if caching is enabled
+  virtual void precompute_for_time_frame(const double start_time, const double end_time) const;
+  //! Returns \c true if the factors for this time frame are stored in the cache
+  virtual bool is_thread_safe_for_time_frame(const double start_time, const double end_time) const;
+
   bool use_detector_efficiencies() const;
   bool use_dead_time() const;
   bool use_geometric_factors() const;
@@ -124,8 +149,14 @@ private:
   bool _use_dead_time;
   bool _use_geometric_factors;
   bool _use_crystal_interference_factors;
+  bool _cache_normalisation_factors;
+  mutable BinNormalisationFactorsCache _factors_cache;
 
   void read_norm_data(const string& filename);
+  //! computes the factor for a bin from the components (without using the cache)
+  float compute_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const;
+  //! checks if the factors depend on the time frame
+  bool factors_depend_on_time_frame() const;
   float get_dead_time_efficiency ( const DetectionPosition<>& det_pos,
 				  const double start_time, const double end_time) const;
 
@@ -110,6 +110,12 @@ ChainedBinNormalisation(shared_ptr<BinNormalisation> const& apply_first,
   virtual void undo(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const;
 
   virtual float get_bin_efficiency(const Bin& bin,const double start_time, const double end_time) const;
+
+  //! Calls precompute_for_time_frame() of the 2 BinNormalisation members
+  virtual void precompute_for_time_frame(const double start_time, const double end_time) const;
+
+  //! Returns \c true if this is the case for the 2 BinNormalisation members
+  virtual bool is_thread_safe_for_time_frame(const double start_time, const double end_time) const;
  
 
 private:
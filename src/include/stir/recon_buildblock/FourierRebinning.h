@@ -36,7 +36,9 @@
 
 #include "stir/recon_buildblock/ProjDataRebinning.h"
 #include "stir/RegisteredParsingObject.h"
+#include "stir/shared_ptr.h"
 #include <complex>
+#include <vector>
 
 
 START_NAMESPACE_STIR
@@ -65,6 +67,7 @@ class PETCount_rebinned
 #ifdef PARALLEL
     friend PMessage& operator<<(PMessage&, PETCount_rebinned&);
     friend PMessage& operator>>(PMessage&, PETCount_rebinned&);
+#endif
 
     PETCount_rebinned & operator+= (const PETCount_rebinned &rebin)
         {
@@ -73,7 +76,6 @@ class PETCount_rebinned
             ssrb += rebin.ssrb;
             return *this;
         }
-#endif
 // Default constructor by initialising all the elements conter to null
     explicit PETCount_rebinned(int total_v=0, int miss_v =0, int ssrb_v = 0)
         :total(total_v), miss(miss_v), ssrb(ssrb_v)
@@ -91,7 +93,7 @@ class PETCount_rebinned
   The digital implementation of the rebinning is done as follows:
 
   a) Initialise the 2D Fourier transform of all rebinned sinograms Pr(w,k);<BR>
-  b) Process sequentially each pair of oblique sinograms pij and pji for i,j (= 0..2*num_rings-2) as:<BR>
+  b) Process each pair of oblique sinograms pij and pji for i,j (= 0..2*num_rings-2) as:<BR>
 	- merge pij and pji to get a sinogram sampled over 2p;<BR>
 	- calculates the 2D FFT Pij(w,k) of the merged sinogram;<BR>
 	- assign each frequency component (w,k) to the rebinned sinogram of the slice lying closest axially to 
@@ -116,6 +118,15 @@ class PETCount_rebinned
   Therefore the rebinned data are estimated using only the oblique sinograms with 
   a small value of d : dlim. Owing to the small value of d, the axial shift can be 
   neglected as in the SSRB approximation.
+
+  The 2D FFTs use the number of views of the data (i.e. there is no interpolation
+  to a power of 2), while in tangential direction the sinograms are zero-padded to a size
+  for which the FFT is efficient (see find_efficient_fourier_length()).
+
+  When STIR is compiled with OpenMP, the sinograms of a segment are processed in parallel.
+  Every thread then accumulates its contributions in its own copy of the Fourier transform
+  of the rebinned data (and the weights), so memory use increases with the number of threads.
+  The final inverse FFTs are done in parallel as well.
 */
 
 class FourierRebinning : public   RegisteredParsingObject<
@@ -173,7 +184,7 @@ class FourierRebinning : public   RegisteredParsingObject<
   \brief Fourier rebinning
 
   This method takes as input the 3D data set (Array3D) in Fourier space of one sinogram
-  for a given delta as the data dimension are (1,fft_size,nviews_pow2), the scanner informations
+  for a given delta as the data dimension are (1,fft_size,num_views_fft), the scanner informations
   and returns the updated stack of 2D rebinned sinograms still in Fourier space,
   the updated weigthing factors as well as  the new rebinned elements counter.
 
@@ -181,25 +192,30 @@ class FourierRebinning : public   RegisteredParsingObject<
 */
     void rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
        PETCount_rebinned &num_rebinned, const Array<2,std::complex<float> > &FT_current_sinogram, const float z, 
-       const float average_ring_difference_in_segment, const int num_views_pow2, const int num_tang_poss_pow2,
+       const float average_ring_difference_in_segment, const int num_views_fft, const int num_tang_poss_fft,
        const float half_distance_between_rings, const float sampling_distance_in_s, const float radial_sampling_freq_w,
        const float R_field_of_view_mm, const float ratio_ring_spacing_to_ring_radius);
 
 /*!
   \brief This method takes as input the real 3D data set
-  (in which the number of views have been extended to a number of power of 2)
+  (in which the views have been extended to cover 360 degrees)
   and  returns the rebinned sinograms in Fourier space, their weighting factors
   as well as the counter rebinned elements
 
+  The vectors have one element per thread. Element 0 has to be allocated by the caller,
+  the others will be allocated when the corresponding thread needs it.
+
   \b Rebinning <BR>
   Assign each frequency component (w,k) to the rebinned sinogram of the slice lying closest axially to
   z - (tk/w) with t=((ring0 -ring1)*ring_spacing/(2*R) with R=ring_radius, 
   Pm(w,k) = Pm(w,k) + Pij(w,k) (i=ring0 and j=ring1), and m is the nearest integer to (i+j) -k(i-j)/(Rw)).
 */
 
-    void do_rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
-                      PETCount_rebinned &count_rebinned, const SegmentBySinogram<float> &segment, const int num_tang_poss_pow2,
-                      const int num_views_pow2, const int num_planes, const float average_ring_difference_in_segment,
+    void do_rebinning(std::vector<shared_ptr<Array<3,std::complex<float> > > > &local_FT_rebinned_data_sptrs,
+                      std::vector<shared_ptr<Array<3,float> > > &local_Weights_for_FT_rebinned_data_sptrs,
+                      std::vector<PETCount_rebinned> &local_count_rebinned,
+                      const SegmentBySinogram<float> &segment, const int num_tang_poss_fft,
+                      const int num_views_fft, const int num_planes, const float average_ring_difference_in_segment,
                       const float half_distance_between_rings, const float sampling_distance_in_s, 
                       const float radial_sampling_freq_w, const float R_field_of_view_mm,
                       const float ratio_ring_spacing_to_ring_radius);
@@ -217,11 +233,8 @@ class FourierRebinning : public   RegisteredParsingObject<
     void do_display_count(PETCount_rebinned &num_rebinned_total);
 
 
-//! This is a function to adjust the number of views of a segment to the next power of 2
-    void do_adjust_nb_views_to_pow2(SegmentBySinogram<float> &segment) ;
-
 //! This function checks if the steering and input paramters for FORE are inside the possible range of parameters
-    Succeeded fore_check_parameters(int num_tang_poss_pow2, int num_views_pow2, int max_segment_num_to_process);
+    Succeeded fore_check_parameters(int num_tang_poss_fft, int num_views_fft, int max_segment_num_to_process);
 
     
  protected:
@@ -225,6 +225,16 @@ public:
   std::string
     get_objective_function_values_report(const TargetT& current_estimate);
 
+  //! Construct a string with statistics on the computations done so far
+  /*! This is intended for information that helps to tune the run-time of the
+      computations, such as the statistics of the cache of a ProjMatrixByBin.
+      It is reported at the end of a reconstruction.
+
+      The default implementation returns an empty string.
+  */
+  virtual std::string
+    get_computation_statistics_report() const;
+
   //! Return the number of subsets in-use
   int get_num_subsets() const;
 
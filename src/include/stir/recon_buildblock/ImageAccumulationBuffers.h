@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup recon_buildblock
+
+  \brief Declaration of class stir::ImageAccumulationBuffers
+*/
+
+#ifndef __stir_recon_buildblock_ImageAccumulationBuffers_H__
+#define __stir_recon_buildblock_ImageAccumulationBuffers_H__
+
+#include "stir/DiscretisedDensity.h"
+#include "stir/shared_ptr.h"
+#include <vector>
+#include <cstddef>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup recon_buildblock
+  \brief A bounded pool of images that threads can add their contributions to
+
+  This is used for parallel back projection, where every thread adds the back projection
+  of some projection data to the same image. Instead of giving every thread its own
+  copy of the image (which needs a lot of memory for a large number of threads),
+  a fixed number of buffers is used, independent of the number of threads. The first
+  buffer is the output image itself.
+
+  A thread calls acquire() to get exclusive access to a buffer, adds to it, and calls
+  release(). If all buffers are in use, acquire() waits until one becomes free.
+  At the end, accumulate() adds all other buffers to the output image, in parallel
+  over the planes of the image.
+
+  \code
+  ImageAccumulationBuffers buffers(image);
+  #pragma omp parallel for
+  for (...)
+    {
+      const int buffer_num = buffers.acquire();
+      back_projector.back_project(buffers.get_buffer(buffer_num), viewgrams);
+      buffers.release(buffer_num);
+    }
+  buffers.accumulate();
+  \endcode
+
+  Without OpenMP, there is only one buffer (i.e. the output image).
+*/
+class ImageAccumulationBuffers
+{
+public:
+  //! Constructor
+  /*!
+    \param output_image the image where everything will be accumulated. It is used as the first buffer.
+    \param num_buffers the maximum number of buffers. If 0, get_default_num_buffers() is used.
+
+    Buffers other than the output image are only allocated when they are needed.
+  */
+  explicit ImageAccumulationBuffers(DiscretisedDensity<3,float>& output_image,
+                                    const int num_buffers = 0);
+
+  ~ImageAccumulationBuffers();
+
+  //! return the maximum number of buffers
+  int get_num_buffers() const;
+
+  //! wait for a buffer that is not used by another thread, and return its number
+  int acquire();
+
+  //! return a buffer that has been acquired
+  DiscretisedDensity<3,float>& get_buffer(const int buffer_num);
+
+  //! allow other threads to use the buffer again
+  void release(const int buffer_num);
+
+  //! add all buffers to the output image
+  /*! Has to be called outside a parallel region. The other buffers are deallocated afterwards. */
+  void accumulate();
+
+  //! default for the maximum amount of memory (in MB) used by the extra buffers
+  static const std::size_t default_max_memory_in_MB = 2048;
+
+  //! return the default number of buffers
+  /*! This is the current maximum number of threads, but limited such that the extra buffers
+      use at most \a max_memory_in_MB. The result is at least 1.
+  */
+  static int get_default_num_buffers(const DiscretisedDensity<3,float>& image,
+                                     const std::size_t max_memory_in_MB = default_max_memory_in_MB);
+
+private:
+  struct Lock;
+
+  DiscretisedDensity<3,float>& output_image;
+  std::vector<shared_ptr<DiscretisedDensity<3,float> > > buffer_sptrs;
+  std::vector<shared_ptr<Lock> > lock_sptrs;
+};
+
+END_NAMESPACE_STIR
+
+#endif
@@ -0,0 +1,148 @@
+//
+//
+
+#ifndef __stir_recon_buildblock_PackedProjMatrixElemsForOneBin__
+#define __stir_recon_buildblock_PackedProjMatrixElemsForOneBin__
+
+/*!
+
+  \file
+  \ingroup projection
+
+  \brief Declaration of class stir::PackedProjMatrixElemsForOneBin
+
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/Bin.h"
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+
+START_NAMESPACE_STIR
+
+class ProjMatrixElemsForOneBin;
+template <int num_dimensions, typename elemT> class DiscretisedDensity;
+
+/*!
+\ingroup projection
+\brief A compact (read-only) version of ProjMatrixElemsForOneBin
+
+  ProjMatrixElemsForOneBin stores 3 coordinates and a float for every element
+  (12 bytes). This class stores the elements sorted in 'runs' of elements
+  with the same first and second coordinate. For every run, we store the
+  coordinates of its first element and its length. For every element, we
+  store only the 16-bit offset of its 3rd coordinate w.r.t. the start of the
+  run, and its value (in a separate array). The values can be stored as
+  \c float (lossless), as 16-bit floats, or quantised to 16 bits (w.r.t. the
+  maximum absolute value in the row). This reduces the memory used per element
+  to 6 or 4 bytes (plus a small overhead per run).
+
+  forward_project() and back_project() use this format directly, which
+  makes the inner loop run over consecutive voxels in the image.
+
+  \warning The order of the elements is not preserved (they are sorted).
+*/
+class PackedProjMatrixElemsForOneBin
+{
+public:
+  //! Specifies how the values of the elements are stored
+  enum ValueFormat { float_values, half_float_values, quantised_values };
+
+  //! Convert a string ("float", "half float" or "quantised") to a ValueFormat
+  /*! Calls error() if the string is not recognised. */
+  static ValueFormat value_format_from_string(const std::string&);
+
+  //! default constructor (constructs an empty row)
+  PackedProjMatrixElemsForOneBin();
+
+  //! construct from a row (effectively calls pack())
+  explicit
+    PackedProjMatrixElemsForOneBin(const ProjMatrixElemsForOneBin& elems,
+                                   const ValueFormat value_format = float_values);
+
+  //! overwrite the current object with a packed version of \a elems
+  void pack(const ProjMatrixElemsForOneBin& elems,
+            const ValueFormat value_format = float_values);
+
+  //! overwrite \a elems with the (sorted) elements of this row
+  void unpack(ProjMatrixElemsForOneBin& elems) const;
+
+  //! get the bin coordinates corresponding to this row
+  inline Bin get_bin() const
+  { return bin; }
+
+  inline ValueFormat get_value_format() const
+  { return value_format; }
+
+  //! number of non-zero elements
+  inline std::size_t size() const
+  { return c3_offsets.size(); }
+
+  //! estimate of the memory used by this object (in bytes)
+  std::size_t size_in_bytes() const;
+
+  //! back project a single bin
+  void back_project(DiscretisedDensity<3,float>&,
+                    const Bin&) const;
+  //! back project a single bin, adding to every voxel atomically
+  /*! \see ProjMatrixElemsForOneBin::back_project_atomically() */
+  void back_project_atomically(DiscretisedDensity<3,float>&,
+                               const Bin&) const;
+  //! forward project into a single bin
+  void forward_project(Bin&,
+                      const DiscretisedDensity<3,float>&) const;
+
+private:
+  //! elements with the same first and second coordinates
+  struct Run
+  {
+    short c1, c2, c3;
+    boost::uint16_t length;
+  };
+
+  Bin bin;
+  ValueFormat value_format;
+  //! scale factor used for quantised_values
+  float scale;
+  std::vector<Run> runs;
+  //! offsets of the 3rd coordinates w.r.t. the start of the run
+  std::vector<boost::uint16_t> c3_offsets;
+  //! values when using float_values
+  std::vector<float> float_values_storage;
+  //! values when using half_float_values or quantised_values
+  std::vector<boost::uint16_t> packed_values_storage;
+
+  //! helper function for forward_project(), templated in the way the values are found
+  template <class ValuesT>
+    float forward_project_runs(const DiscretisedDensity<3,float>&,
+                               const ValuesT& values) const;
+  //! helper function for back_project(), templated in the way the values are found
+  template <bool atomically, class ValuesT>
+    void back_project_runs(DiscretisedDensity<3,float>&,
+                           const float data,
+                           const ValuesT& values) const;
+  //! helper function for back_project() and back_project_atomically()
+  template <bool atomically>
+    void back_project_bin(DiscretisedDensity<3,float>&,
+                          const Bin&) const;
+};
+
+END_NAMESPACE_STIR
+
+#endif
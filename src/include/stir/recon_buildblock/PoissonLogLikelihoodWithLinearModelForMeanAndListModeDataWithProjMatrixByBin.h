@@ -2,6 +2,7 @@
 //
 /*
     Copyright (C) 2003- 2011, Hammersmith Imanet Ltd
+    Copyright (C) 2026, University College London
 
     This file is free software; you can redistribute it and/or modify
     it under the terms of the GNU Lesser General Public License as published by
@@ -32,7 +33,9 @@
 #include "stir/RegisteredParsingObject.h"
 #include "stir/recon_buildblock/PoissonLogLikelihoodWithLinearModelForMeanAndListModeData.h"
 #include "stir/recon_buildblock/ProjMatrixByBin.h" 
-#include "stir/ProjDataInMemory.h"
+#include "stir/ProjData.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/VectorWithOffset.h"
 
 #include "stir/ExamInfo.h"
 START_NAMESPACE_STIR
@@ -49,6 +52,35 @@ START_NAMESPACE_STIR
   If the list mode data is binned (with LmToProjData) without merging
   any bins, then the log likelihood computed from list mode data and
   projection data will be identical.
+
+  Subsets are formed by the event index in the current time frame, i.e. event
+  \c n (counting only prompts in the frame) belongs to subset
+  <tt>n % num_subsets</tt>. Every subset therefore sees (on average) the same
+  LORs, and the subset sensitivity is simply the total sensitivity divided by
+  the number of subsets.
+
+  Events are read in batches of size \c num_events_per_batch. The events in a batch
+  are then forward and back projected in parallel (when using OpenMP), where every
+  thread accumulates in its own gradient image. The additive sinogram is kept
+  in memory as a set of segments, such that finding the additive term for an
+  event is a simple look-up. It therefore has to be uncompressed (span 1, no mashing),
+  which is checked by set_up_before_sensitivity().
+
+  Every subset needs to read all events in the frame. The events before the frame are
+  only skipped the first time the frame is read, after which the position in the list mode
+  data of the last block of records before the frame is used by the next subsets.
+
+  \par Parameters
+  \verbatim
+  PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin Parameters:=
+  ; see PoissonLogLikelihoodWithLinearModelForMeanAndListModeData for other keywords
+  max ring difference num to process :=
+  Matrix type :=
+  additive sinogram :=
+  ; number of events processed (in parallel) in one go
+  num events per batch := 100000
+  End PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin Parameters:=
+  \endverbatim
 */
 
 template <typename TargetT>
@@ -81,6 +113,9 @@ public:
 
   int set_num_subsets(const int new_num_subsets);
 
+  //! Returns the statistics of the cache of the projection matrix
+  virtual std::string get_computation_statistics_report() const;
+
 protected:
   virtual double
     actual_compute_objective_function_without_penalty(const TargetT& current_estimate,
@@ -93,12 +128,14 @@ protected:
   virtual Succeeded 
     set_up_before_sensitivity(shared_ptr <TargetT > const& target_sptr); 
  
-  // TODO
+  //! Adds the total sensitivity divided by the number of subsets
+  /*! As subsets are formed by event index, every subset has the same sensitivity.
+      The total sensitivity is the back projection of the bin efficiencies (or 1 if
+      no normalisation is set) for all bins in the uncompressed projection data.
+      It is only computed once, see total_sensitivity_sptr.
+  */
   virtual void
-    add_subset_sensitivity(TargetT& sensitivity, const int subset_num) const
-  {
-    error("add_subset_sensitivity not implemented yet");
-  }
+    add_subset_sensitivity(TargetT& sensitivity, const int subset_num) const;
   
   //! Maximum ring difference to take into account
   /*! \todo Might be removed */
@@ -108,8 +145,27 @@ protected:
   shared_ptr<ProjMatrixByBin> PM_sptr;
   //shared_ptr<ProjectorByBinPair> projector_by_bin_pair;
   
-  //! points to the additive projection data
-  shared_ptr<ProjDataInMemory> additive_proj_data_sptr; 
+  //! in-memory copy of the additive projection data (see set_additive_proj_data_sptr()), indexed by segment number
+  /*! Filled in by set_up_before_sensitivity() */
+  VectorWithOffset<shared_ptr<SegmentBySinogram<float> > > additive_segment_sptrs;
+
+  //! total sensitivity, computed by add_subset_sensitivity() (reset by set_up_before_sensitivity())
+  mutable shared_ptr<TargetT> total_sensitivity_sptr;
+
+  //! number of events that are read before processing them in parallel
+  int num_events_per_batch;
+
+  //! \name position in the list mode data of the last block of records before the start of a frame
+  /*! Set by compute_sub_gradient_without_penalty_plus_sensitivity() when reading the
+      frame for the first time, such that the next subsets do not need to read all events
+      before the frame again. Invalidated by set_up_before_sensitivity().
+  */
+  //@{
+  bool has_frame_start_position;
+  int frame_num_for_start_position;
+  CListModeData::SavedPosition frame_start_position;
+  double time_at_frame_start_position;
+  //@}
  
   std::string additive_projection_data_filename ; 
   //! ProjDataInfo
@@ -195,6 +195,15 @@ public:
   const BinNormalisation& get_normalisation() const;
   const shared_ptr<BinNormalisation>& get_normalisation_sptr() const;
   //@}
+
+  //! Returns the statistics of the cache of the projection matrix (if any)
+  /*! This is only non-empty when the back projector uses a ProjMatrixByBin.
+      The forward projector of a ProjectorByBinPairUsingProjMatrixByBin uses the
+      same matrix, so its statistics are included.
+      \warning When using MPI, the projectors of the master are not used for the
+      computations, so the statistics of the workers are not reported.
+  */
+  virtual std::string get_computation_statistics_report() const;
   /*! \name Functions to set parameters
     This can be used as alternative to the parsing mechanism.
    \warning After using any of these, you have to call set_up().
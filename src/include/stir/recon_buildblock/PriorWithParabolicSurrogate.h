@@ -55,6 +55,20 @@ public:
     parabolic_surrogate_curvature(TargetT& parabolic_surrogate_curvature, 
 				  const TargetT &current_estimate) = 0;
 
+  //! compute the gradient and the parabolic surrogate curvature
+  /*! Gives the same result as calling compute_gradient() and parabolic_surrogate_curvature().
+      This default implementation does just that, but derived classes can overload it to
+      compute both in a single pass over the image.
+   */
+  virtual void
+    compute_gradient_and_parabolic_surrogate_curvature(TargetT& prior_gradient,
+                                                       TargetT& parabolic_surrogate_curvature,
+                                                       const TargetT &current_estimate)
+    {
+      this->compute_gradient(prior_gradient, current_estimate);
+      this->parabolic_surrogate_curvature(parabolic_surrogate_curvature, current_estimate);
+    }
+
   //! A function that allows skipping some computations if the curvature is independent of the \c current_estimate
   /*! Defaults to return \c true, but can be overloaded by the derived class.
    */
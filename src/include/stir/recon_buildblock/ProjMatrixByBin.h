@@ -14,7 +14,7 @@
 /*
     Copyright (C) 2000 PARAPET partners
     Copyright (C) 2000-2009, Hammersmith Imanet Ltd
-    Copyright (C) 2013, 2015 University College London
+    Copyright (C) 2013, 2015, 2026 University College London
 
     This file is part of STIR.
 
@@ -34,17 +34,13 @@
 #include "stir/RegisteredObject.h"
 #include "stir/ParsingObject.h"
 #include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/recon_buildblock/PackedProjMatrixElemsForOneBin.h"
 #include "stir/recon_buildblock/DataSymmetriesForBins.h"
 #include "stir/shared_ptr.h"
 #include "stir/VectorWithOffset.h"
 #include "stir/TimedObject.h"
-#include <boost/cstdint.hpp>
-//#include <map>
-#include <boost/unordered_map.hpp>
-#ifdef STIR_OPENMP
-#include <omp.h>
-#endif
-
+#include <vector>
+#include <string>
 // define a local preprocessor symbol to keep code relatively clean
 #ifdef STIR_NO_MUTABLE
 #define STIR_MUTABLE_CONST
@@ -80,10 +76,34 @@ class Bin;
   \verbatim
   disable caching := false
   store only basic bins in cache := true
+  maximum cache size in MB := 0
+  cache value format := float
   \endverbatim
   The 2nd option allows to cache the whole matrix. This results in the fastest
   behaviour IF your system does not start swapping. The default choice caches 
   only the 'basic' bins, and computes symmetry related bins from the 'basic' ones.
+
+  The 3rd option limits the amount of memory used by the cache (0 means
+  no limit). When the limit is exceeded, rows that have not been used recently
+  are removed from the cache (using a 'clock' approximation of LRU). This
+  is mostly useful in combination with <tt>store only basic bins in cache := false</tt>
+  for large scanners.
+
+  The 4th option determines how the values of the matrix elements are stored in the
+  cache (see PackedProjMatrixElemsForOneBin). Possible values are \c float (lossless),
+  <tt>half float</tt> and \c quantised. The latter 2 use less memory, at the
+  expense of (a small loss of) precision.
+
+  \par Implementation details
+
+  The cache is split into one part per view/segment. Each part stores a
+  table of pointers to immutable rows (in the format of PackedProjMatrixElemsForOneBin), indexed by axial and tangential
+  position, which is only allocated when the first row for that view/segment
+  is stored. When only 'basic' bins are cached with the \c float format, rows are
+  stored as ProjMatrixElemsForOneBin instead, as they need to be copied anyway to
+  apply the symmetries, and there is then no point in decoding them. Rows are shared via shared_ptr, so looking up a row does not
+  need a lock (only the atomic shared_ptr functions), and rows that are
+  removed from the cache stay valid for threads that are still using them.
 */
 class ProjMatrixByBin :  
   public RegisteredObject<ProjMatrixByBin>,  
@@ -139,7 +159,14 @@ public:
   const char * const file_name_without_extension);
   */
   
-  //void set_maximum_cache_size(const unsigned long size){;}        
+  //! Set the maximum amount of memory (in bytes) used by the cache (0 means no limit)
+  void set_maximum_cache_size(const std::size_t size_in_bytes);
+  //! Get the maximum amount of memory (in bytes) used by the cache (0 means no limit)
+  std::size_t get_maximum_cache_size() const;
+  //! Set how values are stored in the cache
+  /*! The cache is cleared if the format changes. */
+  void set_cache_value_format(const PackedProjMatrixElemsForOneBin::ValueFormat);
+  PackedProjMatrixElemsForOneBin::ValueFormat get_cache_value_format() const;
   /* TODO
   void set_subset_usage(const SubsetInfo&, const int num_access_times);
   */
@@ -153,6 +180,38 @@ public:
   //! Remove all elements from the cache
   void clear_cache() STIR_MUTABLE_CONST;
 
+  //! Get a row of the matrix in packed format
+  /*! When the cache is enabled and stores all bins (i.e. not only the 'basic' ones), this
+      returns the row from the cache without copying it. Otherwise, the row is
+      computed with get_proj_matrix_elems_for_one_bin() and then packed.
+
+      This is useful for projectors when the whole matrix is cached, as
+      PackedProjMatrixElemsForOneBin::forward_project()
+      and PackedProjMatrixElemsForOneBin::back_project() are faster than their
+      ProjMatrixElemsForOneBin counterparts. In the other cases, packing the
+      row is only overhead, so get_proj_matrix_elems_for_one_bin() should be used.
+  */
+  shared_ptr<const PackedProjMatrixElemsForOneBin>
+    get_packed_proj_matrix_elems_for_one_bin(const Bin&) const;
+
+  //! \name Cache statistics
+  /*! The counters are reset by set_up() and clear_cache(). */
+  //@{
+  //! number of rows found in the cache
+  unsigned long get_num_cache_hits() const;
+  //! number of rows not found in the cache (while it was enabled)
+  unsigned long get_num_cache_misses() const;
+  //! number of rows removed from the cache to stay within the maximum cache size
+  unsigned long get_num_cache_evictions() const;
+  //! (estimate of the) current amount of memory used by the rows in the cache in bytes
+  /*! This does not include the tables of pointers to the rows (which use a
+      few bytes per bin, and are not limited by the maximum cache size).
+  */
+  std::size_t get_cache_size() const;
+  //! a summary of the above, suitable for printing
+  std::string get_cache_statistics() const;
+  //@}
+
   
 protected:
   shared_ptr<DataSymmetriesForBins> symmetries_ptr;
@@ -191,6 +250,10 @@ protected:
 
   bool cache_disabled;  
   bool cache_stores_only_basic_bins;
+  //! maximum cache size as set by the parser (0 means no limit)
+  int cache_max_size_in_MB;
+  //! value format in the cache as set by the parser
+  std::string cache_value_format_string;
 
   /*! \brief The method that tries to get data from the cache.
   
@@ -201,37 +264,104 @@ protected:
   Succeeded get_cached_proj_matrix_elems_for_one_bin(
 	 	 ProjMatrixElemsForOneBin&
                  ) const;		
+
+  //! Get a row from the cache without copying it
+  /*! Returns a null pointer if the row is not in the cache. The row remains
+      valid even if it is removed from the cache by another thread.
+  */
+  shared_ptr<const PackedProjMatrixElemsForOneBin>
+    get_cached_proj_matrix_elems_for_one_bin_sptr(const Bin&) const;
   
   //! The method to store data in the cache.
   void  cache_proj_matrix_elems_for_one_bin( const ProjMatrixElemsForOneBin&)
     STIR_MUTABLE_CONST;
 
 private:
-  
-  typedef boost::uint32_t CacheKey;
 
-	//  typedef std::map<CacheKey, ProjMatrixElemsForOneBin>   MapProjMatrixElemsForOneBin;
-  typedef boost::unordered_map<CacheKey, ProjMatrixElemsForOneBin>   MapProjMatrixElemsForOneBin;
-  typedef MapProjMatrixElemsForOneBin::iterator MapProjMatrixElemsForOneBinIterator;
-  typedef MapProjMatrixElemsForOneBin::const_iterator const_MapProjMatrixElemsForOneBinIterator;
- 
+  typedef shared_ptr<const PackedProjMatrixElemsForOneBin> CachedElemsSptr;
+  typedef shared_ptr<const ProjMatrixElemsForOneBin> CachedUnpackedElemsSptr;
+
+  //! one entry in the cache
+  /*! Only one of the 2 pointers is used, see cache_stores_unpacked_rows(). */
+  struct CacheSlot
+  {
+    CacheSlot() : recently_used(0) {}
+    CachedElemsSptr elems_sptr;
+    CachedUnpackedElemsSptr unpacked_elems_sptr;
+    //! 'reference' bit for the clock algorithm
+    unsigned char recently_used;
+  };
+
+  //! the part of the cache for one view/segment
+  struct CacheShard
+  {
+    CacheShard();
+    int min_axial_pos_num;
+    int max_axial_pos_num;
+    int min_tangential_pos_num;
+    int max_tangential_pos_num;
+    //! set to true once \c slots has been allocated
+    bool allocated;
+    std::vector<CacheSlot> slots;
+    unsigned long num_hits;
+    unsigned long num_misses;
+  };
+
   //! collection of  ProjMatrixElemsForOneBin (internal cache )   
 #ifndef STIR_NO_MUTABLE
   mutable
 #endif
-    VectorWithOffset<VectorWithOffset<MapProjMatrixElemsForOneBin> > cache_collection;
-#ifdef STIR_OPENMP
+    VectorWithOffset<VectorWithOffset<CacheShard> > cache_collection;
+
+  std::size_t cache_max_size;
+  PackedProjMatrixElemsForOneBin::ValueFormat cache_value_format;
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    std::size_t cache_size;
 #ifndef STIR_NO_MUTABLE
   mutable
 #endif
-  VectorWithOffset<VectorWithOffset<omp_lock_t> > cache_locks;
+    unsigned long num_cache_evictions;
+
+  //! current position of the clock 'hand' used for evictions
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    int clock_view_num, clock_segment_num;
+#ifndef STIR_NO_MUTABLE
+  mutable
 #endif
+    std::size_t clock_slot_num;
+
+  //! find the part of the cache for the view/segment of \a bin (or 0 if out of range)
+  CacheShard* get_cache_shard(const Bin& bin) const;
+
+  //! find the slot in the cache corresponding to \a bin
+  /*! Returns 0 if the bin is out of range, or when the table for its
+      view/segment has not been allocated yet and \a allocate is false.
+  */
+  CacheSlot* get_cache_slot(CacheShard& shard, const Bin& bin, const bool allocate) const;
+
+  //! find the slot in the cache for looking up \a bin (or 0 if there is none)
+  /*! \a shard_ptr is set to the corresponding part of the cache (or 0). */
+  CacheSlot* find_cache_slot_for_lookup(CacheShard*& shard_ptr, const Bin& bin) const;
+
+  //! update the 'reference' bit and the statistics after a lookup
+  void record_cache_lookup(CacheShard* shard_ptr, CacheSlot* slot_ptr, const bool found) const;
+
+  //! remove the row from \a slot, returning the number of bytes released
+  std::size_t release_cache_slot(CacheSlot& slot) const;
+
+  //! true if rows are stored as ProjMatrixElemsForOneBin in the cache
+  /*! This is the case when only 'basic' bins are stored in \c float format. */
+  bool cache_stores_unpacked_rows() const;
 
-  //! create the key for caching
-  // KT 15/05/2002 not static anymore as it uses cache_stores_only_basic_bins
-  CacheKey cache_key(const Bin& bin) const;
+  //! add \a num_bytes to the size of the cache (which can be negative)
+  void add_to_cache_size(const long num_bytes) const;
 
-   
+  //! remove rows that have not been used recently until the cache is small enough
+  void evict_from_cache() const;
 };
 
 
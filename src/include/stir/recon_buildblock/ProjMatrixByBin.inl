@@ -99,7 +99,10 @@ get_proj_matrix_elems_for_one_bin(
         cache_proj_matrix_elems_for_one_bin(probabilities);
       }
       symm_ptr->transform_proj_matrix_elems_for_one_bin(probabilities);
-      cache_proj_matrix_elems_for_one_bin(probabilities);      
+      // some symmetry operations do not change the bin coordinates (only the image coordinates),
+      // in which case we should not overwrite the row for the basic bin
+      if (probabilities.get_bin() != basic_bin)
+        cache_proj_matrix_elems_for_one_bin(probabilities);      
     }
   }  
   // stop_timers(); TODO, can't do this in a const member
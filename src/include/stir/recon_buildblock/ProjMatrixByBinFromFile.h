@@ -2,6 +2,7 @@
 //
 /*
     Copyright (C) 2004- 2008, Hammersmith Imanet Ltd
+    Copyright (C) 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -36,7 +37,10 @@
 #include "stir/shared_ptr.h"
 #include <iostream>
 
- 
+namespace boost { namespace interprocess {
+    class file_mapping;
+    class mapped_region;
+} }
 
 START_NAMESPACE_STIR
 
@@ -46,10 +50,28 @@ class Bin;
   \ingroup projection
   \brief Reads/writes a projection matrix from/to file
 
-  The only supported file format consists of an Interfile-type header
+  The file format consists of an Interfile-type header
   and a binary file which stores the 'basic' elements in a sparse form, 
   i.e. only the elements that cannot by constructed via symmetries.
 
+  Two versions of the binary file are supported:
+  - Version 1.0 stores the LORs sequentially. The whole file is read into the
+    cache by set_up(), so the cache has to be large enough to contain the whole matrix.
+  - Version 2.0 (written by write_to_file()) starts with a small header,
+    followed by the LORs (each aligned to 16 bytes) and a table with the bin
+    coordinates and file offset of every LOR (sorted on bin coordinates).
+    The file is memory-mapped by set_up(), and LORs are read on demand
+    from the mapped file, so set-up is nearly instantaneous and several
+    processes can share the same (page-cached) file. This version can be used
+    with a maximum cache size, or even without cache.
+
+  \warning Reading a LOR from a Version 2.0 file is not zero-copy: the elements
+  in the mapped file are copied into the ProjMatrixElemsForOneBin that is
+  returned (and possibly into the cache). This is because ProjMatrixByBin
+  owns its rows, as it needs to apply the symmetry operations on them.
+  What is avoided is reading and parsing the file, and keeping a
+  private copy of the whole matrix in every process.
+
   \todo this class currently only works with VoxelsOnCartesianGrid. 
   To fix this, we would need a DiscretisedDensityInfo class, and be able
   to have constructed the appropriate symmetries object by parsing the
@@ -58,7 +80,7 @@ class Bin;
   \par Example .par file
   \verbatim
     ProjMatrixByBinFromFile Parameters:=
-      Version := 1.0
+      Version := 2.0
       symmetries type := PET_CartesianGrid
         PET_CartesianGrid symmetries parameters:=
 	  do_symmetry_90degrees_min_phi:= <bool>
@@ -89,9 +111,9 @@ public :
   static const char * const registered_name; 
  
   //! Writes a projection matrix to file in a format such that this class can read it back
-  /*! Currently this will write an interfile-type header, a file with the binary data,
-      a template image and template sinogram. You will need all 4 to be able to read the
-      matrix back in.
+  /*! Currently this will write an interfile-type header, a file with the binary data
+      (using Version 2.0), a template image and template sinogram. You will need all 4
+      to be able to read the matrix back in.
   */
 static Succeeded
   write_to_file(const std::string& output_filename_prefix, 
@@ -141,8 +163,17 @@ private:
   virtual void initialise_keymap();
   virtual bool post_processing();
 
+  //! read all LORs into the cache (Version 1.0)
   Succeeded read_data();
-    
+
+  //! memory-map the data file and check its header (Version 2.0)
+  Succeeded map_data();
+
+  //! memory-mapped data (only used for Version 2.0)
+  shared_ptr<boost::interprocess::file_mapping> data_file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> data_region_sptr;
+  //! number of LORs in the mapped file
+  std::size_t num_lors_in_data;
 };
 
 END_NAMESPACE_STIR
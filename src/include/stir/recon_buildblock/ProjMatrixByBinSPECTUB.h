@@ -34,6 +34,13 @@
 #include "stir/IndexRange.h"
 #include "stir/shared_ptr.h"
 #include <iostream>
+#include <string>
+#include <vector>
+
+namespace boost { namespace interprocess {
+    class file_mapping;
+    class mapped_region;
+} }
 
 
 #include "stir/recon_buildblock/SPECTUB_Tools.h"
@@ -42,6 +49,7 @@ START_NAMESPACE_STIR
 
 template <int num_dimensions, typename elemT> class DiscretisedDensity;
 class Bin;
+class Succeeded;
 /*!
   \ingroup projection
   \brief generates projection matrix for SPECT studies
@@ -53,6 +61,28 @@ class Bin;
 
   \warning this class currently only works with VoxelsOnCartesianGrid. 
 
+  \par Computation of the weights
+
+  The weights are computed view by view. If all views are kept in memory, all views
+  are computed by set_up(). When compiled with OpenMP, different views are then computed
+  by different threads. Otherwise, views are computed when they are needed (and the
+  previous view is discarded).
+
+  \par Sharing the weights between runs
+
+  If a <tt>weight matrix cache directory</tt> is set, the computed weights are written
+  to a file in that directory, and later runs with the same parameters memory-map that file
+  instead of computing the weights again. Different processes using the same file then share
+  the same physical memory. The name of the file is derived from a checksum of all
+  parameters that influence the weights (including the contents of the attenuation map and
+  mask), and the file stores those parameters as well such that a mismatch is detected.
+  The file uses a compressed sparse row format in native byte order, see
+  write_weight_file(). It is only valid on systems with the same byte order.
+
+  If <tt>keep all views in cache</tt> is 0, the views are computed one at a time while
+  writing the file, such that the whole matrix is never kept in memory. Once the file is
+  mapped, all views are available (also to different threads).
+
   \par Sample parameter file
 
 \verbatim
@@ -79,6 +109,10 @@ class Bin;
 
     ; if next variable is set to 0, only a single view is kept in memory
    keep all views in cache:=1
+    ; if set, the weights are stored in (or read from) a file in this directory
+    ; (defaults to empty, i.e. no file is used). This works with both values
+    ; of the previous keyword.
+   weight matrix cache directory:=
 
 End Projection Matrix By Bin SPECT UB Parameters:=
 \endverbatim
@@ -107,6 +141,12 @@ class ProjMatrixByBinSPECTUB :
                       const shared_ptr<DiscretisedDensity<3,float> >& density_info_ptr // TODO should be Info only
                       );
 
+  //! name of the file where the weights are stored (empty if there is no weight matrix cache directory)
+  /*! Only valid after set_up(). */
+  const std::string& get_weight_file_name() const;
+  //! returns \c true if the weights are read from the memory-mapped weight file
+  bool is_using_weight_file() const;
+
  private:
 
   // parameters that will be parsed
@@ -122,6 +162,7 @@ class ProjMatrixByBinSPECTUB :
   std::string mask_type;
   std::string mask_file;
   bool keep_all_views_in_cache; //!< if set to false, only a single view is kept in memory
+  std::string weight_matrix_cache_directory; //!< if not empty, directory where the weights are stored
 
   // explicitly list necessary members for image details (should use an Info object instead)
   CartesianCoordinate3D<float> voxel_size;
@@ -163,10 +204,51 @@ class ProjMatrixByBinSPECTUB :
 
   int maxszb;
 
-	
-  void compute_one_subset(const int kOS) const;
+  //! weights for the views in one UB subset, in compressed sparse row format
+  struct SubsetWeights
+  {
+    //! index in \c voxel_index of the first weight of every row (and one past the last)
+    std::vector<int> row_start;
+    //! voxel index (as in the UB library) of every weight
+    std::vector<int> voxel_index;
+    std::vector<float> value;
+  };
+  //! weights for every UB subset (empty if not computed yet)
+  mutable std::vector<SubsetWeights> subset_weights;
+  //! if \c true, subsets are computed (one at a time) when they are needed
+  bool compute_subsets_on_demand;
+
+  //! name of the weight file (set by set_up())
+  std::string weight_filename;
+  //! memory-mapped weight file (if used)
+  shared_ptr<boost::interprocess::file_mapping> weight_file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> weight_region_sptr;
+
+  void compute_one_subset(const int kOS, SubsetWeights& weights) const;
+  //! computes all subsets (in parallel when using OpenMP)
+  void compute_all_subsets();
   void delete_UB_SPECT_arrays();
-  mutable std::vector<bool> subset_already_processed;
+
+  //! text listing all parameters that influence the weights
+  std::string get_weight_matrix_key() const;
+  //! writes all subsets to file, computing the ones that are not in memory
+  /*! The file contains
+      - a header (including the size of the key)
+      - the key returned by get_weight_matrix_key(), padded to a multiple of 8 bytes
+      - for every row, the (64-bit) index of its first weight, and the total number of weights
+      - the voxel index of every weight (as \c int)
+      - the value of every weight (as \c float)
+
+      Rows are ordered according to the UB subsets. Subsets that are not in \c subset_weights
+      are computed one at a time, and only one of them is kept in memory. The values are
+      first written to a second temporary file, and appended when all voxel indices are written.
+      The file is first written under a temporary
+      name (unique to this process) and then renamed, such that other processes do not see
+      a partially written file.
+  */
+  Succeeded write_weight_file(const std::string& filename, const std::string& key) const;
+  //! memory-maps the weight file, checking that it was written with \a key
+  Succeeded map_weight_file(const std::string& filename, const std::string& key);
 };
 
 END_NAMESPACE_STIR
@@ -163,6 +163,16 @@ public:
   // TODO make sure we can have a const argument
   void merge(ProjMatrixElemsForOneBin &lor );
 
+  //! sort the elements and add the values of elements with the same coordinates
+  /*! This can be used after appending the elements of several lors with push_back()
+      (ignoring the warning there). It is much faster than calling merge() for
+      every lor, as merge() inserts elements in the middle of the vector.
+
+      A stable sort is used, such that values are added in the order they
+      were appended, giving the same result as successive calls to merge().
+  */
+  void merge_duplicates();
+
   //! Compare 2 lors to see if they are equal
   /*! \warning Compares element by element. Does not sort first or so.
       \warning Compares float values, so uses a tolerance. This tolerance
@@ -191,6 +201,11 @@ public:
   //! back project a single bin 
   void back_project(DiscretisedDensity<3,float>&,
                     const Bin&) const;
+  //! back project a single bin, adding to every voxel atomically
+  /*! This allows several threads to back project into the same image at the same time.
+      It is slower than back_project() when only 1 thread is used. */
+  void back_project_atomically(DiscretisedDensity<3,float>&,
+                               const Bin&) const;
 
   //! forward project into a single bin
   void forward_project(Bin&,
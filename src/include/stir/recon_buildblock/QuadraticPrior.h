@@ -124,6 +124,23 @@ class QuadraticPrior:  public
   void parabolic_surrogate_curvature(DiscretisedDensity<3,elemT>& parabolic_surrogate_curvature, 
                         const DiscretisedDensity<3,elemT> &current_image_estimate);
 
+  //! compute the value, gradient and parabolic surrogate curvature in a single pass over the image
+  /*! This gives the same results as calling compute_value(), compute_gradient() and
+      parabolic_surrogate_curvature(), but is faster. Both \a prior_gradient and
+      \a parabolic_surrogate_curvature are always computed (any data in them is overwritten).
+      \return the value of the prior
+  */
+  double
+    compute_value_gradient_and_curvature(DiscretisedDensity<3,elemT>& prior_gradient, 
+                                         DiscretisedDensity<3,elemT>& parabolic_surrogate_curvature, 
+                                         const DiscretisedDensity<3,elemT> &current_image_estimate);
+
+  //! compute gradient and parabolic surrogate curvature using compute_value_gradient_and_curvature()
+  virtual void
+    compute_gradient_and_parabolic_surrogate_curvature(DiscretisedDensity<3,elemT>& prior_gradient,
+                                                       DiscretisedDensity<3,elemT>& parabolic_surrogate_curvature,
+                                                       const DiscretisedDensity<3,elemT> &current_image_estimate);
+
   //! compute Hessian 
   void compute_Hessian(DiscretisedDensity<3,elemT>& prior_Hessian_for_single_densel, 
                 const BasicCoordinate<3,int>& coords,
@@ -173,6 +190,12 @@ protected:
   virtual bool post_processing();
  private:
   shared_ptr<DiscretisedDensity<3,elemT> > kappa_ptr;
+
+  //! compute the weights if they are not set yet, and check the kappa image
+  void check_and_set_weights(const DiscretisedDensity<3,elemT> &current_image_estimate) const;
+
+  //! write the gradient to file if gradient_filename_prefix is set
+  void write_gradient_if_requested(const DiscretisedDensity<3,elemT>& prior_gradient) const;
 };
 
 
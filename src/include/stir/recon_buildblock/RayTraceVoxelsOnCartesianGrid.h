@@ -28,6 +28,7 @@
     See STIR/LICENSE.txt for details
 */
 #include "stir/common.h"
+#include <vector>
 
 START_NAMESPACE_STIR
 
@@ -80,4 +81,27 @@ RayTraceVoxelsOnCartesianGrid(ProjMatrixElemsForOneBin& lor,
                               const CartesianCoordinate3D<float>& voxel_size,
                               const float normalisation_constant = 1.F);
 
+/*! \ingroup recon_buildblock
+  
+  \brief Ray traces several LORs one after the other and appends the sum of their LOIs to the 
+  ProjMatrixElemsForOneBin object, merging the results in one pass.
+
+  This is equivalent to calling RayTraceVoxelsOnCartesianGrid() for every pair of
+  \a start_points and \a end_points and merging the results with ProjMatrixElemsForOneBin::merge().
+  Every LOR is traced with the single-LOR function above, i.e. only the merging is batched:
+  the voxels of all LORs are combined with a single sort (see
+  ProjMatrixElemsForOneBin::merge_duplicates()), which is much faster when the LORs
+  intersect many common voxels (as for the multiple LORs per bin used by
+  ProjMatrixByBinUsingRayTracing).
+  
+  The result is sorted and has no duplicate voxels (if this was the case for \a lor
+  on input).
+*/
+void 
+RayTraceVoxelsOnCartesianGrid(ProjMatrixElemsForOneBin& lor, 
+                              const std::vector<CartesianCoordinate3D<float> >& start_points, 
+                              const std::vector<CartesianCoordinate3D<float> >& end_points, 
+                              const CartesianCoordinate3D<float>& voxel_size,
+                              const float normalisation_constant = 1.F);
+
 END_NAMESPACE_STIR
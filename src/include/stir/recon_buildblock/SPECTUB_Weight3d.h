@@ -32,8 +32,9 @@
   <i>Integration of advanced 3D SPECT modeling into the open-source STIR framework</i>,
   Med. Phys. 40, 092502 (2013); http://dx.doi.org/10.1118/1.4816676
 
-  \todo Variables wm, wmh and Rrad are currently global variables. This means that this code would be very dangerous
-  in a parallel setting.
+  \todo Variables wm, wmh and Rrad are currently global variables. wm_calculation() and wm_size_estimation()
+  only read wmh and Rrad, such that different views can be computed in parallel, but
+  only one matrix can be set-up at the same time.
 */
 
 namespace SPECTUB {
@@ -48,7 +49,13 @@ namespace SPECTUB {
   extern float * Rrad;  //! radii per view
 
 
+//! computes the weights for the angles angle_index[0..prj.NangOS-1], storing them in \a wm
+/*! \a wm needs to have been allocated according to \a NITEMS. This function does not
+    modify any global variables, so different calls can run in parallel (with different \a wm).
+*/
 void wm_calculation( const int kOS,
+					const int *const angle_index,
+					wm_da_type& wm,
 					const angle_type *const ang, 
 					voxel_type vox, 
 					bin_type bin, 
@@ -62,7 +69,12 @@ void wm_calculation( const int kOS,
 					const int *const  NITEMS
 					);
 
+//! adds the number of weights for the angles angle_index[0..prj.NangOS-1] to \a NITEMS
+/*! This function does not modify any global variables, so different calls can run in parallel
+    (with different \a NITEMS).
+*/
 void wm_size_estimation (int kOS,
+						 const int *const angle_index,
 						 const angle_type * const ang, 
 						 voxel_type vox, 
 						 bin_type bin, 
@@ -85,6 +85,7 @@
 #include "stir/Viewgram.h"
 #include "stir/VoxelsOnCartesianGrid.h"
 #include "stir/ProjDataInfo.h"
+#include <vector>
 
 namespace stir {
   class ExamInfo;
@@ -221,10 +222,15 @@ namespace distributed
    * \param viewgrams the viewgrams to be sent
    * \param destination the process id where to send the related viewgrams
    * 
-   * This function iterates through the relatedviewgrams object and calls \c send_viewgram() 
-   * for each comprised viewgram. 
-   * The only value sent is the count of viewgrams contained within the related_viewgrams object
-   * to make sure that the worker knows how many viewgrams he has to receive.
+   * All viewgrams are sent together, such that only 3 messages are needed:
+   * 1. The count of viewgrams contained within the related_viewgrams object
+   * 2. The dimensions and vs_num of all viewgrams
+   * 3. The values of all viewgrams, serialized to a one-dimensional array
+   *
+   * The last message is sent with \c MPI_Isend, i.e. this function returns before the
+   * worker has received the values. The master can therefore prepare the next viewgrams
+   * while the values are being transferred. The send-buffer is kept until the send is complete.
+   * \see wait_for_pending_sends()
    */
   void send_related_viewgrams(stir::RelatedViewgrams<float>* viewgrams, int destination);
         
@@ -240,6 +246,12 @@ namespace distributed
    */
   void send_viewgram(const stir::Viewgram<float>& viewgram, int destination);
         
+  /*! \brief waits until all non-blocking sends started by send_related_viewgrams() are complete
+   *
+   * This frees all send-buffers. It has to be called before \c MPI_Finalize.
+   */
+  void wait_for_pending_sends();
+        
         
   //----------------------Receive operations----------------------------------
         
@@ -375,8 +387,8 @@ namespace distributed
    * that would lead to the overhead of sending it everytime a related_viewgram is sent, 
    * which is really expensive.  
    * 
-   * This function receives the count of viewgrams to be received and calls
-   * \c receive_and_construct_viewgram that often. Every received viewgram is pushed back
+   * This function receives the count of viewgrams to be received, their dimensions and 
+   * all their values (see send_related_viewgrams()). The received viewgrams are pushed back
    * to a viewgram vector, which afterwards is used with the symmetries to construct 
    * a RelatedViewgrams object.  
    */
@@ -384,6 +396,45 @@ namespace distributed
                                                const stir::shared_ptr<stir::ProjDataInfo>& proj_data_info_ptr, 
                                                const stir::shared_ptr<stir::DataSymmetriesForViewSegmentNumbers> symmetries_sptr,
                                                int source);
+
+  /*! \brief related viewgrams of which the values are still being received
+   *
+   * See start_receive_related_viewgrams() and complete_receive_related_viewgrams().
+   * The buffer is kept such that no memory needs to be allocated when the object
+   * is used for the next receive.
+   */
+  struct RelatedViewgramsReceive
+  {
+    //! dimensions, view and segment number of every viewgram (6 values per viewgram)
+    std::vector<int> viewgram_values;
+    //! receive-buffer for the values of all viewgrams
+    std::vector<float> buffer;
+    MPI_Request request;
+  };
+
+  /*! \brief starts receiving a RelatedViewgrams object
+   * \param receive object keeping track of the receive
+   * \param source the process id from which to receive the viewgrams
+   *
+   * This receives the count and dimensions of the viewgrams (see send_related_viewgrams()) and
+   * posts a non-blocking receive (\c MPI_Irecv) for their values. This function therefore returns
+   * before the values have arrived, such that they can be transferred while the current
+   * work is done. Call complete_receive_related_viewgrams() to get the viewgrams.
+   */
+  void start_receive_related_viewgrams(RelatedViewgramsReceive& receive, int source);
+
+  /*! \brief waits for the values of the viewgrams and constructs the RelatedViewgrams object
+   * \param viewgrams object that will be filled with the data
+   * \param receive object that was passed to start_receive_related_viewgrams() before
+   * \param proj_data_info_ptr the ProjDataInfo pointer describing the data
+   * \param symmetries_sptr the symmetries pointer constructed when setting up the projectors
+   *
+   * \see receive_and_construct_related_viewgrams()
+   */
+  void complete_receive_related_viewgrams(stir::RelatedViewgrams<float>*& viewgrams, 
+                                          RelatedViewgramsReceive& receive,
+                                          const stir::shared_ptr<stir::ProjDataInfo>& proj_data_info_ptr, 
+                                          const stir::shared_ptr<stir::DataSymmetriesForViewSegmentNumbers> symmetries_sptr);
         
   /*! \brief receives a Viewgram object
    * \param viewgram the viewgrams to be constructed
@@ -34,6 +34,7 @@
 #include "stir/ParsingObject.h"
 #include "stir/numerics/BSplines.h"
 #include <vector>
+#include <map>
 #include "stir/CartesianCoordinate3D.h"
 
 START_NAMESPACE_STIR
@@ -259,6 +260,13 @@ class ScatterEstimationByBin : public ParsingObject
 
   unsigned 
     find_in_detection_points_vector(const CartesianCoordinate3D<float>& coord) const;
+
+  //! fill detection_points_vector with the detection points of all bins
+  /*! This calls find_detectors() for all bins in the output projection data (in a fixed order).
+      Afterwards, detection_points_vector will not be modified anymore, such that
+      find_in_detection_points_vector() can be called from multiple threads without locking.
+  */
+  void set_up_detection_points();
   // private:
   const ProjDataInfoCylindricalNoArcCorr * proj_data_info_ptr;
   CartesianCoordinate3D<float>  shift_detector_coordinates_to_origin;
@@ -270,6 +278,10 @@ class ScatterEstimationByBin : public ParsingObject
 
   // next needs to be mutable because find_in_detection_points_vector is const
   mutable std::vector<CartesianCoordinate3D<float> > detection_points_vector;
+  //! map from a detection point to its index in detection_points_vector
+  mutable std::map<CartesianCoordinate3D<float>, unsigned> detection_points_map;
+  //! set by set_up_detection_points()
+  bool all_detection_points_are_found;
  private:
   int total_detectors;
 
@@ -389,6 +401,12 @@ class ScatterEstimationByBin : public ParsingObject
       call remove_cache_for_scattpoint_det_integrals_over_activity() first. 
   */
   void initialise_cache_for_scattpoint_det_integrals_over_activity();
+  //! compute all values in the caches that have not been computed yet
+  /*! Both caches need to be initialised and set_up_detection_points() needs to be called first.
+      All integrals are computed in parallel (when using OpenMP). Afterwards, the caches are
+      only read, so no locking or atomic operations are needed.
+  */
+  void fill_cache_for_scattpoint_det_integrals();
 };
 
 
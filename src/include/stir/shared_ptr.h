@@ -4,8 +4,9 @@
   \file
   \ingroup buildblock
   
-  \brief Import of std::shared_ptr, std::dynamic_pointer_cast and
-  std::static_pointer_cast (or corresponding boost versions if 
+  \brief Import of std::shared_ptr, std::dynamic_pointer_cast,
+  std::static_pointer_cast and the atomic_load/atomic_store/atomic_exchange
+  overloads for shared_ptr (or corresponding boost versions if 
   STIR_USE_BOOST_SHARED_PTR is set, i.e. normally when std::shared_ptr doesn't exist) 
   into the stir namespace.        
 */         
@@ -38,6 +39,9 @@ namespace stir {
   using boost::shared_ptr;
   using boost::dynamic_pointer_cast;
   using boost::static_pointer_cast;
+  using boost::atomic_load;
+  using boost::atomic_store;
+  using boost::atomic_exchange;
   //! work-around for using std::make_shared on old compilers
 #define MAKE_SHARED boost::make_shared
 }
@@ -47,6 +51,9 @@ namespace stir {
   using std::shared_ptr;
   using std::dynamic_pointer_cast;
   using std::static_pointer_cast;
+  using std::atomic_load;
+  using std::atomic_store;
+  using std::atomic_exchange;
   //! work-around for using std::make_shared on old compilers
 #define MAKE_SHARED std::make_shared
 }
@@ -30,6 +30,7 @@
 #include "stir/DiscretisedDensity.h"
 #include "stir/spatial_transformation/SpatialTransformation.h"
 #include "stir/numerics/BSplinesRegularGrid.h"
+#include "stir/spatial_transformation/PrecomputedLinearWarp.h"
 #include "stir/RegisteredParsingObject.h"
 #include "stir/Succeeded.h"
 #include <fstream>
@@ -81,6 +82,17 @@ class GatedSpatialTransformation: public RegisteredParsingObject<GatedSpatialTra
   void 
     accumulate_warp_image(DiscretisedDensity<3, float> & new_reference_image,
                           const GatedDiscretisedDensity & gated_image) const ;
+  //! Sets \a new_reference_image to the sum over the gates of the adjoint warp of each gate
+  /*! This is the adjoint of warp_image(GatedDiscretisedDensity&, const DiscretisedDensity<3, float>&),
+      see PrecomputedLinearWarp::accumulate_adjoint_warp(). No interpolation is performed.
+  */
+  void
+    adjoint_warp_image(DiscretisedDensity<3, float> & new_reference_image,
+                       const GatedDiscretisedDensity & gated_image) const ;
+  //! Adds the sum over the gates of the adjoint warp of each gate to \a new_reference_image
+  void
+    accumulate_adjoint_warp_image(DiscretisedDensity<3, float> & new_reference_image,
+                                  const GatedDiscretisedDensity & gated_image) const ;
   void set_defaults();
   Succeeded set_up(); 
   //@}
@@ -88,12 +100,16 @@ class GatedSpatialTransformation: public RegisteredParsingObject<GatedSpatialTra
   typedef RegisteredParsingObject<GatedSpatialTransformation,SpatialTransformation> base_type;
   void initialise_keymap();
   bool post_processing();	
+  //! compute the interpolation weights for every gate from the stored transformations
+  void set_up_warps();
   std::string _transformation_filename_prefix;
   GatedDiscretisedDensity _spatial_transformation_z;
   GatedDiscretisedDensity _spatial_transformation_y;
   GatedDiscretisedDensity _spatial_transformation_x;
   std::string _spline_level_number;
   bool _spatial_transformations_are_stored;
+  //! precomputed weights for every gate
+  std::vector<shared_ptr<const PrecomputedLinearWarp> > _warps;
   BSpline::BSplineType _spline_type;
   std::string _time_gate_definition_filename;
   TimeGateDefinitions _gate_defs;
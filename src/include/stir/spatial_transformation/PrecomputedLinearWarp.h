@@ -0,0 +1,88 @@
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup spatial_transformation
+  \brief Declaration of class stir::PrecomputedLinearWarp
+*/
+
+#ifndef __stir_spatial_transformation_PrecomputedLinearWarp_H__
+#define __stir_spatial_transformation_PrecomputedLinearWarp_H__
+
+#include "stir/DiscretisedDensity.h"
+#include "stir/BasicCoordinate.h"
+#include <vector>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup spatial_transformation
+  \brief Warps images with a fixed motion field using linear interpolation, with precomputed weights
+
+  This gives the same result as warp_image() with BSpline::linear, but the interpolation
+  weights are computed only once for the motion field. For every voxel, the
+  index of the first of the 8 neighbouring voxels used for the interpolation is stored,
+  together with the fractional position along each dimension (the weights are separable).
+  This is useful when the same motion field is used for many images, as in
+  GatedSpatialTransformation.
+
+  As in warp_image(), the motion fields are in mm, and voxel \c c of the warped image
+  is found by interpolating the original image at \c c plus the displacement (in
+  voxel units). Voxels for which that position is not strictly inside the image are set to 0.
+
+  The adjoint (i.e. transpose) of the warp is available as well. This distributes
+  every voxel value over its 8 neighbours with the same weights, and is therefore
+  not the same as warping with an inverse motion field.
+
+  When compiled with OpenMP, different planes are handled by different threads.
+
+  \warning All images need to have the same (regular) index range as the motion fields.
+*/
+class PrecomputedLinearWarp
+{
+public:
+  //! Computes the weights for the given motion fields (in mm)
+  PrecomputedLinearWarp(const DiscretisedDensity<3,float>& motion_x,
+                        const DiscretisedDensity<3,float>& motion_y,
+                        const DiscretisedDensity<3,float>& motion_z);
+
+  //! Sets \a out_density to the warped \a in_density
+  void warp(DiscretisedDensity<3,float>& out_density,
+            const DiscretisedDensity<3,float>& in_density) const;
+
+  //! Adds the adjoint of the warp applied to \a in_density to \a out_density
+  void accumulate_adjoint_warp(DiscretisedDensity<3,float>& out_density,
+                               const DiscretisedDensity<3,float>& in_density) const;
+
+private:
+  BasicCoordinate<3,int> _min_indices;
+  BasicCoordinate<3,int> _max_indices;
+  //! distance between voxels in the same column and plane in a contiguous array
+  int _y_stride;
+  int _z_stride;
+  //! for every voxel, the offset of the first neighbour used, or -1 if the voxel is set to 0
+  std::vector<int> _offsets;
+  //! for every voxel, the fractional positions along z, y and x
+  std::vector<float> _fractions;
+
+  void check_index_range(const DiscretisedDensity<3,float>& density, const char * const caller) const;
+};
+
+END_NAMESPACE_STIR
+
+#endif
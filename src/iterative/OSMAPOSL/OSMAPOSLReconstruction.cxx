@@ -72,6 +72,67 @@ using std::endl;
 
 START_NAMESPACE_STIR
 
+/* Helper functions for the update loops in update_estimate().
+   The generic versions use full_iterators. The versions for DiscretisedDensity<3,float>
+   use plain pointers when the images are stored contiguously, such that the compiler
+   can vectorise the loops.
+*/
+template <typename TargetT>
+static void
+divide_images(TargetT& numerator, const TargetT& denominator, const float small_num)
+{
+  divide(numerator.begin_all(), numerator.end_all(), 
+         denominator.begin_all(),
+         small_num);
+}
+
+static void
+divide_images(DiscretisedDensity<3,float>& numerator, const DiscretisedDensity<3,float>& denominator, const float small_num)
+{
+  if (numerator.is_contiguous() && denominator.is_contiguous() &&
+      numerator.size_all() == denominator.size_all())
+    {
+      float * const numerator_ptr = numerator.get_full_data_ptr();
+      divide(numerator_ptr, numerator_ptr + numerator.size_all(),
+             denominator.get_const_full_data_ptr(),
+             small_num);
+    }
+  else
+    divide(numerator.begin_all(), numerator.end_all(), 
+           denominator.begin_all(),
+           small_num);
+}
+
+template <typename TargetT>
+static void
+multiply_images(TargetT& image, const TargetT& factor)
+{
+  typename TargetT::const_full_iterator factor_iter = factor.begin_all_const(); 
+  const typename TargetT::const_full_iterator end_factor_iter = factor.end_all_const(); 
+  typename TargetT::full_iterator image_iter = image.begin_all(); 
+  while (factor_iter!=end_factor_iter) 
+    { 
+      *image_iter *= (*factor_iter); 
+      ++image_iter; ++factor_iter; 
+    } 
+}
+
+static void
+multiply_images(DiscretisedDensity<3,float>& image, const DiscretisedDensity<3,float>& factor)
+{
+  if (image.is_contiguous() && factor.is_contiguous() &&
+      image.size_all() == factor.size_all())
+    {
+      float * const image_ptr = image.get_full_data_ptr();
+      const float * const factor_ptr = factor.get_const_full_data_ptr();
+      const size_t size = image.size_all();
+      for (size_t i=0; i<size; ++i)
+        image_ptr[i] *= factor_ptr[i];
+    }
+  else
+    multiply_images<DiscretisedDensity<3,float> >(image, factor);
+}
+
 template <typename TargetT>
 const char * const
 OSMAPOSLReconstruction <TargetT> ::registered_name =
@@ -429,10 +490,7 @@ update_estimate(TargetT &current_image_estimate)
     
   if (this->objective_function_sptr->prior_is_zero())
     {
-      divide(multiplicative_update_image_ptr->begin_all(),
-             multiplicative_update_image_ptr->end_all(), 
-             sensitivity.begin_all(),
-             small_num);
+      divide_images(*multiplicative_update_image_ptr, sensitivity, small_num);
         
     }
     else
@@ -486,10 +544,7 @@ update_estimate(TargetT &current_image_estimate)
           }
         }
       }         
-      divide(multiplicative_update_image_ptr->begin_all(),
-             multiplicative_update_image_ptr->end_all(), 
-             denominator_ptr->begin_all(),
-             small_num);
+      divide_images(*multiplicative_update_image_ptr, *denominator_ptr, small_num);
     }
     
     info(boost::format("Number of (cancelled) singularities in Sensitivity division: %1%") % count);
@@ -539,16 +594,7 @@ update_estimate(TargetT &current_image_estimate)
     }  
 
   //current_image_estimate *= *multiplicative_update_image_ptr; 
-  {
-    typename TargetT::const_full_iterator multiplicative_update_image_iter = multiplicative_update_image_ptr->begin_all_const(); 
-    const typename TargetT::const_full_iterator end_multiplicative_update_image_iter = multiplicative_update_image_ptr->end_all_const(); 
-    typename TargetT::full_iterator current_image_estimate_iter = current_image_estimate.begin_all(); 
-    while (multiplicative_update_image_iter!=end_multiplicative_update_image_iter) 
-      { 
-        *current_image_estimate_iter *= (*multiplicative_update_image_iter); 
-        ++current_image_estimate_iter; ++multiplicative_update_image_iter; 
-      } 
-  }
+  multiply_images(current_image_estimate, *multiplicative_update_image_ptr);
   
 #ifndef PARALLEL
   //cerr << "Subset : " << subset_timer.value() << "secs " <<endl;
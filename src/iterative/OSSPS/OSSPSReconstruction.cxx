@@ -353,7 +353,32 @@ update_estimate(TargetT &current_image_estimate)
   unique_ptr< TargetT > numerator_ptr
     (current_image_estimate.get_empty_copy());
 
-  this->objective_function_sptr->compute_sub_gradient(*numerator_ptr, current_image_estimate, subset_num);
+  const bool compute_denominator =
+    recompute_penalty_term_in_denominator || 
+    (this->get_subiteration_num() == this->get_start_subiteration_num());
+  // will contain the penalty term in the denominator (if it is computed)
+  unique_ptr< TargetT > work_image_ptr;
+
+  if (compute_denominator && !this->objective_function_sptr->prior_is_zero())
+    {
+      // compute the gradient and curvature of the prior in one go
+      // (equivalent to compute_sub_gradient() and parabolic_surrogate_curvature())
+      this->objective_function_sptr->
+        compute_sub_gradient_without_penalty(*numerator_ptr, current_image_estimate, subset_num);
+      unique_ptr< TargetT > prior_gradient_ptr
+        (current_image_estimate.get_empty_copy());
+      work_image_ptr.reset(current_image_estimate.get_empty_copy());
+      static_cast<PriorWithParabolicSurrogate<TargetT>&>(*get_prior_ptr()).
+        compute_gradient_and_parabolic_surrogate_curvature(*prior_gradient_ptr, *work_image_ptr,
+                                                           current_image_estimate);
+      //*numerator_ptr -= *prior_gradient_ptr/this->num_subsets;
+      std::transform(numerator_ptr->begin_all(), numerator_ptr->end_all(),
+                     prior_gradient_ptr->begin_all(),
+                     numerator_ptr->begin_all(),
+                     _1 - _2 / static_cast<float>(this->num_subsets));
+    }
+  else
+    this->objective_function_sptr->compute_sub_gradient(*numerator_ptr, current_image_estimate, subset_num);
   //*numerator_ptr *= this->num_subsets;
   std::transform(numerator_ptr->begin_all(), numerator_ptr->end_all(),
 		 numerator_ptr->begin_all(),
@@ -364,17 +389,12 @@ update_estimate(TargetT &current_image_estimate)
 
   // now divide by denominator
 
-  if (recompute_penalty_term_in_denominator || 
-      (this->get_subiteration_num() == this->get_start_subiteration_num()))
+  if (compute_denominator)
     {
-      unique_ptr< TargetT > work_image_ptr
-	(current_image_estimate.get_empty_copy());
-      
       // avoid work (or crash) when penalty is 0
       if (!this->objective_function_sptr->prior_is_zero())
 	{
-	  static_cast<PriorWithParabolicSurrogate<TargetT>&>(*get_prior_ptr()).
-	    parabolic_surrogate_curvature(*work_image_ptr, current_image_estimate);   
+	  // parabolic surrogate curvature was computed above
 	  //*work_image_ptr *= 2;
 	  //*work_image_ptr += *precomputed_denominator_ptr ;
 	  std::transform(work_image_ptr->begin_all(), work_image_ptr->end_all(),
@@ -383,7 +403,10 @@ update_estimate(TargetT &current_image_estimate)
 			 _1 * 2 + _2);
 	}
       else
-	*work_image_ptr = *precomputed_denominator_ptr ;
+	{
+	  work_image_ptr.reset(current_image_estimate.get_empty_copy());
+	  *work_image_ptr = *precomputed_denominator_ptr ;
+	}
     
       // KT 09/12/2002 new
       // avoid division by 0 by thresholding the denominator to be strictly positive      
@@ -7,7 +7,7 @@
 */
 /*
     Copyright (C) 2003, Hammersmith Imanet Ltd
-    Copyright (C) 2014, University College London
+    Copyright (C) 2014, 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -24,6 +24,7 @@
 */
 
 #include "stir/listmode/CListModeData.h"
+#include "stir/listmode/CListRecord.h"
 #include "stir/ExamInfo.h"
 #include "stir/is_null_ptr.h"
 
@@ -51,6 +52,42 @@ CListModeData::
 //  return exam_info_sptr;
 //}
 
+void
+CListModeData::
+create_empty_records(std::vector<shared_ptr<CListRecord> >& records) const
+{
+  for (std::vector<shared_ptr<CListRecord> >::iterator iter = records.begin();
+       iter != records.end();
+       ++iter)
+    {
+      if (is_null_ptr(*iter))
+        *iter = this->get_empty_record_sptr();
+    }
+}
+
+std::size_t
+CListModeData::
+get_next_records(std::vector<shared_ptr<CListRecord> >& records) const
+{
+  this->create_empty_records(records);
+  std::size_t num_records_read = 0;
+  for (std::vector<shared_ptr<CListRecord> >::iterator iter = records.begin();
+       iter != records.end();
+       ++iter, ++num_records_read)
+    {
+      if (this->get_next_record(**iter) == Succeeded::no)
+        break;
+    }
+  return num_records_read;
+}
+
+Succeeded
+CListModeData::
+update_saved_get_position(const SavedPosition&)
+{
+  return Succeeded::no;
+}
+
 const Scanner* 
 CListModeData::
 get_scanner_ptr() const
@@ -226,6 +226,22 @@ get_next_record(CListRecord& record_of_general_type) const
   }
 }
 
+template <class CListRecordT>
+std::size_t
+CListModeDataECAT<CListRecordT>::
+get_next_records(std::vector<shared_ptr<CListRecord> >& records) const
+{
+  this->create_empty_records(records);
+  std::size_t num_records_read =
+    current_lm_data_ptr->get_next_records_from_pointers(records.begin(), records.end());
+  // continue with the next .lm file if necessary (see get_next_record())
+  while (num_records_read < records.size() &&
+         open_lm_file(current_lm_file+1) == Succeeded::yes)
+    num_records_read +=
+      current_lm_data_ptr->get_next_records_from_pointers(records.begin() + num_records_read, records.end());
+  return num_records_read;
+}
+
 
 
 template <class CListRecordT>
@@ -270,6 +286,21 @@ set_get_position(const typename CListModeDataECAT<CListRecordT>::SavedPosition&
   return
     current_lm_data_ptr->set_get_position(saved_get_positions[pos].second);
 }
+
+template <class CListRecordT>
+Succeeded
+CListModeDataECAT<CListRecordT>::
+update_saved_get_position(const typename CListModeDataECAT<CListRecordT>::SavedPosition& pos)
+{
+  if (pos >= saved_get_positions.size())
+    return Succeeded::no;
+  if (saved_get_positions[pos].first == current_lm_file)
+    return current_lm_data_ptr->update_saved_get_position(saved_get_positions[pos].second);
+  // the position was saved in another .lm file
+  saved_get_positions[pos].first = current_lm_file;
+  saved_get_positions[pos].second = current_lm_data_ptr->save_get_position();
+  return Succeeded::yes;
+}
 #if 0
 template <class CListRecordT>
 SavedPosition
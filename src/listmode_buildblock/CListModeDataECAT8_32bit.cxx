@@ -110,6 +110,14 @@ get_next_record(CListRecord& record_of_general_type) const
   return current_lm_data_ptr->get_next_record(record);
  }
 
+std::size_t
+CListModeDataECAT8_32bit::
+get_next_records(std::vector<shared_ptr<CListRecord> >& records) const
+{
+  this->create_empty_records(records);
+  return current_lm_data_ptr->get_next_records_from_pointers(records.begin(), records.end());
+}
+
 
 Succeeded
 CListModeDataECAT8_32bit::
@@ -135,5 +143,13 @@ set_get_position(const CListModeDataECAT8_32bit::SavedPosition& pos)
     current_lm_data_ptr->set_get_position(pos);
 }
 
+Succeeded
+CListModeDataECAT8_32bit::
+update_saved_get_position(const CListModeDataECAT8_32bit::SavedPosition& pos)
+{
+  return
+    current_lm_data_ptr->update_saved_get_position(pos);
+}
+
 } // namespace ecat
 END_NAMESPACE_STIR
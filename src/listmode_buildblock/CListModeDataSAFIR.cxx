@@ -91,6 +91,19 @@ get_next_record(CListRecord& record_of_general_type) const
 	
 }
 
+template <class CListRecordT>
+std::size_t
+CListModeDataSAFIR<CListRecordT>::
+get_next_records(std::vector<shared_ptr<CListRecord> >& records) const
+{
+	this->create_empty_records(records);
+	const std::size_t num_records_read =
+		current_lm_data_ptr->get_next_records_from_pointers(records.begin(), records.end());
+	for (std::size_t i=0; i<num_records_read; ++i)
+		static_cast<CListRecordT&>(*records[i]).event_SAFIR().set_map(map);
+	return num_records_read;
+}
+
 template <class CListRecordT>
 Succeeded
 CListModeDataSAFIR<CListRecordT>::
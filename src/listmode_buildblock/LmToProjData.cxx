@@ -9,7 +9,7 @@
 */
 /*
     Copyright (C) 2000 - 2011-12-31, Hammersmith Imanet Ltd
-    Copyright (C) 2013, University College London
+    Copyright (C) 2013, 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -35,6 +35,8 @@ USE_SegmentByView
   Currently we work (somewhat tediously) around this problem by using Array classes directly.
   If you want to use the Segment classes (safer and cleaner)
   #define USE_SegmentByView
+  Note that when using memory mapped output (see MappedProjDataOutput below), we
+  do store integers when possible.
 
 
 FRAME_BASED_DT_CORR:
@@ -82,10 +84,18 @@ FRAME_BASED_DT_CORR:
 #include "stir/CPUTimer.h"
 #include "stir/recon_buildblock/TrivialBinNormalisation.h"
 #include "stir/is_null_ptr.h"
+#include "boost/cstdint.hpp"
+#include "boost/scoped_ptr.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #ifndef STIR_NO_NAMESPACES
 using std::string;
@@ -140,6 +150,147 @@ construct_proj_data(shared_ptr<iostream>& output,
 		    const ExamInfo& exam_info,
                     const shared_ptr<ProjDataInfo>& proj_data_info_ptr);
 
+namespace {
+/* Helper class for binning directly into a memory mapped Interfile projection data file.
+   The file is created with its final size such that every bin can be incremented in place.
+   Data are stored with order Segment_View_AxialPos_TangPos, with segments in increasing order.
+*/
+class MappedProjDataOutput
+{
+public:
+  MappedProjDataOutput(const string& output_filename,
+                       const ExamInfo& exam_info,
+                       const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+                       const bool store_counts);
+
+  //! add \a value to the bin (after rounding to an integer if we store counts)
+  void add(const Bin& bin, const float value)
+  {
+    const std::size_t index = this->get_index(bin);
+    if (this->store_counts)
+      this->counts_ptr[index] += round_to_count(value);
+    else
+      this->values_ptr[index] += value;
+  }
+
+  //! as add(), but can be called from multiple threads
+  void add_atomically(const Bin& bin, const float value)
+  {
+    const std::size_t index = this->get_index(bin);
+    if (this->store_counts)
+      {
+        const boost::int32_t count = round_to_count(value);
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+        this->counts_ptr[index] += count;
+      }
+    else
+      {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+        this->values_ptr[index] += value;
+      }
+  }
+
+  //! make sure all data are written to disk
+  void flush();
+
+private:
+  std::size_t get_index(const Bin& bin) const
+  {
+    return
+      this->segment_offsets[bin.segment_num()] +
+      (static_cast<std::size_t>(bin.view_num() - this->min_view_num) *
+       this->proj_data_info_sptr->get_num_axial_poss(bin.segment_num()) +
+       (bin.axial_pos_num() - this->proj_data_info_sptr->get_min_axial_pos_num(bin.segment_num()))) *
+      this->num_tangential_poss +
+      (bin.tangential_pos_num() - this->min_tangential_pos_num);
+  }
+
+  static boost::int32_t round_to_count(const float value)
+  { return static_cast<boost::int32_t>(value >= 0 ? value + .5F : value - .5F); }
+
+  shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  const bool store_counts;
+  VectorWithOffset<std::size_t> segment_offsets;
+  int min_view_num;
+  int min_tangential_pos_num;
+  std::size_t num_tangential_poss;
+  boost::scoped_ptr<boost::interprocess::file_mapping> file_mapping_sptr;
+  boost::scoped_ptr<boost::interprocess::mapped_region> region_sptr;
+  boost::int32_t * counts_ptr;
+  float * values_ptr;
+};
+
+/* Helper class for reading records in blocks with CListModeData::get_next_records().
+   For list mode data that is read from a stream, this avoids a virtual function call
+   per record. Records are returned without copying them. As records are read ahead,
+   synchronise_position() has to be called before saving the position in the list
+   mode data, and discard() after setting it.
+   The position at the start of every block is saved in the same slot
+   (if the list mode data supports CListModeData::update_saved_get_position()).
+*/
+class ListModeRecordReader
+{
+public:
+  ListModeRecordReader(CListModeData& lm_data, const std::size_t block_size)
+    : lm_data(lm_data), records(block_size),
+      num_records_in_block(0), next_record_in_block(0),
+      has_block_start_position(false)
+  {}
+
+  //! swap the next record with \a record_sptr. Returns \c false if there are no more records.
+  bool get_next_record(shared_ptr<CListRecord>& record_sptr)
+  {
+    if (this->next_record_in_block == this->num_records_in_block)
+      {
+        if (!this->has_block_start_position ||
+            this->lm_data.update_saved_get_position(this->block_start_position) == Succeeded::no)
+          {
+            this->block_start_position = this->lm_data.save_get_position();
+            this->has_block_start_position = true;
+          }
+        this->num_records_in_block = this->lm_data.get_next_records(this->records);
+        this->next_record_in_block = 0;
+        if (this->num_records_in_block == 0)
+          return false;
+      }
+    std::swap(record_sptr, this->records[this->next_record_in_block++]);
+    return true;
+  }
+
+  //! set the position in the list mode data to just after the last record returned
+  void synchronise_position()
+  {
+    if (this->next_record_in_block == this->num_records_in_block)
+      return;
+    this->lm_data.set_get_position(this->block_start_position);
+    // skip the records that were returned already
+    std::vector<shared_ptr<CListRecord> >
+      records_to_skip(this->records.begin(), this->records.begin() + this->next_record_in_block);
+    this->lm_data.get_next_records(records_to_skip);
+    this->discard();
+  }
+
+  //! forget about records that were read ahead (e.g. after setting the position in the list mode data)
+  void discard()
+  {
+    this->num_records_in_block = 0;
+    this->next_record_in_block = 0;
+  }
+
+private:
+  CListModeData& lm_data;
+  std::vector<shared_ptr<CListRecord> > records;
+  std::size_t num_records_in_block;
+  std::size_t next_record_in_block;
+  CListModeData::SavedPosition block_start_position;
+  bool has_block_start_position;
+};
+}
+
 /**************************************************************
  The 3 parsing functions
 ***************************************************************/
@@ -152,6 +303,8 @@ set_defaults()
   store_delayeds = true;
   interactive=false;
   num_segments_in_memory = -1;
+  use_memory_mapped_output = false;
+  parallel_binning = false;
   normalisation_ptr.reset(new TrivialBinNormalisation);
   post_normalisation_ptr.reset(new TrivialBinNormalisation);
   do_pre_normalisation =0;
@@ -174,6 +327,8 @@ initialise_keymap()
   parser.add_key("maximum absolute segment number to process", &max_segment_num_to_process); 
   parser.add_key("do pre normalisation ", &do_pre_normalisation);
   parser.add_key("num_segments_in_memory", &num_segments_in_memory);
+  parser.add_key("use memory mapped output", &use_memory_mapped_output);
+  parser.add_key("parallel binning", &parallel_binning);
 
   //if (lm_data_ptr->has_delayeds()) TODO we haven't read the CListModeData yet, so cannot access has_delayeds() yet
   // one could add the next 2 keywords as part of a callback function for the 'input file' keyword.
@@ -234,7 +389,7 @@ post_processing()
     }
 
   const int num_segments = template_proj_data_info_ptr->get_num_segments();
-  if (num_segments_in_memory == -1 || interactive)
+  if (num_segments_in_memory == -1 || interactive || use_memory_mapped_output)
     num_segments_in_memory = num_segments;
   else
     num_segments_in_memory =
@@ -531,11 +686,35 @@ process_data()
   VectorWithOffset<CListModeData::SavedPosition> 
     frame_start_positions(1, static_cast<int>(frame_defs.get_num_frames()));
   shared_ptr <CListRecord> record_sptr = lm_data_ptr->get_empty_record_sptr();
-  CListRecord& record = *record_sptr;
+  // records are read in blocks of this size (this saves one position in the list mode data per block)
+  ListModeRecordReader record_reader(*lm_data_ptr, 10000);
 
-  if (!record.event().is_valid_template(*template_proj_data_info_ptr))
+  if (!record_sptr->event().is_valid_template(*template_proj_data_info_ptr))
 	  error("The scanner template is not valid for LmToProjData. This might be because of unsupported arc correction.");
 
+  const ProjDataInfo& proj_data_info = *template_proj_data_info_ptr;
+  const bool use_mapped_output = use_memory_mapped_output && !interactive;
+  // when no normalisation is used, we can store (integer) counts
+  const bool store_counts =
+    !do_pre_normalisation && post_normalisation_ptr->is_trivial();
+
+#ifdef STIR_OPENMP
+  const bool bin_in_parallel = parallel_binning && do_time_frame && !interactive;
+  // if normalisation factors depend on current_time, we need to end a batch at every time tag
+  const bool end_batch_at_time_tag =
+    do_pre_normalisation ? !normalisation_ptr->is_trivial() : !post_normalisation_ptr->is_trivial();
+  // records for a batch of events (allocated only once)
+  const std::size_t batch_size = 100000;
+  std::vector<shared_ptr<CListRecord> > batch_records;
+  if (bin_in_parallel)
+    {
+      batch_records.resize(batch_size);
+      for (std::size_t i=0; i<batch_size; ++i)
+        batch_records[i] = lm_data_ptr->get_empty_record_sptr();
+      cerr << "LmToProjData: binning with " << omp_get_max_threads() << " threads\n";
+    }
+#endif
+
 
   /* Here starts the main loop which will store the listmode data. */
   for (current_frame_num = 1;
@@ -554,14 +733,19 @@ process_data()
       // *********** open output file
       shared_ptr<iostream> output;
       shared_ptr<ProjData> proj_data_ptr;
+      shared_ptr<MappedProjDataOutput> mapped_output_sptr;
 
       {
         char rest[50];
         sprintf(rest, "_f%dg1d0b0", current_frame_num);
         const string output_filename = output_filename_prefix + rest;
       
-        proj_data_ptr = 
-          construct_proj_data(output, output_filename, this_frame_exam_info, template_proj_data_info_ptr);
+        if (use_mapped_output)
+          mapped_output_sptr.reset(new MappedProjDataOutput(output_filename, this_frame_exam_info, 
+                                                            template_proj_data_info_ptr, store_counts));
+        else
+          proj_data_ptr = 
+            construct_proj_data(output, output_filename, this_frame_exam_info, template_proj_data_info_ptr);
       }
 
       long num_prompts_in_frame = 0;
@@ -575,16 +759,16 @@ process_data()
 	 segments between start_segment_index and 
 	 start_segment_index+num_segments_in_memory.
        */
-       for (int start_segment_index = proj_data_ptr->get_min_segment_num(); 
-	    start_segment_index <= proj_data_ptr->get_max_segment_num(); 
+       for (int start_segment_index = proj_data_info.get_min_segment_num(); 
+	    start_segment_index <= proj_data_info.get_max_segment_num(); 
 	    start_segment_index += num_segments_in_memory) 
 	 {
 	 
 	   const int end_segment_index = 
-	     min( proj_data_ptr->get_max_segment_num()+1, start_segment_index + num_segments_in_memory) - 1;
+	     min( proj_data_info.get_max_segment_num()+1, start_segment_index + num_segments_in_memory) - 1;
     
-	   if (!interactive)
-	     allocate_segments(segments, start_segment_index, end_segment_index, proj_data_ptr->get_proj_data_info_ptr());
+	   if (!interactive && !use_mapped_output)
+	     allocate_segments(segments, start_segment_index, end_segment_index, &proj_data_info);
 
 	   // the next variable is used to see if there are more events to store for the current segments
 	   // num_events_to_store-more_events will be the number of allowed coincidence events currently seen in the file
@@ -594,12 +778,13 @@ process_data()
 	   long more_events = 
          do_time_frame? 1 : num_events_to_store;
 
-	   if (start_segment_index != proj_data_ptr->get_min_segment_num())
+	   if (start_segment_index != proj_data_info.get_min_segment_num())
 	     {
 	       // we're going once more through the data (for the next batch of segments)
 	       cerr << "\nProcessing next batch of segments\n";
 	       // go to the beginning of the listmode data for this frame
 	       lm_data_ptr->set_get_position(frame_start_positions[current_frame_num]);
+	       record_reader.discard();
 	       current_time = start_time;
 	     }
 	   else
@@ -611,24 +796,152 @@ process_data()
 	       // as we first might have to skip some events before we get to start_time.
 	       // So, let's do that now.
 	       while (current_time < start_time && 
-		      lm_data_ptr->get_next_record(record) == Succeeded::yes) 
+		      record_reader.get_next_record(record_sptr)) 
 		 {
-		   if (record.is_time())
-		     current_time = record.time().get_time_in_secs();
+		   if (record_sptr->is_time())
+		     current_time = record_sptr->time().get_time_in_secs();
 		 }
 	       // now save position such that we can go back
+	       record_reader.synchronise_position();
 	       frame_start_positions[current_frame_num] = 
 		 lm_data_ptr->save_get_position();
 	     }
 	   {      
+#ifdef STIR_OPENMP
+	     if (bin_in_parallel)
+	       {
+		 // thread-local partial sinograms (not used for memory mapped output)
+		 std::vector<VectorWithOffset<segment_type *> > local_segments;
+		 if (!use_mapped_output)
+		   {
+		     local_segments.resize(omp_get_max_threads(), segments);
+		     for (int thread_num=0; thread_num<static_cast<int>(local_segments.size()); ++thread_num)
+		       allocate_segments(local_segments[thread_num], start_segment_index, end_segment_index, &proj_data_info);
+		   }
+
+		 bool more_records = true;
+		 std::size_t num_events_in_batch = 0;
+		 while (more_records)
+		   {
+		     // read a batch of events (sequentially)
+		     bool time_tag_pending = false;
+		     while (num_events_in_batch < batch_size)
+		       {
+			 if (!record_reader.get_next_record(batch_records[num_events_in_batch]))
+			   {
+			     // no more events in file for some reason
+			     more_records = false;
+			     break;
+			   }
+			 const CListRecord& record = *batch_records[num_events_in_batch];
+			 if (record.is_time() && end_time > 0.01) // Direct comparison within doubles is unsafe.
+			   {
+			     const double new_time = record.time().get_time_in_secs();
+			     if (new_time >= end_time)
+			       {
+				 current_time = new_time;
+				 more_records = false;
+				 break;
+			       }
+			     if (end_batch_at_time_tag && num_events_in_batch > 0 && new_time != current_time)
+			       {
+				 // first bin the events with the current time
+				 time_tag_pending = true;
+				 break;
+			       }
+			     current_time = new_time;
+			     assert(current_time>=start_time);
+			     process_new_time_event(record.time());
+			   }
+			 if (record.is_event())
+			   ++num_events_in_batch;
+		       }
+
+		     // bin the batch in parallel
+		     long num_stored_events_in_batch = 0;
+		     long num_prompts_in_batch = 0;
+		     long num_delayeds_in_batch = 0;
+#pragma omp parallel for schedule(static) reduction(+:num_stored_events_in_batch,num_prompts_in_batch,num_delayeds_in_batch)
+		     for (int i=0; i<static_cast<int>(num_events_in_batch); ++i)
+		       {
+			 const CListEvent& event = batch_records[i]->event();
+			 Bin bin;
+			 // set value in case the event decoder doesn't touch it
+			 bin.set_bin_value(1);
+			 get_bin_from_event(bin, event);
+			 // check if it's inside the range we want to store
+			 if (bin.get_bin_value()<=0
+			     || bin.tangential_pos_num()< proj_data_info.get_min_tangential_pos_num()
+			     || bin.tangential_pos_num()> proj_data_info.get_max_tangential_pos_num()
+			     || bin.axial_pos_num()<proj_data_info.get_min_axial_pos_num(bin.segment_num())
+			     || bin.axial_pos_num()>proj_data_info.get_max_axial_pos_num(bin.segment_num())
+			     )
+			   continue;
+			 const int event_increment =
+			   event.is_prompt() 
+			   ? ( store_prompts ? 1 : 0 ) // it's a prompt
+			   :  delayed_increment;//it is a delayed-coincidence event
+			 if (event_increment==0)
+			   continue;
+			 // now check if we have its segment in memory
+			 if (bin.segment_num() < start_segment_index || bin.segment_num() > end_segment_index)
+			   continue;
+			 do_post_normalisation(bin);
+			 num_stored_events_in_batch += event_increment;
+			 if (event.is_prompt())
+			   ++num_prompts_in_batch;
+			 else
+			   ++num_delayeds_in_batch;
+			 if (use_mapped_output)
+			   mapped_output_sptr->add_atomically(bin, bin.get_bin_value() * event_increment);
+			 else
+			   (*local_segments[omp_get_thread_num()][bin.segment_num()])
+			     [bin.view_num()][bin.axial_pos_num()][bin.tangential_pos_num()] += 
+			     bin.get_bin_value() * event_increment;
+		       }
+		     num_stored_events += num_stored_events_in_batch;
+		     num_prompts_in_frame += num_prompts_in_batch;
+		     num_delayeds_in_frame += num_delayeds_in_batch;
+		     cout << "\r" << num_stored_events << " events stored" << flush;
+
+		     if (time_tag_pending)
+		       {
+			 // the time tag is still in the record after the batch, process it now
+			 const CListRecord& record = *batch_records[num_events_in_batch];
+			 current_time = record.time().get_time_in_secs();
+			 process_new_time_event(record.time());
+			 if (record.is_event())
+			   {
+			     // keep it for the next batch
+			     std::swap(batch_records[0], batch_records[num_events_in_batch]);
+			     num_events_in_batch = 1;
+			   }
+			 else
+			   num_events_in_batch = 0;
+		       }
+		     else
+		       num_events_in_batch = 0;
+		   } // end of while loop over all events
+
+		 // "reduce" data constructed by threads
+		 for (int thread_num=0; thread_num<static_cast<int>(local_segments.size()); ++thread_num)
+		   for (int seg=start_segment_index ; seg<=end_segment_index; seg++)
+		     {
+		       *segments[seg] += *local_segments[thread_num][seg];
+		       delete local_segments[thread_num][seg];
+		     }
+	       }
+	     else
+#endif
 	     // loop over all events in the listmode file
 	     while (more_events)
 	       {
-		 if (lm_data_ptr->get_next_record(record) == Succeeded::no) 
+		 if (!record_reader.get_next_record(record_sptr))
 		   {
 		     // no more events in file for some reason
 		     break; //get out of while loop
 		   }
+		 const CListRecord& record = *record_sptr;
          if (record.is_time() && end_time > 0.01) // Direct comparison within doubles is unsafe.
 		   {
 		     current_time = record.time().get_time_in_secs();
@@ -651,14 +964,14 @@ process_data()
 		     		       
 		     // check if it's inside the range we want to store
 		     if (bin.get_bin_value()>0
-			 && bin.tangential_pos_num()>= proj_data_ptr->get_min_tangential_pos_num()
-			 && bin.tangential_pos_num()<= proj_data_ptr->get_max_tangential_pos_num()
-			 && bin.axial_pos_num()>=proj_data_ptr->get_min_axial_pos_num(bin.segment_num())
-			 && bin.axial_pos_num()<=proj_data_ptr->get_max_axial_pos_num(bin.segment_num())
+			 && bin.tangential_pos_num()>= proj_data_info.get_min_tangential_pos_num()
+			 && bin.tangential_pos_num()<= proj_data_info.get_max_tangential_pos_num()
+			 && bin.axial_pos_num()>=proj_data_info.get_min_axial_pos_num(bin.segment_num())
+			 && bin.axial_pos_num()<=proj_data_info.get_max_axial_pos_num(bin.segment_num())
 			 ) 
 		       {
-			 assert(bin.view_num()>=proj_data_ptr->get_min_view_num());
-			 assert(bin.view_num()<=proj_data_ptr->get_max_view_num());
+			 assert(bin.view_num()>=proj_data_info.get_min_view_num());
+			 assert(bin.view_num()<=proj_data_info.get_max_view_num());
             
 			 // see if we increment or decrement the value in the sinogram
 			 const int event_increment =
@@ -689,6 +1002,8 @@ process_data()
 			       printf("Seg %4d view %4d ax_pos %4d tang_pos %4d time %8g stored with incr %d \n", 
 				      bin.segment_num(), bin.view_num(), bin.axial_pos_num(), bin.tangential_pos_num(),
 				      current_time, event_increment);
+			     else if (use_mapped_output)
+			       mapped_output_sptr->add(bin, bin.get_bin_value() * event_increment);
 			     else
 			       (*segments[bin.segment_num()])[bin.view_num()][bin.axial_pos_num()][bin.tangential_pos_num()] += 
 			       bin.get_bin_value() * 
@@ -708,7 +1023,9 @@ process_data()
 	       max(time_of_last_stored_event,current_time); 
 	   } 
 
-	   if (!interactive)
+	   if (use_mapped_output)
+	     mapped_output_sptr->flush();
+	   else if (!interactive)
 	   save_and_delete_segments(output, segments, 
 				    start_segment_index, end_segment_index, 
 				    *proj_data_ptr);  
@@ -717,6 +1034,8 @@ process_data()
 	    <<  "\nNumber of delayeds stored in this time period: " << num_delayeds_in_frame
 	    << '\n';
    } // end of loop over frames
+ // leave the list mode data after the last record we used
+ record_reader.synchronise_position();
 
  timer.stop();
 
@@ -823,5 +1142,86 @@ construct_proj_data(shared_ptr<iostream>& output,
 #endif
 }
 
+namespace {
+MappedProjDataOutput::
+MappedProjDataOutput(const string& output_filename,
+                     const ExamInfo& exam_info,
+                     const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+                     const bool store_counts)
+  : proj_data_info_sptr(proj_data_info_sptr),
+    store_counts(store_counts),
+    segment_offsets(proj_data_info_sptr->get_min_segment_num(), proj_data_info_sptr->get_max_segment_num()),
+    min_view_num(proj_data_info_sptr->get_min_view_num()),
+    min_tangential_pos_num(proj_data_info_sptr->get_min_tangential_pos_num()),
+    num_tangential_poss(static_cast<std::size_t>(proj_data_info_sptr->get_num_tangential_poss())),
+    counts_ptr(0),
+    values_ptr(0)
+{
+  // find where every segment starts
+  vector<int> segment_sequence_in_stream;
+  std::size_t num_elems = 0;
+  for (int segment_num=proj_data_info_sptr->get_min_segment_num();
+       segment_num<=proj_data_info_sptr->get_max_segment_num();
+       ++segment_num)
+    {
+      segment_sequence_in_stream.push_back(segment_num);
+      this->segment_offsets[segment_num] = num_elems;
+      num_elems += 
+        static_cast<std::size_t>(proj_data_info_sptr->get_num_views()) *
+        proj_data_info_sptr->get_num_axial_poss(segment_num) *
+        this->num_tangential_poss;
+    }
+  const std::size_t size_of_elem = store_counts ? sizeof(boost::int32_t) : sizeof(float);
+
+  // write the header (and create an empty data file)
+  {
+    shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo(exam_info));
+    ProjDataInterfile proj_data(exam_info_sptr, proj_data_info_sptr, output_filename, ios::out,
+                                segment_sequence_in_stream,
+                                ProjDataFromStream::Segment_View_AxialPos_TangPos,
+                                store_counts ? NumericType::INT : NumericType::FLOAT);
+  }
+  // now give the data file its final size (filled with zeroes)
+  string data_filename = output_filename;
+  add_extension(data_filename, ".s");
+  {
+    fstream data_file(data_filename.c_str(), ios::in|ios::out|ios::binary);
+    if (!data_file)
+      error("LmToProjData: error opening output file %s\n", data_filename.c_str());
+    if (num_elems > 0)
+      {
+        data_file.seekp(static_cast<std::streamoff>(num_elems*size_of_elem - 1));
+        data_file.put(0);
+      }
+    if (!data_file)
+      error("LmToProjData: error creating output file %s\n", data_filename.c_str());
+  }
+  if (num_elems == 0)
+    return;
+  try
+    {
+      this->file_mapping_sptr.reset(new boost::interprocess::file_mapping(data_filename.c_str(),
+                                                                         boost::interprocess::read_write));
+      this->region_sptr.reset(new boost::interprocess::mapped_region(*this->file_mapping_sptr,
+                                                                    boost::interprocess::read_write));
+    }
+  catch (boost::interprocess::interprocess_exception& e)
+    {
+      error("LmToProjData: error mapping output file %s: %s\n", data_filename.c_str(), e.what());
+    }
+  if (store_counts)
+    this->counts_ptr = static_cast<boost::int32_t *>(this->region_sptr->get_address());
+  else
+    this->values_ptr = static_cast<float *>(this->region_sptr->get_address());
+}
+
+void
+MappedProjDataOutput::
+flush()
+{
+  if (this->region_sptr && !this->region_sptr->flush())
+    error("LmToProjData: error writing memory mapped output file\n");
+}
+}
 
 END_NAMESPACE_STIR
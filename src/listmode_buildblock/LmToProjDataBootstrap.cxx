@@ -105,6 +105,13 @@ post_processing()
   if (LmToProjData::post_processing())
     return true;
 
+  // get_bin_from_event() needs to be called for every event in sequence
+  if (this->parallel_binning)
+    {
+      warning("LmToProjDataBootstrap does not support parallel binning. Disabling it.");
+      this->parallel_binning = false;
+    }
+
   if (seed == 0)
     return true;
 
@@ -0,0 +1,134 @@
+//
+//
+/*!
+  \file
+  \ingroup listmode_utilities
+
+  \brief Program to compare serial and parallel binning of listmode data
+
+  \par Usage
+  \verbatim
+  benchmark_lm_to_projdata par_file
+  \endverbatim
+  The parameter file has the same format as for lm_to_projdata (see class stir::LmToProjData).
+  The data are binned twice, once without and once with <tt>parallel binning</tt>
+  (output filenames are constructed by appending \c _serial and \c _parallel
+  to the output filename prefix). The wall-clock time of both is reported, and the
+  output of every time frame is compared.
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/listmode/LmToProjData.h"
+#include "stir/ProjData.h"
+#include "stir/SegmentByView.h"
+#include "stir/HighResWallClockTimer.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+using std::endl;
+#endif
+
+START_NAMESPACE_STIR
+
+//! Helper class to be able to set parallel_binning and the output filename prefix
+class LmToProjDataForBenchmark : public LmToProjData
+{
+public:
+  LmToProjDataForBenchmark(const char * const par_filename,
+                           const bool parallel, const std::string& suffix)
+    : LmToProjData(par_filename)
+  {
+    this->parallel_binning = parallel;
+    this->output_filename_prefix += suffix;
+  }
+
+  std::string get_output_filename(const unsigned int frame_num) const
+  {
+    return boost::str(boost::format("%s_f%dg1d0b0.hs") % this->output_filename_prefix % frame_num);
+  }
+
+  unsigned int get_num_frames() const
+  { return this->frame_defs.get_num_frames(); }
+};
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main(int argc, char * argv[])
+{
+  if (argc!=2)
+    {
+      cerr << "\nUsage: " << argv[0] << " par_file\n";
+      exit(EXIT_FAILURE);
+    }
+
+  LmToProjDataForBenchmark serial_application(argv[1], false, "_serial");
+  LmToProjDataForBenchmark parallel_application(argv[1], true, "_parallel");
+
+  HighResWallClockTimer serial_timer;
+  serial_timer.start();
+  serial_application.process_data();
+  serial_timer.stop();
+
+  HighResWallClockTimer parallel_timer;
+  parallel_timer.start();
+  parallel_application.process_data();
+  parallel_timer.stop();
+
+  // compare output
+  bool identical = true;
+  for (unsigned int frame_num=1; frame_num<=serial_application.get_num_frames(); ++frame_num)
+    {
+      shared_ptr<ProjData> serial_proj_data_sptr =
+        ProjData::read_from_file(serial_application.get_output_filename(frame_num));
+      shared_ptr<ProjData> parallel_proj_data_sptr =
+        ProjData::read_from_file(parallel_application.get_output_filename(frame_num));
+      for (int segment_num=serial_proj_data_sptr->get_min_segment_num();
+           segment_num<=serial_proj_data_sptr->get_max_segment_num();
+           ++segment_num)
+        {
+          const SegmentByView<float> serial_segment =
+            serial_proj_data_sptr->get_segment_by_view(segment_num);
+          const SegmentByView<float> parallel_segment =
+            parallel_proj_data_sptr->get_segment_by_view(segment_num);
+          // allow for rounding errors due to summing in a different order
+          const float tolerance = 1.E-5F * std::max(1.F, serial_segment.find_max());
+          SegmentByView<float>::const_full_iterator serial_iter = serial_segment.begin_all();
+          SegmentByView<float>::const_full_iterator parallel_iter = parallel_segment.begin_all();
+          for (; serial_iter != serial_segment.end_all(); ++serial_iter, ++parallel_iter)
+            if (std::fabs(*serial_iter - *parallel_iter) > tolerance)
+              {
+                warning(boost::format("Output differs for frame %1%, segment %2%") % frame_num % segment_num);
+                identical = false;
+                break;
+              }
+        }
+    }
+
+  cerr << "\nWall-clock time for serial binning:   " << serial_timer.value() << "s"
+       << "\nWall-clock time for parallel binning: " << parallel_timer.value() << "s"
+       << "\nOutput is " << (identical ? "identical" : "DIFFERENT") << endl;
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
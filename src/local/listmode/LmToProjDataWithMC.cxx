@@ -59,6 +59,13 @@ post_processing()
 {
   if (LmToProjData::post_processing())
     return true;
+
+  // get_bin_from_event() needs to be called for every event in sequence (and after the preceding time event)
+  if (this->parallel_binning)
+    {
+      warning("LmToProjDataWithMC does not support parallel binning. Disabling it.");
+      this->parallel_binning = false;
+    }
    
   if (is_null_ptr(ro3d_ptr))
   {
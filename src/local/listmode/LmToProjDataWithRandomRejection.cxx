@@ -97,6 +97,13 @@ post_processing()
   if (LmToProjData::post_processing())
     return true;
 
+  // get_bin_from_event() needs to be called for every event in sequence
+  if (this->parallel_binning)
+    {
+      warning("LmToProjDataWithRandomRejection does not support parallel binning. Disabling it.");
+      this->parallel_binning = false;
+    }
+
   if (this->seed == 0)
     {
       warning("Seed needs to be non-zero"); return true;
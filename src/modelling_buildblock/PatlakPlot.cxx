@@ -27,7 +27,7 @@
 
 
 #include "stir/modelling/PatlakPlot.h"
-#include "stir/linear_regression.h"
+#include <algorithm>
 
 START_NAMESPACE_STIR
 
@@ -209,92 +209,141 @@ PatlakPlot::set_up()
     return Succeeded::no;
 }
 
-void 
-PatlakPlot::apply_linear_regression(ParametricVoxelsOnCartesianGrid & par_image, const DynamicDiscretisedDensity & dyn_image) const
+void
+PatlakPlot::
+scale_model_matrix_if_necessary(const DiscretisedDensity<3,float>& image,
+                                const float scanner_default_bin_size) const
 {
-  if (!this->_in_correct_scale)
-    {
+  if (this->_in_correct_scale || this->_model_matrix.get_if_in_correct_scale())
+    return;
 #ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_not_in_correct_scale.txt");
+  this->_model_matrix.write_to_file("patlak_matrix_not_in_correct_scale.txt");
 #endif //NDEBUG
-      const DiscretisedDensityOnCartesianGrid <3,float>*  image_cartesian_ptr = 
-        dynamic_cast< DiscretisedDensityOnCartesianGrid<3,float>*  > (((dyn_image.get_densities())[0]).get());
-      const BasicCoordinate<3,float> this_grid_spacing = image_cartesian_ptr->get_grid_spacing();
-      this->_model_matrix.scale_model_matrix(this_grid_spacing[2]/dyn_image.get_scanner_default_bin_size());
+  const DiscretisedDensityOnCartesianGrid <3,float>*  image_cartesian_ptr = 
+    dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,float>*  > (&image);
+  if (image_cartesian_ptr == 0)
+    error("PatlakPlot: images need to be on a Cartesian grid");
+  const BasicCoordinate<3,float> this_grid_spacing = image_cartesian_ptr->get_grid_spacing();
+  this->_model_matrix.scale_model_matrix(this_grid_spacing[2]/scanner_default_bin_size);
 #ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_in_correct_scale.txt");
+  this->_model_matrix.write_to_file("patlak_matrix_in_correct_scale.txt");
 #endif //NDEBUG
-    }
-  //  const DynamicDiscretisedDensity & dyn_image=this->_dyn_image;
+}
+
+void
+PatlakPlot::
+get_linear_regression_weights(VectorWithOffset<float>& slope_weights,
+                              VectorWithOffset<float>& intercept_weights) const
+{
   const unsigned int num_frames=(this->_frame_defs).get_num_frames();
-  unsigned int frame_num;
-  unsigned int starting_frame= this->_starting_frame; 
-  Array<2,float> brain_patlak_model_array=this->_model_matrix.get_model_array();
-  VectorWithOffset<float> patlak_x(starting_frame-1,num_frames-1);
-  VectorWithOffset<float> patlak_y(starting_frame-1,num_frames-1); 
-  VectorWithOffset<float> weights(starting_frame-1,num_frames-1);
+  const unsigned int starting_frame= this->_starting_frame; 
+  const Array<2,float> brain_patlak_model_array=this->_model_matrix.get_model_array();
+
+  // Unweighted linear regression of y_f on x_f, with y_f = image_f/model[2][f], see linear_regression():
+  //   slope = sum_f (x_f - mean_x) y_f / Stt
+  //   intercept = mean_y - mean_x slope
+  // with Stt = sum_f (x_f - mean_x)^2
+  VectorWithOffset<float> patlak_x(starting_frame,num_frames);
+  double S=0., Sx=0.;
   for(unsigned int frame_num = starting_frame; 
       frame_num<=num_frames ; ++frame_num )
     {      
-      patlak_x[frame_num-1]=brain_patlak_model_array[1][frame_num]/brain_patlak_model_array[2][frame_num];
-      weights[frame_num-1]=1;                    
+      patlak_x[frame_num]=brain_patlak_model_array[1][frame_num]/brain_patlak_model_array[2][frame_num];
+      S += 1.;
+      Sx += patlak_x[frame_num];
     }   
-  {  // Do linear_regression for each voxel // for k j i 
-    float slope=0.F;
-    float y_intersection=0.F;
-    float variance_of_slope=0.F;
-    float variance_of_y_intersection=0.F;
-    float covariance_of_y_intersection_with_slope=0.F;
-    float chi_square = 0.F;  
-     
-    const int min_k_index = dyn_image[1].get_min_index(); 
-    const int max_k_index = dyn_image[1].get_max_index();
-    for ( int k = min_k_index; k<= max_k_index; ++k)
-      {
-        const int min_j_index = dyn_image[1][k].get_min_index(); 
-        const int max_j_index = dyn_image[1][k].get_max_index();
-        for ( int j = min_j_index; j<= max_j_index; ++j)
-          {
-            const int min_i_index = dyn_image[1][k][j].get_min_index(); 
-            const int max_i_index = dyn_image[1][k][j].get_max_index();
-            for ( int i = min_i_index; i<= max_i_index; ++i)
-              { 
-                for ( frame_num = starting_frame; 
-                      frame_num<=num_frames ; ++frame_num )
-                  patlak_y[frame_num-1]=dyn_image[frame_num][k][j][i]/brain_patlak_model_array[2][frame_num];
-                linear_regression(y_intersection, slope,
-                                  chi_square,
-                                  variance_of_y_intersection,
-                                  variance_of_slope,
-                                  covariance_of_y_intersection_with_slope,
-                                  patlak_y,
-                                  patlak_x,                   
-                                  weights);     
-                par_image[k][j][i][2]=y_intersection;
-                par_image[k][j][i][1]=slope;
-              }
-          }
-      }    
-  }
+  const double mean_x = Sx/S;
+  double Stt=0.;
+  for(unsigned int frame_num = starting_frame; 
+      frame_num<=num_frames ; ++frame_num )
+    Stt += square(patlak_x[frame_num] - mean_x);
+
+  slope_weights = VectorWithOffset<float>(starting_frame,num_frames);
+  intercept_weights = VectorWithOffset<float>(starting_frame,num_frames);
+  for(unsigned int frame_num = starting_frame; 
+      frame_num<=num_frames ; ++frame_num )
+    {
+      const double slope_weight = (patlak_x[frame_num] - mean_x)/Stt;
+      slope_weights[frame_num] =
+        static_cast<float>(slope_weight/brain_patlak_model_array[2][frame_num]);
+      intercept_weights[frame_num] =
+        static_cast<float>((1/S - mean_x*slope_weight)/brain_patlak_model_array[2][frame_num]);
+    }
+}
+
+// adds slope_weight*frame_plane to the slope and intercept_weight*frame_plane to the intercept
+static void
+add_weighted_plane(Array<2,KineticParameters<2,float> >& par_plane,
+                   const Array<2,float>& frame_plane,
+                   const float slope_weight, const float intercept_weight)
+{
+  for (int j = frame_plane.get_min_index(); j<= frame_plane.get_max_index(); ++j)
+    {
+      const Array<1,float>& frame_row = frame_plane[j];
+      Array<1,KineticParameters<2,float> >& par_row = par_plane[j];
+      const int min_i_index = frame_row.get_min_index(); 
+      const int max_i_index = frame_row.get_max_index();
+      for ( int i = min_i_index; i<= max_i_index; ++i)
+        {
+          par_row[i][1] += slope_weight*frame_row[i];
+          par_row[i][2] += intercept_weight*frame_row[i];
+        }
+    }
+}
+
+void 
+PatlakPlot::apply_linear_regression(ParametricVoxelsOnCartesianGrid & par_image, const DynamicDiscretisedDensity & dyn_image) const
+{
+  this->scale_model_matrix_if_necessary(dyn_image[1], dyn_image.get_scanner_default_bin_size());
+  const unsigned int num_frames=(this->_frame_defs).get_num_frames();
+  const unsigned int starting_frame= this->_starting_frame; 
+  VectorWithOffset<float> slope_weights, intercept_weights;
+  this->get_linear_regression_weights(slope_weights, intercept_weights);
+
+  std::fill(par_image.begin_all(), par_image.end_all(), 0.F);
+  // For every plane, loop over the frames such that the parametric plane stays in cache
+  const int min_k_index = dyn_image[1].get_min_index(); 
+  const int max_k_index = dyn_image[1].get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for ( int k = min_k_index; k<= max_k_index; ++k)
+    for (unsigned int frame_num = starting_frame; 
+         frame_num<=num_frames ; ++frame_num )
+      add_weighted_plane(par_image[k], dyn_image[frame_num][k],
+                         slope_weights[frame_num], intercept_weights[frame_num]);
+}
+
+void
+PatlakPlot::add_frame_to_linear_regression(ParametricVoxelsOnCartesianGrid & par_image,
+                                           const DiscretisedDensity<3,float> & frame_image,
+                                           const unsigned int frame_num,
+                                           const float scanner_default_bin_size) const
+{
+  if (frame_num < this->_starting_frame)
+    return;
+  if (frame_num > (this->_frame_defs).get_num_frames())
+    error("PatlakPlot::add_frame_to_linear_regression: frame %u is larger than the number of frames", frame_num);
+
+  this->scale_model_matrix_if_necessary(frame_image, scanner_default_bin_size);
+  VectorWithOffset<float> slope_weights, intercept_weights;
+  this->get_linear_regression_weights(slope_weights, intercept_weights);
+
+  const int min_k_index = frame_image.get_min_index(); 
+  const int max_k_index = frame_image.get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for ( int k = min_k_index; k<= max_k_index; ++k)
+    add_weighted_plane(par_image[k], frame_image[k],
+                       slope_weights[frame_num], intercept_weights[frame_num]);
 }
 
 void
 PatlakPlot::multiply_dynamic_image_with_model_gradient(ParametricVoxelsOnCartesianGrid & par_image,
                                                        const DynamicDiscretisedDensity & dyn_image) const
 {
-  if (!this->_in_correct_scale)
-    {
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_not_in_correct_scale.txt");
-#endif //NDEBUG
-      const DiscretisedDensityOnCartesianGrid <3,float>*  image_cartesian_ptr = 
-        dynamic_cast< DiscretisedDensityOnCartesianGrid<3,float>*  > (((dyn_image.get_densities())[0]).get());
-      const BasicCoordinate<3,float> this_grid_spacing = image_cartesian_ptr->get_grid_spacing();
-      this->_model_matrix.scale_model_matrix(this_grid_spacing[2]/dyn_image.get_scanner_default_bin_size());
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_in_correct_scale.txt");
-#endif //NDEBUG
-    }
+  this->scale_model_matrix_if_necessary(dyn_image[1], dyn_image.get_scanner_default_bin_size());
   this->_model_matrix.multiply_dynamic_image_with_model(par_image,dyn_image);
 }
 
@@ -302,19 +351,7 @@ void
 PatlakPlot::multiply_dynamic_image_with_model_gradient_and_add_to_input(ParametricVoxelsOnCartesianGrid & par_image,
                                                                         const DynamicDiscretisedDensity & dyn_image) const
 {
-  if (!this->_in_correct_scale)
-    {
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_not_in_correct_scale.txt");
-#endif //NDEBUG
-      const DiscretisedDensityOnCartesianGrid <3,float>*  image_cartesian_ptr = 
-        dynamic_cast< DiscretisedDensityOnCartesianGrid<3,float>*  > (((dyn_image.get_densities())[0]).get());
-      const BasicCoordinate<3,float> this_grid_spacing = image_cartesian_ptr->get_grid_spacing();
-      this->_model_matrix.scale_model_matrix(this_grid_spacing[2]/dyn_image.get_scanner_default_bin_size());
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_in_correct_scale.txt");
-#endif //NDEBUG
-    }
+  this->scale_model_matrix_if_necessary(dyn_image[1], dyn_image.get_scanner_default_bin_size());
   this->_model_matrix.multiply_dynamic_image_with_model_and_add_to_input(par_image,dyn_image);
 }
 // Should be a virtual function declared in the KineticModels or better to the LinearModels
@@ -322,19 +359,7 @@ void
 PatlakPlot::get_dynamic_image_from_parametric_image(DynamicDiscretisedDensity & dyn_image,
                                                     const ParametricVoxelsOnCartesianGrid & par_image) const
 {
-  if (!this->_in_correct_scale)
-    {
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_not_in_correct_scale.txt");
-#endif //NDEBUG
-      const DiscretisedDensityOnCartesianGrid <3,float>*  image_cartesian_ptr = 
-        dynamic_cast< DiscretisedDensityOnCartesianGrid<3,float>*  > (((dyn_image.get_densities())[0]).get());
-      const BasicCoordinate<3,float> this_grid_spacing = image_cartesian_ptr->get_grid_spacing();
-      this->_model_matrix.scale_model_matrix(this_grid_spacing[2]/dyn_image.get_scanner_default_bin_size());
-#ifndef NDEBUG
-      this->_model_matrix.write_to_file("patlak_matrix_in_correct_scale.txt");
-#endif //NDEBUG
-    }
+  this->scale_model_matrix_if_necessary(dyn_image[1], dyn_image.get_scanner_default_bin_size());
 
   this->_model_matrix.multiply_parametric_image_with_model(dyn_image,par_image); 
 }
@@ -37,6 +37,9 @@
   
   \sa PatlakPlot.h for the \a par_file
 
+  \note For ECAT7 input, frames are read one at a time, such that the whole dynamic image
+  never needs to be in memory.
+
   \note This implementation does not use wighted least squares because for Patlak Plot only the last frames are used, which they usually have the same duration and similar number of counts.
 
   \todo Reimplement the method for image-based input function.
@@ -52,6 +55,12 @@
 #include "stir/Succeeded.h"
 #include "stir/IO/OutputFileFormat.h"
 #include "stir/IO/read_from_file.h"
+#include "stir/is_null_ptr.h"
+#ifdef HAVE_LLN_MATRIX
+#include "stir/IO/stir_ecat7.h"
+#include "stir/Scanner.h"
+#endif
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <iomanip>
@@ -79,19 +88,41 @@ USING_NAMESPACE_STIR
     return EXIT_FAILURE ;
   else
     {  
-      shared_ptr<DynamicDiscretisedDensity> 
-	dyn_image_sptr(read_from_file<DynamicDiscretisedDensity>(argv[2]));
-      const DynamicDiscretisedDensity & dyn_image= *dyn_image_sptr;
-#if 1
       shared_ptr<ParametricVoxelsOnCartesianGrid> 
 	par_image_sptr(ParametricVoxelsOnCartesianGrid::read_from_file(argv[1]));
       ParametricVoxelsOnCartesianGrid par_image = *par_image_sptr;
-#else
-      ParametricVoxelsOnCartesianGrid par_image(dyn_image[1]);
+#ifdef HAVE_LLN_MATRIX
+      if (ecat::ecat7::is_ECAT7_image_file(argv[2]))
+	{
+	  // read and process one frame at a time, such that the dynamic image is never in memory
+	  Main_header mhead;
+	  if (ecat::ecat7::read_ECAT7_main_header(mhead, argv[2]) == Succeeded::no)
+	    error("apply_patlak_to_images: cannot read main header of %s", argv[2]);
+	  const shared_ptr<Scanner> scanner_sptr(ecat::find_scanner_from_ECAT_system_type(mhead.system_type));
+	  std::fill(par_image.begin_all(), par_image.end_all(), 0.F);
+	  for (unsigned int frame_num=indirect_patlak.get_starting_frame();
+	       frame_num<=indirect_patlak.get_time_frame_definitions().get_num_frames();
+	       ++frame_num)
+	    {
+	      const shared_ptr<DiscretisedDensity<3,float> >
+		frame_sptr(ecat::ecat7::ECAT7_to_VoxelsOnCartesianGrid(argv[2], frame_num,
+								       /* gate_num, data_num, bed_num */ 1,0,0));
+	      if (is_null_ptr(frame_sptr))
+		error("apply_patlak_to_images: no frame %u available in %s", frame_num, argv[2]);
+	      indirect_patlak.add_frame_to_linear_regression(par_image, *frame_sptr, frame_num,
+							    scanner_sptr->get_default_bin_size());
+	    }
+	}
+      else
 #endif
-      //ToDo: Assertion for the dyn-par images, sizes I have to create from one to the other image, so then it should be OK...      
-      assert(indirect_patlak.get_time_frame_definitions().get_num_frames()==dyn_image.get_time_frame_definitions().get_num_frames());
-      indirect_patlak.apply_linear_regression(par_image,dyn_image);
+	{
+	  shared_ptr<DynamicDiscretisedDensity> 
+	    dyn_image_sptr(read_from_file<DynamicDiscretisedDensity>(argv[2]));
+	  const DynamicDiscretisedDensity & dyn_image= *dyn_image_sptr;
+	  //ToDo: Assertion for the dyn-par images, sizes I have to create from one to the other image, so then it should be OK...      
+	  assert(indirect_patlak.get_time_frame_definitions().get_num_frames()==dyn_image.get_time_frame_definitions().get_num_frames());
+	  indirect_patlak.apply_linear_regression(par_image,dyn_image);
+	}
 
       // Writing image
       std::cerr << "Writing parametric-image in '"<< argv[1] << "'\n";
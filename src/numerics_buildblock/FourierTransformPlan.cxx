@@ -0,0 +1,395 @@
+//
+//
+/*!
+  \file
+  \ingroup DFT
+  \brief Implementation of class stir::FourierTransformPlan
+
+  The built-in algorithm is a recursive mixed-radix decimation-in-time FFT
+  with special butterflies for radix 2, 3 and 4 and a generic one for other
+  factors. It is derived from KISS FFT by Mark Borgerding
+  (https://github.com/mborgerding/kissfft), which is distributed under the
+  BSD license reproduced below.
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*
+    The built-in FFT (FourierTransformPlan::transform_recursively() and the
+    butterfly functions) is derived from KISS FFT, which carries the following license:
+
+    Copyright (c) 2003-2010, Mark Borgerding
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without modification,
+    are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list
+      of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this
+      list of conditions and the following disclaimer in the documentation and/or other
+      materials provided with the distribution.
+    * Neither the author nor the names of any contributors may be used to endorse or
+      promote products derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+    ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+    IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+    INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+    NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+    PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+    WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stir/numerics/FourierTransformPlan.h"
+#include "stir/is_null_ptr.h"
+#include "stir/error.h"
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <math.h>
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#endif
+
+START_NAMESPACE_STIR
+
+typedef std::complex<float> complex_t;
+
+shared_ptr<const FourierTransformPlan>
+FourierTransformPlan::
+get_plan(const int length, const int sign)
+{
+  typedef std::map<std::pair<int,int>, shared_ptr<const FourierTransformPlan> > cache_type;
+  static cache_type cache;
+
+  shared_ptr<const FourierTransformPlan> plan_sptr;
+#ifdef STIR_OPENMP
+#pragma omp critical(STIRFOURIERTRANSFORMPLAN)
+#endif
+  {
+    shared_ptr<const FourierTransformPlan>& cached_plan_sptr =
+      cache[std::make_pair(length, sign)];
+    if (is_null_ptr(cached_plan_sptr))
+      cached_plan_sptr.reset(new FourierTransformPlan(length, sign));
+    plan_sptr = cached_plan_sptr;
+  }
+  return plan_sptr;
+}
+
+FourierTransformPlan::
+FourierTransformPlan(const int length_v, const int sign_v)
+  : length(length_v), sign(sign_v), fftw_plan_ptr(0)
+{
+  if (sign!=1 && sign!=-1)
+    error("FourierTransformPlan: sign should be 1 or -1, but is %d", sign);
+  if (length<0)
+    error("FourierTransformPlan: length should be non-negative, but is %d", length);
+
+  this->twiddle_factors.resize(length);
+  for (int k=0; k<length; ++k)
+    {
+      const double phase = sign*2*_PI*k/length;
+      this->twiddle_factors[k] = complex_t(static_cast<float>(cos(phase)), static_cast<float>(sin(phase)));
+    }
+
+  // find factors (radix 4 first, as it has the most efficient butterfly)
+  {
+    int n = length;
+    int p = 4;
+    while (n > 1)
+      {
+        while (n % p)
+          {
+            switch (p)
+              {
+              case 4: p = 2; break;
+              case 2: p = 3; break;
+              default: p += 2; break;
+              }
+            if (p*p > n)
+              p = n; // n is prime
+          }
+        n /= p;
+        this->factors.push_back(p);
+        this->factors.push_back(n);
+      }
+  }
+
+#ifdef HAVE_FFTW
+  if (length > 1)
+    {
+      std::vector<complex_t> buffer(length);
+      fftwf_complex * const buffer_ptr = reinterpret_cast<fftwf_complex *>(&buffer[0]);
+      // note: FFTW_FORWARD==-1 and FFTW_BACKWARD==1, which is the sign of the exponent
+      this->fftw_plan_ptr =
+        fftwf_plan_dft_1d(length, buffer_ptr, buffer_ptr, sign, FFTW_ESTIMATE | FFTW_UNALIGNED);
+      if (this->fftw_plan_ptr == 0)
+        error("FourierTransformPlan: FFTW could not create a plan for length %d", length);
+    }
+#endif
+}
+
+FourierTransformPlan::
+~FourierTransformPlan()
+{
+#ifdef HAVE_FFTW
+  if (this->fftw_plan_ptr != 0)
+    fftwf_destroy_plan(static_cast<fftwf_plan>(this->fftw_plan_ptr));
+#endif
+}
+
+bool
+FourierTransformPlan::
+is_using_FFTW()
+{
+#ifdef HAVE_FFTW
+  return true;
+#else
+  return false;
+#endif
+}
+
+int
+FourierTransformPlan::
+get_length() const
+{
+  return this->length;
+}
+
+int
+FourierTransformPlan::
+get_sign() const
+{
+  return this->sign;
+}
+
+const complex_t&
+FourierTransformPlan::
+get_twiddle_factor(const int k) const
+{
+  return this->twiddle_factors[k];
+}
+
+void
+FourierTransformPlan::
+transform(complex_t* data, const int stride) const
+{
+  if (this->length <= 1)
+    return;
+  std::vector<complex_t> work(this->length);
+  this->transform(data, stride, &work[0]);
+}
+
+void
+FourierTransformPlan::
+transform_many(complex_t* data, const int num_vectors,
+               const int stride, const int distance) const
+{
+  if (this->length <= 1 || num_vectors <= 0)
+    return;
+#ifdef STIR_OPENMP
+  // only use threads when there is enough work
+#pragma omp parallel if (num_vectors > 1 && static_cast<double>(num_vectors)*this->length > 16384)
+#endif
+  {
+    std::vector<complex_t> work(this->length);
+#ifdef STIR_OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (int v=0; v<num_vectors; ++v)
+      this->transform(data + static_cast<std::ptrdiff_t>(v)*distance, stride, &work[0]);
+  }
+}
+
+void
+FourierTransformPlan::
+transform(complex_t* data, const int stride, complex_t* work) const
+{
+  if (this->length <= 1)
+    return;
+#ifdef HAVE_FFTW
+  const fftwf_plan plan = static_cast<fftwf_plan>(this->fftw_plan_ptr);
+  if (stride == 1)
+    {
+      fftwf_complex * const data_ptr = reinterpret_cast<fftwf_complex *>(data);
+      fftwf_execute_dft(plan, data_ptr, data_ptr);
+      return;
+    }
+  for (int i=0; i<this->length; ++i)
+    work[i] = data[static_cast<std::ptrdiff_t>(i)*stride];
+  fftwf_complex * const work_ptr = reinterpret_cast<fftwf_complex *>(work);
+  fftwf_execute_dft(plan, work_ptr, work_ptr);
+#else
+  // note: this reads the data and writes the result in work
+  this->transform_recursively(work, data, 1, stride, &this->factors[0]);
+#endif
+  for (int i=0; i<this->length; ++i)
+    data[static_cast<std::ptrdiff_t>(i)*stride] = work[i];
+}
+
+/* Compute the DFT of length p*m of in[0], in[twiddle_stride*in_stride], ...
+   and store the result in out[0]...out[p*m-1].
+   This is done by computing the DFTs of length m of the p interleaved subsequences
+   (by recursion), and then combining them with butterflies.
+*/
+void
+FourierTransformPlan::
+transform_recursively(complex_t* out, const complex_t* in,
+                      const int twiddle_stride, const int in_stride,
+                      const int * factors_ptr) const
+{
+  const int p = factors_ptr[0]; // radix
+  const int m = factors_ptr[1]; // remaining length
+  const std::ptrdiff_t in_step = static_cast<std::ptrdiff_t>(twiddle_stride)*in_stride;
+
+  if (m == 1)
+    {
+      for (int k=0; k<p; ++k, in += in_step)
+        out[k] = *in;
+    }
+  else
+    {
+      for (int k=0; k<p; ++k, in += in_step)
+        this->transform_recursively(out + k*m, in, twiddle_stride*p, in_stride, factors_ptr+2);
+    }
+
+  switch (p)
+    {
+    case 2: this->butterfly_2(out, twiddle_stride, m); break;
+    case 3: this->butterfly_3(out, twiddle_stride, m); break;
+    case 4: this->butterfly_4(out, twiddle_stride, m); break;
+    default: this->butterfly_generic(out, twiddle_stride, m, p); break;
+    }
+}
+
+void
+FourierTransformPlan::
+butterfly_2(complex_t* out, const int twiddle_stride, const int m) const
+{
+  complex_t* out2 = out + m;
+  const complex_t* tw = &this->twiddle_factors[0];
+  for (int k=0; k<m; ++k, ++out, ++out2, tw += twiddle_stride)
+    {
+      const complex_t t = *out2 * *tw;
+      *out2 = *out - t;
+      *out += t;
+    }
+}
+
+void
+FourierTransformPlan::
+butterfly_3(complex_t* out, const int twiddle_stride, const int m) const
+{
+  // imaginary part of exp(sign*2*pi*i/3)
+  const float epi3_imag = this->twiddle_factors[twiddle_stride*m].imag();
+  const complex_t* tw1 = &this->twiddle_factors[0];
+  const complex_t* tw2 = &this->twiddle_factors[0];
+  for (int k=0; k<m; ++k, ++out, tw1 += twiddle_stride, tw2 += 2*twiddle_stride)
+    {
+      const complex_t s1 = out[m] * *tw1;
+      const complex_t s2 = out[2*m] * *tw2;
+      const complex_t s3 = s1 + s2;
+      const complex_t s0 = (s1 - s2) * epi3_imag;
+
+      out[m] = *out - s3*.5F;
+      *out += s3;
+      out[2*m] = complex_t(out[m].real() + s0.imag(), out[m].imag() - s0.real());
+      out[m] += complex_t(-s0.imag(), s0.real());
+    }
+}
+
+void
+FourierTransformPlan::
+butterfly_4(complex_t* out, const int twiddle_stride, const int m) const
+{
+  const complex_t* tw1 = &this->twiddle_factors[0];
+  const complex_t* tw2 = &this->twiddle_factors[0];
+  const complex_t* tw3 = &this->twiddle_factors[0];
+  for (int k=0; k<m; ++k, ++out,
+         tw1 += twiddle_stride, tw2 += 2*twiddle_stride, tw3 += 3*twiddle_stride)
+    {
+      const complex_t s0 = out[m] * *tw1;
+      const complex_t s1 = out[2*m] * *tw2;
+      const complex_t s2 = out[3*m] * *tw3;
+      const complex_t s5 = *out - s1;
+      *out += s1;
+      const complex_t s3 = s0 + s2;
+      const complex_t s4 = s0 - s2;
+      out[2*m] = *out - s3;
+      *out += s3;
+      // multiply s4 with sign*i
+      if (this->sign == 1)
+        {
+          out[m]   = complex_t(s5.real() - s4.imag(), s5.imag() + s4.real());
+          out[3*m] = complex_t(s5.real() + s4.imag(), s5.imag() - s4.real());
+        }
+      else
+        {
+          out[m]   = complex_t(s5.real() + s4.imag(), s5.imag() - s4.real());
+          out[3*m] = complex_t(s5.real() - s4.imag(), s5.imag() + s4.real());
+        }
+    }
+}
+
+void
+FourierTransformPlan::
+butterfly_generic(complex_t* out, const int twiddle_stride, const int m, const int p) const
+{
+  std::vector<complex_t> scratch(p);
+  for (int u=0; u<m; ++u)
+    {
+      for (int q1=0, k=u; q1<p; ++q1, k+=m)
+        scratch[q1] = out[k];
+
+      for (int q1=0, k=u; q1<p; ++q1, k+=m)
+        {
+          // note: twiddle_stride*k < twiddle_stride*p*m == length
+          int twiddle_index = 0;
+          out[k] = scratch[0];
+          for (int q=1; q<p; ++q)
+            {
+              twiddle_index += twiddle_stride*k;
+              if (twiddle_index >= this->length)
+                twiddle_index -= this->length;
+              out[k] += scratch[q] * this->twiddle_factors[twiddle_index];
+            }
+        }
+    }
+}
+
+int
+find_efficient_fourier_length(const int min_length, const bool even)
+{
+  if (min_length <= 0)
+    return 0;
+  for (int length = min_length; ; ++length)
+    {
+      if (even && length%2 != 0)
+        continue;
+      int remainder = length;
+      while (remainder%2 == 0) remainder /= 2;
+      while (remainder%3 == 0) remainder /= 3;
+      while (remainder%5 == 0) remainder /= 5;
+      if (remainder == 1)
+        return length;
+    }
+}
+
+END_NAMESPACE_STIR
@@ -23,6 +23,7 @@
     See STIR/LICENSE.txt for details
 */
 #include "stir/numerics/fourier.h"
+#include "stir/numerics/FourierTransformPlan.h"
 #include "stir/round.h"
 #include "stir/modulo.h"
 #include "stir/array_index_functions.h"
@@ -88,10 +89,13 @@ static void init_expminarray(const int k, const int pow2k)
    This is almost a straightforward 1D FFT implementation. The only tricky bit
    is to make sure that all operations are written in a way that is defined
    (and efficient) in the case that the element type is a vector again.
+
+   This is only used for types that the FourierTransformPlan cannot handle
+   (i.e. not std::complex<float>, or irregular arrays).
 */
 
 template <typename T>
-void fourier_1d(T& c, const int sign)
+static void fourier_1d_radix_2(T& c, const int sign)
 {
   if (c.size()==0) return;
   assert(c.get_min_index()==0);
@@ -142,6 +146,82 @@ void fourier_1d(T& c, const int sign)
 
 namespace detail {
 
+/* Transform along one dimension of a contiguous block of data, stored such that
+   element (o,i,j) is at data[(o*length + i)*inner_size + j]
+   (for 0<=o<outer_size, 0<=i<length, 0<=j<inner_size).
+   The transform is over i. All vectors are done with the same plan, and
+   distributed over threads by FourierTransformPlan::transform_many().
+*/
+static void
+fourier_1d_using_plan(std::complex<float>* data,
+                      const int outer_size, const int length, const int inner_size,
+                      const int sign)
+{
+  if (outer_size==0 || length==0 || inner_size==0)
+    return;
+  const shared_ptr<const FourierTransformPlan> plan_sptr =
+    FourierTransformPlan::get_plan(length, sign);
+  if (inner_size==1)
+    plan_sptr->transform_many(data, outer_size, 1, length);
+  else
+    for (int o=0; o<outer_size; ++o)
+      plan_sptr->transform_many(data + static_cast<std::ptrdiff_t>(o)*length*inner_size,
+                                inner_size, inner_size, 1);
+}
+
+/* Overloads that select the implementation of fourier_1d() */
+template <typename T>
+inline void
+fourier_1d_auxiliary(T& c, const int sign)
+{
+  fourier_1d_radix_2(c, sign);
+}
+
+inline void
+fourier_1d_auxiliary(VectorWithOffset<std::complex<float> >& c, const int sign)
+{
+  if (c.size()==0) return;
+  assert(c.get_min_index()==0);
+  assert(sign==1 || sign ==-1);
+  fourier_1d_using_plan(&c[0], 1, c.get_length(), 1, sign);
+}
+
+template <int num_dimensions>
+void
+fourier_1d_auxiliary(Array<num_dimensions, std::complex<float> >& c, const int sign)
+{
+  if (c.size()==0) return;
+  assert(c.get_min_index()==0);
+  assert(sign==1 || sign ==-1);
+  if (!c.is_regular())
+    {
+      fourier_1d_radix_2(c, sign);
+      return;
+    }
+  if (!c.is_contiguous())
+    {
+      // work on a contiguous copy
+      Array<num_dimensions, std::complex<float> > tmp(c.get_index_range(), /*contiguous=*/true);
+      tmp = c;
+      fourier_1d_auxiliary(tmp, sign);
+      c = tmp;
+      return;
+    }
+  fourier_1d_using_plan(c.get_full_data_ptr(),
+                        1, c.get_length(), static_cast<int>(c.size_all()/c.size()),
+                        sign);
+}
+
+} // end of namespace detail
+
+template <typename T>
+void fourier_1d(T& c, const int sign)
+{
+  detail::fourier_1d_auxiliary(c, sign);
+}
+
+namespace detail {
+
 /* A class that does the recursion for multi-dimensional arrays.
 
    This is done with a class because partial template specialisation is
@@ -198,18 +278,64 @@ struct fourier_auxiliary<std::complex<double> >
 };
 #endif
 
+/* Overloads that select the implementation of fourier() */
+template <typename T>
+inline void
+fourier_all_dimensions(T& c, const int sign)
+{
+#if !defined(_MSC_VER) || _MSC_VER>1200
+  fourier_auxiliary<typename T::value_type>::do_fourier(c,sign);
+#else
+  fourier_auxiliary<T::value_type>::do_fourier(c,sign);
+#endif
+}
+
+/* For regular arrays of std::complex<float>, we do one dimension after the other
+   on the contiguous data, such that every dimension is a single batch of 1D
+   transforms.
+*/
+template <int num_dimensions>
+void
+fourier_all_dimensions(Array<num_dimensions, std::complex<float> >& c, const int sign)
+{
+  if (c.size_all()==0) return;
+  assert(sign==1 || sign ==-1);
+  BasicCoordinate<num_dimensions, int> min_index, max_index;
+  if (!c.get_regular_range(min_index, max_index))
+    {
+      fourier_auxiliary<typename Array<num_dimensions, std::complex<float> >::value_type>::do_fourier(c,sign);
+      return;
+    }
+  assert(min_index == (min_index*0));
+  if (!c.is_contiguous())
+    {
+      // work on a contiguous copy
+      Array<num_dimensions, std::complex<float> > tmp(c.get_index_range(), /*contiguous=*/true);
+      tmp = c;
+      fourier_all_dimensions(tmp, sign);
+      c = tmp;
+      return;
+    }
+  std::complex<float>* const data = c.get_full_data_ptr();
+  const int total_size = static_cast<int>(c.size_all());
+  int outer_size = 1;
+  for (int d=1; d<=num_dimensions; ++d)
+    {
+      const int length = max_index[d] + 1;
+      const int inner_size = total_size/(outer_size*length);
+      fourier_1d_using_plan(data, outer_size, length, inner_size, sign);
+      outer_size *= length;
+    }
+}
+
 } // end of namespace detail
 
-// now the fourier function is easy to define in terms of the class above
+// now the fourier function is easy to define in terms of the functions above
 template <typename T>
 void 
 fourier(T& c, const int sign)
 {
-#if !defined(_MSC_VER) || _MSC_VER>1200
-  detail::fourier_auxiliary<typename T::value_type>::do_fourier(c,sign);
-#else
-  detail::fourier_auxiliary<T::value_type>::do_fourier(c,sign);
-#endif
+  detail::fourier_all_dimensions(c, sign);
 }
 
 
@@ -249,15 +375,17 @@ fourier_1d_for_real_data(const Array<1,T>& v, const int sign)
 
   //cout << "C: " << c;
   c.resize(n+1);
+  // get factors exp(sign*I*_PI*i/n) (with I=sqrt(-1)) from the plan for length 2n
+  const shared_ptr<const FourierTransformPlan> plan_2n_sptr =
+    FourierTransformPlan::get_plan(static_cast<int>(2*n), sign);
   for (unsigned int i=1; i<=n/2; ++i)
     {
       const complex_t t1 = 
 	(c[i]+std::conj(c[n-i]));
-      // TODO could get exp() from static exparray
-      // the nice thing about this code that it works even when the length is not a power of 2
-      // (but of course, the call to fourier_1d would currently abort in that case)
+      // multiply with exp(I*(sign*i*_PI/n - _PI/2)) = -I*exp(sign*I*_PI*i/n)
+      const std::complex<float>& w = plan_2n_sptr->get_twiddle_factor(i);
       const complex_t t2 = 			   
-	std::exp(complex_t(0, static_cast<T>(sign*(i*_PI)/n-_PI/2)))*
+	complex_t(w.imag(), -w.real())*
 	(c[i]-std::conj(c[n-i]));
 
       c[i] = (t1 + t2);
@@ -281,8 +409,6 @@ inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c,
   assert(c.get_min_index()==0);
   assert(sign==1 || sign ==-1);
   const int n = c.get_length()-1;
-  if (n%2!=0)
-    error("inverse_fourier_1d_of_real_data can only handle arrays of even length.\n");
 
   /* Problematic asserts to check that the imaginary part of c[0] and c[n] is 0
      Trouble is that it could be only approximately 0 (e.g. when calling 
@@ -295,12 +421,16 @@ inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c,
   */
   //assert(fabs(c[0].imag())<=.001*norm(c.begin_all(),c.end_all())/sqrt(n+1.)); // note divide by n+1 to avoid division by 0
   //assert(fabs(c[n].imag())<=.001*norm(c.begin_all(),c.end_all())/sqrt(n+1.));
+  // get factors exp(sign*I*_PI*i/n) (with I=sqrt(-1)) from the plan for length 2n
+  const shared_ptr<const FourierTransformPlan> plan_2n_sptr =
+    FourierTransformPlan::get_plan(2*n, sign);
   for (int i=1; i<=n/2; ++i)
     {
       const complex_t t1 = (c[i]+std::conj(c[n-i]));
-      // TODO could get exp() from static exparray
+      // multiply with exp(I*(-sign*i*_PI/n + _PI/2)) = I*conj(exp(sign*I*_PI*i/n))
+      const std::complex<float>& w = plan_2n_sptr->get_twiddle_factor(i);
       const complex_t t2 = 			   
-	std::exp(complex_t(0, static_cast<T>(-sign*(i*_PI)/n+_PI/2)))*
+	complex_t(w.imag(), w.real())*
 	(c[i]-std::conj(c[n-i]));
 
       c[i] = (t1 + t2);
@@ -349,10 +479,28 @@ struct fourier_for_real_data_auxiliary
   static Array<num_dimensions,std::complex<elemT> >
   do_fourier_for_real_data(const Array<num_dimensions,elemT >& c, const int sign)
   {
+    BasicCoordinate<num_dimensions, int> min_index, max_index;
+    if (c.get_regular_range(min_index, max_index))
+      {
+        // allocate the whole result in one go, such that it is contiguous
+        // and the transform over the other dimensions can use a plan
+        const int real_length = max_index[num_dimensions] - min_index[num_dimensions] + 1;
+        if (real_length%2!=0)
+          error("fourier_for_real_data can only handle arrays of even length.\n");
+        max_index[num_dimensions] = min_index[num_dimensions] + real_length/2;
+        Array<num_dimensions, std::complex<elemT> > array(IndexRange<num_dimensions>(min_index, max_index),
+                                                          /*contiguous=*/true);
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i=c.get_min_index(); i<=c.get_max_index(); ++i)
+          array[i] = fourier_for_real_data(c[i], sign);
+        fourier_1d(array, sign);
+        return array;
+      }
     // complicated business to get index range which is as follows:
     // outer_dimension = outer_dimension of c
     // all other dimensions are as small as possible (to avoid reallocations)
-    BasicCoordinate<num_dimensions, int> min_index, max_index;
     for (int d=2; d<=num_dimensions; ++d)
       min_index[d] = max_index[d] = 0;
     min_index[1] = c.get_min_index();
@@ -367,10 +515,24 @@ struct fourier_for_real_data_auxiliary
   do_inverse_fourier_for_real_data_corrupting_input(Array<num_dimensions,std::complex<elemT> >& c, const int sign)
   {
     inverse_fourier_1d(c, sign);
+    BasicCoordinate<num_dimensions, int> min_index, max_index;
+    if (c.get_regular_range(min_index, max_index))
+      {
+        // allocate the whole result in one go, such that it is contiguous
+        max_index[num_dimensions] = min_index[num_dimensions] +
+          2*(max_index[num_dimensions] - min_index[num_dimensions]) - 1;
+        Array<num_dimensions, elemT> array(IndexRange<num_dimensions>(min_index, max_index),
+                                           /*contiguous=*/true);
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i=c.get_min_index(); i<=c.get_max_index(); ++i)
+          array[i] = inverse_fourier_for_real_data_corrupting_input(c[i], sign);
+        return array;
+      }
     // complicated business to get index range which is as follows:
     // outer_dimension = outer_dimension of c
     // all other dimensions are as small as possible (to avoid reallocations)
-    BasicCoordinate<num_dimensions, int> min_index, max_index;
     for (int d=2; d<=num_dimensions; ++d)
       min_index[d] = max_index[d] = 0;
     min_index[1] = c.get_min_index();
@@ -519,10 +681,30 @@ template
 void 
 fourier<>(Array<3,std::complex<float> >& c, const int sign);
 
+template
+void 
+fourier<>(Array<2,std::complex<float> >& c, const int sign);
+
+template
+void 
+fourier<>(Array<1,std::complex<float> >& c, const int sign);
+
 template
 void 
 fourier<>(VectorWithOffset<std::complex<float> >& c, const int sign);
 
+template
+void 
+fourier_1d<>(Array<3,std::complex<float> >& c, const int sign);
+
+template
+void 
+fourier_1d<>(Array<2,std::complex<float> >& c, const int sign);
+
+template
+void 
+fourier_1d<>(Array<1,std::complex<float> >& c, const int sign);
+
 #define INSTANTIATE(d,type) \
  template \
  Array<d,std::complex<type> > \
@@ -35,18 +35,16 @@
 #include "stir/RelatedViewgrams.h"
 #include "stir/ProjData.h"
 #include "stir/DiscretisedDensity.h"
+#include "stir/recon_buildblock/ImageAccumulationBuffers.h"
 #include <vector>
-#ifdef STIR_OPENMP
-#include "stir/is_null_ptr.h"
-#include "stir/DiscretisedDensity.h"
-#include <omp.h>
-#endif
 #include <boost/format.hpp>
 
 START_NAMESPACE_STIR
 
 BackProjectorByBin::BackProjectorByBin()
-  :   _already_set_up(false)
+  :   _already_set_up(false),
+      _accumulate_atomically(false),
+      _max_memory_for_accumulation_buffers_in_MB(ImageAccumulationBuffers::default_max_memory_in_MB)
 {
 }
 
@@ -91,16 +89,45 @@ BackProjectorByBin::back_project(DiscretisedDensity<3,float>& image,
                                          proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
                                          0, 1/*subset_num, num_subsets*/);
 
+  if (this->supports_atomic_accumulation())
+    {
+      // all threads add to the output image, so memory use does not grow with the number of threads
+      this->_accumulate_atomically = true;
 #ifdef STIR_OPENMP
-  std::vector< shared_ptr<DiscretisedDensity<3,float> > > local_output_image_sptrs;
-#pragma omp parallel shared(proj_data, symmetries_sptr, local_output_image_sptrs)
+#pragma omp parallel shared(proj_data, symmetries_sptr, image)
 #endif
-  { 
+      {
 #ifdef STIR_OPENMP
-#pragma omp single
-    {
-      local_output_image_sptrs.resize(omp_get_num_threads(), shared_ptr<DiscretisedDensity<3,float> >());
+#pragma omp for schedule(runtime)
+#endif
+        // note: older versions of openmp need an int as loop
+        for (int i=0; i<static_cast<int>(vs_nums_to_process.size()); ++i)
+          {
+            const ViewSegmentNumbers vs=vs_nums_to_process[i];
+#ifdef STIR_OPENMP
+            RelatedViewgrams<float> viewgrams;
+#pragma omp critical (BACKPROJECTORBYBIN_GETVIEWGRAMS)
+            viewgrams = proj_data.get_related_viewgrams(vs, symmetries_sptr);
+#else
+            const RelatedViewgrams<float> viewgrams =
+              proj_data.get_related_viewgrams(vs, symmetries_sptr);
+#endif
+            back_project(image, viewgrams);
+          }
+      }
+      this->_accumulate_atomically = false;
+      return;
     }
+
+  // threads add to a limited number of images, such that memory use does not grow with the number of threads
+  ImageAccumulationBuffers
+    buffers(image,
+            ImageAccumulationBuffers::get_default_num_buffers(image, this->_max_memory_for_accumulation_buffers_in_MB));
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(proj_data, symmetries_sptr, buffers)
+#endif
+  { 
+#ifdef STIR_OPENMP
 #pragma omp for schedule(runtime)  
 #endif
     // note: older versions of openmp need an int as loop
@@ -115,25 +142,41 @@ BackProjectorByBin::back_project(DiscretisedDensity<3,float>& image,
         const RelatedViewgrams<float> viewgrams = 
           proj_data.get_related_viewgrams(vs, symmetries_sptr);
 #endif
-#ifdef STIR_OPENMP
-        const int thread_num=omp_get_thread_num();
-        if(is_null_ptr(local_output_image_sptrs[thread_num]))
-          local_output_image_sptrs[thread_num].reset(image.get_empty_copy());
-        
-        back_project(*(local_output_image_sptrs[thread_num]), viewgrams);	  
-#else            
-        back_project(image, viewgrams);
-#endif
+        const int buffer_num = buffers.acquire();
+        back_project(buffers.get_buffer(buffer_num), viewgrams);	  
+        buffers.release(buffer_num);
       }
   }
-#ifdef STIR_OPENMP
   // "reduce" data constructed by threads
-  {
-    for (int i=0; i<static_cast<int>(local_output_image_sptrs.size()); ++i)
-      if(!is_null_ptr(local_output_image_sptrs[i])) // only accumulate if a thread filled something in
-        image += *(local_output_image_sptrs[i]);
-  }
-#endif
+  buffers.accumulate();
+}
+
+void
+BackProjectorByBin::
+set_max_memory_for_accumulation_buffers_in_MB(const std::size_t max_memory_in_MB)
+{
+  this->_max_memory_for_accumulation_buffers_in_MB = max_memory_in_MB;
+}
+
+std::size_t
+BackProjectorByBin::
+get_max_memory_for_accumulation_buffers_in_MB() const
+{
+  return this->_max_memory_for_accumulation_buffers_in_MB;
+}
+
+bool
+BackProjectorByBin::
+supports_atomic_accumulation() const
+{
+  return false;
+}
+
+bool
+BackProjectorByBin::
+accumulates_atomically() const
+{
+  return this->_accumulate_atomically;
 }
 
 void 
@@ -120,6 +120,13 @@ BackProjectorByBinUsingProjMatrixByBin::get_symmetries_used() const
   return proj_matrix_ptr->get_symmetries_ptr();
 }
 
+bool
+BackProjectorByBinUsingProjMatrixByBin::
+supports_atomic_accumulation() const
+{
+  return true;
+}
+
 void 
 BackProjectorByBinUsingProjMatrixByBin::
 actual_back_project(DiscretisedDensity<3,float>& image,
@@ -127,6 +134,9 @@ actual_back_project(DiscretisedDensity<3,float>& image,
 		    const int min_axial_pos_num, const int max_axial_pos_num,
 		    const int min_tangential_pos_num, const int max_tangential_pos_num)
 {
+  // other threads might add to the same image
+  const bool atomically = this->accumulates_atomically();
+
   if (proj_matrix_ptr->is_cache_enabled()/* &&
 					    !proj_matrix_ptr->does_cache_store_only_basic_bins()*/)
     {
@@ -135,6 +145,11 @@ actual_back_project(DiscretisedDensity<3,float>& image,
       // would be slow if there's no caching at all, but is very fast if everything is cached
 
       ProjMatrixElemsForOneBin proj_matrix_row;
+      // If all bins are cached, we can use the packed rows in the cache without copying.
+      // Otherwise, packing would only be overhead.
+      const bool use_packed_rows =
+        proj_matrix_ptr->is_cache_enabled() &&
+        !proj_matrix_ptr->does_cache_store_only_basic_bins();
   
       RelatedViewgrams<float>::const_iterator r_viewgrams_iter = viewgrams.begin();
   
@@ -151,8 +166,23 @@ actual_back_project(DiscretisedDensity<3,float>& image,
 		if (viewgram[ax_pos][tang_pos] == 0)
 		  continue;
 		Bin bin(segment_num, view_num, ax_pos, tang_pos, viewgram[ax_pos][tang_pos]);
-		proj_matrix_ptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, bin);
-		proj_matrix_row.back_project(image, bin);
+		if (use_packed_rows)
+		  {
+		    const shared_ptr<const PackedProjMatrixElemsForOneBin> packed_row_sptr =
+		      proj_matrix_ptr->get_packed_proj_matrix_elems_for_one_bin(bin);
+		    if (atomically)
+		      packed_row_sptr->back_project_atomically(image, bin);
+		    else
+		      packed_row_sptr->back_project(image, bin);
+		  }
+		else
+		  {
+		    proj_matrix_ptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, bin);
+		    if (atomically)
+		      proj_matrix_row.back_project_atomically(image, bin);
+		    else
+		      proj_matrix_row.back_project(image, bin);
+		  }
 	      }
 	  ++r_viewgrams_iter;   
 	}
@@ -231,7 +261,10 @@ actual_back_project(DiscretisedDensity<3,float>& image,
 		    assert(bin.tangential_pos_num() == basic_bin.tangential_pos_num());
 	      
 		    symm_op_ptr->transform_proj_matrix_elems_for_one_bin(proj_matrix_row_copy);
-		    proj_matrix_row_copy.back_project(image, bin);
+		    if (atomically)
+		      proj_matrix_row_copy.back_project_atomically(image, bin);
+		    else
+		      proj_matrix_row_copy.back_project(image, bin);
 		  }
 	      }  
 	  }      
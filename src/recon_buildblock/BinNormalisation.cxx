@@ -59,6 +59,18 @@ set_up(const shared_ptr<ProjDataInfo>& proj_data_info_sptr)
   return Succeeded::yes;  
 }
 
+void
+BinNormalisation::
+precompute_for_time_frame(const double, const double) const
+{}
+
+bool
+BinNormalisation::
+is_thread_safe_for_time_frame(const double, const double) const
+{
+  return false;
+}
+
 void
 BinNormalisation::
 check(const ProjDataInfo& proj_data_info) const
@@ -125,6 +137,8 @@ apply(ProjData& proj_data,const double start_time, const double end_time,
                                          proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
                                          0, 1/*subset_num, num_subsets*/);
 
+  this->precompute_for_time_frame(start_time, end_time);
+
 #ifdef STIR_OPENMP
 #pragma omp parallel for  shared(proj_data, symmetries_sptr) schedule(runtime)  
 #endif
@@ -171,6 +185,8 @@ undo(ProjData& proj_data,const double start_time, const double end_time,
                                          proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
                                          0, 1/*subset_num, num_subsets*/);
 
+  this->precompute_for_time_frame(start_time, end_time);
+
 #ifdef STIR_OPENMP
 #pragma omp parallel for  shared(proj_data, symmetries_sptr) schedule(runtime)  
 #endif
@@ -0,0 +1,138 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup normalisation
+
+  \brief Implementation for class stir::BinNormalisationFactorsCache
+*/
+
+#include "stir/recon_buildblock/BinNormalisationFactorsCache.h"
+#include "stir/RelatedViewgrams.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/IndexRange3D.h"
+#include <algorithm>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
+
+START_NAMESPACE_STIR
+
+BinNormalisationFactorsCache::
+BinNormalisationFactorsCache()
+  : _is_enabled(false), _is_filled(false), _time_dependent(false), _start_time(0.), _end_time(0.)
+{}
+
+void
+BinNormalisationFactorsCache::
+set_up(const ProjDataInfo& proj_data_info, const bool enabled, const bool time_dependent)
+{
+  this->_is_enabled = enabled;
+  this->_is_filled = false;
+  this->_time_dependent = time_dependent;
+  if (!enabled)
+    {
+      // deallocate
+      this->_factors = VectorWithOffset<Array<3,float> >();
+      return;
+    }
+  this->_factors =
+    VectorWithOffset<Array<3,float> >(proj_data_info.get_min_segment_num(), proj_data_info.get_max_segment_num());
+  for (int segment_num = proj_data_info.get_min_segment_num();
+       segment_num <= proj_data_info.get_max_segment_num();
+       ++segment_num)
+    this->_factors[segment_num] =
+      Array<3,float>(IndexRange3D(proj_data_info.get_min_view_num(), proj_data_info.get_max_view_num(),
+                                  proj_data_info.get_min_axial_pos_num(segment_num),
+                                  proj_data_info.get_max_axial_pos_num(segment_num),
+                                  proj_data_info.get_min_tangential_pos_num(),
+                                  proj_data_info.get_max_tangential_pos_num()));
+}
+
+bool
+BinNormalisationFactorsCache::
+is_enabled() const
+{
+  return this->_is_enabled;
+}
+
+bool
+BinNormalisationFactorsCache::
+is_filled_for(const double start_time, const double end_time) const
+{
+  return
+    this->_is_filled &&
+    (!this->_time_dependent ||
+     (start_time == this->_start_time && end_time == this->_end_time));
+}
+
+bool
+BinNormalisationFactorsCache::
+can_fill()
+{
+#ifdef STIR_OPENMP
+  return !omp_in_parallel();
+#else
+  return true;
+#endif
+}
+
+void
+BinNormalisationFactorsCache::
+set_filled_for(const double start_time, const double end_time)
+{
+  this->_start_time = start_time;
+  this->_end_time = end_time;
+  this->_is_filled = true;
+}
+
+void
+BinNormalisationFactorsCache::
+apply_or_undo_stored_factors(RelatedViewgrams<float>& viewgrams, const bool divide) const
+{
+  for (RelatedViewgrams<float>::iterator iter = viewgrams.begin(); iter != viewgrams.end(); ++iter)
+    {
+      const Array<2,float>& factors = this->_factors[iter->get_segment_num()][iter->get_view_num()];
+      const int min_tangential_pos_num = iter->get_min_tangential_pos_num();
+      const int max_tangential_pos_num = iter->get_max_tangential_pos_num();
+      for (int axial_pos_num = iter->get_min_axial_pos_num();
+           axial_pos_num <= iter->get_max_axial_pos_num();
+           ++axial_pos_num)
+        {
+          Array<1,float>& row = (*iter)[axial_pos_num];
+          const Array<1,float>& factors_row = factors[axial_pos_num];
+          if (divide)
+            {
+              for (int tangential_pos_num = min_tangential_pos_num;
+                   tangential_pos_num <= max_tangential_pos_num;
+                   ++tangential_pos_num)
+                row[tangential_pos_num] /= std::max(1.E-20F, factors_row[tangential_pos_num]);
+            }
+          else
+            {
+              for (int tangential_pos_num = min_tangential_pos_num;
+                   tangential_pos_num <= max_tangential_pos_num;
+                   ++tangential_pos_num)
+                row[tangential_pos_num] *= factors_row[tangential_pos_num];
+            }
+        }
+    }
+}
+
+END_NAMESPACE_STIR
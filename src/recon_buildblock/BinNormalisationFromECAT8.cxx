@@ -166,6 +166,7 @@ BinNormalisationFromECAT8::set_defaults()
   this->_use_dead_time = false;
   this->_use_geometric_factors = true;
   this->_use_crystal_interference_factors = true;  
+  this->_cache_normalisation_factors = false;
 }
 
 void 
@@ -182,6 +183,7 @@ initialise_keymap()
   //this->parser.add_key("use_dead_time", &this->_use_dead_time);
   this->parser.add_key("use_geometric_factors", &this->_use_geometric_factors);
   this->parser.add_key("use_crystal_interference_factors", &this->_use_crystal_interference_factors);
+  this->parser.add_key("cache normalisation factors", &this->_cache_normalisation_factors);
   this->parser.add_stop_key("End Bin Normalisation From ECAT8");
 }
 
@@ -235,6 +237,12 @@ set_up(const shared_ptr<ProjDataInfo>& proj_data_info_ptr_v)
 
   mash = scanner_ptr->get_num_detectors_per_ring()/2/proj_data_info_ptr->get_num_views();
 
+  this->_factors_cache.set_up(*proj_data_info_ptr, this->_cache_normalisation_factors,
+                              this->factors_depend_on_time_frame());
+  // if the factors are the same for all time frames, we can compute them now
+  if (!this->factors_depend_on_time_frame())
+    this->precompute_for_time_frame(0., 0.);
+
   return Succeeded::yes;
 }
 
@@ -537,7 +545,7 @@ use_crystal_interference_factors() const
 #if 1
 float 
 BinNormalisationFromECAT8::
-get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const {
+compute_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const {
 
 
   // TODO disable when not HR+ or HR++
@@ -720,6 +728,56 @@ BinNormalisationFromECAT8::get_dead_time_efficiency (const DetectionPosition<>&
 
 
 
+bool
+BinNormalisationFromECAT8::
+factors_depend_on_time_frame() const
+{
+  return this->use_dead_time() && !is_null_ptr(this->singles_rates_ptr);
+}
+
+void
+BinNormalisationFromECAT8::
+precompute_for_time_frame(const double start_time, const double end_time) const
+{
+  this->_factors_cache.fill_if_necessary(*this, &BinNormalisationFromECAT8::compute_bin_efficiency,
+                                         start_time, end_time);
+}
+
+bool
+BinNormalisationFromECAT8::
+is_thread_safe_for_time_frame(const double start_time, const double end_time) const
+{
+  // the stored factors are only read
+  return this->_factors_cache.is_filled_for(start_time, end_time);
+}
+
+float
+BinNormalisationFromECAT8::
+get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const
+{
+  return this->_factors_cache.get_bin_efficiency(*this, &BinNormalisationFromECAT8::compute_bin_efficiency,
+                                                 bin, start_time, end_time);
+}
+
+void
+BinNormalisationFromECAT8::
+apply(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const
+{
+  this->check(*viewgrams.get_proj_data_info_sptr());
+  this->_factors_cache.apply(viewgrams, *this, &BinNormalisationFromECAT8::compute_bin_efficiency,
+                             start_time, end_time);
+}
+
+void
+BinNormalisationFromECAT8::
+undo(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const
+{
+  this->check(*viewgrams.get_proj_data_info_sptr());
+  this->_factors_cache.undo(viewgrams, *this, &BinNormalisationFromECAT8::compute_bin_efficiency,
+                            start_time, end_time);
+}
+
+
 END_NAMESPACE_ECAT  
 END_NAMESPACE_STIR
 
@@ -120,6 +120,25 @@ ChainedBinNormalisation:: get_bin_efficiency(const Bin& bin,const double start_t
      ? apply_second->get_bin_efficiency(bin,start_time,end_time)
      : 1);
 }
+
+void
+ChainedBinNormalisation::
+precompute_for_time_frame(const double start_time, const double end_time) const
+{
+  if (!is_null_ptr(apply_first))
+    apply_first->precompute_for_time_frame(start_time, end_time);
+  if (!is_null_ptr(apply_second))
+    apply_second->precompute_for_time_frame(start_time, end_time);
+}
+
+bool
+ChainedBinNormalisation::
+is_thread_safe_for_time_frame(const double start_time, const double end_time) const
+{
+  return
+    (is_null_ptr(apply_first) || apply_first->is_thread_safe_for_time_frame(start_time, end_time)) &&
+    (is_null_ptr(apply_second) || apply_second->is_thread_safe_for_time_frame(start_time, end_time));
+}
  
  
 END_NAMESPACE_STIR
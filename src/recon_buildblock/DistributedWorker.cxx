@@ -122,6 +122,79 @@ int main(int argc, char **argv)
   
 namespace stir 
 {
+  namespace
+  {
+    /* A work package sent by the master (see send_viewgrams() in distributable.cxx).
+       The header holds the view and segment number, and its tag says if new viewgrams
+       follow, if cached viewgrams have to be used, or if the iteration is finished.
+       While a package is processed, the next one is already being received into
+       a second WorkPackage object.
+    */
+    struct WorkPackage
+    {
+      int vs_values[2];
+      MPI_Request header_request;
+      int tag;
+      bool body_received;
+      bool add_bin_corr_viewgrams;
+      bool mult_viewgrams;
+      distributed::RelatedViewgramsReceive additive_receive;
+      distributed::RelatedViewgramsReceive mult_receive;
+      distributed::RelatedViewgramsReceive measured_receive;
+    };
+
+    //! post a non-blocking receive for the header of the next package
+    void start_receive_header(WorkPackage& package)
+    {
+      package.body_received = false;
+      MPI_Irecv(package.vs_values, 2, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &package.header_request);
+    }
+
+    //! check if the header has arrived (waiting for it if \a wait is \c true)
+    bool header_received(WorkPackage& package, const bool wait)
+    {
+      if (package.header_request == MPI_REQUEST_NULL)
+        return true; // it arrived earlier
+      MPI_Status status;
+      int completed = 1;
+      if (wait)
+        MPI_Wait(&package.header_request, &status);
+      else
+        MPI_Test(&package.header_request, &completed, &status);
+      if (completed)
+        package.tag = status.MPI_TAG;
+      return completed != 0;
+    }
+
+    /* receive the (small) messages that follow the header, and start the receives
+       of the viewgram values. Only call this after the header has been received.
+    */
+    void start_receive_body(WorkPackage& package,
+                            const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+                            const shared_ptr<DataSymmetriesForViewSegmentNumbers>& symmetries_sptr,
+                            const int my_rank)
+    {
+      package.body_received = true;
+      if (package.tag != NEW_VIEWGRAM_TAG)
+        return;
+#ifndef NDEBUG
+      //run test for related viewgrams
+      if (distributed::test && my_rank==1 && distributed::first_iteration==true) distributed::test_related_viewgrams_slave(proj_data_info_sptr, symmetries_sptr);
+#endif          
+      //receive info if additive_binwise_correction_viewgrams are NULL        
+      package.add_bin_corr_viewgrams=distributed::receive_bool_value(BINWISE_CORRECTION_TAG, 0);
+      if (package.add_bin_corr_viewgrams) 
+        distributed::start_receive_related_viewgrams(package.additive_receive, 0);
+
+      //receive info if mult_viewgrams_ptr are NULL   
+      package.mult_viewgrams=distributed::receive_bool_value(BINWISE_MULT_TAG, 0);         
+      if (package.mult_viewgrams) 
+        distributed::start_receive_related_viewgrams(package.mult_receive, 0);
+
+      // measured viewgrams
+      distributed::start_receive_related_viewgrams(package.measured_receive, 0);
+    }
+  }
         
   template <typename TargetT>
   DistributedWorker<TargetT>::DistributedWorker() 
@@ -289,6 +362,21 @@ namespace stir
 	    //output_image_ptr->fill(0.F);
 	  }
                    
+        /* The worker receives the next work package while it processes the current one.
+           As soon as the current package has arrived, a non-blocking receive is posted
+           for the header of the next one. If that header is already there (the master
+           sends up to 2 packages to every worker), the receives for the values of its
+           viewgrams are posted as well, such that they can be transferred while this
+           worker is busy computing.
+        */
+        WorkPackage packages[2];
+        int current_package = 0;
+        start_receive_header(packages[current_package]);
+#ifdef STIR_MPI_TIMINGS
+        HighResWallClockTimer waiting_timer; //measures the time this worker waits for work packages
+        waiting_timer.reset();
+#endif
+
         //loop to receive viewgrams until received END_ITERATION_TAG
         while (true)
           {
@@ -298,16 +386,25 @@ namespace stir
             RelatedViewgrams<float>* mult_viewgrams_ptr = NULL;
             int count=0, count2=0;
                                 
+            WorkPackage& package = packages[current_package];
+#ifdef STIR_MPI_TIMINGS
+            waiting_timer.start();
+#endif
+            header_received(package, /*wait=*/true);
+            if (!package.body_received)
+              start_receive_body(package, proj_data_info_sptr, symmetries_sptr, my_rank);
+
             //receive vs_num values     
             ViewSegmentNumbers vs;
-            status = distributed::receive_view_segment_numbers(vs, MPI_ANY_TAG);
+            vs.view_num() = package.vs_values[0];
+            vs.segment_num() = package.vs_values[1];
                         
             /*check whether to
              *  - use a viewgram already received in previous iteration
              *  - receive a new viewgram
              *  - end the iteration
              */         
-            if (status.MPI_TAG==REUSE_VIEWGRAM_TAG) //use a viewgram already available
+            if (package.tag==REUSE_VIEWGRAM_TAG) //use a viewgram already available
               {                        
                 viewgrams = new RelatedViewgrams<float>(proj_data_ptr->get_related_viewgrams(vs, symmetries_sptr));
                 if (!is_null_ptr(binwise_correction))
@@ -317,28 +414,25 @@ namespace stir
                   mult_viewgrams_ptr = 
                     new RelatedViewgrams<float>(mult_proj_data_sptr->get_related_viewgrams(vs, symmetries_sptr));
               } 
-            else if (status.MPI_TAG==NEW_VIEWGRAM_TAG) //receive a message with a new viewgram
+            else if (package.tag==NEW_VIEWGRAM_TAG) //wait for the rest of the new viewgrams
               {
-#ifndef NDEBUG
-                //run test for related viewgrams
-                if (distributed::test && my_rank==1 && distributed::first_iteration==true) distributed::test_related_viewgrams_slave(proj_data_info_sptr, symmetries_sptr);
-#endif          
-                //receive info if additive_binwise_correction_viewgrams are NULL        
-                const bool add_bin_corr_viewgrams=distributed::receive_bool_value(BINWISE_CORRECTION_TAG, 0);
+                const bool add_bin_corr_viewgrams = package.add_bin_corr_viewgrams;
                 if (add_bin_corr_viewgrams) 
                   {
-                    distributed::receive_and_construct_related_viewgrams(additive_binwise_correction_viewgrams, proj_data_info_sptr, symmetries_sptr, 0);
+                    distributed::complete_receive_related_viewgrams(additive_binwise_correction_viewgrams, package.additive_receive,
+                                                                    proj_data_info_sptr, symmetries_sptr);
                   }
 
-                //receive info if mult_viewgrams_ptr are NULL   
-                const bool mult_viewgrams=distributed::receive_bool_value(BINWISE_MULT_TAG, 0);         
+                const bool mult_viewgrams = package.mult_viewgrams;
                 if (mult_viewgrams) 
                   {
-                    distributed::receive_and_construct_related_viewgrams(mult_viewgrams_ptr, proj_data_info_sptr, symmetries_sptr, 0);
+                    distributed::complete_receive_related_viewgrams(mult_viewgrams_ptr, package.mult_receive,
+                                                                    proj_data_info_sptr, symmetries_sptr);
                   }
 
                 // measured viewgrams
-                distributed::receive_and_construct_related_viewgrams(viewgrams, proj_data_info_sptr, symmetries_sptr, 0); 
+                distributed::complete_receive_related_viewgrams(viewgrams, package.measured_receive,
+                                                                proj_data_info_sptr, symmetries_sptr);
                         
                 //save Viewgrams to ProjDataInMemory object
                 if(cache_enabled)
@@ -368,8 +462,15 @@ namespace stir
                       }
                   }
               }
-            else if (status.MPI_TAG==END_ITERATION_TAG)  //the iteration is completed --> send results
+            else if (package.tag==END_ITERATION_TAG)  //the iteration is completed --> send results
               { 
+#ifdef STIR_MPI_TIMINGS
+                waiting_timer.stop();
+                if (distributed::test_send_receive_times)
+                  std::cout << "Slave " << my_rank << ": waited " << waiting_timer.value() << " seconds for work packages" << std::endl;
+#endif
+                //viewgrams sent back for testing might still be in transit
+                distributed::wait_for_pending_sends();
                 //make reduction over computed output_images
                 distributed::first_iteration=false;
 		if (!is_null_ptr(output_image_ptr))
@@ -394,6 +495,17 @@ namespace stir
               }
             else 
               error("Slave received unknown tag");
+#ifdef STIR_MPI_TIMINGS
+            waiting_timer.stop();
+#endif
+
+            // start receiving the next package, such that it arrives while we are busy
+            {
+              WorkPackage& next_package = packages[1-current_package];
+              start_receive_header(next_package);
+              if (header_received(next_package, /*wait=*/false))
+                start_receive_body(next_package, proj_data_info_sptr, symmetries_sptr, my_rank);
+            }
             
             //measure time used for parallelized part
             if (distributed::rpc_time) {t.reset(); t.start();}
@@ -424,6 +536,7 @@ namespace stir
             if (viewgrams!=NULL) delete viewgrams;
             if (additive_binwise_correction_viewgrams!=NULL) delete additive_binwise_correction_viewgrams;
             if (mult_viewgrams_ptr!=NULL) delete mult_viewgrams_ptr;
+            current_package = 1-current_package;
           }
         if (distributed::rpc_time)
 	  stir::info(boost::format("Slave %1% used %2% seconds for PRC-processing.")
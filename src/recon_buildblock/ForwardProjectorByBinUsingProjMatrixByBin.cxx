@@ -132,6 +132,11 @@ ForwardProjectorByBinUsingProjMatrixByBin::
     // would be slow if there's no caching at all, but is very fast if everything is cached
     
     ProjMatrixElemsForOneBin proj_matrix_row;
+    // If all bins are cached, we can use the packed rows in the cache without copying.
+    // Otherwise, packing would only be overhead.
+    const bool use_packed_rows =
+      proj_matrix_ptr->is_cache_enabled() &&
+      !proj_matrix_ptr->does_cache_store_only_basic_bins();
     
     RelatedViewgrams<float>::iterator r_viewgrams_iter = viewgrams.begin();
     
@@ -145,8 +150,13 @@ ForwardProjectorByBinUsingProjMatrixByBin::
         for ( int ax_pos = min_axial_pos_num; ax_pos <= max_axial_pos_num ;++ax_pos)
         { 
           Bin bin(segment_num, view_num, ax_pos, tang_pos, 0);
-          proj_matrix_ptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, bin);
-          proj_matrix_row.forward_project(bin,image);
+          if (use_packed_rows)
+            proj_matrix_ptr->get_packed_proj_matrix_elems_for_one_bin(bin)->forward_project(bin,image);
+          else
+            {
+              proj_matrix_ptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, bin);
+              proj_matrix_row.forward_project(bin,image);
+            }
           viewgram[ax_pos][tang_pos] = bin.get_bin_value();
         }
         ++r_viewgrams_iter; 
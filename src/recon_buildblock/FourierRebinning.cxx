@@ -49,8 +49,13 @@
 #include <complex>
 #include <boost/format.hpp>
 #include "stir/numerics/fourier.h"
-#include "stir/interpolate.h"
+#include "stir/numerics/FourierTransformPlan.h"
+#include "stir/is_null_ptr.h"
+#include "stir/num_threads.h"
 #include "stir/info.h"
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #define POSITIVE_Z_SHIFT -1
 #define NEGATIVE_Z_SHIFT 1
@@ -128,19 +133,26 @@ rebin()
   //CON return value 
   Succeeded success = Succeeded::yes;
     
-  //CL Find the number of views and tangential positions power of two
-  int num_views_pow2;
-  for ( num_views_pow2 = 1; num_views_pow2 < 2*proj_data_sptr->get_num_views() && num_views_pow2 < (1<<15); num_views_pow2*=2);
-  int num_tang_poss_pow2;
-  for ( num_tang_poss_pow2 = 1; num_tang_poss_pow2 < proj_data_sptr->get_num_tangential_poss() && num_tang_poss_pow2 < (1<<15); num_tang_poss_pow2*=2);
+  // Find the sizes for the FFTs
+  // The DFT can handle any size, so we use the 360 degree sinograms as they are
+  // (i.e. no interpolation of the views), and pad in tangential direction to a size 
+  // where the DFT is efficient.
+  const int num_views_fft = 2*proj_data_sptr->get_num_views();
+  const int num_tang_poss_fft = find_efficient_fourier_length(proj_data_sptr->get_num_tangential_poss());
   
   //CL Initialise the 2D Fourier transform of all rebinned sinograms P(w,k)=0
    const int num_planes = proj_data_sptr->get_proj_data_info_ptr()->get_scanner_ptr()->get_num_rings()*2-1;
 
-  Array<3,std::complex<float> > FT_rebinned_data(IndexRange3D(0, num_planes-1, 0, num_views_pow2-1, 0, num_tang_poss_pow2-1));
-  Array<3,float> Weights_for_FT_rebinned_data(IndexRange3D(0, num_planes-1, 0,num_views_pow2-1, 0,num_tang_poss_pow2-1));
+  // Every thread accumulates in its own arrays. The first ones are used as final result.
+  // Arrays for other threads are only allocated when needed, see do_rebinning().
+  std::vector<shared_ptr<Array<3,std::complex<float> > > > local_FT_rebinned_data_sptrs(get_max_num_threads());
+  std::vector<shared_ptr<Array<3,float> > > local_Weights_for_FT_rebinned_data_sptrs(get_max_num_threads());
+  local_FT_rebinned_data_sptrs[0].reset(new Array<3,std::complex<float> >(IndexRange3D(0, num_planes-1, 0, num_views_fft-1, 0, num_tang_poss_fft-1)));
+  local_Weights_for_FT_rebinned_data_sptrs[0].reset(new Array<3,float>(IndexRange3D(0, num_planes-1, 0,num_views_fft-1, 0,num_tang_poss_fft-1)));
+  Array<3,std::complex<float> >& FT_rebinned_data = *local_FT_rebinned_data_sptrs[0];
+  Array<3,float>& Weights_for_FT_rebinned_data = *local_Weights_for_FT_rebinned_data_sptrs[0];
   //CON some statistics
-  PETCount_rebinned num_rebinned(0,0,0);
+  std::vector<PETCount_rebinned> local_num_rebinned(get_max_num_threads());
 
   //CON Create the output (rebinned projection data) data structure and set the properties of the rebinned sinograms
   shared_ptr<ProjData> rebinned_proj_data_sptr;
@@ -148,7 +160,7 @@ rebin()
   shared_ptr<ProjDataInfo> rebinned_proj_data_info_sptr
     ( proj_data_sptr->get_proj_data_info_ptr()->clone());
   //CON Adapt the properties that will be modified by the rebinning.
-  rebinned_proj_data_info_sptr->set_num_views(num_views_pow2/2);
+  rebinned_proj_data_info_sptr->set_num_views(num_views_fft/2);
   //CON After rebinning we have of course only "direct" sinograms left e.q only segment 0 exists 
   rebinned_proj_data_info_sptr->reduce_segment_range(0,0);
   //CON maximal ring difference a LOR in the largest segment that is going to be rebinned 
@@ -169,7 +181,7 @@ rebin()
   const Scanner* scanner = rebinned_proj_data_sptr->get_proj_data_info_ptr()->get_scanner_ptr();
   const float half_distance_between_rings = scanner->get_ring_spacing()/2.F; 
   const float sampling_distance_in_s = rebinned_proj_data_info_sptr->get_sampling_in_s(Bin(0,0,0,0));
-  const float radial_sampling_freq_w = float(2.*_PI)/sampling_distance_in_s/num_tang_poss_pow2;
+  const float radial_sampling_freq_w = float(2.*_PI)/sampling_distance_in_s/num_tang_poss_fft;
   //CON D = #bins * binsize, R = D / 2
   const float R_field_of_view_mm = ((int) (rebinned_proj_data_info_sptr->get_num_tangential_poss() / 2) - 1)*sampling_distance_in_s;
   const float scanner_space_between_rings = scanner->get_ring_spacing();
@@ -177,7 +189,7 @@ rebin()
   const float ratio_ring_spacing_to_ring_radius = scanner_space_between_rings / scanner_ring_radius;
 
   //CON Check that the user defineable FORE parameters are inside a possible range of values
-  if(fore_check_parameters(num_tang_poss_pow2,num_views_pow2,max_segment_num_to_process) != Succeeded::yes){
+  if(fore_check_parameters(num_tang_poss_fft,num_views_fft,max_segment_num_to_process) != Succeeded::yes){
     error("FORE Rebinning :: Setup failed "); 
    };
   
@@ -236,12 +248,9 @@ rebin()
 	  display(segment, segment.find_max(), s);
 	}
 	
-    //CON the sinogramm dimensions need to have a dimension which is a power of 2 (required by the FFT algorithm) 
-    //CON for s (radial coordinate) pad the sinogramm with zeros to form a larger array. 
-    //CON the phi (azimuthal cordinate (view)) coordinate is periodic. The samples need to be interpolated to the
-    //CON to the new matrix size. Do this by linear interpolation.             
+    // for s (radial coordinate) the sinogram will be padded with zeros to form a larger array (see do_rebinning).
+    // the phi (azimuthal coordinate (view)) coordinate is periodic, so no padding is necessary.
     //CON -> DeFrise p. 153 Sec IV.C
-    do_adjust_nb_views_to_pow2(segment);
 
     
     //CON The sinogramm data is now in the required format and ready for rebinning.       
@@ -249,13 +258,33 @@ rebin()
     //CON FT_rebinned_data[plane][w(FT of s)][k(FT of phi)] 
     //CON Weight has the same dimensions. It stores normalisation factors (floats)
     //CON to take into account the variable number of contributions to each frequency.     
-    do_rebinning(FT_rebinned_data, Weights_for_FT_rebinned_data, num_rebinned, segment,
-                 num_tang_poss_pow2, num_views_pow2, num_planes, average_ring_difference_in_segment,
+    do_rebinning(local_FT_rebinned_data_sptrs, local_Weights_for_FT_rebinned_data_sptrs, local_num_rebinned, segment,
+                 num_tang_poss_fft, num_views_fft, num_planes, average_ring_difference_in_segment,
                  half_distance_between_rings, sampling_distance_in_s, radial_sampling_freq_w, R_field_of_view_mm,
 	         ratio_ring_spacing_to_ring_radius);
   
  }  //CON end loop over segments.
 
+  // add contributions of the other threads
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int plane=0; plane<num_planes; ++plane)
+    for (int thread_num=1; thread_num<static_cast<int>(local_FT_rebinned_data_sptrs.size()); ++thread_num)
+      if (!is_null_ptr(local_FT_rebinned_data_sptrs[thread_num])) // only accumulate if a thread filled something in
+        {
+          FT_rebinned_data[plane] += (*local_FT_rebinned_data_sptrs[thread_num])[plane];
+          Weights_for_FT_rebinned_data[plane] += (*local_Weights_for_FT_rebinned_data_sptrs[thread_num])[plane];
+        }
+  PETCount_rebinned num_rebinned(0,0,0);
+  for (int thread_num=0; thread_num<static_cast<int>(local_num_rebinned.size()); ++thread_num)
+    num_rebinned += local_num_rebinned[thread_num];
+  // free memory
+  for (int thread_num=1; thread_num<static_cast<int>(local_FT_rebinned_data_sptrs.size()); ++thread_num)
+    {
+      local_FT_rebinned_data_sptrs[thread_num].reset();
+      local_Weights_for_FT_rebinned_data_sptrs[thread_num].reset();
+    }
 
   //CON Some statistics 
   std::cout << "\nFORE Rebinning :: Total rebinning count: \n";
@@ -265,7 +294,10 @@ rebin()
   //CL now finally fill in the new sinogram s
   SegmentBySinogram<float> sino2D_rebinned = rebinned_proj_data_sptr->get_empty_segment_by_sinogram(0);
 
-  
+  // planes are independent, so we can do them in parallel (unless we need to display them)
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) if (fore_debug_level<3)
+#endif
   for (int plane=FT_rebinned_data.get_min_index();plane <= FT_rebinned_data.get_max_index(); plane++){
    
    if(plane%10==0) info(boost::format("FORE Rebinning :: Inv FFT rebinned z-position (slice) = %1%") % plane);
@@ -277,14 +309,14 @@ rebin()
   //CON the rebinning weights
   //CON before the inv. FFT can be applied this is not much overhead and it can be left like it was done when still 
   //CON using the numerical receipies FFT code.       
-   Array<2, std::complex<float> > FT_rebinned_sinogram(IndexRange2D(0,num_tang_poss_pow2-1,0,num_views_pow2/2));
+   Array<2, std::complex<float> > FT_rebinned_sinogram(IndexRange2D(0,num_tang_poss_fft-1,0,num_views_fft/2));
   //CON fourier_for_real_data will resize the array to its appropriate dimensions
    Array<2,float> rebinned_sinogram(IndexRange2D(0,1,0,1));
  
   //CON Normalise the rebinned sinograms by applying the weight factors
   //CON See DeFrise IV.D p154.   
- for (int j = 0; j < num_tang_poss_pow2; j++) {    
-   for (int i = 0; i <= num_views_pow2/2; i++) {   
+ for (int j = 0; j < num_tang_poss_fft; j++) {    
+   for (int i = 0; i <= num_views_fft/2; i++) {   
      const float Actual_Weight = (Weights_for_FT_rebinned_data[plane][i][j] == 0) ? 0 : 
        1.F/(Weights_for_FT_rebinned_data[plane][i][j]);
      FT_rebinned_sinogram[j][i] = FT_rebinned_data[plane][i][j]* Actual_Weight;
@@ -296,13 +328,13 @@ rebin()
     {
       char s[100];
       Array<2,float> real(FT_rebinned_sinogram.get_index_range());
-      for (int i = 0; i < num_views_pow2; i++) 
-	for (int j = 0; j <= num_tang_poss_pow2/2; j++) 
+      for (int i = 0; i < num_views_fft; i++) 
+	for (int j = 0; j <= num_tang_poss_fft/2; j++) 
           real[i][j] = FT_rebinned_sinogram[i][j].real();
       sprintf(s, "real part of FT of rebinned (extended) sinogram %d",plane);
       display(real, s, real.find_max());
-      for (int i = 0; i < num_views_pow2; i++) 
-	for (int j = 0; j <= num_tang_poss_pow2/2; j++) 
+      for (int i = 0; i < num_views_fft; i++) 
+	for (int j = 0; j <= num_tang_poss_fft/2; j++) 
           real[i][j] = FT_rebinned_sinogram[i][j].imag();
       sprintf(s, "imag part of FT of rebinned (extended) sinogram %d",plane);
       display(real, s, real.find_max());
@@ -312,8 +344,8 @@ rebin()
     rebinned_sinogram = inverse_fourier_for_real_data(FT_rebinned_sinogram); 
 
    //CL Keep only one half of data [o.._PI]
-    for (int i=0;i<(int)(num_views_pow2/2);i++) 
-     for (int j=0;j<num_tang_poss_pow2;j++)
+    for (int i=0;i<(int)(num_views_fft/2);i++) 
+     for (int j=0;j<num_tang_poss_fft;j++)
         if ((j+sino2D_rebinned.get_min_tangential_pos_num())<=sino2D_rebinned.get_max_tangential_pos_num()) 
           sino2D_rebinned[plane][i][j+sino2D_rebinned.get_min_tangential_pos_num()]=rebinned_sinogram[j][i];
            
@@ -346,33 +378,50 @@ rebin()
 
 void 
 FourierRebinning::
-do_rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
-             PETCount_rebinned &count_rebinned, 
-             const SegmentBySinogram<float> &segment, const int num_tang_poss_pow2,
-             const int num_views_pow2, const int num_planes, const float average_ring_difference_in_segment,
+do_rebinning(std::vector<shared_ptr<Array<3,std::complex<float> > > > &local_FT_rebinned_data_sptrs,
+             std::vector<shared_ptr<Array<3,float> > > &local_Weights_for_FT_rebinned_data_sptrs,
+             std::vector<PETCount_rebinned> &local_count_rebinned, 
+             const SegmentBySinogram<float> &segment, const int num_tang_poss_fft,
+             const int num_views_fft, const int num_planes, const float average_ring_difference_in_segment,
              const float half_distance_between_rings, const float sampling_distance_in_s, 
              const float radial_sampling_freq_w, const float R_field_of_view_mm,
              const float ratio_ring_spacing_to_ring_radius)
  
  
  {
-   const int local_rebinned = count_rebinned.total;
-   const int local_miss= count_rebinned.miss;
-   const int local_ssrb= count_rebinned.ssrb;
+   PETCount_rebinned count_before(0,0,0);
+   for (int thread_num=0; thread_num<static_cast<int>(local_count_rebinned.size()); ++thread_num)
+     count_before += local_count_rebinned[thread_num];
 
 //CON Loop over all slices, FFT the sinograms and call the actual rebinning kernel.
+// Slices are distributed over threads. Each thread adds its contributions to its own arrays.
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
    for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num() ;axial_pos_num++)   
      {
+#ifdef STIR_OPENMP
+      const int thread_num = omp_get_thread_num();
+#else
+      const int thread_num = 0;
+#endif
+      if (is_null_ptr(local_FT_rebinned_data_sptrs[thread_num]))
+        {
+          local_FT_rebinned_data_sptrs[thread_num].reset
+            (new Array<3,std::complex<float> >(local_FT_rebinned_data_sptrs[0]->get_index_range()));
+          local_Weights_for_FT_rebinned_data_sptrs[thread_num].reset
+            (new Array<3,float>(local_Weights_for_FT_rebinned_data_sptrs[0]->get_index_range()));
+        }
 
       if(axial_pos_num%10 == 0)  info(boost::format("FORE Rebinning z (slice) = %1%") % axial_pos_num);   
-      Array<2,float> current_sinogram(IndexRange2D(0,num_tang_poss_pow2-1,0,num_views_pow2-1));
+      Array<2,float> current_sinogram(IndexRange2D(0,num_tang_poss_fft-1,0,num_views_fft-1));
   
   //CL Calculate the 2D FFT of P(w,k) of the merged segment
   //CON copy the sinogram data of slice axial_pos_num from the segment array to slicedata
   //CON the sinogram is flipped. This will taken account for in the rebinning, where the assignment of the FFT
   //CON coefficients are assigned opposite.
      for (int j = 0; j < segment.get_num_tangential_poss(); j++) 
-      for (int i = 0; i < num_views_pow2; i++) 
+      for (int i = 0; i < num_views_fft; i++) 
         current_sinogram[j][i] = segment[axial_pos_num][i][j + segment.get_min_tangential_pos_num()];
        
   //CON FFT slicedata
@@ -383,18 +432,22 @@ do_rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &We
     const float z_in_mm = proj_data_info.get_m(Bin(segment.get_segment_num(),0,axial_pos_num,0)) - proj_data_info.get_m(Bin(0,0,0,0));
 
   //CON Call the rebinning kernel.                                                             
-    rebinning(FT_rebinned_data,Weights_for_FT_rebinned_data,count_rebinned,FT_current_sinogram,
-              z_in_mm, average_ring_difference_in_segment, num_views_pow2,
-              num_tang_poss_pow2,half_distance_between_rings,sampling_distance_in_s,radial_sampling_freq_w,
+    rebinning(*local_FT_rebinned_data_sptrs[thread_num],*local_Weights_for_FT_rebinned_data_sptrs[thread_num],
+              local_count_rebinned[thread_num],FT_current_sinogram,
+              z_in_mm, average_ring_difference_in_segment, num_views_fft,
+              num_tang_poss_fft,half_distance_between_rings,sampling_distance_in_s,radial_sampling_freq_w,
               R_field_of_view_mm,ratio_ring_spacing_to_ring_radius);
 
  }//CL End of loop of axial_pos_num
      
     if(fore_debug_level > 0){
+      PETCount_rebinned count_after(0,0,0);
+      for (int thread_num=0; thread_num<static_cast<int>(local_count_rebinned.size()); ++thread_num)
+        count_after += local_count_rebinned[thread_num];
       info(boost::format("Total rebinned: %1%\n"
                          "Total missed: %2%\n"
                          "Total rebinned SSRB: %3%") 
-           % (count_rebinned.total - local_rebinned) % (count_rebinned.miss - local_miss) % (count_rebinned.ssrb - local_ssrb) );
+           % (count_after.total - count_before.total) % (count_after.miss - count_before.miss) % (count_after.ssrb - count_before.ssrb) );
    }
 
 }
@@ -407,7 +460,7 @@ FourierRebinning::
 rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
           PETCount_rebinned &num_rebinned, const Array<2,std::complex<float> > &FT_current_sinogram,
 	  const float z_in_mm, const float delta, 
-          const int num_views_pow2, const int num_tang_poss_pow2, const float half_distance_between_rings, 
+          const int num_views_fft, const int num_tang_poss_fft, const float half_distance_between_rings, 
 	  const float sampling_distance_in_s, const float radial_sampling_freq_w, const float R_field_of_view_mm, 
           const float ratio_ring_spacing_to_ring_radius)
 {
@@ -429,10 +482,10 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
   //CON The integer Fourier index "k" corresponds to the azimuthal angle "view"
 
   //CON FORE regime (rebinning)
-  //CON Iterate over all frequency tuples (w,k) starting from wmin,kmin up to num_tang_poss_pow2/2,num_views_pow2/2
+  //CON Iterate over all frequency tuples (w,k) starting from wmin,kmin up to num_tang_poss_fft/2,num_views_fft/2
 
-      for (int j = wmin; j <= num_tang_poss_pow2/2;j++) {
-        for (int i = kmin; i <= num_views_pow2/2; i++) {
+      for (int j = wmin; j <= num_tang_poss_fft/2;j++) {
+        for (int i = kmin; i <= num_views_fft/2; i++) {
 
               float w = static_cast<float>(j) * radial_sampling_freq_w;
               float k = static_cast<float>(i);     
@@ -467,7 +520,7 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
 
               int jj = j;
          
-             if(shift_direction==NEGATIVE_Z_SHIFT && j > 0)   jj = num_tang_poss_pow2 - j;
+             if(shift_direction==NEGATIVE_Z_SHIFT && j > 0)   jj = num_tang_poss_fft - j;
                 
                 //CON new_z_sl is the z-coordinate of the shifted z-position this contribution is assigned to.  	    
                 const float new_z_sl = static_cast<float>(z) + shift_direction * zshift/half_distance_between_rings;       
@@ -509,7 +562,7 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
      //CON and therefore there will be only contributions to one direct sinogram and the weights are therefore always 1. 
     
        for (int j = 0; j < wmin; j++){
-         for (int i = 0; i <= num_views_pow2/2; i++) {
+         for (int i = 0; i <= num_views_fft/2; i++) {
 	 
 	       for(int shift_direction=POSITIVE_Z_SHIFT;shift_direction<=NEGATIVE_Z_SHIFT;shift_direction+=CHANGE_Z_SHIFT){
 
@@ -517,7 +570,7 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
 
 		   // Take reverse ordering of tangential position in the negative segment into account (?)
                    if(shift_direction==NEGATIVE_Z_SHIFT && j > 0)  
-                      jj=num_tang_poss_pow2 - j;                  
+                      jj=num_tang_poss_fft - j;                  
       
                     
                     if (small_z >= 0 && small_z <= maxplane ) {      
@@ -533,8 +586,8 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
       
 
 //CL Small k :
-//CL Next treat small k's and w=wNyq=(num_tang_poss_pow2 / 2)+1, k=1..klim :
-       for (int j = wmin; j <= num_tang_poss_pow2/2; j++) {
+//CL Next treat small k's and w=wNyq=(num_tang_poss_fft / 2)+1, k=1..klim :
+       for (int j = wmin; j <= num_tang_poss_fft/2; j++) {
          for (int i = 0; i <= kmin; i++) {
           
                for(int shift_direction=POSITIVE_Z_SHIFT;shift_direction<=NEGATIVE_Z_SHIFT;shift_direction+=CHANGE_Z_SHIFT){
@@ -543,7 +596,7 @@ rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weigh
 
 		   // Take reverse ordering of tangential position in the negative segment into account (?)
                     if(shift_direction==NEGATIVE_Z_SHIFT && j > 0)  
-                       jj=num_tang_poss_pow2 - j;  
+                       jj=num_tang_poss_fft - j;  
                
                    
                     if (small_z >= 0 && small_z <= maxplane ) {            
@@ -596,41 +649,8 @@ do_display_count(PETCount_rebinned &count)
 }
 
 
-void 
-FourierRebinning::
-do_adjust_nb_views_to_pow2(SegmentBySinogram<float> &segment) 
-{
-// Adjustment of the number of views to a power of two
-//CON Use the STIR overlap_interpolate method and remove the simlar private implementation (adjust_pow2) here.      
-  const int num_views_pow2 = stir::round(pow(2.,((int)ceil(log ((float)segment.get_num_views())/log(2.)))));
-  const float offset_for_overlap_interpolate = 0.F;
-      
-    if (num_views_pow2 == segment.get_num_views()) 
-        return; 
-
-    //CON Create the projection data info ptr for the resized segment
-    shared_ptr<ProjDataInfo> out_proj_data_info_sptr(segment.get_proj_data_info_ptr()->clone());
-    out_proj_data_info_sptr->set_num_views(num_views_pow2);
-    //CON the re-dimensioned segment      
-    SegmentBySinogram<float> out_segment = 
-      out_proj_data_info_sptr->get_empty_segment_by_sinogram(segment.get_segment_num());
-
-    for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num();
-             axial_pos_num++) 
-    {
-        const Sinogram<float> sino2D = segment.get_sinogram(axial_pos_num);
-        Sinogram<float> out_sino2D = out_segment.get_sinogram(axial_pos_num);
-      
-        float extension_factor = static_cast<float>(out_sino2D.get_num_views())/ static_cast<float>(sino2D.get_num_views());
-	overlap_interpolate(out_sino2D, sino2D,extension_factor,offset_for_overlap_interpolate,true);
-   
-      out_segment.set_sinogram(out_sino2D);
-    }
-    segment = out_segment;
-}
-
 Succeeded FourierRebinning::
-fore_check_parameters(int num_tang_poss_pow2, int num_views_pow2, int max_segment_num_to_process){
+fore_check_parameters(int num_tang_poss_fft, int num_views_fft, int max_segment_num_to_process){
 
 //CON Check if the parameters given make sense.
 
@@ -648,20 +668,20 @@ fore_check_parameters(int num_tang_poss_pow2, int num_views_pow2, int max_segmen
  }
 
 
- if(wmin >= num_tang_poss_pow2/2 || kmin >= num_views_pow2/2) {
+ if(wmin >= num_tang_poss_fft/2 || kmin >= num_views_fft/2) {
    warning(boost::format("FORE initialisation :: The parameter wmin or kmin is larger than the highest frequency component computed by the FFT algorithm\n"
                          "                       Choose an value smaller than the largest frequency\n"
                          "                       kmin must be smaller than %1% and wmin must be smaller than %2%")
-           % (num_tang_poss_pow2/2) % (num_views_pow2/2));
+           % (num_tang_poss_fft/2) % (num_views_fft/2));
    return Succeeded::no; 
  }
 
 
- if(kc >= num_views_pow2/2) {
+ if(kc >= num_views_fft/2) {
    warning(boost::format("FORE initialisation :: Your parameter kc is larger than the highest frequency component in w (FTT of radial coordinate s)\n"
                          "                       Choose an value smaller than the largest frequency\n"
                          "                       kc must be smaller than %1%") 
-           % num_views_pow2);
+           % num_views_fft);
    return Succeeded::no; 
  } 
 
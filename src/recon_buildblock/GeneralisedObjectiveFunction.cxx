@@ -348,6 +348,14 @@ get_objective_function_values_report(const TargetT& current_estimate)
   return s.str();
 }
 
+template<typename TargetT>
+std::string
+GeneralisedObjectiveFunction<TargetT>::
+get_computation_statistics_report() const
+{
+  return std::string();
+}
+
 template<typename TargetT>
 bool
 GeneralisedObjectiveFunction<TargetT>::
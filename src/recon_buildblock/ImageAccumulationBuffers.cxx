@@ -0,0 +1,157 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup recon_buildblock
+
+  \brief Implementation of class stir::ImageAccumulationBuffers
+*/
+
+#include "stir/recon_buildblock/ImageAccumulationBuffers.h"
+#include "stir/num_threads.h"
+#include "stir/is_null_ptr.h"
+#include <algorithm>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
+
+START_NAMESPACE_STIR
+
+// wrapper around an OpenMP lock, such that omp.h does not need to be included in the header
+struct ImageAccumulationBuffers::Lock
+{
+#ifdef STIR_OPENMP
+  omp_lock_t lock;
+  Lock() { omp_init_lock(&lock); }
+  ~Lock() { omp_destroy_lock(&lock); }
+#endif
+};
+
+ImageAccumulationBuffers::
+ImageAccumulationBuffers(DiscretisedDensity<3,float>& output_image_v,
+                         const int num_buffers)
+  : output_image(output_image_v)
+{
+#ifdef STIR_OPENMP
+  const int actual_num_buffers =
+    num_buffers > 0 ? num_buffers : get_default_num_buffers(output_image);
+#else
+  const int actual_num_buffers = 1;
+#endif
+  this->buffer_sptrs.resize(actual_num_buffers);
+  this->lock_sptrs.resize(actual_num_buffers);
+  for (int i=0; i<actual_num_buffers; ++i)
+    this->lock_sptrs[i].reset(new Lock);
+}
+
+ImageAccumulationBuffers::
+~ImageAccumulationBuffers()
+{}
+
+int
+ImageAccumulationBuffers::
+get_num_buffers() const
+{
+  return static_cast<int>(this->lock_sptrs.size());
+}
+
+const std::size_t ImageAccumulationBuffers::default_max_memory_in_MB;
+
+int
+ImageAccumulationBuffers::
+get_default_num_buffers(const DiscretisedDensity<3,float>& image,
+                        const std::size_t max_memory_in_MB)
+{
+  const std::size_t image_size_in_MB =
+    std::max(image.size_all() * sizeof(float) / 1048576, std::size_t(1));
+  // the first buffer is the output image, so doesn't count
+  const std::size_t max_num_buffers = 1 + max_memory_in_MB / image_size_in_MB;
+  return static_cast<int>(std::min(max_num_buffers,
+                                   static_cast<std::size_t>(std::max(get_max_num_threads(), 1))));
+}
+
+int
+ImageAccumulationBuffers::
+acquire()
+{
+#ifdef STIR_OPENMP
+  const int num_buffers = this->get_num_buffers();
+  // start at a different buffer for each thread to avoid contention
+  const int first_buffer_num = omp_get_thread_num() % num_buffers;
+  int buffer_num = -1;
+  for (int i=0; i<num_buffers; ++i)
+    {
+      const int candidate = (first_buffer_num + i) % num_buffers;
+      if (omp_test_lock(&this->lock_sptrs[candidate]->lock))
+        {
+          buffer_num = candidate;
+          break;
+        }
+    }
+  if (buffer_num < 0)
+    {
+      // all in use, so wait
+      buffer_num = first_buffer_num;
+      omp_set_lock(&this->lock_sptrs[buffer_num]->lock);
+    }
+  // allocate the buffer if necessary (we have exclusive access now)
+  if (buffer_num > 0 && is_null_ptr(this->buffer_sptrs[buffer_num]))
+    this->buffer_sptrs[buffer_num].reset(this->output_image.get_empty_copy());
+  return buffer_num;
+#else
+  return 0;
+#endif
+}
+
+DiscretisedDensity<3,float>&
+ImageAccumulationBuffers::
+get_buffer(const int buffer_num)
+{
+  if (buffer_num == 0)
+    return this->output_image;
+  return *this->buffer_sptrs[buffer_num];
+}
+
+void
+ImageAccumulationBuffers::
+release(const int buffer_num)
+{
+#ifdef STIR_OPENMP
+  omp_unset_lock(&this->lock_sptrs[buffer_num]->lock);
+#endif
+}
+
+void
+ImageAccumulationBuffers::
+accumulate()
+{
+  const int min_z = this->output_image.get_min_index();
+  const int max_z = this->output_image.get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int z=min_z; z<=max_z; ++z)
+    {
+      for (int i=1; i<this->get_num_buffers(); ++i)
+        if (!is_null_ptr(this->buffer_sptrs[i])) // only accumulate if a thread filled something in
+          this->output_image[z] += (*this->buffer_sptrs[i])[z];
+    }
+  for (int i=1; i<this->get_num_buffers(); ++i)
+    this->buffer_sptrs[i].reset();
+}
+
+END_NAMESPACE_STIR
@@ -47,6 +47,7 @@
 #include "stir/modelling/KineticParameters.h"
 
 #include "stir/TextWriter.h"
+#include "stir/info.h"
 
 #ifndef STIR_NO_NAMESPACES
 using std::cerr;
@@ -433,6 +434,12 @@ reconstruct(shared_ptr<TargetT > const& target_data_sptr)
   this->stop_timers();
 
   cerr << "Total CPU Time " << this->get_CPU_timer_value() << "secs"<<endl;
+  {
+    const std::string statistics =
+      this->objective_function_sptr->get_computation_statistics_report();
+    if (!statistics.empty())
+      info(statistics);
+  }
 
   // currently, if there was something wrong, the programme is just aborted
   // so, if we get here, everything was fine
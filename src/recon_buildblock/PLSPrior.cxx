@@ -268,6 +268,9 @@ void PLSPrior<elemT>::compute_image_gradient_element(DiscretisedDensity<3,elemT>
     const int max_z = image.get_max_index();
 
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (int z=min_z; z<=max_z; z++)
           {
 
@@ -322,6 +325,9 @@ PLSPrior<elemT>::compute_normalisation_anatomical_gradient(DiscretisedDensity<3,
     const int max_z = image_grad_x.get_max_index();
 
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (int z=min_z; z<=max_z; z++)
           {
 
@@ -374,8 +380,13 @@ compute_inner_product_and_penalty(DiscretisedDensity<3,elemT> &inner_product,
 
     const int min_z = pet_image.get_min_index();
     const int max_z = pet_image.get_max_index();
+    // avoid copying the shared_ptr for every voxel
+    const DiscretisedDensity<3,elemT>& norm = *this->norm_sptr;
 
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
         for (int z=min_z; z<=max_z; z++)
           {
 
@@ -395,8 +406,8 @@ compute_inner_product_and_penalty(DiscretisedDensity<3,elemT> &inner_product,
                     for (int x=min_x;x<= max_x;x++)
                     {
                         if(only_2D){
-                            inner_product[z][y][x]   = ((pet_im_grad_y[z][y][x]*(*anatomical_grad_y_sptr)[z][y][x]/(*get_norm_sptr())[z][y][x]) +
-                                                        (pet_im_grad_x[z][y][x]*(*anatomical_grad_x_sptr)[z][y][x]/(*get_norm_sptr())[z][y][x]));
+                            inner_product[z][y][x]   = ((pet_im_grad_y[z][y][x]*(*anatomical_grad_y_sptr)[z][y][x]/norm[z][y][x]) +
+                                                        (pet_im_grad_x[z][y][x]*(*anatomical_grad_x_sptr)[z][y][x]/norm[z][y][x]));
 
                             penalty[z][y][x]= sqrt (square(this->alpha) + square(pet_im_grad_y[z][y][x]) +
                                                                               square(pet_im_grad_x[z][y][x]) -
@@ -405,7 +416,7 @@ compute_inner_product_and_penalty(DiscretisedDensity<3,elemT> &inner_product,
                         else{
                      inner_product[z][y][x]   = (pet_im_grad_z[z][y][x]*(*anatomical_grad_z_sptr)[z][y][x] +
                                                  pet_im_grad_y[z][y][x]*(*anatomical_grad_y_sptr)[z][y][x] +
-                                                 pet_im_grad_x[z][y][x]*(*anatomical_grad_x_sptr)[z][y][x])/(*get_norm_sptr())[z][y][x];
+                                                 pet_im_grad_x[z][y][x]*(*anatomical_grad_x_sptr)[z][y][x])/norm[z][y][x];
 
                      penalty[z][y][x]= sqrt (square(this->alpha) + square(pet_im_grad_z[z][y][x]) +
                                                                        square(pet_im_grad_y[z][y][x]) +
@@ -457,6 +468,9 @@ compute_value(const DiscretisedDensity<3,elemT> &current_image_estimate)
   double result = 0.;
   const int min_z = current_image_estimate.get_min_index();
   const int max_z = current_image_estimate.get_max_index();
+#ifdef STIR_OPENMP
+#pragma omp parallel for reduction(+:result) schedule(static)
+#endif
   for (int z=min_z; z<=max_z; z++)
     {
 
@@ -540,7 +554,12 @@ compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient,
 
   const int min_z = current_image_estimate.get_min_index();
   const int max_z = current_image_estimate.get_max_index();
+  // avoid copying the shared_ptr for every voxel
+  const DiscretisedDensity<3,elemT>& norm = *this->norm_sptr;
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
   for (int z=min_z; z<=max_z; z++)
     {
 
@@ -569,38 +588,41 @@ compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient,
               if(only_2D){
                   (*gradientx_sptr)[z][y][x+1] =
                      (((*pet_im_grad_x_sptr)[z][y][x+1]-(*anatomical_grad_x_sptr)[z][y][x+1]*(*inner_product_sptr)[z][y][x+1]/
-                          (*get_norm_sptr ())[z][y][x+1])/(*penalty_sptr)[z][y][x+1] -
-                     (((*pet_im_grad_x_sptr)[z][y][x]-(*anatomical_grad_x_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/(*get_norm_sptr ())[z][y][x])/
+                          norm[z][y][x+1])/(*penalty_sptr)[z][y][x+1] -
+                     (((*pet_im_grad_x_sptr)[z][y][x]-(*anatomical_grad_x_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/norm[z][y][x])/
                       (*penalty_sptr)[z][y][x]) );
 
                   (*gradienty_sptr)[z][y+1][x] =
                       (((*pet_im_grad_y_sptr)[z][y+1][x]-(*anatomical_grad_y_sptr)[z][y+1][x]*(*inner_product_sptr)[z][y+1][x]/
-                          (*get_norm_sptr ())[z][y+1][x])/(*penalty_sptr)[z][y+1][x] -
-                      (((*pet_im_grad_y_sptr)[z][y][x]-(*anatomical_grad_y_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/(*get_norm_sptr ())[z][y][x])/
+                          norm[z][y+1][x])/(*penalty_sptr)[z][y+1][x] -
+                      (((*pet_im_grad_y_sptr)[z][y][x]-(*anatomical_grad_y_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/norm[z][y][x])/
                        (*penalty_sptr)[z][y][x]) );
               }
               else{
 
                   (*gradientx_sptr)[z][y][x+1] =
-                          (((*pet_im_grad_x_sptr)[z][y][x+1]-(*anatomical_grad_x_sptr)[z][y][x+1]*(*inner_product_sptr)[z][y][x+1]/(*get_norm_sptr ())[z][y][x+1])/
+                          (((*pet_im_grad_x_sptr)[z][y][x+1]-(*anatomical_grad_x_sptr)[z][y][x+1]*(*inner_product_sptr)[z][y][x+1]/norm[z][y][x+1])/
                           (*penalty_sptr)[z][y][x+1] -
-                          ((*pet_im_grad_x_sptr)[z][y][x]-(*anatomical_grad_x_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/(*get_norm_sptr ())[z][y][x])/
+                          ((*pet_im_grad_x_sptr)[z][y][x]-(*anatomical_grad_x_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/norm[z][y][x])/
                           (*penalty_sptr)[z][y][x]);
 
                   (*gradienty_sptr)[z][y+1][x] =
                           (((*pet_im_grad_y_sptr)[z][y+1][x]-(*anatomical_grad_y_sptr)[z][y+1][x]*(*inner_product_sptr)[z][y+1][x]/
-                          (*get_norm_sptr ())[z][y+1][x])/(*penalty_sptr)[z][y+1][x] -
+                          norm[z][y+1][x])/(*penalty_sptr)[z][y+1][x] -
                           (((*pet_im_grad_y_sptr)[z][y][x]-(*anatomical_grad_y_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/
-                            (*get_norm_sptr ())[z][y][x])/(*penalty_sptr)[z][y][x]) );
+                            norm[z][y][x])/(*penalty_sptr)[z][y][x]) );
 
                   (*gradientz_sptr)[z+1][y][x] =
                       (((*pet_im_grad_z_sptr)[z+1][y][x]-(*anatomical_grad_z_sptr)[z+1][y][x]*(*inner_product_sptr)[z+1][y][x]/
-                          (*get_norm_sptr ())[z+1][y][x])/(*penalty_sptr)[z+1][y][x] -
+                          norm[z+1][y][x])/(*penalty_sptr)[z+1][y][x] -
                           (((*pet_im_grad_z_sptr)[z][y][x]-(*anatomical_grad_z_sptr)[z][y][x]*(*inner_product_sptr)[z][y][x]/
-                            (*get_norm_sptr ())[z][y][x])/(*penalty_sptr)[z][y][x]) );
+                            norm[z][y][x])/(*penalty_sptr)[z][y][x]) );
               }
               }}}
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
   for (int z=min_z; z<=max_z; z++)
     {
 
@@ -0,0 +1,450 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup projection
+  \brief non-inline implementations for stir::PackedProjMatrixElemsForOneBin
+
+*/
+#include "stir/recon_buildblock/PackedProjMatrixElemsForOneBin.h"
+#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/DiscretisedDensity.h"
+#include "stir/Coordinate3D.h"
+#include "stir/interfile_keyword_functions.h"
+#include "stir/error.h"
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+START_NAMESPACE_STIR
+
+// local functions for conversion between float and IEEE 754 half precision floats
+namespace {
+
+inline boost::uint16_t
+float_to_half_float(const float f)
+{
+  boost::uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  const boost::uint16_t sign = static_cast<boost::uint16_t>((x >> 16) & 0x8000U);
+  boost::uint32_t mantissa = x & 0x7fffffU;
+  if ((x & 0x7fffffffU) >= 0x7f800000U)
+    {
+      // Inf or NaN
+      return static_cast<boost::uint16_t>(sign | 0x7c00U | (mantissa!=0 ? 0x200U : 0U));
+    }
+  const int exponent = static_cast<int>((x >> 23) & 0xffU) - 127 + 15;
+  if (exponent >= 31)
+    {
+      // too large, store as Inf
+      return static_cast<boost::uint16_t>(sign | 0x7c00U);
+    }
+  if (exponent <= 0)
+    {
+      // denormalised half float (or 0)
+      if (exponent < -10)
+        return sign;
+      mantissa |= 0x800000U;
+      const int shift = 14 - exponent;
+      boost::uint32_t half_mantissa = mantissa >> shift;
+      // round
+      if ((mantissa >> (shift-1)) & 1U)
+        ++half_mantissa;
+      return static_cast<boost::uint16_t>(sign | half_mantissa);
+    }
+  boost::uint32_t half =
+    sign | (static_cast<boost::uint32_t>(exponent) << 10) | (mantissa >> 13);
+  // round (note: overflow of the mantissa correctly increments the exponent)
+  if (mantissa & 0x1000U)
+    ++half;
+  return static_cast<boost::uint16_t>(half);
+}
+
+inline float
+half_float_to_float(const boost::uint16_t h)
+{
+  const boost::uint32_t sign = static_cast<boost::uint32_t>(h & 0x8000U) << 16;
+  boost::uint32_t exponent = (h >> 10) & 0x1fU;
+  boost::uint32_t mantissa = h & 0x3ffU;
+  boost::uint32_t x;
+  if (exponent == 0)
+    {
+      if (mantissa == 0)
+        x = sign;
+      else
+        {
+          // denormalised, normalise it
+          int e = 1;
+          while ((mantissa & 0x400U) == 0)
+            {
+              mantissa <<= 1;
+              --e;
+            }
+          mantissa &= 0x3ffU;
+          x = sign | (static_cast<boost::uint32_t>(e + 127 - 15) << 23) | (mantissa << 13);
+        }
+    }
+  else if (exponent == 31)
+    x = sign | 0x7f800000U | (mantissa << 13);
+  else
+    x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+// function objects to get at the values in the various formats
+
+class FloatValues
+{
+public:
+  explicit FloatValues(const float * const values) : values(values) {}
+  inline float operator()(const std::size_t i) const
+  { return values[i]; }
+private:
+  const float * values;
+};
+
+class HalfFloatValues
+{
+public:
+  explicit HalfFloatValues(const boost::uint16_t * const values) : values(values) {}
+  inline float operator()(const std::size_t i) const
+  { return half_float_to_float(values[i]); }
+private:
+  const boost::uint16_t * values;
+};
+
+class QuantisedValues
+{
+public:
+  QuantisedValues(const boost::uint16_t * const values, const float scale)
+    : values(values), scale(scale) {}
+  inline float operator()(const std::size_t i) const
+  { return static_cast<boost::int16_t>(values[i]) * scale; }
+private:
+  const boost::uint16_t * values;
+  float scale;
+};
+
+} // end of anonymous namespace
+
+PackedProjMatrixElemsForOneBin::ValueFormat
+PackedProjMatrixElemsForOneBin::
+value_format_from_string(const std::string& str)
+{
+  const std::string format = standardise_interfile_keyword(str);
+  if (format == "float")
+    return float_values;
+  if (format == "half float")
+    return half_float_values;
+  if (format == "quantised")
+    return quantised_values;
+  error(boost::format("PackedProjMatrixElemsForOneBin: unknown value format \"%1%\". "
+                      "Use one of \"float\", \"half float\" or \"quantised\"") % str);
+  return float_values; // avoid compiler warning
+}
+
+PackedProjMatrixElemsForOneBin::
+PackedProjMatrixElemsForOneBin()
+  : value_format(float_values), scale(1.F)
+{}
+
+PackedProjMatrixElemsForOneBin::
+PackedProjMatrixElemsForOneBin(const ProjMatrixElemsForOneBin& elems,
+                               const ValueFormat value_format)
+{
+  this->pack(elems, value_format);
+}
+
+void
+PackedProjMatrixElemsForOneBin::
+pack(const ProjMatrixElemsForOneBin& elems,
+     const ValueFormat value_format_v)
+{
+  typedef ProjMatrixElemsForOneBin::value_type value_type;
+
+  this->bin = elems.get_bin();
+  this->value_format = value_format_v;
+  this->scale = 1.F;
+  this->runs.clear();
+  this->c3_offsets.clear();
+  this->float_values_storage.clear();
+  this->packed_values_storage.clear();
+
+  // we need the elements sorted. They normally are, so check first to avoid a copy.
+  std::vector<value_type> sorted_elems;
+  const value_type * elems_begin = elems.size()==0 ? 0 : &*elems.begin();
+  const value_type * elems_end = elems_begin + elems.size();
+  for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+    {
+      if (iter != elems_begin && !value_type::coordinates_less(*(iter-1), *iter))
+        {
+          sorted_elems.assign(elems_begin, elems_end);
+          std::sort(sorted_elems.begin(), sorted_elems.end(), value_type::coordinates_less);
+          elems_begin = &sorted_elems[0];
+          elems_end = elems_begin + sorted_elems.size();
+          break;
+        }
+    }
+
+  const std::size_t num_elems = static_cast<std::size_t>(elems_end - elems_begin);
+  this->c3_offsets.reserve(num_elems);
+
+  // find the runs
+  for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+    {
+      const int c1 = iter->coord1();
+      const int c2 = iter->coord2();
+      const int c3 = iter->coord3();
+      if (this->runs.empty() ||
+          this->runs.back().c1 != c1 ||
+          this->runs.back().c2 != c2 ||
+          c3 - this->runs.back().c3 > 0xffff ||
+          this->runs.back().length == 0xffff)
+        {
+          Run run;
+          run.c1 = static_cast<short>(c1);
+          run.c2 = static_cast<short>(c2);
+          run.c3 = static_cast<short>(c3);
+          run.length = 0;
+          this->runs.push_back(run);
+        }
+      ++this->runs.back().length;
+      this->c3_offsets.push_back(static_cast<boost::uint16_t>(c3 - this->runs.back().c3));
+    }
+  // avoid wasting memory
+  std::vector<Run>(this->runs).swap(this->runs);
+
+  // store values
+  switch (this->value_format)
+    {
+    case float_values:
+      {
+        this->float_values_storage.reserve(num_elems);
+        for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+          this->float_values_storage.push_back(iter->get_value());
+        break;
+      }
+    case half_float_values:
+      {
+        this->packed_values_storage.reserve(num_elems);
+        for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+          this->packed_values_storage.push_back(float_to_half_float(iter->get_value()));
+        break;
+      }
+    case quantised_values:
+      {
+        float max_abs_value = 0.F;
+        for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+          max_abs_value = std::max(max_abs_value, std::fabs(iter->get_value()));
+        this->scale = max_abs_value > 0 ? max_abs_value/32767.F : 1.F;
+        this->packed_values_storage.reserve(num_elems);
+        for (const value_type * iter = elems_begin; iter != elems_end; ++iter)
+          {
+            const boost::int16_t quantised_value =
+              static_cast<boost::int16_t>(floor(iter->get_value()/this->scale + .5F));
+            this->packed_values_storage.push_back(static_cast<boost::uint16_t>(quantised_value));
+          }
+        break;
+      }
+    }
+}
+
+void
+PackedProjMatrixElemsForOneBin::
+unpack(ProjMatrixElemsForOneBin& elems) const
+{
+  elems.erase();
+  elems.set_bin(this->bin);
+  elems.reserve(this->size());
+
+  const FloatValues float_values_func(this->float_values_storage.empty() ? 0 : &this->float_values_storage[0]);
+  const HalfFloatValues half_float_values_func(this->packed_values_storage.empty() ? 0 : &this->packed_values_storage[0]);
+  const QuantisedValues quantised_values_func(this->packed_values_storage.empty() ? 0 : &this->packed_values_storage[0],
+                                              this->scale);
+  std::size_t elem_num = 0;
+  for (std::vector<Run>::const_iterator run_iter = this->runs.begin();
+       run_iter != this->runs.end();
+       ++run_iter)
+    {
+      for (int i=0; i<run_iter->length; ++i, ++elem_num)
+        {
+          const Coordinate3D<int> coords(run_iter->c1, run_iter->c2, run_iter->c3 + this->c3_offsets[elem_num]);
+          float value = 0.F;
+          switch (this->value_format)
+            {
+            case float_values: value = float_values_func(elem_num); break;
+            case half_float_values: value = half_float_values_func(elem_num); break;
+            case quantised_values: value = quantised_values_func(elem_num); break;
+            }
+          elems.push_back(ProjMatrixElemsForOneBin::value_type(coords, value));
+        }
+    }
+}
+
+std::size_t
+PackedProjMatrixElemsForOneBin::
+size_in_bytes() const
+{
+  return
+    sizeof(*this) +
+    this->runs.capacity()*sizeof(Run) +
+    this->c3_offsets.capacity()*sizeof(boost::uint16_t) +
+    this->float_values_storage.capacity()*sizeof(float) +
+    this->packed_values_storage.capacity()*sizeof(boost::uint16_t);
+}
+
+/* The projection functions loop over all runs and are templated in terms of
+   the function object that gets the values, such that the value format
+   is only checked once per row.
+*/
+template <class ValuesT>
+float
+PackedProjMatrixElemsForOneBin::
+forward_project_runs(const DiscretisedDensity<3,float>& density,
+                     const ValuesT& values) const
+{
+  const int min_c1 = density.get_min_index();
+  const int max_c1 = density.get_max_index();
+  float sum = 0.F;
+  std::size_t elem_num = 0;
+  for (std::vector<Run>::const_iterator run_iter = this->runs.begin();
+       run_iter != this->runs.end();
+       ++run_iter)
+    {
+      const int length = run_iter->length;
+      if (run_iter->c1 < min_c1 || run_iter->c1 > max_c1)
+        {
+          elem_num += length;
+          continue;
+        }
+      const Array<1,float>& line = density[run_iter->c1][run_iter->c2];
+      const int c3 = run_iter->c3;
+      for (int i=0; i<length; ++i, ++elem_num)
+        sum += line[c3 + this->c3_offsets[elem_num]] * values(elem_num);
+    }
+  return sum;
+}
+
+template <bool atomically, class ValuesT>
+void
+PackedProjMatrixElemsForOneBin::
+back_project_runs(DiscretisedDensity<3,float>& density,
+                  const float data,
+                  const ValuesT& values) const
+{
+  const int min_c1 = density.get_min_index();
+  const int max_c1 = density.get_max_index();
+  std::size_t elem_num = 0;
+  for (std::vector<Run>::const_iterator run_iter = this->runs.begin();
+       run_iter != this->runs.end();
+       ++run_iter)
+    {
+      const int length = run_iter->length;
+      if (run_iter->c1 < min_c1 || run_iter->c1 > max_c1)
+        {
+          elem_num += length;
+          continue;
+        }
+      Array<1,float>& line = density[run_iter->c1][run_iter->c2];
+      const int c3 = run_iter->c3;
+      if (atomically)
+        {
+          for (int i=0; i<length; ++i, ++elem_num)
+            {
+              float& voxel = line[c3 + this->c3_offsets[elem_num]];
+              const float value = values(elem_num) * data;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+              voxel += value;
+            }
+        }
+      else
+        {
+          for (int i=0; i<length; ++i, ++elem_num)
+            line[c3 + this->c3_offsets[elem_num]] += values(elem_num) * data;
+        }
+    }
+}
+
+void
+PackedProjMatrixElemsForOneBin::
+forward_project(Bin& single,
+                const DiscretisedDensity<3,float>& density) const
+{
+  if (this->runs.empty())
+    return;
+  switch (this->value_format)
+    {
+    case float_values:
+      single += forward_project_runs(density, FloatValues(&this->float_values_storage[0]));
+      break;
+    case half_float_values:
+      single += forward_project_runs(density, HalfFloatValues(&this->packed_values_storage[0]));
+      break;
+    case quantised_values:
+      single += forward_project_runs(density, QuantisedValues(&this->packed_values_storage[0], this->scale));
+      break;
+    }
+}
+
+template <bool atomically>
+void
+PackedProjMatrixElemsForOneBin::
+back_project_bin(DiscretisedDensity<3,float>& density,
+                 const Bin& single) const
+{
+  const float data = single.get_bin_value();
+  if (data == 0 || this->runs.empty())
+    return;
+  switch (this->value_format)
+    {
+    case float_values:
+      back_project_runs<atomically>(density, data, FloatValues(&this->float_values_storage[0]));
+      break;
+    case half_float_values:
+      back_project_runs<atomically>(density, data, HalfFloatValues(&this->packed_values_storage[0]));
+      break;
+    case quantised_values:
+      back_project_runs<atomically>(density, data, QuantisedValues(&this->packed_values_storage[0], this->scale));
+      break;
+    }
+}
+
+void
+PackedProjMatrixElemsForOneBin::
+back_project(DiscretisedDensity<3,float>& density,
+             const Bin& single) const
+{
+  back_project_bin<false>(density, single);
+}
+
+void
+PackedProjMatrixElemsForOneBin::
+back_project_atomically(DiscretisedDensity<3,float>& density,
+                        const Bin& single) const
+{
+  back_project_bin<true>(density, single);
+}
+
+END_NAMESPACE_STIR
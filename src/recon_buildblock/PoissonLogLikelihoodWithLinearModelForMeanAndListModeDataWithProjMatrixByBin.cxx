@@ -1,6 +1,6 @@
 /*
     Copyright (C) 2003- 2011, Hammersmith Imanet Ltd
-    Copyright (C) 2014, University College London
+    Copyright (C) 2014, 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -28,12 +28,20 @@
 #include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h" 
 #include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
 #include "stir/recon_buildblock/ProjectorByBinPairUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/BinNormalisation.h"
 #include "stir/ProjDataInfoCylindricalNoArcCorr.h"
 #include "stir/ProjData.h"
 #include "stir/listmode/CListRecord.h"
 #include "stir/Viewgram.h"
 #include "stir/info.h"
+#include "stir/warning.h"
+#include "stir/Bin.h"
+#include "stir/Succeeded.h"
+#include "stir/is_null_ptr.h"
 #include <boost/format.hpp>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #ifdef STIR_MPI
 #include "stir/recon_buildblock/distributed_functions.h"
@@ -63,7 +71,11 @@ set_defaults()
 { 
   base_type::set_defaults();
   this->additive_proj_data_sptr.reset();
+  this->additive_segment_sptrs.recycle();
   this->additive_projection_data_filename ="0"; 
+  this->num_events_per_batch = 100000;
+  this->has_frame_start_position = false;
+  this->frame_num_for_start_position = -1;
   this->max_ring_difference_num_to_process =-1;
   this->PM_sptr.reset(new  ProjMatrixByBinUsingRayTracing()); 
 } 
@@ -79,6 +91,7 @@ initialise_keymap()
   this->parser.add_key("max ring difference num to process", &this->max_ring_difference_num_to_process);
   this->parser.add_parsing_key("Matrix type", &this->PM_sptr); 
   this->parser.add_key("additive sinogram",&this->additive_projection_data_filename); 
+  this->parser.add_key("num events per batch", &this->num_events_per_batch);
  
    
 } 
@@ -87,9 +100,8 @@ int
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>::
 set_num_subsets(const int new_num_subsets)
 {
-  if (new_num_subsets!=1)
-    warning("PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin currently only supports 1 subset");
-  this->num_subsets = 1;
+  // subsets are formed by event index, so any number of subsets is fine
+  this->num_subsets = new_num_subsets;
   return this->num_subsets;
 }
 
@@ -101,6 +113,16 @@ actual_subsets_are_approximately_balanced(std::string&) const
   return true; 
 }
 
+template<typename TargetT>
+std::string
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>::
+get_computation_statistics_report() const
+{
+  if (is_null_ptr(this->PM_sptr))
+    return std::string();
+  return this->PM_sptr->get_cache_statistics();
+}
+
 template <typename TargetT>  
 Succeeded 
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>::
@@ -114,6 +136,39 @@ set_up_before_sensitivity(shared_ptr <TargetT > const& target_sptr)
  
   // set projector to be used for the calculations    
   this->PM_sptr->set_up(this->proj_data_info_cyl_uncompressed_ptr->create_shared_clone(),target_sptr); 
+
+  if (!is_null_ptr(this->normalisation_sptr) &&
+      this->normalisation_sptr->set_up(this->proj_data_info_cyl_uncompressed_ptr->create_shared_clone()) != Succeeded::yes)
+    {
+      warning("PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin: set-up of normalisation failed");
+      return Succeeded::no;
+    }
+  this->total_sensitivity_sptr.reset();
+  this->has_frame_start_position = false;
+
+  // read additive term in memory such that we can look it up quickly for every event
+  this->additive_segment_sptrs.recycle();
+  if (!is_null_ptr(this->additive_proj_data_sptr))
+    {
+      // the additive term is looked up with the bin of the event in the uncompressed data
+      if (!(*this->additive_proj_data_sptr->get_proj_data_info_ptr() >= *this->proj_data_info_cyl_uncompressed_ptr))
+        {
+          warning(boost::format("PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin: "
+                                "additive sinogram has to be uncompressed (span 1, no mashing) and contain all "
+                                "segments up to the max ring difference to process (%1%).\n"
+                                "Additive sinogram info:\n%2%")
+                  % this->max_ring_difference_num_to_process
+                  % this->additive_proj_data_sptr->get_proj_data_info_ptr()->parameter_info());
+          return Succeeded::no;
+        }
+      this->additive_segment_sptrs.grow(this->additive_proj_data_sptr->get_min_segment_num(),
+                                        this->additive_proj_data_sptr->get_max_segment_num());
+      for (int segment_num = this->additive_proj_data_sptr->get_min_segment_num();
+           segment_num <= this->additive_proj_data_sptr->get_max_segment_num();
+           ++segment_num)
+        this->additive_segment_sptrs[segment_num].
+          reset(new SegmentBySinogram<float>(this->additive_proj_data_sptr->get_segment_by_sinogram(segment_num)));
+    }
   return Succeeded::yes;
 } 
  
@@ -144,6 +199,9 @@ PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<Tar
 #endif
   shared_ptr<Scanner> scanner_sptr(new Scanner(*this->list_mode_data_sptr->get_scanner_ptr()));
 
+  if (this->num_events_per_batch <= 0)
+    { warning("num events per batch should be positive"); return true; }
+
   if (this->max_ring_difference_num_to_process == -1)
     {
       this->max_ring_difference_num_to_process = 
@@ -155,9 +213,9 @@ PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<Tar
     { 
       info(boost::format("Reading additive projdata data '%1%'")
            % additive_projection_data_filename  );
-      shared_ptr <ProjData> temp_additive_proj_data_sptr =  
+      // note: data will be read in memory by set_up_before_sensitivity()
+      this->additive_proj_data_sptr =
         ProjData::read_from_file(this->additive_projection_data_filename); 
-      this->additive_proj_data_sptr.reset(new ProjDataInMemory(* temp_additive_proj_data_sptr));
     } 
   
 
@@ -200,58 +258,213 @@ compute_sub_gradient_without_penalty_plus_sensitivity(TargetT& gradient,
                                          const TargetT &current_estimate,  
                                          const int subset_num) 
 { 
+  assert(subset_num>=0);
+  assert(subset_num<this->num_subsets);
 
   const double start_time = this->frame_defs.get_start_time(this->current_frame_num);
   const double end_time = this->frame_defs.get_end_time(this->current_frame_num);
-  //go to the beginning of this frame
-  //  list_mode_data_sptr->set_get_position(start_time);
-  // TODO implement function that will do this for a random time
-  this->list_mode_data_sptr->reset();
+  // go to the beginning of this frame
+  // Every subset needs all events in the frame (see the class documentation), but we
+  // only need to skip the events before the frame once. We therefore store the position
+  // of the last block of records that starts before the frame, and go there for the
+  // next subsets.
   double current_time = 0.;
-  ProjMatrixElemsForOneBin proj_matrix_row; 
-  shared_ptr<CListRecord> record_sptr = this->list_mode_data_sptr->get_empty_record_sptr(); 
-  CListRecord& record = *record_sptr; 
-  //  int count_of_events=0;
-  //int in_the_range =0;
-  while (this->list_mode_data_sptr->get_next_record(record) == Succeeded::yes) 
-  { 
-    //count_of_events++;
-    if(record.is_time())
-      {
-        current_time = record.time().get_time_in_secs();
-      }
-    if (current_time >= end_time)
+  const bool use_frame_start_position =
+    this->has_frame_start_position &&
+    this->frame_num_for_start_position == this->current_frame_num &&
+    this->list_mode_data_sptr->set_get_position(this->frame_start_position) == Succeeded::yes;
+  if (use_frame_start_position)
+    current_time = this->time_at_frame_start_position;
+  else
+    {
+      this->list_mode_data_sptr->reset();
+      this->has_frame_start_position = false;
+    }
+  // records are read in blocks to avoid overhead per record
+  std::vector<shared_ptr<CListRecord> > records(1000);
+  std::size_t num_records_in_block = 0;
+  std::size_t record_num_in_block = 0;
+
+  // index of the current prompt in this frame (used for subsets)
+  unsigned long event_num = 0;
+  std::vector<Bin> measured_bins;
+  measured_bins.reserve(this->num_events_per_batch);
+
+#ifdef STIR_OPENMP
+  std::vector< shared_ptr<TargetT> > local_gradient_sptrs(omp_get_max_threads());
+#endif
+
+  bool more_events = true;
+  while (more_events)
+  {
+    // read a batch of events (this cannot be done in parallel)
+    measured_bins.resize(0);
+    while (static_cast<int>(measured_bins.size()) < this->num_events_per_batch)
       {
-        break; // get out of while loop
-      }
-    if (current_time < start_time)
-      continue;
-    if (record.is_event() && record.event().is_prompt()) 
-      { 
-        Bin measured_bin; 
-        record.event().get_bin(measured_bin, *proj_data_info_cyl_uncompressed_ptr); 
-        if (measured_bin.get_bin_value() <= 0)
-          continue;      
-        this->PM_sptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, measured_bin); 
-        //in_the_range++;
-        Bin fwd_bin; 
-        proj_matrix_row.forward_project(fwd_bin,current_estimate); 
-        // additive sinogram 
-        if (!is_null_ptr(this->additive_proj_data_sptr))
+        if (record_num_in_block == num_records_in_block)
+          {
+            if (!use_frame_start_position && current_time < start_time)
+              {
+                // this block might contain the start of the frame, so remember where it is
+                // (reusing the slot in the list mode data if possible)
+                if (!this->has_frame_start_position ||
+                    this->list_mode_data_sptr->update_saved_get_position(this->frame_start_position) == Succeeded::no)
+                  {
+                    this->frame_start_position = this->list_mode_data_sptr->save_get_position();
+                    this->has_frame_start_position = true;
+                  }
+                this->time_at_frame_start_position = current_time;
+                this->frame_num_for_start_position = this->current_frame_num;
+              }
+            num_records_in_block = this->list_mode_data_sptr->get_next_records(records);
+            record_num_in_block = 0;
+            if (num_records_in_block == 0)
+              {
+                more_events = false;
+                break;
+              }
+          }
+        const CListRecord& record = *records[record_num_in_block++];
+        if(record.is_time())
           {
-            float add_value = this->additive_proj_data_sptr->get_bin_value(measured_bin);
-            float value= fwd_bin.get_bin_value()+add_value;         
-            fwd_bin.set_bin_value(value);
+            current_time = record.time().get_time_in_secs();
           }
-        float  measured_div_fwd = measured_bin.get_bin_value()/fwd_bin.get_bin_value();
-        measured_bin.set_bin_value(measured_div_fwd);
-        proj_matrix_row.back_project(gradient, measured_bin); 
-         
-      } 
+        if (current_time >= end_time)
+          {
+            more_events = false;
+            break;
+          }
+        if (current_time < start_time)
+          continue;
+        if (record.is_event() && record.event().is_prompt()) 
+          { 
+            if (static_cast<int>(event_num++ % this->num_subsets) != subset_num)
+              continue;
+            Bin measured_bin; 
+            record.event().get_bin(measured_bin, *proj_data_info_cyl_uncompressed_ptr); 
+            if (measured_bin.get_bin_value() <= 0)
+              continue;      
+            measured_bins.push_back(measured_bin);
+          }
+      }
+
+    // now process the batch
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_gradient_sptrs, measured_bins, current_estimate)
+#endif
+    {
+      ProjMatrixElemsForOneBin proj_matrix_row; 
+#ifdef STIR_OPENMP
+      const int thread_num=omp_get_thread_num();
+      if(is_null_ptr(local_gradient_sptrs[thread_num]))
+        local_gradient_sptrs[thread_num].reset(gradient.get_empty_copy());
+      TargetT& local_gradient = *local_gradient_sptrs[thread_num];
+#pragma omp for schedule(dynamic, 1000)
+#else
+      TargetT& local_gradient = gradient;
+#endif
+      // note: older versions of openmp need an int as loop
+      for (int i=0; i<static_cast<int>(measured_bins.size()); ++i)
+        {
+          Bin measured_bin = measured_bins[i];
+          this->PM_sptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, measured_bin); 
+          Bin fwd_bin; 
+          fwd_bin.set_bin_value(0);
+          proj_matrix_row.forward_project(fwd_bin,current_estimate); 
+          // additive sinogram 
+          // (set_up_before_sensitivity() checked that it contains all bins)
+          if (this->additive_segment_sptrs.size() != 0)
+            {
+              const float add_value =
+                (*this->additive_segment_sptrs[measured_bin.segment_num()])
+                [measured_bin.axial_pos_num()][measured_bin.view_num()][measured_bin.tangential_pos_num()];
+              fwd_bin.set_bin_value(fwd_bin.get_bin_value()+add_value);
+            }
+          const float measured_div_fwd = measured_bin.get_bin_value()/fwd_bin.get_bin_value();
+          measured_bin.set_bin_value(measured_div_fwd);
+          proj_matrix_row.back_project(local_gradient, measured_bin); 
+        }
+    }
   }
-  //  cerr << " The number_of_events " << count_of_events << "   ";
-  //cerr << " The number of events proecessed "  << in_the_range << "  ";
-    
+#ifdef STIR_OPENMP
+  // "reduce" data constructed by threads
+  for (int i=0; i<static_cast<int>(local_gradient_sptrs.size()); ++i)
+    if(!is_null_ptr(local_gradient_sptrs[i])) // only accumulate if a thread filled something in
+      gradient += *(local_gradient_sptrs[i]);
+#endif
+}
+
+template <typename TargetT> 
+void 
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+add_subset_sensitivity(TargetT& sensitivity, const int subset_num) const
+{
+  if (is_null_ptr(this->total_sensitivity_sptr))
+    {
+      this->total_sensitivity_sptr.reset(sensitivity.get_empty_copy());
+      TargetT& total_sensitivity = *this->total_sensitivity_sptr;
+
+      const double start_time = this->frame_defs.get_start_time(this->current_frame_num);
+      const double end_time = this->frame_defs.get_end_time(this->current_frame_num);
+      const ProjDataInfo& proj_data_info = *this->proj_data_info_cyl_uncompressed_ptr;
+
+#ifdef STIR_OPENMP
+      std::vector< shared_ptr<TargetT> > local_sensitivity_sptrs(omp_get_max_threads());
+#endif
+      for (int segment_num = proj_data_info.get_min_segment_num();
+           segment_num <= proj_data_info.get_max_segment_num();
+           ++segment_num)
+        {
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_sensitivity_sptrs)
+#endif
+          {
+            ProjMatrixElemsForOneBin proj_matrix_row;
+#ifdef STIR_OPENMP
+            const int thread_num=omp_get_thread_num();
+            if(is_null_ptr(local_sensitivity_sptrs[thread_num]))
+              local_sensitivity_sptrs[thread_num].reset(total_sensitivity.get_empty_copy());
+            TargetT& local_sensitivity = *local_sensitivity_sptrs[thread_num];
+#pragma omp for schedule(dynamic)
+#else
+            TargetT& local_sensitivity = total_sensitivity;
+#endif
+            for (int view_num = proj_data_info.get_min_view_num();
+                 view_num <= proj_data_info.get_max_view_num();
+                 ++view_num)
+              for (int axial_pos_num = proj_data_info.get_min_axial_pos_num(segment_num);
+                   axial_pos_num <= proj_data_info.get_max_axial_pos_num(segment_num);
+                   ++axial_pos_num)
+                for (int tangential_pos_num = proj_data_info.get_min_tangential_pos_num();
+                     tangential_pos_num <= proj_data_info.get_max_tangential_pos_num();
+                     ++tangential_pos_num)
+                  {
+                    Bin bin(segment_num, view_num, axial_pos_num, tangential_pos_num);
+                    bin.set_bin_value(is_null_ptr(this->normalisation_sptr) 
+                                      ? 1.F
+                                      : this->normalisation_sptr->get_bin_efficiency(bin, start_time, end_time));
+                    if (bin.get_bin_value() == 0)
+                      continue;
+                    this->PM_sptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, bin);
+                    proj_matrix_row.back_project(local_sensitivity, bin);
+                  }
+          }
+        }
+#ifdef STIR_OPENMP
+      // "reduce" data constructed by threads
+      for (int i=0; i<static_cast<int>(local_sensitivity_sptrs.size()); ++i)
+        if(!is_null_ptr(local_sensitivity_sptrs[i])) // only accumulate if a thread filled something in
+          total_sensitivity += *(local_sensitivity_sptrs[i]);
+#endif
+    }
+
+  typename TargetT::full_iterator sens_iter = sensitivity.begin_all();
+  typename TargetT::const_full_iterator total_sens_iter = this->total_sensitivity_sptr->begin_all_const();
+  while (sens_iter != sensitivity.end_all())
+    {
+      *sens_iter += *total_sens_iter / this->num_subsets;
+      ++sens_iter; ++total_sens_iter;
+    }
 }
 
 #  ifdef _MSC_VER
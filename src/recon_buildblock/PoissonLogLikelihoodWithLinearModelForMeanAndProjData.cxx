@@ -53,6 +53,8 @@
 #include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
 #endif
 #include "stir/recon_buildblock/ProjectorByBinPairUsingSeparateProjectors.h"
+// for get_computation_statistics_report()
+#include "stir/recon_buildblock/BackProjectorByBinUsingProjMatrixByBin.h"
 
 #include "stir/ProjDataInMemory.h"
 
@@ -492,6 +494,20 @@ set_input_data(const shared_ptr<ExamData> & arg)
     this->proj_data_sptr = dynamic_pointer_cast<ProjData>(arg);
 }
 
+template<typename TargetT>
+std::string
+PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>::
+get_computation_statistics_report() const
+{
+  if (is_null_ptr(this->projector_pair_ptr))
+    return std::string();
+  BackProjectorByBinUsingProjMatrixByBin * const back_projector_ptr =
+    dynamic_cast<BackProjectorByBinUsingProjMatrixByBin *>(this->projector_pair_ptr->get_back_projector_sptr().get());
+  if (back_projector_ptr == 0 || is_null_ptr(back_projector_ptr->get_proj_matrix_sptr()))
+    return std::string();
+  return back_projector_ptr->get_proj_matrix_sptr()->get_cache_statistics();
+}
+
 /***************************************************************
   subset balancing
  ***************************************************************/
@@ -628,6 +644,11 @@ set_up_before_sensitivity(shared_ptr<TargetT > const& target_sptr)
       return Succeeded::no;
     }
 
+  // compute (time-dependent) normalisation factors once, outside of any parallel loop
+  this->normalisation_sptr->
+    precompute_for_time_frame(this->frame_defs.get_start_time(this->frame_num),
+                              this->frame_defs.get_end_time(this->frame_num));
+
   return Succeeded::yes;
 }
 
@@ -12,7 +12,7 @@
 /*
     Copyright (C) 2000 PARAPET partners
     Copyright (C) 2000-2009, Hammersmith Imanet Ltd
-    Copyright (C) 2013, 2015 University College London
+    Copyright (C) 2013, 2015, 2026 University College London
 
     This file is part of STIR.
 
@@ -32,6 +32,10 @@
 
 #include "stir/recon_buildblock/ProjMatrixByBin.h"
 #include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/Succeeded.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
+#include <algorithm>
 
 // define a local preprocessor symbol to keep code relatively clean
 #ifdef STIR_NO_MUTABLE
@@ -42,10 +46,40 @@
 
 START_NAMESPACE_STIR
 
+//! estimate of the memory used by a row in the cache (including shared_ptr overhead)
+static std::size_t
+size_in_bytes(const PackedProjMatrixElemsForOneBin& elems)
+{
+  return elems.size_in_bytes() + 4*sizeof(void *);
+}
+
+static std::size_t
+size_in_bytes(const ProjMatrixElemsForOneBin& elems)
+{
+  return elems.capacity()*sizeof(ProjMatrixElemsForOneBin::value_type) +
+    sizeof(ProjMatrixElemsForOneBin) + 4*sizeof(void *);
+}
+
+//! store \a elems_sptr in \a *slot_elems_sptr_ptr if it is empty. Returns \c false if it was not.
+template <class elemsT>
+static bool
+store_if_empty(shared_ptr<elemsT>* slot_elems_sptr_ptr,
+               const shared_ptr<elemsT>& elems_sptr)
+{
+  shared_ptr<elemsT> expected;
+#if defined(STIR_USE_BOOST_SHARED_PTR)
+  return atomic_compare_exchange(slot_elems_sptr_ptr, &expected, elems_sptr);
+#else
+  return std::atomic_compare_exchange_strong(slot_elems_sptr_ptr, &expected, elems_sptr);
+#endif
+}
+
 void ProjMatrixByBin::set_defaults()
 {
   cache_disabled=false;
   cache_stores_only_basic_bins=true;
+  cache_max_size_in_MB=0;
+  cache_value_format_string="float";
 }
 
 void 
@@ -53,15 +87,34 @@ ProjMatrixByBin::initialise_keymap()
 {
   parser.add_key("disable caching", &cache_disabled);
   parser.add_key("store_only_basic_bins_in_cache", &cache_stores_only_basic_bins);
+  parser.add_key("maximum cache size in MB", &cache_max_size_in_MB);
+  parser.add_key("cache value format", &cache_value_format_string);
 }
 
 bool
 ProjMatrixByBin::post_processing()
 {
+  if (cache_max_size_in_MB<0)
+    {
+      warning("ProjMatrixByBin: maximum cache size in MB should be non-negative");
+      return true;
+    }
+  this->set_maximum_cache_size(static_cast<std::size_t>(cache_max_size_in_MB)*1024*1024);
+  this->set_cache_value_format(PackedProjMatrixElemsForOneBin::value_format_from_string(cache_value_format_string));
   return false;
 }
 
+ProjMatrixByBin::CacheShard::CacheShard()
+  : min_axial_pos_num(0), max_axial_pos_num(-1),
+    min_tangential_pos_num(0), max_tangential_pos_num(-1),
+    allocated(false),
+    num_hits(0), num_misses(0)
+{}
+
 ProjMatrixByBin::ProjMatrixByBin()
+  : cache_max_size(0), cache_value_format(PackedProjMatrixElemsForOneBin::float_values),
+    cache_size(0), num_cache_evictions(0),
+    clock_view_num(0), clock_segment_num(0), clock_slot_num(0)
 { 
   set_defaults();
 }
@@ -74,7 +127,13 @@ enable_cache(const bool v)
 void 
 ProjMatrixByBin::
 store_only_basic_bins_in_cache(const bool v) 
-{ cache_stores_only_basic_bins=v;}
+{
+  if (v == this->cache_stores_only_basic_bins)
+    return;
+  // rows might be stored in a different format
+  this->clear_cache();
+  this->cache_stores_only_basic_bins=v;
+}
 
 bool 
 ProjMatrixByBin::
@@ -86,6 +145,31 @@ ProjMatrixByBin::
 does_cache_store_only_basic_bins() const
 { return cache_stores_only_basic_bins; }
 
+void
+ProjMatrixByBin::
+set_maximum_cache_size(const std::size_t size_in_bytes)
+{ cache_max_size = size_in_bytes; }
+
+std::size_t
+ProjMatrixByBin::
+get_maximum_cache_size() const
+{ return cache_max_size; }
+
+void
+ProjMatrixByBin::
+set_cache_value_format(const PackedProjMatrixElemsForOneBin::ValueFormat value_format)
+{
+  if (value_format == this->cache_value_format)
+    return;
+  this->clear_cache();
+  this->cache_value_format = value_format;
+}
+
+PackedProjMatrixElemsForOneBin::ValueFormat
+ProjMatrixByBin::
+get_cache_value_format() const
+{ return cache_value_format; }
+
 void 
 ProjMatrixByBin::
 clear_cache() STIR_MUTABLE_CONST
@@ -93,29 +177,31 @@ clear_cache() STIR_MUTABLE_CONST
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJMATRIXBYBINCLEARCACHE)
 #endif
-  for (int i=this->cache_collection.get_min_index();
-       i<=this->cache_collection.get_max_index();
-       ++i)
-    {
-      for (int j=this->cache_collection[i].get_min_index();
-           j<=this->cache_collection[i].get_max_index();
-           ++j)
-        {
-          this->cache_collection[i][j].clear();
-        }
-    }
-}
-
-/*
-void  
-ProjMatrixByBin::
-reserve_num_elements_in_cache(const std::size_t num_elems)
-{
-  if ( cache_disabled ) return;
-  //cache_collection.reserve(num_elems);
-  cache_collection.rehash(ceil(num_elems / cache_collection.max_load_factor()));
+  {
+    for (int i=this->cache_collection.get_min_index();
+         i<=this->cache_collection.get_max_index();
+         ++i)
+      {
+        for (int j=this->cache_collection[i].get_min_index();
+             j<=this->cache_collection[i].get_max_index();
+             ++j)
+          {
+            CacheShard& shard = this->cache_collection[i][j];
+            // we keep the (empty) slots, but release all rows
+            for (std::vector<CacheSlot>::iterator iter = shard.slots.begin();
+                 iter != shard.slots.end();
+                 ++iter)
+              {
+                this->add_to_cache_size(-static_cast<long>(this->release_cache_slot(*iter)));
+                iter->recently_used = 0;
+              }
+            shard.num_hits = 0;
+            shard.num_misses = 0;
+          }
+      }
+    this->num_cache_evictions = 0;
+  }
 }
-*/
 
 void
 ProjMatrixByBin::
@@ -131,40 +217,189 @@ set_up(
 
   this->cache_collection.recycle();
   this->cache_collection.resize(min_view_num, max_view_num);
-#ifdef STIR_OPENMP
-  this->cache_locks.recycle();
-  this->cache_locks.resize(min_view_num, max_view_num);
-#endif
+  this->cache_size = 0;
+  this->num_cache_evictions = 0;
+  this->clock_view_num = min_view_num;
+  this->clock_segment_num = min_segment_num;
+  this->clock_slot_num = 0;
 
   for (int view_num=min_view_num; view_num<=max_view_num; ++view_num)
     {
       this->cache_collection[view_num].resize(min_segment_num, max_segment_num);
-#ifdef STIR_OPENMP
-      this->cache_locks[view_num].resize(min_segment_num, max_segment_num);
       for (int seg_num = min_segment_num; seg_num <=max_segment_num; ++seg_num)
-        omp_init_lock(&this->cache_locks[view_num][seg_num]);
+        {
+          CacheShard& shard = this->cache_collection[view_num][seg_num];
+          shard.min_axial_pos_num = proj_data_info_sptr->get_min_axial_pos_num(seg_num);
+          shard.max_axial_pos_num = proj_data_info_sptr->get_max_axial_pos_num(seg_num);
+          shard.min_tangential_pos_num = proj_data_info_sptr->get_min_tangential_pos_num();
+          shard.max_tangential_pos_num = proj_data_info_sptr->get_max_tangential_pos_num();
+        }
+    }
+}
+
+void
+ProjMatrixByBin::
+add_to_cache_size(const long num_bytes) const
+{
+  const std::size_t abs_num_bytes = static_cast<std::size_t>(num_bytes>=0 ? num_bytes : -num_bytes);
+  if (num_bytes>=0)
+    {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+      this->cache_size += abs_num_bytes;
+    }
+  else
+    {
+#ifdef STIR_OPENMP
+#pragma omp atomic
 #endif
+      this->cache_size -= abs_num_bytes;
     }
 }
 
+ProjMatrixByBin::CacheShard*
+ProjMatrixByBin::
+get_cache_shard(const Bin& bin) const
+{
+  if (bin.view_num() < this->cache_collection.get_min_index() ||
+      bin.view_num() > this->cache_collection.get_max_index())
+    return 0;
+  VectorWithOffset<CacheShard>& shards_for_view = this->cache_collection[bin.view_num()];
+  if (bin.segment_num() < shards_for_view.get_min_index() ||
+      bin.segment_num() > shards_for_view.get_max_index())
+    return 0;
+  return &shards_for_view[bin.segment_num()];
+}
 
-/*!
-    \warning Preconditions
-    <li>abs(axial_pos_num) fits in 17 bits
-    <li>abs(tangential_pos_num) fits in 11 bits   
-  */
-ProjMatrixByBin::CacheKey
-ProjMatrixByBin::cache_key(const Bin& bin) const
+ProjMatrixByBin::CacheSlot*
+ProjMatrixByBin::
+get_cache_slot(CacheShard& shard, const Bin& bin, const bool allocate) const
 {
-  assert(static_cast<boost::uint32_t>(abs(bin.axial_pos_num())) < (static_cast<boost::uint32_t>(1)<<18));
-  assert(abs(bin.tangential_pos_num()) < (1<<12));
-  return (CacheKey)( 
-                    (static_cast<boost::uint32_t>(bin.axial_pos_num()>=0?0:1) << 31)
-                    | (static_cast<boost::uint32_t>(bin.axial_pos_num())<<13) 
-                    | (static_cast<boost::uint32_t>(bin.tangential_pos_num()>=0?0:1) << 12)
-                    |  static_cast<boost::uint32_t>(abs(bin.tangential_pos_num())) );    	
-} 
+  if (bin.axial_pos_num() < shard.min_axial_pos_num ||
+      bin.axial_pos_num() > shard.max_axial_pos_num ||
+      bin.tangential_pos_num() < shard.min_tangential_pos_num ||
+      bin.tangential_pos_num() > shard.max_tangential_pos_num)
+    return 0;
+
+  // allocate the slots for this view/segment if necessary
+  // use "Double-Checked-Locking(DCL) pattern" with OpenMP atomic operation
+  // (see ProjDataInfoCylindrical::initialise_ring_diff_arrays_if_not_done_yet)
+  const int num_tangential_poss =
+    shard.max_tangential_pos_num - shard.min_tangential_pos_num + 1;
+  bool allocated;
+#if defined(STIR_OPENMP) &&  _OPENMP >=201012
+#pragma omp atomic read
+  allocated = shard.allocated;
+#pragma omp flush
+  if (!allocated)
+#endif
+    {
+#if defined(STIR_OPENMP)
+#pragma omp critical(PROJMATRIXBYBINALLOCATECACHE)
+#endif
+      {
+        if (!shard.allocated && allocate)
+          {
+            const std::size_t num_slots =
+              static_cast<std::size_t>(shard.max_axial_pos_num - shard.min_axial_pos_num + 1) *
+              num_tangential_poss;
+            shard.slots.resize(num_slots);
+#if defined(STIR_OPENMP)
+#pragma omp flush
+#endif
+#if defined(STIR_OPENMP) &&  _OPENMP >=201012
+#pragma omp atomic write
+#endif
+            shard.allocated = true;
+          }
+        allocated = shard.allocated;
+      }
+    }
+  if (!allocated)
+    return 0;
+  return
+    &shard.slots[static_cast<std::size_t>(bin.axial_pos_num() - shard.min_axial_pos_num)*num_tangential_poss +
+                 (bin.tangential_pos_num() - shard.min_tangential_pos_num)];
+}
 
+void
+ProjMatrixByBin::
+evict_from_cache() const
+{
+  // Only one thread needs to do this. Threads that are only reading from the cache
+  // are not blocked.
+#ifdef STIR_OPENMP
+#pragma omp critical(PROJMATRIXBYBINEVICT)
+#endif
+  {
+    // remove rows until we're at 90% of the maximum, such that we don't
+    // have to come back here immediately
+    const std::size_t target_size = this->cache_max_size - this->cache_max_size/10;
+    const int min_view_num = this->cache_collection.get_min_index();
+    const int max_view_num = this->cache_collection.get_max_index();
+    // 2 passes over all views/segments is enough for the clock to go round
+    const int max_num_shards_to_visit =
+      2 * (max_view_num - min_view_num + 1) *
+      (max_view_num>=min_view_num ? this->cache_collection[min_view_num].get_length() : 0);
+    int num_shards_visited = 0;
+    std::size_t current_size;
+#ifdef STIR_OPENMP
+#pragma omp atomic read
+#endif
+    current_size = this->cache_size;
+
+    while (current_size > target_size && num_shards_visited < max_num_shards_to_visit)
+      {
+        CacheShard& shard = this->cache_collection[this->clock_view_num][this->clock_segment_num];
+        bool allocated;
+#if defined(STIR_OPENMP) &&  _OPENMP >=201012
+#pragma omp atomic read
+#endif
+        allocated = shard.allocated;
+        if (allocated)
+          {
+            for (; this->clock_slot_num < shard.slots.size() && current_size > target_size;
+                 ++this->clock_slot_num)
+              {
+                CacheSlot& slot = shard.slots[this->clock_slot_num];
+                unsigned char recently_used;
+#ifdef STIR_OPENMP
+#pragma omp atomic read
+#endif
+                recently_used = slot.recently_used;
+                if (recently_used)
+                  {
+                    // give it a second chance
+#ifdef STIR_OPENMP
+#pragma omp atomic write
+#endif
+                    slot.recently_used = 0;
+                    continue;
+                  }
+                const std::size_t num_bytes = this->release_cache_slot(slot);
+                if (num_bytes > 0)
+                  {
+                    this->add_to_cache_size(-static_cast<long>(num_bytes));
+                    current_size -= std::min(current_size, num_bytes);
+                    ++this->num_cache_evictions;
+                  }
+              }
+            if (current_size <= target_size)
+              break;
+          }
+        // go to next shard
+        ++num_shards_visited;
+        this->clock_slot_num = 0;
+        if (++this->clock_segment_num > this->cache_collection[this->clock_view_num].get_max_index())
+          {
+            if (++this->clock_view_num > max_view_num)
+              this->clock_view_num = min_view_num;
+            this->clock_segment_num = this->cache_collection[this->clock_view_num].get_min_index();
+          }
+      }
+  }
+}
 
 void  
 ProjMatrixByBin::
@@ -173,29 +408,75 @@ cache_proj_matrix_elems_for_one_bin(
 { 
   if ( cache_disabled ) return;
   
-  //std::cerr << "cached lor size " << probabilities.size() << " capacity " << probabilities.capacity() << std::endl;    
-  // insert probabilities into the collection	
   const Bin bin = probabilities.get_bin();
+  CacheShard * const shard_ptr = this->get_cache_shard(bin);
+  if (shard_ptr == 0)
+    return;
+  CacheSlot * const slot_ptr = this->get_cache_slot(*shard_ptr, bin, /*allocate=*/ true);
+  if (slot_ptr == 0)
+    return;
+
+  // Never overwrite a row that is already in the cache (as std::map::insert did), e.g.
+  // when another thread stored the same row in the mean time.
+  if (this->cache_stores_unpacked_rows())
+    {
+      const CachedUnpackedElemsSptr elems_sptr(new ProjMatrixElemsForOneBin(probabilities));
+      if (!store_if_empty(&slot_ptr->unpacked_elems_sptr, elems_sptr))
+        return;
+      this->add_to_cache_size(static_cast<long>(size_in_bytes(*elems_sptr)));
+    }
+  else
+    {
+      const CachedElemsSptr elems_sptr(new PackedProjMatrixElemsForOneBin(probabilities, this->cache_value_format));
+      if (!store_if_empty(&slot_ptr->elems_sptr, elems_sptr))
+        return;
+      this->add_to_cache_size(static_cast<long>(size_in_bytes(*elems_sptr)));
+    }
+
+  if (this->cache_max_size > 0)
+    {
+      std::size_t current_size;
 #ifdef STIR_OPENMP
-  omp_set_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
-#endif
-  cache_collection[bin.view_num()][bin.segment_num()].insert(MapProjMatrixElemsForOneBin::value_type( cache_key(bin), 
-                                                                                                      probabilities));  
-#ifdef STIR_OPENMP
-  omp_unset_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
+#pragma omp atomic read
 #endif
+      current_size = this->cache_size;
+      if (current_size > this->cache_max_size)
+        this->evict_from_cache();
+    }
 }
 
+bool
+ProjMatrixByBin::
+cache_stores_unpacked_rows() const
+{
+  return
+    this->cache_stores_only_basic_bins &&
+    this->cache_value_format == PackedProjMatrixElemsForOneBin::float_values;
+}
 
-Succeeded 
+std::size_t
 ProjMatrixByBin::
-get_cached_proj_matrix_elems_for_one_bin(
-                                         ProjMatrixElemsForOneBin& probabilities) const
-{  
+release_cache_slot(CacheSlot& slot) const
+{
+  std::size_t num_bytes = 0;
+  const CachedElemsSptr old_elems_sptr =
+    atomic_exchange(&slot.elems_sptr, CachedElemsSptr());
+  if (old_elems_sptr)
+    num_bytes += size_in_bytes(*old_elems_sptr);
+  const CachedUnpackedElemsSptr old_unpacked_elems_sptr =
+    atomic_exchange(&slot.unpacked_elems_sptr, CachedUnpackedElemsSptr());
+  if (old_unpacked_elems_sptr)
+    num_bytes += size_in_bytes(*old_unpacked_elems_sptr);
+  return num_bytes;
+}
+
+ProjMatrixByBin::CacheSlot*
+ProjMatrixByBin::
+find_cache_slot_for_lookup(CacheShard*& shard_ptr, const Bin& bin) const
+{
+  shard_ptr = 0;
   if ( cache_disabled ) 
-    return Succeeded::no;
-  
-  const Bin bin = probabilities.get_bin();
+    return 0;
 
 #ifndef NDEBUG
   if (cache_stores_only_basic_bins)
@@ -205,38 +486,154 @@ get_cached_proj_matrix_elems_for_one_bin(
     assert ( symmetries_ptr->find_basic_bin(bin_copy) == 0);     
   }
 #endif         
-  
-  bool found=false;
+
+  shard_ptr = this->get_cache_shard(bin);
+  if (shard_ptr == 0)
+    return 0;
+  return this->get_cache_slot(*shard_ptr, bin, /*allocate=*/ false);
+}
+
+void
+ProjMatrixByBin::
+record_cache_lookup(CacheShard* shard_ptr, CacheSlot* slot_ptr, const bool found) const
+{
+  if (shard_ptr == 0)
+    return;
+  if (found)
+    {
+      // only write when necessary to avoid cache-line traffic between threads
+      unsigned char recently_used;
 #ifdef STIR_OPENMP
-  omp_set_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
+#pragma omp atomic read
 #endif
-
-  {
-    const_MapProjMatrixElemsForOneBinIterator pos = 
-      cache_collection[bin.view_num()][bin.segment_num()].find(cache_key( bin));
-  
-    if ( pos != cache_collection[bin.view_num()][bin.segment_num()]. end())
-      { 
-	//cout << Key << " =========>> entry found in cache " <<  endl;
-	probabilities = pos->second;
-	// note: cannot return from inside an OPENMP critical section
-	//return Succeeded::yes;	
-	found=true;
-      } 
-  }
+      recently_used = slot_ptr->recently_used;
+      if (!recently_used)
+        {
 #ifdef STIR_OPENMP
-  omp_unset_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
+#pragma omp atomic write
 #endif
-  if (found)
-    return Succeeded::yes;	
+          slot_ptr->recently_used = 1;
+        }
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+      ++shard_ptr->num_hits;
+    }
   else
     {
-      //cout << " This entry  is not in the cache :" << Key << endl;	
-      return Succeeded::no;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+      ++shard_ptr->num_misses;
+    }
+}
+
+shared_ptr<const PackedProjMatrixElemsForOneBin>
+ProjMatrixByBin::
+get_cached_proj_matrix_elems_for_one_bin_sptr(const Bin& bin) const
+{
+  CacheShard* shard_ptr;
+  CacheSlot * const slot_ptr = this->find_cache_slot_for_lookup(shard_ptr, bin);
+  const CachedElemsSptr elems_sptr =
+    slot_ptr == 0 ? CachedElemsSptr() : atomic_load(&slot_ptr->elems_sptr);
+  this->record_cache_lookup(shard_ptr, slot_ptr, static_cast<bool>(elems_sptr));
+  return elems_sptr;
+}
+
+Succeeded 
+ProjMatrixByBin::
+get_cached_proj_matrix_elems_for_one_bin(
+                                         ProjMatrixElemsForOneBin& probabilities) const
+{  
+  if (this->cache_stores_unpacked_rows())
+    {
+      // no decoding necessary, just copy the row
+      CacheShard* shard_ptr;
+      CacheSlot * const slot_ptr =
+        this->find_cache_slot_for_lookup(shard_ptr, probabilities.get_bin());
+      const CachedUnpackedElemsSptr elems_sptr =
+        slot_ptr == 0 ? CachedUnpackedElemsSptr() : atomic_load(&slot_ptr->unpacked_elems_sptr);
+      this->record_cache_lookup(shard_ptr, slot_ptr, static_cast<bool>(elems_sptr));
+      if (!elems_sptr)
+        return Succeeded::no;
+      probabilities = *elems_sptr;
+      return Succeeded::yes;
+    }
+
+  const CachedElemsSptr elems_sptr =
+    this->get_cached_proj_matrix_elems_for_one_bin_sptr(probabilities.get_bin());
+  if (!elems_sptr)
+    return Succeeded::no;
+
+  elems_sptr->unpack(probabilities);
+  return Succeeded::yes;
+}
+
+shared_ptr<const PackedProjMatrixElemsForOneBin>
+ProjMatrixByBin::
+get_packed_proj_matrix_elems_for_one_bin(const Bin& bin) const
+{
+  CachedElemsSptr elems_sptr;
+  if (!cache_disabled && !cache_stores_only_basic_bins)
+    {
+      elems_sptr = this->get_cached_proj_matrix_elems_for_one_bin_sptr(bin);
+      if (elems_sptr)
+        return elems_sptr;
     }
+  ProjMatrixElemsForOneBin elems;
+  this->get_proj_matrix_elems_for_one_bin(elems, bin);
+  elems_sptr.reset(new PackedProjMatrixElemsForOneBin(elems, this->cache_value_format));
+  return elems_sptr;
 }
 
+unsigned long
+ProjMatrixByBin::
+get_num_cache_hits() const
+{
+  unsigned long num_hits = 0;
+  for (int i=this->cache_collection.get_min_index(); i<=this->cache_collection.get_max_index(); ++i)
+    for (int j=this->cache_collection[i].get_min_index(); j<=this->cache_collection[i].get_max_index(); ++j)
+      num_hits += this->cache_collection[i][j].num_hits;
+  return num_hits;
+}
 
+unsigned long
+ProjMatrixByBin::
+get_num_cache_misses() const
+{
+  unsigned long num_misses = 0;
+  for (int i=this->cache_collection.get_min_index(); i<=this->cache_collection.get_max_index(); ++i)
+    for (int j=this->cache_collection[i].get_min_index(); j<=this->cache_collection[i].get_max_index(); ++j)
+      num_misses += this->cache_collection[i][j].num_misses;
+  return num_misses;
+}
+
+unsigned long
+ProjMatrixByBin::
+get_num_cache_evictions() const
+{ return this->num_cache_evictions; }
+
+std::size_t
+ProjMatrixByBin::
+get_cache_size() const
+{ return this->cache_size; }
+
+std::string
+ProjMatrixByBin::
+get_cache_statistics() const
+{
+  const std::string maximum =
+    this->cache_max_size == 0
+    ? std::string("no maximum")
+    : boost::str(boost::format("maximum %1% MB") % (this->cache_max_size/(1024.*1024)));
+  return
+    boost::str(boost::format("ProjMatrixByBin cache: %1% hits, %2% misses, %3% evictions, %4% MB in use (%5%)")
+               % this->get_num_cache_hits()
+               % this->get_num_cache_misses()
+               % this->get_num_cache_evictions()
+               % (this->get_cache_size()/(1024.*1024))
+               % maximum);
+}
 
 //TODO
 
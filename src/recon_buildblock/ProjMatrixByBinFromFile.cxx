@@ -1,7 +1,7 @@
 /*
     Copyright (C) 2004 - 2008, Hammersmith Imanet Ltd
     Copyright (C) 2011 - 2012, Kris Thielemans
-    Copyright (C) 2014, University College London
+    Copyright (C) 2014, 2026, University College London
     This file is part of STIR.
 
     This file is free software; you can redistribute it and/or modify
@@ -40,12 +40,16 @@
 #include "stir/Succeeded.h"
 #include "stir/is_null_ptr.h"
 #include "stir/Coordinate3D.h"
-//#include "boost/format.hpp"
+#include "boost/format.hpp"
 //#include "stir/info.h"
 #include "boost/cstdint.hpp"
 #include "boost/scoped_ptr.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <fstream>
 #include <algorithm>
+#include <vector>
+#include <cstring>
 
 using std::string;
 
@@ -58,6 +62,7 @@ ProjMatrixByBinFromFile::registered_name =
 
 ProjMatrixByBinFromFile::
 ProjMatrixByBinFromFile()
+  : num_lors_in_data(0)
 {
   set_defaults();
 }
@@ -111,9 +116,9 @@ ProjMatrixByBinFromFile::post_processing()
   if (ProjMatrixByBin::post_processing() == true)
     return true;
 
-  if (this->parsed_version != "1.0")
+  if (this->parsed_version != "1.0" && this->parsed_version != "2.0")
     { 
-      warning("version has to be 1.0");
+      warning("version has to be 1.0 or 2.0");
       return true;
     }
   this->symmetries_type = standardise_interfile_keyword(this->symmetries_type);
@@ -216,6 +221,21 @@ set_up(
   // every LOR that's in the file in the cache
   ProjMatrixByBin::set_up(this->proj_data_info_ptr, density_info_ptr);
 
+  if (this->parsed_version == "2.0")
+    {
+      // LORs will be read from the mapped file when necessary
+      if (map_data() == Succeeded::no)
+        error("Something wrong mapping the matrix from file. Exiting.");
+      return;
+    }
+
+  // we cannot have LORs removed from the cache, as we wouldn't be able to recompute them
+  if (this->get_maximum_cache_size() != 0)
+    {
+      warning("ProjMatrixByBinFromFile needs to store the whole matrix in the cache for version 1.0. Ignoring maximum cache size.");
+      this->set_maximum_cache_size(0);
+    }
+
   if (read_data() ==Succeeded::no)
     error("Something wrong reading the matrix from file. Exiting.");
 }
@@ -223,45 +243,116 @@ set_up(
 // anonymous namespace for local functions
 namespace {
 
+  /* Layout of the binary file for Version 2.0
+
+     All numbers are stored in native byte order (which is checked via
+     byte_order_marker when reading).
+     - FileHeader
+     - LORs, each starting at an offset which is a multiple of record_alignment,
+       stored as FileLORElement arrays
+     - FileLORIndexEntry array (of size num_lors, sorted on bin coordinates),
+       also starting at a multiple of record_alignment
+  */
+  const char file_magic[8] = { 'S','T','I','R','P','M','2','\0' };
+  const boost::uint32_t byte_order_marker = 0x01020304U;
+  const boost::uint64_t record_alignment = 16;
+
+  struct FileHeader
+  {
+    char magic[8];
+    boost::uint32_t byte_order;
+    boost::uint32_t element_size;
+    boost::uint64_t num_lors;
+    boost::uint64_t index_offset;
+    boost::uint64_t reserved[4];
+  };
+
+  struct FileLORElement
+  {
+    boost::int16_t c1, c2, c3, reserved;
+    float value;
+  };
+
+  struct FileLORIndexEntry
+  {
+    boost::int32_t segment_num, view_num, axial_pos_num, tangential_pos_num;
+    boost::uint64_t offset;
+    boost::uint32_t num_elements;
+    boost::uint32_t reserved;
+  };
+
+  inline bool
+  index_entry_less(const FileLORIndexEntry& e1, const FileLORIndexEntry& e2)
+  {
+    if (e1.segment_num != e2.segment_num) return e1.segment_num < e2.segment_num;
+    if (e1.view_num != e2.view_num) return e1.view_num < e2.view_num;
+    if (e1.axial_pos_num != e2.axial_pos_num) return e1.axial_pos_num < e2.axial_pos_num;
+    return e1.tangential_pos_num < e2.tangential_pos_num;
+  }
+
   // static (i.e. private) function to write the data
+  // The offset and size of the LOR is added to index.
   static Succeeded
-  write_lor(std::ostream&fst, const ProjMatrixElemsForOneBin& lor) 
+  write_lor(std::ostream&fst, const ProjMatrixElemsForOneBin& lor,
+            std::vector<FileLORIndexEntry>& index) 
   {  
-    const Bin bin = lor.get_bin();
+    // pad to alignment
+    boost::uint64_t offset = static_cast<boost::uint64_t>(fst.tellp());
     {
-      boost::int32_t c;
-      c = bin.segment_num(); fst.write ( (char*)&c, sizeof(boost::int32_t));
-      c = bin.view_num(); fst.write ( (char*)&c, sizeof(boost::int32_t));
-      c = bin.axial_pos_num(); fst.write ( (char*)&c, sizeof(boost::int32_t));
-      c = bin.tangential_pos_num(); fst.write ( (char*)&c, sizeof(boost::int32_t));
+      const char zeroes[record_alignment] = {0};
+      const boost::uint64_t padding = (record_alignment - offset % record_alignment) % record_alignment;
+      fst.write(zeroes, static_cast<std::streamsize>(padding));
+      offset += padding;
     }
-    {
-      boost::uint32_t c= static_cast<boost::uint32_t>(lor.size());
-      fst.write( (char*)&c , sizeof(boost::uint32_t));  
-    }
-    if (!fst)
-      return Succeeded::no;
-    ProjMatrixElemsForOneBin::const_iterator element_ptr = lor.begin();
-    // todo add compression in this loop 
-    while (element_ptr != lor.end())
-      {           
-	boost::int16_t c;
-	c = static_cast<boost::int16_t>(element_ptr->coord1());
-	fst.write ( (char*)&c, sizeof(boost::int16_t));
-	c = static_cast<boost::int16_t>(element_ptr->coord2());
-	fst.write ( (char*)&c, sizeof(boost::int16_t));
-	c = static_cast<boost::int16_t>(element_ptr->coord3());
-	fst.write ( (char*)&c, sizeof(boost::int16_t));
-	const float value = element_ptr->get_value();
-	fst.write ( (char*)&value, sizeof(float));
-	if (!fst)
-	  return Succeeded::no;
 
-	++element_ptr;
+    const Bin bin = lor.get_bin();
+    FileLORIndexEntry entry;
+    entry.segment_num = bin.segment_num();
+    entry.view_num = bin.view_num();
+    entry.axial_pos_num = bin.axial_pos_num();
+    entry.tangential_pos_num = bin.tangential_pos_num();
+    entry.offset = offset;
+    entry.num_elements = static_cast<boost::uint32_t>(lor.size());
+    entry.reserved = 0;
+    index.push_back(entry);
+
+    std::vector<FileLORElement> elements(lor.size());
+    std::vector<FileLORElement>::iterator out_iter = elements.begin();
+    for (ProjMatrixElemsForOneBin::const_iterator element_ptr = lor.begin();
+         element_ptr != lor.end();
+         ++element_ptr, ++out_iter)
+      {           
+	out_iter->c1 = static_cast<boost::int16_t>(element_ptr->coord1());
+	out_iter->c2 = static_cast<boost::int16_t>(element_ptr->coord2());
+	out_iter->c3 = static_cast<boost::int16_t>(element_ptr->coord3());
+	out_iter->reserved = 0;
+	out_iter->value = element_ptr->get_value();
       } 
+    if (!elements.empty())
+      fst.write(reinterpret_cast<const char *>(&elements[0]),
+                static_cast<std::streamsize>(elements.size()*sizeof(FileLORElement)));
+    if (!fst)
+      return Succeeded::no;
     return Succeeded::yes;
   } 
 
+  // static (i.e. private) function to write the header of the file
+  static Succeeded
+  write_file_header(std::ostream&fst, const boost::uint64_t num_lors, const boost::uint64_t index_offset)
+  {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, file_magic, sizeof(header.magic));
+    header.byte_order = byte_order_marker;
+    header.element_size = sizeof(FileLORElement);
+    header.num_lors = num_lors;
+    header.index_offset = index_offset;
+    fst.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (!fst)
+      return Succeeded::no;
+    return Succeeded::yes;
+  }
+
   // return type for read_lor()
   class readReturnType
   {
@@ -349,8 +440,9 @@ write_to_file(const std::string& output_filename_prefix,
 	return Succeeded::no;
       }
   }
+  // use the name of the header, as this is what we need to write in the .hpm file
   string template_proj_data_filename =
-    output_filename_prefix + "_template_proj_data";
+    output_filename_prefix + "_template_proj_data.hs";
   {
     // the following constructor will write an interfile header (and empty data) to disk
     shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
@@ -374,7 +466,7 @@ write_to_file(const std::string& output_filename_prefix,
       }
 
     header << "Projection Matrix By Bin From File Parameters:=\n"
-	   << "Version := 1.0\n";
+	   << "Version := 2.0\n";
     // TODO symmetries should not be hard-coded
     if (!is_null_ptr(dynamic_cast<const DataSymmetriesForBins_PET_CartesianGrid * const>(proj_matrix.get_symmetries_ptr())))
       {
@@ -412,6 +504,10 @@ write_to_file(const std::string& output_filename_prefix,
 
   std::ofstream fst;
   open_write_binary(fst, data_filename.c_str());
+  // write a dummy header first, we will fill it in at the end
+  if (write_file_header(fst, 0, 0) == Succeeded::no)
+    return Succeeded::no;
+  std::vector<FileLORIndexEntry> index;
   
   // loop over bins
   // the complication here is that we cannot just test if each bin in the range is 'basic'
@@ -496,10 +592,27 @@ write_to_file(const std::string& output_filename_prefix,
 	    //  continue;
 	    
 	    proj_matrix.get_proj_matrix_elems_for_one_bin(lor,bin);
-	    if (write_lor(fst, lor) == Succeeded::no)
+	    if (write_lor(fst, lor, index) == Succeeded::no)
 	      return Succeeded::no;
 	  }
   }
+
+  // write index (sorted such that we can do a binary search) and fill in the header
+  std::sort(index.begin(), index.end(), index_entry_less);
+  boost::uint64_t index_offset = static_cast<boost::uint64_t>(fst.tellp());
+  {
+    // pad to alignment such that the index can be used directly from the mapped file
+    const char zeroes[record_alignment] = {0};
+    const boost::uint64_t padding = (record_alignment - index_offset % record_alignment) % record_alignment;
+    fst.write(zeroes, static_cast<std::streamsize>(padding));
+    index_offset += padding;
+  }
+  if (!index.empty())
+    fst.write(reinterpret_cast<const char *>(&index[0]),
+              static_cast<std::streamsize>(index.size()*sizeof(FileLORIndexEntry)));
+  fst.seekp(0);
+  if (write_file_header(fst, index.size(), index_offset) == Succeeded::no)
+    return Succeeded::no;
   return Succeeded::yes;
 }
 
@@ -525,13 +638,96 @@ read_data()
 }
 
 
+Succeeded
+ProjMatrixByBinFromFile::
+map_data()
+{
+  if (!is_null_ptr(this->data_region_sptr))
+    return Succeeded::yes; // already mapped
+
+  try
+    {
+      this->data_file_mapping_sptr.reset(new boost::interprocess::file_mapping(data_filename.c_str(),
+                                                                              boost::interprocess::read_only));
+      this->data_region_sptr.reset(new boost::interprocess::mapped_region(*this->data_file_mapping_sptr,
+                                                                         boost::interprocess::read_only));
+    }
+  catch (boost::interprocess::interprocess_exception& e)
+    {
+      warning(boost::format("ProjMatrixByBinFromFile: error mapping %1%: %2%") % data_filename % e.what());
+      return Succeeded::no;
+    }
+
+  const char * const data = static_cast<const char *>(this->data_region_sptr->get_address());
+  const std::size_t data_size = this->data_region_sptr->get_size();
+  if (data_size < sizeof(FileHeader))
+    {
+      warning(boost::format("ProjMatrixByBinFromFile: %1% is too small") % data_filename);
+      return Succeeded::no;
+    }
+  const FileHeader& header = *reinterpret_cast<const FileHeader *>(data);
+  if (std::memcmp(header.magic, file_magic, sizeof(header.magic)) != 0)
+    {
+      warning(boost::format("ProjMatrixByBinFromFile: %1% is not a Version 2.0 projection matrix file") % data_filename);
+      return Succeeded::no;
+    }
+  if (header.byte_order != byte_order_marker || header.element_size != sizeof(FileLORElement))
+    {
+      warning(boost::format("ProjMatrixByBinFromFile: %1% was written on a system with a different byte order or alignment") % data_filename);
+      return Succeeded::no;
+    }
+  if (header.index_offset % sizeof(boost::uint64_t) != 0 ||
+      header.index_offset + header.num_lors*sizeof(FileLORIndexEntry) > data_size)
+    {
+      warning(boost::format("ProjMatrixByBinFromFile: %1% has an invalid index (file truncated?)") % data_filename);
+      return Succeeded::no;
+    }
+  this->num_lors_in_data = static_cast<std::size_t>(header.num_lors);
+  return Succeeded::yes;
+}
+
 void 
 ProjMatrixByBinFromFile::
 calculate_proj_matrix_elems_for_one_bin(ProjMatrixElemsForOneBin& lor
 					) const
 {
-  //error("ProjMatrixByBinFromFile element not found in cache (and hence file)");
   lor.erase();
+  if (is_null_ptr(this->data_region_sptr))
+    {
+      // Version 1.0: all LORs were put in the cache, so this one is not in the file
+      //error("ProjMatrixByBinFromFile element not found in cache (and hence file)");
+      return;
+    }
+
+  // find the LOR in the index via binary search
+  const char * const data = static_cast<const char *>(this->data_region_sptr->get_address());
+  const FileHeader& header = *reinterpret_cast<const FileHeader *>(data);
+  const FileLORIndexEntry * const index_begin =
+    reinterpret_cast<const FileLORIndexEntry *>(data + header.index_offset);
+  const FileLORIndexEntry * const index_end = index_begin + this->num_lors_in_data;
+  const Bin bin = lor.get_bin();
+  FileLORIndexEntry entry_to_find;
+  entry_to_find.segment_num = bin.segment_num();
+  entry_to_find.view_num = bin.view_num();
+  entry_to_find.axial_pos_num = bin.axial_pos_num();
+  entry_to_find.tangential_pos_num = bin.tangential_pos_num();
+  const FileLORIndexEntry * const entry_ptr =
+    std::lower_bound(index_begin, index_end, entry_to_find, index_entry_less);
+  if (entry_ptr == index_end || index_entry_less(entry_to_find, *entry_ptr))
+    return; // not in the file
+
+  if (entry_ptr->offset + entry_ptr->num_elements*sizeof(FileLORElement) > this->data_region_sptr->get_size())
+    error(boost::format("ProjMatrixByBinFromFile: %1% has an invalid offset (file truncated?)") % data_filename);
+  const FileLORElement * element_ptr =
+    reinterpret_cast<const FileLORElement *>(data + entry_ptr->offset);
+  const FileLORElement * const element_end = element_ptr + entry_ptr->num_elements;
+  // copy the elements, as ProjMatrixByBin needs to own the row (see class documentation)
+  lor.reserve(entry_ptr->num_elements);
+  for (; element_ptr != element_end; ++element_ptr)
+    lor.push_back(ProjMatrixElemsForOneBin::value_type(Coordinate3D<int>(element_ptr->c1,
+                                                                         element_ptr->c2,
+                                                                         element_ptr->c3),
+                                                       element_ptr->value));
 }
 END_NAMESPACE_STIR
 
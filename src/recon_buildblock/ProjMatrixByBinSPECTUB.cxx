@@ -40,7 +40,10 @@
 #include "stir/is_null_ptr.h"
 #include "stir/Coordinate3D.h"
 #include "stir/info.h"
+#include "stir/warning.h"
+#include "stir/error.h"
 #include "stir/CPUTimer.h"
+#include "stir/HighResWallClockTimer.h"
 #ifdef STIR_OPENMP
 #include "stir/num_threads.h"
 #endif
@@ -49,13 +52,25 @@
 //#include "boost/scoped_ptr.hpp"
 #include <boost/math/special_functions/fpclassify.hpp>
 #include <boost/format.hpp>
+#include "boost/cstdint.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#if defined(__OS_WIN__)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
 #include <algorithm>
 #include <stdio.h>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <ctime>
 #include <stdlib.h>
 #include <math.h>
 #include <ctype.h>
@@ -76,6 +91,57 @@ namespace SPECTUB {
 
 START_NAMESPACE_STIR
 
+namespace {
+  /* File format for the weights, see ProjMatrixByBinSPECTUB::write_weight_file() */
+  const char weight_file_magic[8] = { 'S','T','I','R','U','B','1','\0' };
+  const boost::uint32_t weight_file_byte_order_marker = 0x01020304U;
+
+  // used for unique names of temporary files
+  long get_process_id()
+  {
+#if defined(__OS_WIN__)
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(getpid());
+#endif
+  }
+
+  struct WeightFileHeader
+  {
+    char magic[8];
+    boost::uint32_t byte_order;
+    boost::uint32_t index_size;
+    boost::uint64_t num_subsets;
+    boost::uint64_t num_rows_per_subset;
+    boost::uint64_t num_elements;
+    boost::uint64_t key_size;
+    boost::uint64_t row_start_offset;
+    boost::uint64_t voxel_index_offset;
+    boost::uint64_t value_offset;
+  };
+
+  // size rounded up to a multiple of 8 bytes
+  inline boost::uint64_t
+  padded_size(const boost::uint64_t size)
+  {
+    return (size + 7) / 8 * 8;
+  }
+
+  // 64-bit FNV-1a hash
+  boost::uint64_t
+  checksum(const void * const data, const std::size_t size)
+  {
+    const unsigned char * const bytes = static_cast<const unsigned char *>(data);
+    boost::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i)
+      {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+      }
+    return hash;
+  }
+}
+
 
 const char * const 
 ProjMatrixByBinSPECTUB::registered_name =
@@ -107,6 +173,7 @@ initialise_keymap()
   parser.add_key("mask type", &mask_type);
   parser.add_key("mask file", &mask_file);
   parser.add_key("keep_all_views_in_cache", &keep_all_views_in_cache);
+  parser.add_key("weight matrix cache directory", &weight_matrix_cache_directory);
 
   parser.add_stop_key("End Projection Matrix By Bin SPECT UB Parameters");
 }
@@ -120,6 +187,7 @@ ProjMatrixByBinSPECTUB::set_defaults()
   this->already_setup= false;
 
   this->keep_all_views_in_cache=false;
+  this->weight_matrix_cache_directory="";
   minimum_weight=0.0;
   maximum_number_of_sigmas= 2.;
   spatial_resolution_PSF= 0.00001;
@@ -157,7 +225,7 @@ set_up(
   ProjMatrixByBin::set_up(proj_data_info_ptr_v, density_info_ptr);
 
 #ifdef STIR_OPENMP
-  if (!this->keep_all_views_in_cache)
+  if (!this->keep_all_views_in_cache && this->weight_matrix_cache_directory.empty())
     {
       warning("SPECTUB matrix can currently only use single-threaded code unless all views are kept. Setting num_threads to 1");
       set_num_threads(1);
@@ -384,8 +452,6 @@ set_up(
 		wmh.do_msk     = true;
 		wmh.do_msk_slc = true;
 	}
-	
-	wm.do_save_STIR = true;
 
 	//:: Control of read parameters
 	cout << "" << endl;
@@ -486,72 +552,52 @@ set_up(
           }
 	else msk_2d = msk_3d = NULL;
 
-	//... Initialization and memory allocation for the weight matrix ...................
+	//... file with weights ............................................................
 
-	wm.NbOS = prj.NbOS;     // number of rows in the weight matrix
-	wm.Nvox = vol.Nvox;     // number of columnes in the weight matrix	
+	this->weight_region_sptr.reset();
+	this->weight_file_mapping_sptr.reset();
+	this->subset_weights.clear();
+	this->subset_weights.resize(prj.NOS);
+	this->compute_subsets_on_demand = !this->keep_all_views_in_cache;
+
+	std::string weight_key;
+	this->weight_filename.clear();
+	if (!this->weight_matrix_cache_directory.empty())
+	  {
+	    weight_key = this->get_weight_matrix_key();
+	    std::ostringstream filename_stream;
+	    filename_stream << this->weight_matrix_cache_directory << "/SPECTUB_"
+	                    << std::hex << std::setw(16) << std::setfill('0')
+	                    << checksum(weight_key.data(), weight_key.size())
+	                    << ".wm";
+	    this->weight_filename = filename_stream.str();
+	  }
 
 	//... setting PSF maximum size (in bins) and memory allocation for PSF values .......
 
 	this->maxszb = max_psf_szb( ang );  // maximum PSF size (horizontal component of PSF)
 	NITEMS = new int * [prj.NOS];
 	for (int kOS=0; kOS<prj.NOS; ++kOS) {
-	  NITEMS[kOS] = new int [ wm.NbOS ];
-	}
-
-	//... double array wm.val and wm.col .....................................................
-
-	if ( ( wm.val = new (nothrow) float * [ wm.NbOS ] ) == NULL ) 
-          {
-            //error_wm_SPECT( 200, "wm.val[]" );
-            error("Error allocating space to store values for SPECTUB matrix");
-          }
-	if ( ( wm.col = new (nothrow) int   * [ wm.NbOS ] ) == NULL ) 
-          {
-            //error_wm_SPECT( 200, "wm.col[]" );
-            error("Error allocating space to store column indices for SPECTUB matrix");
-          }
-
-	//... array wm.ne .........................................................................
-
-	if ( ( wm.ne = new (nothrow) int [ wm.NbOS + 1 ]) == 0 ) 
-          {
-            // error_wm_SPECT(200,"wm.ne[]");
-            error("Error allocating space to store number of elements for SPECTUB matrix");
-          }
-
-
-	//... STIR indices .......................................................................
-
-	if ( wm.do_save_STIR ){
-		wm.ns = new int [ prj.NbOS ];
-		wm.nb = new int [ prj.NbOS ];
-		wm.na = new int [ prj.NbOS ];
-
-		wm.nx = new short int [ vol.Nvox ];
-		wm.ny = new short int [ vol.Nvox ];
-		wm.nz = new short int [ vol.Nvox ];
+	  NITEMS[kOS] = new int [ prj.NbOS ];
 	}
 
-	//... memory allocation for wmh .........................................................
-
-	wmh.index = new int [ wmh.prj.NangOS ];
-	wmh.Rrad  = new float [ wmh.prj.NangOS ];
+	if (!this->weight_filename.empty() &&
+	    this->map_weight_file(this->weight_filename, weight_key) == Succeeded::yes)
+	  {
+	    info(boost::format("Using SPECTUB weights from %1%") % this->weight_filename);
+	    this->already_setup= true;
+	    return;
+	  }
 
 	//..........................................................................................
 	//... CALCULATION OF MATRICES ..............................................................
 	//..........................................................................................
 
 	//... LOOP: Subsets .................................................................
-	subset_already_processed.assign(prj.NOS, false);
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
 	for ( int kOS = 0 ; kOS < prj.NOS ; kOS++ ){
-		wmh.subset_ind = kOS;
-
-		for ( int i = 0 ; i < prj.NangOS ; i ++ ){
-
-			wmh.index[ i ] = prj.order[ i + kOS * prj.NangOS ];
-			wmh.Rrad [ i ] = Rrad[ wmh.index[ i ] ];
-		}
 
 		//... NITEMS initialization  ......................
 
@@ -560,21 +606,48 @@ set_up(
 
 		//... size estimations ........................................................
 
-		wm_size_estimation ( kOS,  ang, vox, bin, vol, prj, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS[kOS] );
-
-		//cout << "\nwm_SPECT. Size estimation done. time (s): " << double( clock()-ini )/CLOCKS_PER_SEC <<endl;
+		wm_size_estimation ( kOS, &prj.order[ kOS * prj.NangOS ], ang, vox, bin, vol, prj, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS[kOS] );
 
-	// compute_one_subset(kOS);
 	}   // end of LOOP: Subsets
 
-	//delete_UB_SPECT_arrays();
 	info(boost::format("Done estimating size of matrix. Execution (CPU) time %1% s ") % timer.value(), 
              2);
+
+	if (!this->compute_subsets_on_demand)
+	  this->compute_all_subsets();
+	if (!this->weight_filename.empty())
+	  {
+	    // if subsets are computed on demand, write_weight_file() computes them one at a time
+	    if (this->write_weight_file(this->weight_filename, weight_key) == Succeeded::yes &&
+	        this->map_weight_file(this->weight_filename, weight_key) == Succeeded::yes)
+	      {
+	        // weights will be read from the file, so we can free the memory
+	        this->subset_weights.clear();
+	        this->subset_weights.resize(prj.NOS);
+	      }
+	    else
+	      warning(boost::format("ProjMatrixByBinSPECTUB: could not store weights in %1%. Weights will be computed in memory")
+	              % this->weight_filename);
+	  }
 	// wm_SPECT ends here ---------------------------------------------------------------------------------------------
 
 	this->already_setup= true;
 }
 
+const std::string&
+ProjMatrixByBinSPECTUB::
+get_weight_file_name() const
+{
+  return this->weight_filename;
+}
+
+bool
+ProjMatrixByBinSPECTUB::
+is_using_weight_file() const
+{
+  return !is_null_ptr(this->weight_region_sptr);
+}
+
 ProjMatrixByBinSPECTUB::
 ~ProjMatrixByBinSPECTUB()
 {
@@ -596,10 +669,6 @@ delete_UB_SPECT_arrays()
     }
   }
 
-  delete [] wm.val;
-  delete [] wm.col;
-  delete [] wm.ne;
-
   //... freeing memory .............................................
 
   delete [] prj.order;
@@ -607,8 +676,6 @@ delete_UB_SPECT_arrays()
   for (int kOS=0; kOS<prj.NOS; ++kOS)
     delete [] NITEMS[kOS];
   delete [] NITEMS;	
-  delete [] wmh.index;
-  delete [] wmh.Rrad;
 
   if (wmh.do_psf){
     delete [] gaussdens.val;
@@ -621,159 +688,409 @@ delete_UB_SPECT_arrays()
     delete [] msk_2d;
   }
 
-  if ( wm.do_save_STIR ){
-    delete [] wm.ns;
-    delete [] wm.nb;
-    delete [] wm.na;
-    delete [] wm.nx;
-    delete [] wm.ny;
-    delete [] wm.nz;
-
-  }
-
 }
 void
 ProjMatrixByBinSPECTUB::
-compute_one_subset(const int kOS) const
+compute_one_subset(const int kOS, SubsetWeights& weights) const
 {
   using namespace SPECTUB;
 
   CPUTimer timer;
   timer.start();
-  // cout << "\n\n--- Processing subset: " << kOS+1 << "/" << prj.NOS << " ----------------------------------------\n" << endl;
 
-  //... to fill wmh fields related to the subset ..................................
+  const int * const nitems = NITEMS[kOS];
 
-  wmh.subset_ind = kOS;
+  //... memory allocation: every row gets space for its estimated number of weights (at least 1) ....
 
-  for ( int i = 0 ; i < prj.NangOS ; i ++ ){
+  weights.row_start.resize(prj.NbOS + 1);
+  weights.row_start[0] = 0;
+  for ( int i = 0 ; i < prj.NbOS ; i++ ) weights.row_start[ i+1 ] = weights.row_start[ i ] + nitems[ i ];
+  weights.voxel_index.resize(weights.row_start[ prj.NbOS ]);
+  weights.value.resize(weights.row_start[ prj.NbOS ]);
 
-    wmh.index[ i ] = prj.order[ i + kOS * prj.NangOS ];
-    wmh.Rrad [ i ] = Rrad[ wmh.index[ i ] ];
-  }
+  //... wm for this subset, pointing into the above arrays ....................................
 
-  //... NITEMS initialization  ......................
-
-  // for ( int i = 0 ; i < prj.NbOS ; i++ ) NITEMS[ i ] = 1;
+  std::vector<float *> val(prj.NbOS);
+  std::vector<int *> col(prj.NbOS);
+  std::vector<int> ne(prj.NbOS + 1, 0);
+  for ( int i = 0 ; i < prj.NbOS ; i++ ){
+    val[ i ] = &weights.value[ weights.row_start[ i ] ];
+    col[ i ] = &weights.voxel_index[ weights.row_start[ i ] ];
+  }
 
+  wm_da_type wm;
+  wm.NbOS = prj.NbOS;
+  wm.Nvox = vol.Nvox;
+  wm.val = &val[0];
+  wm.col = &col[0];
+  wm.ne = &ne[0];
+  wm.na = wm.nb = wm.ns = 0;
+  wm.nx = wm.ny = wm.nz = 0;
+  wm.do_save_wmh = false;
+  // STIR indices are found from the row and voxel indices, see calculate_proj_matrix_elems_for_one_bin()
+  wm.do_save_STIR = false;
 
-  //... size esmitations ........................................................
+  //... wm calculation for this subset ...........................
 
-  //wm_size_estimation ( kOS,  ang, vox, bin, vol, prj, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS );
+  wm_calculation ( kOS, &prj.order[ kOS * prj.NangOS ], wm, ang, vox, bin, vol, prj, attmap, msk_3d, msk_2d, maxszb, &gaussdens, nitems );
 
-  //cout << "\nwm_SPECT. Size estimation done. time (s): " << double( clock()-ini )/CLOCKS_PER_SEC <<endl;
+  //... remove unused space ......................................
 
-  int ne = 0;
+  int num_elements = 0;
+  for ( int i = 0 ; i < prj.NbOS ; i++ ){
+    const int old_start = weights.row_start[ i ];
+    weights.row_start[ i ] = num_elements;
+    if (old_start != num_elements)
+      for ( int j = 0 ; j < ne[ i ] ; j++ ){
+        weights.voxel_index[ num_elements + j ] = weights.voxel_index[ old_start + j ];
+        weights.value[ num_elements + j ] = weights.value[ old_start + j ];
+      }
+    num_elements += ne[ i ];
+  }
+  weights.row_start[ prj.NbOS ] = num_elements;
+  std::vector<int>(weights.voxel_index.begin(), weights.voxel_index.begin() + num_elements).swap(weights.voxel_index);
+  std::vector<float>(weights.value.begin(), weights.value.begin() + num_elements).swap(weights.value);
+
+  info(boost::format("Weight matrix calculation done for subset %1%: %2% non-zero weights (%3% MB). time %4% (s)")
+       % kOS
+       % num_elements
+       % ( num_elements * (sizeof(int) + sizeof(float)) / 1048576.)
+       % timer.value(),
+       2);
+}
 
-  for ( int i = 0 ; i < wmh.prj.NbOS ; i++ ) ne += NITEMS[kOS][ i ];
+void
+ProjMatrixByBinSPECTUB::
+compute_all_subsets()
+{
+  HighResWallClockTimer timer;
+  timer.start();
 
-  //... size information ....................................................................
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int kOS=0; kOS<prj.NOS; ++kOS)
+    this->compute_one_subset(kOS, this->subset_weights[kOS]);
 
-  info(boost::format("total number of non-zero weights in this view: %1%, estimated size: %2% MB") 
-       % ne
-       % ( wm.do_save_STIR ?  (ne + 10* prj.NbOS)/104857.6 : ne/131072),
+  timer.stop();
+  info(boost::format("Done computing weights of SPECTUB matrix. Execution (wall-clock) time %1% s")
+       % timer.value(),
        2);
+}
 
-  //... memory allocation for wm float arrays ...................................
+std::string
+ProjMatrixByBinSPECTUB::
+get_weight_matrix_key() const
+{
+  using namespace SPECTUB;
 
-  for( int i = 0 ; i < wmh.prj.NbOS ; i++ ){
+  std::ostringstream key;
+  key << std::setprecision(9);
+  key << "SPECTUB weight matrix\n"
+      << "image: " << vol.Ncol << ' ' << vol.Nrow << ' ' << vol.Nsli
+      << ' ' << vol.szcm << ' ' << vol.thcm
+      << ' ' << vol.first_sl << ' ' << vol.last_sl << '\n'
+      << "projections: " << prj.Nbin << ' ' << prj.szcm << ' ' << prj.Nang
+      << ' ' << prj.ang0 << ' ' << prj.incr
+      << ' ' << prj.NOS << ' ' << prj.NangOS << '\n'
+      << "radii:";
+  for (int i = 0 ; i < prj.Nang ; i++ )
+    key << ' ' << Rrad[ i ];
+  key << '\n'
+      << "resolution: " << wmh.min_w << ' ' << wmh.maxsigm << ' ' << wmh.psfres << '\n'
+      << "psf: " << wmh.do_psf << ' ' << wmh.do_psf_3d;
+  if (wmh.do_psf)
+    key << ' ' << wmh.COL.A << ' ' << wmh.COL.B;
+  key << '\n'
+      << "attenuation: " << wmh.do_att << ' ' << wmh.do_full_att;
+  if (attmap != NULL)
+    key << " checksum " << std::hex << checksum(attmap, vol.Nvox*sizeof(float)) << std::dec;
+  key << '\n'
+      << "mask: " << wmh.do_msk;
+  if (wmh.do_msk)
+    key << " checksum " << std::hex << checksum(msk_3d, vol.Nvox*sizeof(bool)) << std::dec;
+  key << '\n';
+  return key.str();
+}
 
-    if ( ( wm.val[ i ] = new (nothrow) float [ NITEMS[kOS][ i ] ]) == NULL) 
+Succeeded
+ProjMatrixByBinSPECTUB::
+write_weight_file(const std::string& filename, const std::string& key) const
+{
+  using namespace SPECTUB;
+
+  WeightFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, weight_file_magic, sizeof(header.magic));
+  header.byte_order = weight_file_byte_order_marker;
+  header.index_size = sizeof(int);
+  header.num_subsets = prj.NOS;
+  header.num_rows_per_subset = prj.NbOS;
+  header.key_size = key.size();
+  header.row_start_offset = sizeof(header) + padded_size(key.size());
+  header.voxel_index_offset =
+    header.row_start_offset + (header.num_subsets*header.num_rows_per_subset + 1)*sizeof(boost::uint64_t);
+  // num_elements and value_offset are only known when all subsets are written
+
+  // write to a temporary file first, such that other processes never see a partial file.
+  // Its name has to be unique, as other processes could be writing the same weights.
+  std::string tmp_filename;
+  {
+    // the process id distinguishes processes on the same machine, the time and
+    // clock make a collision between processes on different machines sharing the
+    // directory unlikely, and the counter distinguishes calls within one process
+    static unsigned long num_calls = 0;
+    std::ostringstream tmp_filename_stream;
+    tmp_filename_stream << filename << ".tmp." << get_process_id() << '.'
+                        << std::hex << static_cast<unsigned long>(std::time(0)) << '.'
+                        << static_cast<unsigned long>(std::clock()) << '.'
+                        << num_calls++;
+    tmp_filename = tmp_filename_stream.str();
+  }
+  // the values are written to a second file while the voxel indices are written,
+  // and appended at the end
+  const std::string tmp_values_filename = tmp_filename + ".values";
+  {
+    std::ofstream fst(tmp_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    std::ofstream values_fst(tmp_values_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fst || !values_fst)
       {
-        //error_wm_SPECT( 200, "wm.val[][]" );
-        error("Error allocating space to store values for SPECTUB matrix");
+        warning(boost::format("ProjMatrixByBinSPECTUB: error opening %1% for writing") % tmp_filename);
+        fst.close();
+        values_fst.close();
+        std::remove(tmp_filename.c_str());
+        std::remove(tmp_values_filename.c_str());
+        return Succeeded::no;
       }
-
-    if ( ( wm.col[ i ] = new (nothrow) int   [ NITEMS[kOS][ i ] ]) == NULL) 
+    const char zeroes[8] = {0};
+    std::vector<boost::uint64_t> file_row_start(static_cast<std::size_t>(prj.NOS)*prj.NbOS + 1, 0);
+    // placeholders for the header and row starts, which are written at the end
+    fst.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fst.write(key.data(), static_cast<std::streamsize>(key.size()));
+    fst.write(zeroes, static_cast<std::streamsize>(padded_size(key.size()) - key.size()));
+    fst.write(reinterpret_cast<const char *>(&file_row_start[0]),
+              static_cast<std::streamsize>(file_row_start.size()*sizeof(boost::uint64_t)));
+
+    // Subsets that are not in memory are computed here, one at a time.
+    for (int kOS=0; kOS<prj.NOS && fst && values_fst; ++kOS)
       {
-        //error_wm_SPECT( 200, "wm.col[]" );
-        error("Error allocating space to store column indices for SPECTUB matrix");
+        SubsetWeights computed_weights;
+        if (this->subset_weights[kOS].row_start.empty())
+          this->compute_one_subset(kOS, computed_weights);
+        const SubsetWeights& weights =
+          this->subset_weights[kOS].row_start.empty() ? computed_weights : this->subset_weights[kOS];
+        for (int i=0; i<prj.NbOS; ++i)
+          file_row_start[static_cast<std::size_t>(kOS)*prj.NbOS + i] = header.num_elements + weights.row_start[i];
+        if (!weights.voxel_index.empty())
+          {
+            fst.write(reinterpret_cast<const char *>(&weights.voxel_index[0]),
+                      static_cast<std::streamsize>(weights.voxel_index.size()*sizeof(int)));
+            values_fst.write(reinterpret_cast<const char *>(&weights.value[0]),
+                             static_cast<std::streamsize>(weights.value.size()*sizeof(float)));
+          }
+        header.num_elements += weights.value.size();
+      }
+    file_row_start.back() = header.num_elements;
+    header.value_offset =
+      header.voxel_index_offset + padded_size(header.num_elements*sizeof(int));
+    fst.write(zeroes, static_cast<std::streamsize>(padded_size(header.num_elements*sizeof(int)) - header.num_elements*sizeof(int)));
+
+    // append the values
+    values_fst.close();
+    if (fst && values_fst && header.num_elements > 0)
+      {
+        std::ifstream values_in(tmp_values_filename.c_str(), std::ios::in | std::ios::binary);
+        fst << values_in.rdbuf();
+      }
+    std::remove(tmp_values_filename.c_str());
+
+    fst.seekp(0);
+    fst.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fst.seekp(static_cast<std::streamoff>(header.row_start_offset));
+    fst.write(reinterpret_cast<const char *>(&file_row_start[0]),
+              static_cast<std::streamsize>(file_row_start.size()*sizeof(boost::uint64_t)));
+    fst.seekp(0, std::ios::end);
+    if (!fst || !values_fst ||
+        static_cast<boost::uint64_t>(fst.tellp()) != header.value_offset + header.num_elements*sizeof(float))
+      {
+        warning(boost::format("ProjMatrixByBinSPECTUB: error writing %1%") % tmp_filename);
+        fst.close();
+        std::remove(tmp_filename.c_str());
+        return Succeeded::no;
       }
   }
-
-  //... to initialize wm to zero ......................
-
-  for ( int i = 0 ; i < wm.NbOS ; i++ ){
-
-    wm.ne[ i ] = 0;
-
-    for( int j = 0 ; j < NITEMS[kOS][ i ] ; j++ ){
-
-      wm.val[ i ][ j ] = (float)0.;
-      wm.col[ i ][ j ] = 0;
-    }
-  }
-  wm.ne[ wm.NbOS ] = 0;
-
-  //... wm calculation for this subset ...........................
-
-  wm_calculation ( kOS, ang, vox, bin, vol, prj, attmap, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS[kOS] );
-  info(boost::format("Weight matrix calculation done. time %1% (s)") % timer.value(),
-       2);
-
-  //... fill lor .........................
-
-  for( int j = 0 ; j < wm.NbOS ; j++ ){
-    ProjMatrixElemsForOneBin lor;
-    Bin bin;
-    bin.segment_num()=0;	
-    bin.view_num()=wm.na [ j ];	
-    bin.axial_pos_num()=wm.ns [ j ];	
-    bin.tangential_pos_num()=wm.nb [ j ];	
-    bin.set_bin_value(0);
-    lor.set_bin(bin);
-
-    lor.reserve(wm.ne[ j ]);
-    for ( int i = 0 ; i < wm.ne[ j ] ; i++ ){
-
-      const ProjMatrixElemsForOneBin::value_type 
-        elem(Coordinate3D<int>(wm.nz[ wm.col[ j ][ i ] ],wm.ny[ wm.col[ j ][ i ] ],wm.nx[ wm.col[ j ][ i ] ]), wm.val[ j ][ i ]);      
-      lor.push_back( elem);	
+  // On POSIX systems, rename replaces an existing file atomically. On other systems, it fails
+  // if the file exists, e.g. when another process stored the same weights in the mean time.
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+      std::remove(tmp_filename.c_str());
+      if (std::ifstream(filename.c_str(), std::ios::in | std::ios::binary))
+        {
+          // map_weight_file() will check if it is the right file
+          info(boost::format("ProjMatrixByBinSPECTUB: %1% was already created by another process") % filename);
+          return Succeeded::yes;
+        }
+      warning(boost::format("ProjMatrixByBinSPECTUB: error renaming %1% to %2%") % tmp_filename % filename);
+      return Succeeded::no;
     }
+  info(boost::format("Stored SPECTUB weights in %1%") % filename);
+  return Succeeded::yes;
+}
 
-    delete [] wm.val[ j ];
-    delete [] wm.col[ j ];
+Succeeded
+ProjMatrixByBinSPECTUB::
+map_weight_file(const std::string& filename, const std::string& key)
+{
+  using namespace SPECTUB;
 
-    this->cache_proj_matrix_elems_for_one_bin(lor);
+  {
+    // check if the file exists (it is not an error if it doesn't)
+    std::ifstream fst(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!fst)
+      return Succeeded::no;
   }
+  try
+    {
+      this->weight_file_mapping_sptr.reset(new boost::interprocess::file_mapping(filename.c_str(),
+                                                                                boost::interprocess::read_only));
+      this->weight_region_sptr.reset(new boost::interprocess::mapped_region(*this->weight_file_mapping_sptr,
+                                                                           boost::interprocess::read_only));
+    }
+  catch (boost::interprocess::interprocess_exception& e)
+    {
+      warning(boost::format("ProjMatrixByBinSPECTUB: error mapping %1%: %2%") % filename % e.what());
+      this->weight_region_sptr.reset();
+      this->weight_file_mapping_sptr.reset();
+      return Succeeded::no;
+    }
 
-  info(boost::format("Total time after transfering to ProjMatrixElemsForOneBin. time %1% (s)") % timer.value(),
-       2);
+  const char * const data = static_cast<const char *>(this->weight_region_sptr->get_address());
+  const std::size_t data_size = this->weight_region_sptr->get_size();
+  const WeightFileHeader * const header_ptr = reinterpret_cast<const WeightFileHeader *>(data);
+  const char * problem = 0;
+  if (data_size < sizeof(WeightFileHeader) ||
+      std::memcmp(header_ptr->magic, weight_file_magic, sizeof(header_ptr->magic)) != 0)
+    problem = "is not a SPECTUB weight file";
+  else if (header_ptr->byte_order != weight_file_byte_order_marker || header_ptr->index_size != sizeof(int))
+    problem = "was written on a system with a different byte order or integer size";
+  else if (header_ptr->key_size != key.size() ||
+           sizeof(WeightFileHeader) + key.size() > data_size ||
+           key.compare(0, key.size(), data + sizeof(WeightFileHeader), key.size()) != 0)
+    problem = "was written with different parameters (checksum collision?)";
+  else if (header_ptr->num_subsets != static_cast<boost::uint64_t>(prj.NOS) ||
+           header_ptr->num_rows_per_subset != static_cast<boost::uint64_t>(prj.NbOS) ||
+           header_ptr->row_start_offset % sizeof(boost::uint64_t) != 0 ||
+           header_ptr->voxel_index_offset % sizeof(int) != 0 ||
+           header_ptr->value_offset % sizeof(float) != 0 ||
+           header_ptr->value_offset + header_ptr->num_elements*sizeof(float) > data_size)
+    problem = "has an invalid size (file truncated?)";
+
+  if (problem != 0)
+    {
+      warning(boost::format("ProjMatrixByBinSPECTUB: %1% %2%. Weights will be recomputed.") % filename % problem);
+      this->weight_region_sptr.reset();
+      this->weight_file_mapping_sptr.reset();
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
 
+// add the weights with voxel indices as in the UB library to the lor
+static void
+add_weights_to_lor(ProjMatrixElemsForOneBin& lor,
+                   const int * voxel_index, const float * value, const std::size_t num_elements,
+                   const SPECTUB::volume_type& vol)
+{
+  // centered indices for STIR format
+  const int x_offset = static_cast<int>(floor(vol.Ncold2));
+  const int y_offset = static_cast<int>(floor(vol.Nrowd2));
+  lor.reserve(num_elements);
+  for (std::size_t i = 0; i < num_elements; ++i)
+    {
+      const int iv = voxel_index[i];
+      const int islc = iv / vol.Npix;
+      const int ip = iv - islc*vol.Npix;
+      const int irow = ip / vol.Ncol;
+      const int icol = ip - irow*vol.Ncol;
+      lor.push_back(ProjMatrixElemsForOneBin::value_type(Coordinate3D<int>(islc, irow - y_offset, icol - x_offset),
+                                                         value[i]));
+    }
 }
+
 void 
 ProjMatrixByBinSPECTUB::
 calculate_proj_matrix_elems_for_one_bin(ProjMatrixElemsForOneBin& lor
 					) const
 {
-  //error("ProjMatrixByBinSPECTUB element not found in cache (and hence file)");
+  lor.erase();
 
-  const int view_num=lor.get_bin().view_num();
-  // find which "UB-subset" this view is in
+  const Bin bin_of_lor = lor.get_bin();
+  // find which "UB-subset" this view is in, and its position in that subset
   int kOS=0;
-  for (kOS=0; kOS<prj.NOS; ++kOS)
+  int row=0;
+  {
+    int i=0;
+    for (i=0; i<prj.Nang; ++i)
+      {
+        if (prj.order[i] == bin_of_lor.view_num())
+          break;
+      }
+    if (i == prj.Nang)
+      return;
+    const int ib = bin_of_lor.tangential_pos_num() + static_cast<int>(prj.Nbind2);
+    if (ib < 0 || ib >= prj.Nbin || bin_of_lor.axial_pos_num() < 0 || bin_of_lor.axial_pos_num() >= prj.Nsli)
+      return;
+    kOS = i / prj.NangOS;
+    // see wm_calculation()
+    row = (i % prj.NangOS) * prj.Nbp + bin_of_lor.axial_pos_num() * prj.Nbin + ib;
+  }
+
+  if (!is_null_ptr(this->weight_region_sptr))
     {
-      // see initialisation of wmh.index
-      if (prj.order[kOS] == view_num)
-	break;
+      const char * const data = static_cast<const char *>(this->weight_region_sptr->get_address());
+      const WeightFileHeader& header = *reinterpret_cast<const WeightFileHeader *>(data);
+      const boost::uint64_t * const row_start =
+        reinterpret_cast<const boost::uint64_t *>(data + header.row_start_offset) +
+        static_cast<std::size_t>(kOS) * prj.NbOS + row;
+      add_weights_to_lor(lor,
+                         reinterpret_cast<const int *>(data + header.voxel_index_offset) + row_start[0],
+                         reinterpret_cast<const float *>(data + header.value_offset) + row_start[0],
+                         static_cast<std::size_t>(row_start[1] - row_start[0]),
+                         vol);
+      return;
     }
+
+  if (!this->compute_subsets_on_demand)
+    {
+      // all subsets were computed by set_up()
+      const SubsetWeights& weights = this->subset_weights[kOS];
+      const int start = weights.row_start[row];
+      if (weights.row_start[row+1] > start)
+        add_weights_to_lor(lor, &weights.voxel_index[start], &weights.value[start],
+                           weights.row_start[row+1] - start, vol);
+      return;
+    }
+
 #ifdef STIR_OPENMP
 #pragma omp critical(PROJMATRIXBYBINUBONEVIEW)
 #endif
-  if (!subset_already_processed[kOS])
-    {
-      if (!this->keep_all_views_in_cache)
-	{
-	  this->clear_cache();
-	  subset_already_processed.assign(prj.NOS,false);
-	}
-      info(boost::format("Computing matrix elements for view %1%") % view_num,
-        2);
-      compute_one_subset(kOS);
-      subset_already_processed[kOS]=true;
-    }
-  lor.erase();
+  {
+    if (this->subset_weights[kOS].row_start.empty())
+      {
+        // only keep a single subset in memory
+        this->clear_cache();
+        this->subset_weights.clear();
+        this->subset_weights.resize(prj.NOS);
+        info(boost::format("Computing matrix elements for view %1%") % bin_of_lor.view_num(),
+             2);
+        this->compute_one_subset(kOS, this->subset_weights[kOS]);
+      }
+    const SubsetWeights& weights = this->subset_weights[kOS];
+    const int start = weights.row_start[row];
+    if (weights.row_start[row+1] > start)
+      add_weights_to_lor(lor, &weights.voxel_index[start], &weights.value[start],
+                         weights.row_start[row+1] - start, vol);
+  }
 }
 
 END_NAMESPACE_STIR
-
@@ -56,6 +56,7 @@
 #include "stir/modulo.h"
 #include "stir/stream.h"
 #include <algorithm>
+#include <vector>
 #include <math.h>
 #include <boost/format.hpp>
 
@@ -384,20 +385,19 @@ static inline int sign(const T& t)
   return t<0 ? -1 : 1;
 }
 
-// just do 1 LOR, returns true if lor is not empty
-static void
-ray_trace_one_lor(ProjMatrixElemsForOneBin& lor, 
-                  const float s_in_mm, const float t_in_mm, 
-                  const float cphi, const float sphi, 
-                  const float costheta, const float tantheta, 
-                  const float offset_in_z,
-                  const float fovrad_in_mm,
-                  const CartesianCoordinate3D<float>& voxel_size,
-                  const bool restrict_to_cylindrical_FOV,
-                  const int num_LORs)
+// find the end-points of 1 LOR (in voxel units) in the order in which it should be ray traced,
+// returns false if the LOR does not intersect the FOV
+static bool
+get_start_and_stop_point(CartesianCoordinate3D<float>& ordered_start_point,
+                         CartesianCoordinate3D<float>& ordered_stop_point,
+                         const float s_in_mm, const float t_in_mm, 
+                         const float cphi, const float sphi, 
+                         const float costheta, const float tantheta, 
+                         const float offset_in_z,
+                         const float fovrad_in_mm,
+                         const CartesianCoordinate3D<float>& voxel_size,
+                         const bool restrict_to_cylindrical_FOV)
 {
-  assert(lor.size() == 0);
-
   /* Find Intersection points of LOR and image FOV (assuming infinitely long scanner)*/
   /* (in voxel units) */
   CartesianCoordinate3D<float> start_point;  
@@ -415,9 +415,9 @@ ray_trace_one_lor(ProjMatrixElemsForOneBin& lor,
     if (restrict_to_cylindrical_FOV)
     {
 #ifdef STIR_PMRT_LARGER_FOV
-      if (fabs(s_in_mm) >= fovrad_in_mm) return;
+      if (fabs(s_in_mm) >= fovrad_in_mm) return false;
 #else
-      if (fabs(s_in_mm) > fovrad_in_mm) return;
+      if (fabs(s_in_mm) > fovrad_in_mm) return false;
 #endif
       // a has to be such that X^2+Y^2 == fovrad^2      
       if (fabs(s_in_mm) == fovrad_in_mm) 
@@ -442,7 +442,7 @@ ray_trace_one_lor(ProjMatrixElemsForOneBin& lor,
       if (fabs(cphi) < 1.E-3 || fabs(sphi) < 1.E-3) 
       {
         if (fovrad_in_mm < fabs(s_in_mm))
-          return;
+          return false;
         max_a = fovrad_in_mm;
         min_a = -fovrad_in_mm;
       }
@@ -453,7 +453,7 @@ ray_trace_one_lor(ProjMatrixElemsForOneBin& lor,
         min_a = max((-fovrad_in_mm*sign(sphi) - s_in_mm*cphi)/sphi,
                     (-fovrad_in_mm*sign(cphi) + s_in_mm*sphi)/cphi);
         if (min_a > max_a - 1.E-3*voxel_size.x())
-          return;
+          return false;
       }
       
     } //!restrict_to_cylindrical_FOV
@@ -499,33 +499,62 @@ ray_trace_one_lor(ProjMatrixElemsForOneBin& lor,
         (start_point.y() == stop_point.y() &&
          (start_point.x() <= stop_point.x()))));
 
-    // do actual ray tracing for this LOR
+    ordered_start_point = from_start_to_stop? start_point : stop_point;
+    ordered_stop_point = !from_start_to_stop? start_point : stop_point;
+    return true;
+  }
+
+}
+
+// just do 1 LOR
+static void
+ray_trace_one_lor(ProjMatrixElemsForOneBin& lor, 
+                  const float s_in_mm, const float t_in_mm, 
+                  const float cphi, const float sphi, 
+                  const float costheta, const float tantheta, 
+                  const float offset_in_z,
+                  const float fovrad_in_mm,
+                  const CartesianCoordinate3D<float>& voxel_size,
+                  const bool restrict_to_cylindrical_FOV,
+                  const int num_LORs)
+{
+  assert(lor.size() == 0);
+
+  CartesianCoordinate3D<float> start_point;  
+  CartesianCoordinate3D<float> stop_point;
+  if (!get_start_and_stop_point(start_point, stop_point,
+                                s_in_mm, t_in_mm, 
+                                cphi, sphi, costheta, tantheta, 
+                                offset_in_z, fovrad_in_mm, 
+                                voxel_size,
+                                restrict_to_cylindrical_FOV))
+    return;
+
+  // do actual ray tracing for this LOR
     
-    RayTraceVoxelsOnCartesianGrid(lor, 
-                                  from_start_to_stop? start_point : stop_point,
-                                  !from_start_to_stop? start_point : stop_point,
-                                  voxel_size,
+  RayTraceVoxelsOnCartesianGrid(lor, 
+                                start_point,
+                                stop_point,
+                                voxel_size,
 #ifdef NEWSCALE
-                                  1.F/num_LORs // normalise to mm
+                                1.F/num_LORs // normalise to mm
 #else
-                                  1/voxel_size.x()/num_LORs // normalise to some kind of 'pixel units'
+                                1/voxel_size.x()/num_LORs // normalise to some kind of 'pixel units'
 #endif
-           );
+                                );
 
 #ifndef NDEBUG
-    {
-      // TODO output is still not sorted... why?
+  {
+    // TODO output is still not sorted... why?
 
-      //ProjMatrixElemsForOneBin sorted_lor = lor;
-      //sorted_lor.sort();
-      //assert(lor == sorted_lor);
-      lor.check_state();
-    }
-#endif
-    return;
+    //ProjMatrixElemsForOneBin sorted_lor = lor;
+    //sorted_lor.sort();
+    //assert(lor == sorted_lor);
+    lor.check_state();
   }
-
+#endif
 }
+
 //////////////////////////////////////
 void 
 ProjMatrixByBinUsingRayTracing::
@@ -687,7 +716,11 @@ calculate_proj_matrix_elems_for_one_bin(
   }
   else
   {
-    ProjMatrixElemsForOneBin ray_traced_lor;
+    // find all LORs first, such that they can be ray traced (and merged) in one go
+    std::vector<CartesianCoordinate3D<float> > start_points;
+    std::vector<CartesianCoordinate3D<float> > stop_points;
+    start_points.reserve(num_tangential_LORs);
+    stop_points.reserve(num_tangential_LORs);
 
     // get_sampling_in_s returns sampling in interleaved case
     // interleaved case has a sampling which is twice as high
@@ -698,16 +731,27 @@ calculate_proj_matrix_elems_for_one_bin(
         s_in_mm - s_inc*(num_tangential_LORs-1)/2.F;
     for (int s_LOR_num=1; s_LOR_num<=num_tangential_LORs; ++s_LOR_num, current_s_in_mm+=s_inc)
     {
-      ray_traced_lor.erase();
-      ray_trace_one_lor(ray_traced_lor, current_s_in_mm, t_in_mm, 
-                          cphi, sphi, costheta, tantheta, 
-                          offset_in_z, fovrad_in_mm, 
-                          voxel_size,
-                          restrict_to_cylindrical_FOV,
-                          num_lors_per_axial_pos*num_tangential_LORs);
-      //std::cerr << "ray traced size " << ray_traced_lor.size() << std::endl;
-      lor.merge(ray_traced_lor);
+      CartesianCoordinate3D<float> start_point;  
+      CartesianCoordinate3D<float> stop_point;
+      if (get_start_and_stop_point(start_point, stop_point,
+                                   current_s_in_mm, t_in_mm, 
+                                   cphi, sphi, costheta, tantheta, 
+                                   offset_in_z, fovrad_in_mm, 
+                                   voxel_size,
+                                   restrict_to_cylindrical_FOV))
+        {
+          start_points.push_back(start_point);
+          stop_points.push_back(stop_point);
+        }
     }
+    RayTraceVoxelsOnCartesianGrid(lor, start_points, stop_points,
+                                  voxel_size,
+#ifdef NEWSCALE
+                                  1.F/(num_lors_per_axial_pos*num_tangential_LORs) // normalise to mm
+#else
+                                  1/voxel_size.x()/(num_lors_per_axial_pos*num_tangential_LORs) // normalise to some kind of 'pixel units'
+#endif
+                                  );
   }
       
   // now add on other LORs in axial direction
@@ -738,30 +782,27 @@ calculate_proj_matrix_elems_for_one_bin(
         else
 #endif
           { 
-            // make copy of LOR that will be used to add adjacent z
-            ProjMatrixElemsForOneBin lor_with_next_z = lor;
+            const int num_elements_in_one_lor = static_cast<int>(lor.size());
             // reserve enough memory to avoid reallocations
             lor.reserve(lor.size()*num_lors_per_axial_pos);
-            // now add adjacent z
+            // now append copies of the LOR with adjacent z
             for (int z_index=1; z_index<num_lors_per_axial_pos; ++z_index)
               {
-                // add 1 to each z in the LOR
-                ProjMatrixElemsForOneBin::iterator element_ptr = lor_with_next_z.begin();
-                const ProjMatrixElemsForOneBin::iterator element_end = lor_with_next_z.end();
-                while (element_ptr != element_end)
+                // add z_index to each z in the LOR
+                for (int i=0; i<num_elements_in_one_lor; ++i)
                   {
-                    *element_ptr = 
+                    const ProjMatrixElemsForOneBin::value_type element = *(lor.begin()+i);
+                    lor.push_back(
                       ProjMatrixElemsForOneBin::
                       value_type(
-                                 Coordinate3D<int>(element_ptr->coord1()+1,
-                                                   element_ptr->coord2(),
-                                                   element_ptr->coord3()),
-                                 element_ptr->get_value());
-                    ++element_ptr;
+                                 Coordinate3D<int>(element.coord1()+z_index,
+                                                   element.coord2(),
+                                                   element.coord3()),
+                                 element.get_value()));
                   }
-                // now merge it into the original
-                lor.merge(lor_with_next_z);
               }
+            // now merge them all at once
+            lor.merge_duplicates();
           }
       } // if( tantheta!=0 && num_lors_per_axial_pos>1)
   } //if (lor.size()!=0)
@@ -159,6 +159,26 @@ void ProjMatrixElemsForOneBin::sort()
 }
 
 
+void ProjMatrixElemsForOneBin::merge_duplicates()
+{
+  if (size()==0)
+    return;
+
+  std::stable_sort(begin(), end(), value_type::coordinates_less);
+
+  iterator last_unique_ptr = begin();
+  for (iterator element_ptr = begin()+1; element_ptr != end(); ++element_ptr)
+  {
+    if (value_type::coordinates_equal(*element_ptr, *last_unique_ptr))
+      *last_unique_ptr += *element_ptr;
+    else
+      *++last_unique_ptr = *element_ptr;
+  }
+  elements.erase(last_unique_ptr+1, end());
+  assert(check_state() == Succeeded::yes);
+}
+
+
 float ProjMatrixElemsForOneBin::square_sum() const
 {
   float sq_sum=0;
@@ -369,6 +389,34 @@ back_project(DiscretisedDensity<3,float>& density,
 }
 
 
+void 
+ProjMatrixElemsForOneBin::
+back_project_atomically(DiscretisedDensity<3,float>& density,   
+                        const Bin& single) const
+{   
+  const float data = single.get_bin_value() ;     
+  if (data == 0)
+    return;
+    
+  BasicCoordinate<3,int> coords;
+  const_iterator element_ptr = 
+    begin();
+  while (element_ptr != end())
+    {
+      coords = element_ptr->get_coords();
+      if (coords[1] >= density.get_min_index() && coords[1] <= density.get_max_index())
+        {
+          float& voxel = density[coords[1]][coords[2]][coords[3]];
+          const float value = element_ptr->get_value() * data;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+          voxel += value;
+        }
+      element_ptr++;            
+    }    
+}
+
 void 
 ProjMatrixElemsForOneBin::
 forward_project(Bin& single,
@@ -34,12 +34,13 @@
 #include "stir/IO/read_from_file.h"
 #include "stir/is_null_ptr.h"
 #include "stir/info.h"
+#include "stir/error.h"
 #include <algorithm>
+#include <vector>
+#include <cstddef>
 using std::min;
 using std::max;
 
-/* Pretty horrible code because we don't have an iterator of neigbhourhoods yet
- */
 
 START_NAMESPACE_STIR
 
@@ -207,206 +208,334 @@ compute_weights(Array<3,float>& weights, const CartesianCoordinate3D<float>& gri
 }
 
 template <typename elemT>
-double
+void
 QuadraticPrior<elemT>::
-compute_value(const DiscretisedDensity<3,elemT> &current_image_estimate)
+check_and_set_weights(const DiscretisedDensity<3,elemT> &current_image_estimate) const
 {
-  if (this->penalisation_factor==0)
-  {
-    return 0.;
-  }
-  
-  
-  const DiscretisedDensityOnCartesianGrid<3,elemT>& current_image_cast =
-    dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,elemT> &>(current_image_estimate);
-  
   if (this->weights.get_length() ==0)
   {
+    const DiscretisedDensityOnCartesianGrid<3,elemT>& current_image_cast =
+      dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,elemT> &>(current_image_estimate);
     compute_weights(this->weights, current_image_cast.get_grid_spacing(), this->only_2D);
   }
-    
-  const bool do_kappa = !is_null_ptr(kappa_ptr);
-  
-  if (do_kappa && !kappa_ptr->has_same_characteristics(current_image_estimate))
+
+  if (!is_null_ptr(kappa_ptr) && !kappa_ptr->has_same_characteristics(current_image_estimate))
     error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
+}
 
+/* Engine for computing sums over the neighbourhood of every voxel, used by
+   the value, gradient, curvature and Hessian computations of QuadraticPrior.
 
-  double result = 0.;
-  const int min_z = current_image_estimate.get_min_index(); 
-  const int max_z = current_image_estimate.get_max_index(); 
-  for (int z=min_z; z<=max_z; z++)
+   This is specific to QuadraticPrior: it only handles priors that are a sum of
+   pairwise terms weighted by QuadraticPrior::weights (and kappa). PLSPrior works
+   with finite-difference image gradients instead, and has its own (OpenMP) loops.
+
+   For every voxel r, voxel_function.begin_voxel() is called, then 
+   voxel_function.add_neighbour(w, image[r], image[r+dr]) for all dr in the 
+   neighbourhood (with w = weights[dr] * kappa[r] * kappa[r+dr]), and finally
+   voxel_function.end_voxel(z,y,x).
+
+   For voxels whose complete neighbourhood is inside the image, this uses precomputed
+   offsets into the (contiguous) image, and skips zero weights. Other voxels are
+   handled by checking the index range for every neighbour.
+
+   When compiled with OpenMP, planes are distributed over threads. Every thread works
+   with a copy of voxel_function, which is added to \a voxel_function at the end
+   by calling voxel_function.reduce(copy).
+*/
+template <typename elemT, typename VoxelFunctionT>
+static void
+apply_to_neighbourhoods(VoxelFunctionT& voxel_function,
+                        const Array<3,float>& weights,
+                        const Array<3,elemT>& image,
+                        const Array<3,elemT>* const kappa_ptr)
+{
+  const int min_z = image.get_min_index(); 
+  const int max_z = image.get_max_index(); 
+  const int weights_min_dz = weights.get_min_index();
+  const int weights_max_dz = weights.get_max_index();
+  const int weights_min_dy = weights[0].get_min_index();
+  const int weights_max_dy = weights[0].get_max_index();
+  const int weights_min_dx = weights[0][0].get_min_index();
+  const int weights_max_dx = weights[0][0].get_max_index();
+
+  // set-up offsets for voxels away from the edges
+  const bool use_offsets =
+    image.is_regular() && image.is_contiguous() && image.size_all()>0 &&
+    (kappa_ptr==0 || kappa_ptr->is_contiguous());
+  std::vector<std::ptrdiff_t> offsets;
+  std::vector<float> offset_weights;
+  std::ptrdiff_t size_y = 0, size_x = 0;
+  const elemT * image_data_ptr = 0;
+  const elemT * kappa_data_ptr = 0;
+  if (use_offsets)
     {
-      const int min_dz = max(weights.get_min_index(), min_z-z);
-      const int max_dz = min(weights.get_max_index(), max_z-z);
-        
-      const int min_y = current_image_estimate[z].get_min_index();
-      const int max_y = current_image_estimate[z].get_max_index();
+      size_y = image[min_z].get_length();
+      size_x = image[min_z][image[min_z].get_min_index()].get_length();
+      for (int dz=weights_min_dz;dz<=weights_max_dz;++dz)
+        for (int dy=weights_min_dy;dy<=weights_max_dy;++dy)
+          for (int dx=weights_min_dx;dx<=weights_max_dx;++dx)
+            if (weights[dz][dy][dx] != 0)
+              {
+                offsets.push_back((dz*size_y + dy)*size_x + dx);
+                offset_weights.push_back(weights[dz][dy][dx]);
+              }
+      image_data_ptr = image.get_const_full_data_ptr();
+      if (kappa_ptr!=0)
+        kappa_data_ptr = kappa_ptr->get_const_full_data_ptr();
+    }
+  const std::size_t num_offsets = offsets.size();
+
+#ifdef STIR_OPENMP
+#pragma omp parallel
+#endif
+  {
+    VoxelFunctionT local_voxel_function(voxel_function);
+    local_voxel_function.reset();
+
+#ifdef STIR_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int z=min_z; z<=max_z; z++)
+      {
+        const int min_dz = max(weights_min_dz, min_z-z);
+        const int max_dz = min(weights_max_dz, max_z-z);
+
+        const int min_y = image[z].get_min_index();
+        const int max_y = image[z].get_max_index();
 
         for (int y=min_y;y<= max_y;y++)
           {
-            const int min_dy = max(weights[0].get_min_index(), min_y-y);
-            const int max_dy = min(weights[0].get_max_index(), max_y-y);            
-
-            const int min_x = current_image_estimate[z][y].get_min_index(); 
-            const int max_x = current_image_estimate[z][y].get_max_index(); 
+            const int min_dy = max(weights_min_dy, min_y-y);
+            const int max_dy = min(weights_max_dy, max_y-y);
+
+            const int min_x = image[z][y].get_min_index(); 
+            const int max_x = image[z][y].get_max_index(); 
+
+            // find range of x where the neighbourhood is inside the image
+            int first_inner_x = max_x+1;
+            int last_inner_x = max_x;
+            if (use_offsets &&
+                min_dz==weights_min_dz && max_dz==weights_max_dz &&
+                min_dy==weights_min_dy && max_dy==weights_max_dy)
+              {
+                first_inner_x = min_x-weights_min_dx;
+                last_inner_x = max_x-weights_max_dx;
+              }
 
-            for (int x=min_x;x<= max_x;x++)       
+            for (int x=min_x;x<= max_x;x++)
               {
-                const int min_dx = max(weights[0][0].get_min_index(), min_x-x);
-                const int max_dx = min(weights[0][0].get_max_index(), max_x-x);
-                
-                /* formula:
-                  sum_dx,dy,dz
-                   1/4 weights[dz][dy][dx] *
-                   (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])^2 *
-                   (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                */
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
+                local_voxel_function.begin_voxel();
+                if (x>=first_inner_x && x<=last_inner_x)
+                  {
+                    const std::ptrdiff_t index =
+                      ((z-min_z)*size_y + (y-min_y))*size_x + (x-min_x);
+                    const elemT centre = image_data_ptr[index];
+                    if (kappa_data_ptr!=0)
                       {
-                        elemT current =
-                          weights[dz][dy][dx] *
-                          square(current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])/4;
-
-                        if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        result += static_cast<double>(current);
+                        const elemT kappa_centre = kappa_data_ptr[index];
+                        for (std::size_t i=0; i<num_offsets; ++i)
+                          local_voxel_function.add_neighbour(offset_weights[i] *
+                                                             (kappa_centre * kappa_data_ptr[index+offsets[i]]),
+                                                             centre, image_data_ptr[index+offsets[i]]);
                       }
-              }              
+                    else
+                      {
+                        for (std::size_t i=0; i<num_offsets; ++i)
+                          local_voxel_function.add_neighbour(offset_weights[i],
+                                                             centre, image_data_ptr[index+offsets[i]]);
+                      }
+                  }
+                else
+                  {
+                    const int min_dx = max(weights_min_dx, min_x-x);
+                    const int max_dx = min(weights_max_dx, max_x-x);
+                    const elemT centre = image[z][y][x];
+                    for (int dz=min_dz;dz<=max_dz;++dz)
+                      for (int dy=min_dy;dy<=max_dy;++dy)
+                        for (int dx=min_dx;dx<=max_dx;++dx)
+                          {
+                            float weight = weights[dz][dy][dx];
+                            if (kappa_ptr!=0)
+                              weight *= (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+                            local_voxel_function.add_neighbour(weight, centre, image[z+dz][y+dy][x+dx]);
+                          }
+                  }
+                local_voxel_function.end_voxel(z,y,x);
+              }
           }
-    }
-  return result * this->penalisation_factor;
+      }
+#ifdef STIR_OPENMP
+#pragma omp critical(STIRQUADRATICPRIORREDUCE)
+#endif
+    voxel_function.reduce(local_voxel_function);
+  }
 }
 
+/* Function object for use in apply_to_neighbourhoods() that computes
+   the value, and possibly the gradient and the parabolic surrogate curvature of the quadratic prior
+   (without the penalisation factor), i.e. for every voxel r
+   value += sum_dr w_dr (image[r]-image[r+dr])^2/4
+   gradient[r] = sum_dr w_dr (image[r]-image[r+dr])
+   curvature[r] = sum_dr w_dr
+
+   gradient and curvature are only computed if the corresponding pointers are non-zero.
+*/
 template <typename elemT>
-void 
+class QuadraticPriorTerms
+{
+public:
+  QuadraticPriorTerms(const float penalisation_factor,
+                      Array<3,elemT> * const gradient_ptr,
+                      Array<3,elemT> * const curvature_ptr)
+    : penalisation_factor(penalisation_factor),
+      gradient_ptr(gradient_ptr), curvature_ptr(curvature_ptr),
+      value(0)
+  {}
+
+  void reset() { value = 0; }
+  void reduce(const QuadraticPriorTerms& other) { value += other.value; }
+
+  void begin_voxel()
+  {
+    gradient = 0;
+    curvature = 0;
+  }
+  void add_neighbour(const float weight, const elemT centre, const elemT neighbour)
+  {
+    const elemT diff = centre - neighbour;
+    value += static_cast<double>(weight * square(diff)/4);
+    gradient += weight * diff;
+    curvature += weight;
+  }
+  void end_voxel(const int z, const int y, const int x)
+  {
+    if (gradient_ptr != 0)
+      (*gradient_ptr)[z][y][x] = gradient * penalisation_factor;
+    if (curvature_ptr != 0)
+      (*curvature_ptr)[z][y][x] = curvature * penalisation_factor;
+  }
+
+  double get_value() const { return value * penalisation_factor; }
+
+private:
+  float penalisation_factor;
+  Array<3,elemT> * gradient_ptr;
+  Array<3,elemT> * curvature_ptr;
+  double value;
+  elemT gradient;
+  elemT curvature;
+};
+
+/* Function object for use in apply_to_neighbourhoods() for
+   add_multiplication_with_approximate_Hessian(), i.e. for every voxel r
+   output[r] += sum_dr w_dr input[r+dr]
+*/
+template <typename elemT>
+class QuadraticPriorApproximateHessianMultiplication
+{
+public:
+  QuadraticPriorApproximateHessianMultiplication(const float penalisation_factor,
+                                                 Array<3,elemT>& output)
+    : penalisation_factor(penalisation_factor), output(output)
+  {}
+
+  void reset() {}
+  void reduce(const QuadraticPriorApproximateHessianMultiplication&) {}
+
+  void begin_voxel()
+  { result = 0; }
+  void add_neighbour(const float weight, const elemT, const elemT neighbour)
+  { result += weight * neighbour; }
+  void end_voxel(const int z, const int y, const int x)
+  { output[z][y][x] += result * penalisation_factor; }
+
+private:
+  float penalisation_factor;
+  Array<3,elemT>& output;
+  elemT result;
+};
+
+template <typename elemT>
+double
 QuadraticPrior<elemT>::
-compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient, 
-                 const DiscretisedDensity<3,elemT> &current_image_estimate)
+compute_value(const DiscretisedDensity<3,elemT> &current_image_estimate)
 {
-  assert(  prior_gradient.has_same_characteristics(current_image_estimate));  
   if (this->penalisation_factor==0)
   {
-    prior_gradient.fill(0);
-    return;
+    return 0.;
   }
   
-  
-  const DiscretisedDensityOnCartesianGrid<3,elemT>& current_image_cast =
-    dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,elemT> &>(current_image_estimate);
-  
-  if (this->weights.get_length() ==0)
+  this->check_and_set_weights(current_image_estimate);
+
+  /* formula:
+     sum_dx,dy,dz
+       1/4 weights[dz][dy][dx] *
+       (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])^2 *
+       (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+  */
+  QuadraticPriorTerms<elemT> terms(this->penalisation_factor, 0, 0);
+  apply_to_neighbourhoods(terms, this->weights, current_image_estimate, this->kappa_ptr.get());
+  return terms.get_value();
+}
+
+template <typename elemT>
+double
+QuadraticPrior<elemT>::
+compute_value_gradient_and_curvature(DiscretisedDensity<3,elemT>& prior_gradient, 
+                                     DiscretisedDensity<3,elemT>& parabolic_surrogate_curvature, 
+                                     const DiscretisedDensity<3,elemT> &current_image_estimate)
+{
+  assert(prior_gradient.has_same_characteristics(current_image_estimate));  
+  assert(parabolic_surrogate_curvature.has_same_characteristics(current_image_estimate));  
+  if (this->penalisation_factor==0)
   {
-    compute_weights(this->weights, current_image_cast.get_grid_spacing(), this->only_2D);
+    prior_gradient.fill(0);
+    parabolic_surrogate_curvature.fill(0);
+    return 0.;
   }
- 
- 
-  
-  const bool do_kappa = !is_null_ptr(kappa_ptr);
-  if (do_kappa && !kappa_ptr->has_same_characteristics(current_image_estimate))
-    error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
-  const int min_z = current_image_estimate.get_min_index();  
-  const int max_z = current_image_estimate.get_max_index();  
-  for (int z=min_z; z<=max_z; z++) 
-    { 
-      const int min_dz = max(weights.get_min_index(), min_z-z); 
-      const int max_dz = min(weights.get_max_index(), max_z-z); 
-      
-      const int min_y = current_image_estimate[z].get_min_index(); 
-      const int max_y = current_image_estimate[z].get_max_index(); 
-      
-      for (int y=min_y;y<= max_y;y++) 
-        { 
-          const int min_dy = max(weights[0].get_min_index(), min_y-y); 
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);             
-          
-          const int min_x = current_image_estimate[z][y].get_min_index();
-          const int max_x = current_image_estimate[z][y].get_max_index();  
-          
-          for (int x=min_x;x<= max_x;x++)
-            {
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x);
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x);
-                
-                /* formula:
-                  sum_dx,dy,dz
-                   weights[dz][dy][dx] *
-                   (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]) *
-                   (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                */
-#if 1
-                elemT gradient = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] *
-                          (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]);
+  this->check_and_set_weights(current_image_estimate);
 
-                        if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+  QuadraticPriorTerms<elemT> terms(this->penalisation_factor, &prior_gradient, &parabolic_surrogate_curvature);
+  apply_to_neighbourhoods(terms, this->weights, current_image_estimate, this->kappa_ptr.get());
+  return terms.get_value();
+}
 
-                        gradient += current;
-                      }
-#else
-                // attempt to speed up by precomputing the sum of weights.
-                // The current code gives identical results but is actually slower
-                // than the above, at least when kappas are present.
-
-
-                // precompute sum of weights
-                // TODO without kappas, this is just weights.sum() most of the time, 
-                // but not near edges
-                float sum_of_weights = 0;
-                {
-                  if (do_kappa)
-                    {                
-                      for (int dz=min_dz;dz<=max_dz;++dz)
-                        for (int dy=min_dy;dy<=max_dy;++dy)
-                          for (int dx=min_dx;dx<=max_dx;++dx)
-                            sum_of_weights +=  weights[dz][dy][dx]*(*kappa_ptr)[z+dz][y+dy][x+dx];
-                    }
-                  else
-                    {
-                      for (int dz=min_dz;dz<=max_dz;++dz)
-                        for (int dy=min_dy;dy<=max_dy;++dy)
-                          for (int dx=min_dx;dx<=max_dx;++dx)
-                            sum_of_weights +=  weights[dz][dy][dx];
-                    }
-                }
-                // now compute contribution of central term
-                elemT gradient = sum_of_weights * current_image_estimate[z][y][x] ;
-
-                // subtract the rest
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] * current_image_estimate[z+dz][y+dy][x+dx];
+template <typename elemT>
+void 
+QuadraticPrior<elemT>::
+compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient, 
+                 const DiscretisedDensity<3,elemT> &current_image_estimate)
+{
+  assert(  prior_gradient.has_same_characteristics(current_image_estimate));  
+  if (this->penalisation_factor==0)
+  {
+    prior_gradient.fill(0);
+    return;
+  }
 
-                        if (do_kappa)
-                          current *= (*kappa_ptr)[z+dz][y+dy][x+dx];
+  this->check_and_set_weights(current_image_estimate);
 
-                        gradient -= current;
-                      }
-                // multiply with central kappa
-                if (do_kappa)
-                  gradient *= (*kappa_ptr)[z][y][x];
-#endif
-                prior_gradient[z][y][x]= gradient * this->penalisation_factor;
-              }              
-          }
-    }
+  /* formula:
+     sum_dx,dy,dz
+       weights[dz][dy][dx] *
+       (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]) *
+       (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+  */
+  QuadraticPriorTerms<elemT> terms(this->penalisation_factor, &prior_gradient, 0);
+  apply_to_neighbourhoods(terms, this->weights, current_image_estimate, this->kappa_ptr.get());
 
   info(boost::format("Prior gradient max %1%, min %2%\n") % prior_gradient.find_max() % prior_gradient.find_min());
 
+  this->write_gradient_if_requested(prior_gradient);
+}
+
+template <typename elemT>
+void
+QuadraticPrior<elemT>::
+write_gradient_if_requested(const DiscretisedDensity<3,elemT>& prior_gradient) const
+{
   static int count = 0;
   ++count;
   if (gradient_filename_prefix.size()>0)
@@ -418,6 +547,21 @@ compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient,
     }
 }
 
+template <typename elemT>
+void
+QuadraticPrior<elemT>::
+compute_gradient_and_parabolic_surrogate_curvature(DiscretisedDensity<3,elemT>& prior_gradient,
+                                                   DiscretisedDensity<3,elemT>& parabolic_surrogate_curvature,
+                                                   const DiscretisedDensity<3,elemT> &current_image_estimate)
+{
+  this->compute_value_gradient_and_curvature(prior_gradient, parabolic_surrogate_curvature, current_image_estimate);
+
+  info(boost::format("Prior gradient max %1%, min %2%\n") % prior_gradient.find_max() % prior_gradient.find_min());
+  info(boost::format("parabolic_surrogate_curvature max %1%, min %2%\n") % parabolic_surrogate_curvature.find_max() % parabolic_surrogate_curvature.find_min());
+
+  this->write_gradient_if_requested(prior_gradient);
+}
+
 template <typename elemT>
 void 
 QuadraticPrior<elemT>::
@@ -433,22 +577,12 @@ compute_Hessian(DiscretisedDensity<3,elemT>& prior_Hessian_for_single_densel,
   }
   
   
-  const DiscretisedDensityOnCartesianGrid<3,elemT>& current_image_cast =
-    dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,elemT> &>(current_image_estimate);
-  
   DiscretisedDensityOnCartesianGrid<3,elemT>& prior_Hessian_for_single_densel_cast =
     dynamic_cast<DiscretisedDensityOnCartesianGrid<3,elemT> &>(prior_Hessian_for_single_densel);
 
-  if (weights.get_length() ==0)
-  {
-    compute_weights(weights, current_image_cast.get_grid_spacing(), this->only_2D);
-  }
- 
+  this->check_and_set_weights(current_image_estimate);
    
   const bool do_kappa = !is_null_ptr(kappa_ptr);
-  
-  if (do_kappa && kappa_ptr->has_same_characteristics(current_image_estimate))
-    error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
   const int z = coords[1];
   const int y = coords[2];
@@ -495,62 +629,11 @@ QuadraticPrior<elemT>::parabolic_surrogate_curvature(DiscretisedDensity<3,elemT>
     return;
   }
   
-  
-  const DiscretisedDensityOnCartesianGrid<3,elemT>& current_image_cast =
-    dynamic_cast< const DiscretisedDensityOnCartesianGrid<3,elemT> &>(current_image_estimate);
-  
-  if (weights.get_length() ==0)
-  {
-    compute_weights(weights, current_image_cast.get_grid_spacing(), this->only_2D);
-  }  
-   
-  const bool do_kappa = !is_null_ptr(kappa_ptr);
-  
-  if (do_kappa && !kappa_ptr->has_same_characteristics(current_image_estimate))
-    error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
-
-  const int min_z = current_image_estimate.get_min_index();   
-  const int max_z = current_image_estimate.get_max_index();   
-  for (int z=min_z; z<=max_z; z++)  
-    {  
-      const int min_dz = max(weights.get_min_index(), min_z-z);  
-      const int max_dz = min(weights.get_max_index(), max_z-z);  
-       
-      const int min_y = current_image_estimate[z].get_min_index();  
-      const int max_y = current_image_estimate[z].get_max_index();  
-       
-      for (int y=min_y;y<= max_y;y++)  
-        {  
-          const int min_dy = max(weights[0].get_min_index(), min_y-y);  
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);              
-           
-          const int min_x = current_image_estimate[z][y].get_min_index(); 
-          const int max_x = current_image_estimate[z][y].get_max_index();   
-          for (int x=min_x;x<= max_x;x++) 
-            { 
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x); 
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x); 
-                
-                elemT gradient = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        // 1 comes from omega = psi'(t)/t = 2*t/2t =1                  
-                        elemT current =
-                          weights[dz][dy][dx] *1;
+  this->check_and_set_weights(current_image_estimate);
 
-                         if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        gradient += current;
-                      }
-                
-                parabolic_surrogate_curvature[z][y][x]= gradient * this->penalisation_factor;
-              }              
-          }
-    }
+  // sum of weights (times kappas), as omega = psi'(t)/t = 2*t/2t =1
+  QuadraticPriorTerms<elemT> terms(this->penalisation_factor, 0, &parabolic_surrogate_curvature);
+  apply_to_neighbourhoods(terms, this->weights, current_image_estimate, this->kappa_ptr.get());
 
   info(boost::format("parabolic_surrogate_curvature max %1%, min %2%\n") % parabolic_surrogate_curvature.find_max() % parabolic_surrogate_curvature.find_min());
   /*{
@@ -577,60 +660,10 @@ add_multiplication_with_approximate_Hessian(DiscretisedDensity<3,elemT>& output,
     return Succeeded::yes;
   }
   
-  DiscretisedDensityOnCartesianGrid<3,elemT>& output_cast =
-    dynamic_cast<DiscretisedDensityOnCartesianGrid<3,elemT> &>(output);
+  this->check_and_set_weights(input);
 
-  if (weights.get_length() ==0)
-  {
-    compute_weights(weights, output_cast.get_grid_spacing(), this->only_2D);
-  }  
-   
-  const bool do_kappa = !is_null_ptr(kappa_ptr);
-  
-  if (do_kappa && !kappa_ptr->has_same_characteristics(input))
-    error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
-
-  const int min_z = output.get_min_index();   
-  const int max_z = output.get_max_index();   
-  for (int z=min_z; z<=max_z; z++)  
-    {  
-      const int min_dz = max(weights.get_min_index(), min_z-z);  
-      const int max_dz = min(weights.get_max_index(), max_z-z);  
-      
-      const int min_y = output[z].get_min_index();  
-      const int max_y = output[z].get_max_index();  
-       
-      for (int y=min_y;y<= max_y;y++)  
-        {  
-          const int min_dy = max(weights[0].get_min_index(), min_y-y);  
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);              
-           
-          const int min_x = output[z][y].get_min_index(); 
-          const int max_x = output[z][y].get_max_index();   
-
-          for (int x=min_x;x<= max_x;x++) 
-            { 
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x); 
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x); 
-                
-                elemT result = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] * input[z+dz][y+dy][x+dx];
-
-                         if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                         result += current;
-                      }
-                
-                output[z][y][x] += result * this->penalisation_factor;
-            }              
-        }
-    }
+  QuadraticPriorApproximateHessianMultiplication<elemT> multiplication(this->penalisation_factor, output);
+  apply_to_neighbourhoods(multiplication, this->weights, input, this->kappa_ptr.get());
   return Succeeded::yes;
 }
 
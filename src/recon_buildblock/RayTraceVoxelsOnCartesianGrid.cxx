@@ -43,6 +43,7 @@
 #include "stir/round.h"
 #include <math.h>
 #include <algorithm>
+#include <vector>
 
 #ifndef STIR_NO_NAMESPACE
 using std::min;
@@ -275,4 +276,43 @@ const float axend = zero_diff_in_x ? d12*1000000.F : (xmax - start_point.x()) *
     }	// end of while (a<amax)           
   }
 }
+
+void 
+RayTraceVoxelsOnCartesianGrid
+        (ProjMatrixElemsForOneBin& lor, 
+         const std::vector<CartesianCoordinate3D<float> >& start_points, 
+         const std::vector<CartesianCoordinate3D<float> >& stop_points, 
+         const CartesianCoordinate3D<float>& voxel_size,
+         const float normalisation_constant)
+{
+  assert(start_points.size() == stop_points.size());
+  if (start_points.size() == 0)
+    return;
+
+  // trace every LOR separately and append them all, then add duplicate voxels
+  // with a single sort (i.e. only the merging is batched)
+  ProjMatrixElemsForOneBin all_lors(lor.get_bin());
+  ProjMatrixElemsForOneBin one_lor(lor.get_bin());
+  for (std::size_t i=0; i<start_points.size(); ++i)
+    {
+      // note: we ray trace in a separate object, as RayTraceVoxelsOnCartesianGrid
+      // sorts its lor in some cases, which would change the order of addition
+      one_lor.erase();
+      RayTraceVoxelsOnCartesianGrid(one_lor, start_points[i], stop_points[i],
+                                    voxel_size, normalisation_constant);
+      if (i==0)
+        all_lors.reserve(one_lor.size()*start_points.size());
+      for (ProjMatrixElemsForOneBin::const_iterator iter = one_lor.begin();
+           iter != one_lor.end();
+           ++iter)
+        all_lors.push_back(*iter);
+    }
+  all_lors.merge_duplicates();
+
+  if (lor.size() == 0)
+    std::swap(lor, all_lors);
+  else
+    lor.merge(all_lors);
+}
+
 END_NAMESPACE_STIR
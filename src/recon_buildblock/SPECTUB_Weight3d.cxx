@@ -53,6 +53,8 @@ using namespace std;
 //==========================================================================
 
 void wm_calculation( const int kOS,
+					const int *const angle_index,
+					wm_da_type& wm,
 					const angle_type *const ang, 
 					voxel_type vox, 
 				        bin_type bin, 
@@ -126,7 +128,7 @@ void wm_calculation( const int kOS,
 		
 		for ( int j = 0 ; j < prj.NangOS ; j++ ){
 			
-			j1 = wmh.index[ j ];			
+			j1 = angle_index[ j ];			
 			
 			for ( int k = 0 ; k < prj.Nsli ; k++ ){
 				
@@ -167,7 +169,7 @@ void wm_calculation( const int kOS,
 			
 			for( int k = 0 ; k < prj.NangOS ; k++ ){
 				
-				int ka = wmh.index[ k ];			// angle index of the current projection (considering the whole set of projections)
+				int ka = angle_index[ k ];			// angle index of the current projection (considering the whole set of projections)
 						
 				//... perpendicular distance form voxel to detection plane ...........................
 				
@@ -309,6 +311,7 @@ void wm_calculation( const int kOS,
 //=============================================================================
 
 void wm_size_estimation (int kOS,
+						 const int *const angle_index,
 						 const angle_type * const ang, 
 						 voxel_type vox, 
 						 bin_type bin, 
@@ -372,7 +375,7 @@ void wm_size_estimation (int kOS,
 			
 			for( int k = 0 ; k < prj.NangOS ; k++ ){
 				
-				int ka = wmh.index[ k ];			// angle index of the current projection (considering the whole set of projections)
+				int ka = angle_index[ k ];			// angle index of the current projection (considering the whole set of projections)
 				
 				//... perpendicular distance form voxel to detection plane ...........................
 				
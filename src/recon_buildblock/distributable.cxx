@@ -45,6 +45,7 @@
 #include "stir/recon_buildblock/distributable.h"
 #include "stir/RelatedViewgrams.h"
 #include "stir/ProjData.h"
+#include "stir/ProjDataFromStream.h"
 #include "stir/ExamInfo.h"
 #include "stir/DiscretisedDensity.h"
 #include "stir/ViewSegmentNumbers.h"
@@ -161,6 +162,15 @@ zero_end_sinograms(ViewgramsPtr viewgrams_ptr)
     }
 }
 
+//! check if \a proj_data can be read by several threads without a critical section
+static bool
+has_thread_safe_reads(const ProjData& proj_data)
+{
+  const ProjDataFromStream * const proj_data_from_stream_ptr =
+    dynamic_cast<const ProjDataFromStream *>(&proj_data);
+  return proj_data_from_stream_ptr != 0 && proj_data_from_stream_ptr->has_positional_reads();
+}
+
 static
 void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
                    shared_ptr<RelatedViewgrams<float> >& additive_binwise_correction_viewgrams,
@@ -176,7 +186,13 @@ void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
                    const ViewSegmentNumbers& view_segment_num
                    )
 {
-  if (!is_null_ptr(binwise_correction))
+  if (!is_null_ptr(binwise_correction) && has_thread_safe_reads(*binwise_correction))
+    {
+      additive_binwise_correction_viewgrams.reset(
+        new RelatedViewgrams<float>
+        (binwise_correction->get_related_viewgrams(view_segment_num, symmetries_ptr)));
+    }
+  else if (!is_null_ptr(binwise_correction))
     {
 #ifdef STIR_OPENMP
 #pragma omp critical(ADDSINO)
@@ -192,7 +208,12 @@ void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
 #endif
     }
                         
-  if (read_from_proj_dat)
+  if (read_from_proj_dat && has_thread_safe_reads(*proj_dat_ptr))
+    {
+      y.reset(new RelatedViewgrams<float>
+	      (proj_dat_ptr->get_related_viewgrams(view_segment_num, symmetries_ptr)));
+    }
+  else if (read_from_proj_dat)
     {
 #ifdef STIR_OPENMP
 #pragma omp critical(VIEW)
@@ -220,9 +241,17 @@ void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
 				new RelatedViewgrams<float>(proj_dat_ptr->get_empty_related_viewgrams(view_segment_num, symmetries_ptr)));
       mult_viewgrams_sptr->fill(1.F);
 #ifdef STIR_OPENMP
+      // no need to serialise if the factors were precomputed by distributable_computation()
+      if (normalisation_sptr->is_thread_safe_for_time_frame(start_time_of_frame,end_time_of_frame))
+        normalisation_sptr->undo(*mult_viewgrams_sptr,start_time_of_frame,end_time_of_frame);
+      else
+        {
 #pragma omp critical(MULT)
-#endif
+          normalisation_sptr->undo(*mult_viewgrams_sptr,start_time_of_frame,end_time_of_frame);
+        }
+#else
       normalisation_sptr->undo(*mult_viewgrams_sptr,start_time_of_frame,end_time_of_frame);
+#endif
     }
                         
   if (view_segment_num.segment_num()==0 && zero_seg0_end_planes)
@@ -317,7 +346,13 @@ void distributable_computation(
     }
 
   distributed::send_int_value(task_id, -1);
+#endif
 
+  // compute (time-dependent) normalisation factors before any parallel loop
+  if (!is_null_ptr(normalisation_sptr) && !normalisation_sptr->is_trivial())
+    normalisation_sptr->precompute_for_time_frame(start_time_of_frame, end_time_of_frame);
+
+#ifdef STIR_MPI
   if (caching_info_ptr != NULL)
     {
       distributable_computation_cache_enabled(
@@ -401,9 +436,19 @@ void distributable_computation(
   int count=0, count2=0;
   
 #ifdef STIR_MPI
+  /* Every slave gets up to 2 work packages at a time, such that it can start on the
+     next one as soon as it finishes the current one, while the master reads and sends
+     the package after that. Afterwards, packages are sent to whichever slave reports
+     that it has finished one, so faster slaves get more work.
+  */
+  const int max_num_packages_per_slave=2;
   int sent_count=0;                     //counts the work packages sent 
-  int working_slaves_count=0; //counts the number of slaves which are currently working
+  int working_slaves_count=0; //counts the number of packages which are currently sent out
   int next_receiver=1;          //always stores the next slave to be provided with work
+#ifdef STIR_MPI_TIMINGS
+  HighResWallClockTimer waiting_timer; //measures the time the master waits for slaves
+  waiting_timer.reset();
+#endif
 #endif
   //double total_seq_rpc_time=0.0; //sums up times used for RPC_process_related_viewgrams
 
@@ -450,13 +495,19 @@ void distributable_computation(
           sent_count++;
     
           //give every slave some work before waiting for requests 
-          if (sent_count < distributed::num_processors-1) // note: -1 as master doesn't get any viewgrams
-            next_receiver++;
+          if (sent_count < max_num_packages_per_slave*(distributed::num_processors-1)) // note: -1 as master doesn't get any viewgrams
+            next_receiver = sent_count % (distributed::num_processors-1) + 1;
           else 
             {
               //wait for available notification
               int int_values[2];
+#ifdef STIR_MPI_TIMINGS
+              waiting_timer.start();
+#endif
               const MPI_Status status=distributed::receive_int_values(int_values, 2, AVAILABLE_NOTIFICATION_TAG);
+#ifdef STIR_MPI_TIMINGS
+              waiting_timer.stop();
+#endif
               next_receiver=status.MPI_SOURCE;
               working_slaves_count--;
         
@@ -525,6 +576,9 @@ void distributable_computation(
 
   // receive remaining available notifications
   {
+#ifdef STIR_MPI_TIMINGS
+    waiting_timer.start();
+#endif
     while(working_slaves_count>0)
       {
         int int_values[2];
@@ -535,7 +589,16 @@ void distributable_computation(
         count+=int_values[0];
         count2+=int_values[1];
       }
+#ifdef STIR_MPI_TIMINGS
+    waiting_timer.stop();
+#endif
   }
+  // all packages are processed, so all viewgrams have arrived
+  distributed::wait_for_pending_sends();
+#ifdef STIR_MPI_TIMINGS
+  if (distributed::test_send_receive_times)
+    std::cout << "Master: waited " << waiting_timer.value() << " seconds for slaves to finish work packages" << std::endl;
+#endif
   distributed::first_iteration=false;   
         
   //broadcast end of iteration notification
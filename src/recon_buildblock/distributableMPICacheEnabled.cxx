@@ -334,6 +334,8 @@ void distributable_computation_cache_enabled(
       count+=int_values[0];
       count2+=int_values[1];
     }
+  // all packages are processed, so all viewgrams have arrived
+  distributed::wait_for_pending_sends();
         
   // in the cache-enabled distributed case, this message is only printed once per iteration
   // TODO this message relies on knowledge of count, count2 which might be inappropriate for 
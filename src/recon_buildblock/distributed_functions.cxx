@@ -38,6 +38,8 @@
 #include "stir/Succeeded.h"
 #include "stir/error.h"
 #include <boost/shared_array.hpp>
+#include <list>
+#include <vector>
 
 using std::ios;
 
@@ -67,6 +69,31 @@ namespace distributed
   int sizes[6]; //array for receiving image dimensions          
         
   stir::HighResWallClockTimer t;
+
+  namespace {
+    //! a non-blocking send together with its buffer, which has to be kept until the send is complete
+    struct PendingSend
+    {
+      MPI_Request request;
+      boost::shared_array<float> buffer;
+    };
+    std::list<PendingSend> pending_sends;
+
+    //! free the buffers of the sends that are complete, without waiting for the others
+    void free_completed_sends()
+    {
+      std::list<PendingSend>::iterator iter = pending_sends.begin();
+      while (iter != pending_sends.end())
+        {
+          int completed = 0;
+          MPI_Test(&iter->request, &completed, MPI_STATUS_IGNORE);
+          if (completed)
+            iter = pending_sends.erase(iter);
+          else
+            ++iter;
+        }
+    }
+  }
                 
         
   //--------------------------------------Send Operations-------------------------------------
@@ -334,20 +361,71 @@ namespace distributed
         
   void send_related_viewgrams(stir::RelatedViewgrams<float>* viewgrams, int destination)
   {
-    //broadcast count of viewgrams to be received
+    //send count of viewgrams to be received
     int num_viewgrams=viewgrams->get_num_viewgrams();
-                
-    //run through viewgrams     
-    stir::RelatedViewgrams<float>::iterator viewgrams_iter = viewgrams->begin();
-    const stir::RelatedViewgrams<float>::iterator viewgrams_end = viewgrams->end();
-
     send_int_values(&num_viewgrams, 1, VIEWGRAM_COUNT_TAG, destination);
-                
-    while (viewgrams_iter!= viewgrams_end)
-      { 
-        send_viewgram(*viewgrams_iter, destination);
-        ++viewgrams_iter;
-      }
+
+    //send dimensions of all viewgrams (axial and tangential positions and the view and segment numbers)
+    std::vector<int> viewgram_values(6*num_viewgrams);
+    int buffer_size=0;
+    {
+      int *values_ptr = &viewgram_values[0];
+      for (stir::RelatedViewgrams<float>::iterator viewgrams_iter = viewgrams->begin();
+           viewgrams_iter != viewgrams->end();
+           ++viewgrams_iter, values_ptr += 6)
+        {
+          values_ptr[0] = viewgrams_iter->get_min_axial_pos_num();
+          values_ptr[1] = viewgrams_iter->get_max_axial_pos_num();
+          values_ptr[2] = viewgrams_iter->get_min_tangential_pos_num();
+          values_ptr[3] = viewgrams_iter->get_max_tangential_pos_num();
+          values_ptr[4] = viewgrams_iter->get_view_num();
+          values_ptr[5] = viewgrams_iter->get_segment_num();
+          buffer_size += (values_ptr[1]-values_ptr[0]+1)*(values_ptr[3]-values_ptr[2]+1);
+        }
+    }
+    send_int_values(&viewgram_values[0], 6*num_viewgrams, VIEWGRAM_DIMENSIONS_TAG, destination);
+
+    //serialise all viewgrams into one send-buffer
+    boost::shared_array<float> viewgrams_buf(new float[buffer_size]);
+    {
+      float *buf_ptr = viewgrams_buf.get();
+      for (stir::RelatedViewgrams<float>::iterator viewgrams_iter = viewgrams->begin();
+           viewgrams_iter != viewgrams->end();
+           ++viewgrams_iter)
+        buf_ptr = std::copy(viewgrams_iter->begin_all(), viewgrams_iter->end_all(), buf_ptr);
+    }
+
+    //send array without waiting for the receiver
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) {t.reset(); t.start();} 
+#endif
+
+    free_completed_sends();
+    pending_sends.push_back(PendingSend());
+    pending_sends.back().buffer = viewgrams_buf;
+    MPI_Isend(viewgrams_buf.get(), buffer_size, MPI_FLOAT, destination, VIEWGRAM_TAG, MPI_COMM_WORLD,
+              &pending_sends.back().request);
+
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) t.stop();
+    if (test_send_receive_times && t.value()>min_threshold) std::cout << "Master: starting to send related viewgrams took " << t.value() << " seconds" << std::endl;
+#endif
+  }
+
+  void wait_for_pending_sends()
+  {
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) {t.reset(); t.start();} 
+#endif
+    for (std::list<PendingSend>::iterator iter = pending_sends.begin();
+         iter != pending_sends.end();
+         ++iter)
+      MPI_Wait(&iter->request, MPI_STATUS_IGNORE);
+    pending_sends.clear();
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) t.stop();
+    if (test_send_receive_times && t.value()>min_threshold) std::cout << "Waiting for pending sends took " << t.value() << " seconds" << std::endl;
+#endif
   }
         
   void send_viewgram(const stir::Viewgram<float>& viewgram, int destination)
@@ -675,24 +753,69 @@ namespace distributed
                                                const stir::shared_ptr<stir::DataSymmetriesForViewSegmentNumbers> symmetries_sptr,
                                                int source)
   {
+#ifdef STIR_MPI_TIMINGS
+    // note: cannot use t here, as it is used by receive_int_values
+    stir::HighResWallClockTimer fulltimer;
+    if (test_send_receive_times) {fulltimer.reset(); fulltimer.start();} 
+#endif
+    RelatedViewgramsReceive receive;
+    start_receive_related_viewgrams(receive, source);
+    complete_receive_related_viewgrams(viewgrams, receive, proj_data_info_ptr, symmetries_sptr);
+
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) fulltimer.stop();
+    if (test_send_receive_times && fulltimer.value()>min_threshold) std::cout << "Slave: received related viewgrams after " << fulltimer.value() << " seconds" << std::endl;
+#endif
+  }
+
+  void start_receive_related_viewgrams(RelatedViewgramsReceive& receive, int source)
+  {
     //receive count of viewgrams
-    int int_values[1];
-    status=distributed::receive_int_values(int_values, 1, VIEWGRAM_COUNT_TAG);
-        
+    int num_viewgrams;
+    status=distributed::receive_int_values(&num_viewgrams, 1, VIEWGRAM_COUNT_TAG);
+
+    //receive dimensions of all viewgrams (values 0-3) and view_num + segment_num (values 4-5)
+    receive.viewgram_values.resize(6*num_viewgrams);
+    status=distributed::receive_int_values(&receive.viewgram_values[0], 6*num_viewgrams, VIEWGRAM_DIMENSIONS_TAG);
+
+    int buffer_size=0;
+    for (int i=0; i<num_viewgrams; i++)
+      {
+        const int *values_ptr = &receive.viewgram_values[6*i];
+        buffer_size += (values_ptr[1]-values_ptr[0]+1)*(values_ptr[3]-values_ptr[2]+1);
+      }
+
+    //start receiving values of all viewgrams
+    receive.buffer.resize(buffer_size);
+    MPI_Irecv(&receive.buffer[0], buffer_size, MPI_FLOAT, source, VIEWGRAM_TAG, MPI_COMM_WORLD, &receive.request);
+  }
+
+  void complete_receive_related_viewgrams(stir::RelatedViewgrams<float>*& viewgrams, 
+                                          RelatedViewgramsReceive& receive,
+                                          const stir::shared_ptr<stir::ProjDataInfo>& proj_data_info_ptr, 
+                                          const stir::shared_ptr<stir::DataSymmetriesForViewSegmentNumbers> symmetries_sptr)
+  {
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) {t.reset(); t.start();} 
+#endif
+    MPI_Wait(&receive.request, &status);
+#ifdef STIR_MPI_TIMINGS
+    if (test_send_receive_times) t.stop();
+    if (test_send_receive_times && t.value()>min_threshold) std::cout << "Slave: waited " << t.value() << " seconds for viewgram values" << std::endl;
+#endif
+
+    const int num_viewgrams = static_cast<int>(receive.viewgram_values.size()/6);
     std::vector<stir::Viewgram<float> > viewgrams_vector;
-                
-    viewgrams_vector.reserve(int_values[0]);
-        
-    for (int i=0; i<int_values[0]; i++) 
+    viewgrams_vector.reserve(num_viewgrams);
+    const float *buf_ptr = &receive.buffer[0];
+    for (int i=0; i<num_viewgrams; i++) 
       { 
-        stir::Viewgram<float>* vg = NULL;
-                        
-        //receive a viewgram from Master
-        receive_and_construct_viewgram(vg, proj_data_info_ptr, source);
-                                                
-        //add viewgram to Viewgram-vector
-        viewgrams_vector.push_back(*vg);        
-        delete vg;          
+        const int *values_ptr = &receive.viewgram_values[6*i];
+        viewgrams_vector.push_back(stir::Viewgram<float>(proj_data_info_ptr, values_ptr[4], values_ptr[5]));
+        stir::Viewgram<float>& viewgram = viewgrams_vector.back();
+        const int size = (values_ptr[1]-values_ptr[0]+1)*(values_ptr[3]-values_ptr[2]+1);
+        std::copy(buf_ptr, buf_ptr+size, viewgram.begin_all());
+        buf_ptr += size;
       }
                 
     //use viewgram-vector and symmetries-pointer to construct related viewgrams element
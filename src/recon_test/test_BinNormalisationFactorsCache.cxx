@@ -0,0 +1,217 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::BinNormalisationFactorsCache
+*/
+
+#include "stir/recon_buildblock/BinNormalisationFactorsCache.h"
+#include "stir/recon_buildblock/TrivialDataSymmetriesForBins.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/RelatedViewgrams.h"
+#include "stir/Scanner.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <algorithm>
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for BinNormalisationFactorsCache
+
+  Uses a simple class that computes a factor from the bin coordinates and the
+  start time of the frame, and counts how often this is done.
+  Checks that get_bin_efficiency(), apply() and undo() give the same results
+  with and without the cache, that the factors are computed only once for
+  time-independent factors, and recomputed for a new time frame otherwise.
+  With OpenMP, it also checks that the cache is not filled inside a parallel region.
+*/
+class BinNormalisationFactorsCacheTests : public RunTests
+{
+public:
+  void run_tests();
+
+  //! the function that the cache calls to compute a factor
+  float compute_bin_efficiency(const Bin& bin, const double start_time, const double) const
+  {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+    ++num_computations;
+    return static_cast<float>(1 + bin.segment_num()*.1 + bin.view_num() + bin.axial_pos_num()*.01 +
+                              bin.tangential_pos_num()*.001 + start_time);
+  }
+
+private:
+  mutable int num_computations;
+  shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  shared_ptr<DataSymmetriesForViewSegmentNumbers> symmetries_sptr;
+
+  //! check all functions of the cache for this time frame
+  void check_cache(BinNormalisationFactorsCache& cache, const double start_time, const double end_time);
+};
+
+void
+BinNormalisationFactorsCacheTests::
+check_cache(BinNormalisationFactorsCache& cache, const double start_time, const double end_time)
+{
+  for (int segment_num = proj_data_info_sptr->get_min_segment_num();
+       segment_num <= proj_data_info_sptr->get_max_segment_num();
+       ++segment_num)
+    for (int view_num = proj_data_info_sptr->get_min_view_num();
+         view_num <= proj_data_info_sptr->get_max_view_num();
+         ++view_num)
+      {
+        const ViewSegmentNumbers vs(view_num, segment_num);
+        RelatedViewgrams<float> viewgrams =
+          proj_data_info_sptr->get_empty_related_viewgrams(vs, symmetries_sptr);
+        viewgrams.fill(2.F);
+        RelatedViewgrams<float> applied_viewgrams = viewgrams;
+        cache.apply(applied_viewgrams, *this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency,
+                    start_time, end_time);
+        RelatedViewgrams<float> undone_viewgrams = viewgrams;
+        cache.undo(undone_viewgrams, *this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency,
+                   start_time, end_time);
+
+        Bin bin(segment_num, view_num, 0, 0);
+        for (bin.axial_pos_num() = proj_data_info_sptr->get_min_axial_pos_num(segment_num);
+             bin.axial_pos_num() <= proj_data_info_sptr->get_max_axial_pos_num(segment_num);
+             ++bin.axial_pos_num())
+          for (bin.tangential_pos_num() = proj_data_info_sptr->get_min_tangential_pos_num();
+               bin.tangential_pos_num() <= proj_data_info_sptr->get_max_tangential_pos_num();
+               ++bin.tangential_pos_num())
+            {
+              const float efficiency = this->compute_bin_efficiency(bin, start_time, end_time);
+              const float cached_efficiency =
+                cache.get_bin_efficiency(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency,
+                                         bin, start_time, end_time);
+              if (!check_if_equal(efficiency, cached_efficiency, "get_bin_efficiency") ||
+                  !check_if_equal(2.F/std::max(1.E-20F, efficiency),
+                                  (*applied_viewgrams.begin())[bin.axial_pos_num()][bin.tangential_pos_num()],
+                                  "apply") ||
+                  !check_if_equal(2.F*efficiency,
+                                  (*undone_viewgrams.begin())[bin.axial_pos_num()][bin.tangential_pos_num()],
+                                  "undo"))
+                {
+                  cerr << "Current bin: segment = " << bin.segment_num()
+                       << ", axial pos " << bin.axial_pos_num()
+                       << ", view = " << bin.view_num()
+                       << ", tangential_pos_num = " << bin.tangential_pos_num() << "\n";
+                  return;
+                }
+            }
+      }
+}
+
+void
+BinNormalisationFactorsCacheTests::run_tests()
+{
+  cerr << "Tests for BinNormalisationFactorsCache\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  scanner_sptr->set_num_rings(5);
+  proj_data_info_sptr.reset(
+    ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                  /*span=*/3,
+                                  /*max_delta=*/4,
+                                  /*num_views=*/8,
+                                  /*num_tang_poss=*/16));
+  symmetries_sptr.reset(new TrivialDataSymmetriesForBins(proj_data_info_sptr));
+  int num_bins = 0;
+  for (int segment_num = proj_data_info_sptr->get_min_segment_num();
+       segment_num <= proj_data_info_sptr->get_max_segment_num();
+       ++segment_num)
+    num_bins += proj_data_info_sptr->get_num_views() *
+      proj_data_info_sptr->get_num_axial_poss(segment_num) *
+      proj_data_info_sptr->get_num_tangential_poss();
+
+  {
+    cerr << "\tTesting without caching\n";
+    BinNormalisationFactorsCache cache;
+    cache.set_up(*proj_data_info_sptr, /*enabled=*/false, /*time_dependent=*/false);
+    check(!cache.is_enabled(), "cache should not be enabled");
+    check(!cache.fill_if_necessary(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency, 0., 0.),
+          "disabled cache should not be filled");
+    check_cache(cache, 0., 1.);
+  }
+  {
+    cerr << "\tTesting time-independent factors\n";
+    BinNormalisationFactorsCache cache;
+    cache.set_up(*proj_data_info_sptr, /*enabled=*/true, /*time_dependent=*/false);
+    check(!cache.is_filled_for(0., 0.), "cache should not be filled after set_up");
+    num_computations = 0;
+    check(cache.fill_if_necessary(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency, 0., 0.),
+          "cache should be filled");
+    check_if_equal(num_computations, num_bins, "number of computed factors");
+    check(cache.is_filled_for(10., 20.), "time-independent cache should be filled for every frame");
+    // factors are computed for the first frame only
+    num_computations = 0;
+    cache.fill_if_necessary(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency, 10., 20.);
+    check_if_equal(num_computations, 0, "number of computed factors for another time frame");
+    check_cache(cache, 0., 0.);
+  }
+  {
+    cerr << "\tTesting time-dependent factors\n";
+    BinNormalisationFactorsCache cache;
+    cache.set_up(*proj_data_info_sptr, /*enabled=*/true, /*time_dependent=*/true);
+    check_cache(cache, 0., 10.);
+    check(cache.is_filled_for(0., 10.), "cache should be filled for the first frame");
+    check(!cache.is_filled_for(10., 20.), "cache should not be filled for the second frame");
+    check_cache(cache, 10., 20.);
+    check(cache.is_filled_for(10., 20.), "cache should be filled for the second frame");
+    num_computations = 0;
+    cache.fill_if_necessary(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency, 10., 20.);
+    check_if_equal(num_computations, 0, "number of computed factors for the same time frame");
+
+#ifdef STIR_OPENMP
+    cerr << "\tTesting time-dependent factors in a parallel region\n";
+    bool filled = true;
+#pragma omp parallel shared(cache, filled)
+    {
+#pragma omp single
+      {
+        filled = cache.fill_if_necessary(*this, &BinNormalisationFactorsCacheTests::compute_bin_efficiency, 20., 30.);
+        check_cache(cache, 20., 30.);
+      }
+    }
+    check(!filled, "cache should not be filled inside a parallel region");
+    check(cache.is_filled_for(10., 20.), "cache should still be filled for the second frame");
+#endif
+  }
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  BinNormalisationFactorsCacheTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -0,0 +1,157 @@
+//
+//
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::FourierRebinning
+
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/recon_buildblock/FourierRebinning.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ProjDataInfoCylindrical.h"
+#include "stir/ExamInfo.h"
+#include "stir/Scanner.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/Sinogram.h"
+#include "stir/Bin.h"
+#include "stir/Succeeded.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for FourierRebinning
+
+  Rebins data of an object that is constant along the scanner axis (a long
+  centred cylinder). All oblique sinograms of such an object are identical to
+  the direct ones, so FORE has to return the same sinogram in every plane.
+
+  We use a number of views that is not a power of 2 to check that the output
+  has the same number of views as the input.
+*/
+class FourierRebinningTests : public RunTests
+{
+public:
+  void run_tests();
+};
+
+void
+FourierRebinningTests::run_tests()
+{
+  std::cerr << "-------- Testing FourierRebinning --------\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  const int max_delta = 3;
+  const int num_views = 96;
+  shared_ptr<ProjDataInfo> proj_data_info_sptr
+    (ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                   /*span*/1, max_delta, num_views, /*tang_pos*/64, /*arc_corrected*/ true));
+  shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+  shared_ptr<ProjData> proj_data_sptr(new ProjDataInMemory(exam_info_sptr, proj_data_info_sptr));
+
+  // fill in the line integrals through a disk of radius 100mm
+  const float radius = 100.F;
+  for (int segment_num = proj_data_sptr->get_min_segment_num();
+       segment_num <= proj_data_sptr->get_max_segment_num();
+       ++segment_num)
+    {
+      SegmentBySinogram<float> segment = proj_data_sptr->get_empty_segment_by_sinogram(segment_num);
+      for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num(); ++axial_pos_num)
+        for (int view_num = segment.get_min_view_num(); view_num <= segment.get_max_view_num(); ++view_num)
+          for (int tang_pos_num = segment.get_min_tangential_pos_num(); tang_pos_num <= segment.get_max_tangential_pos_num(); ++tang_pos_num)
+            {
+              const float s =
+                proj_data_info_sptr->get_s(Bin(segment_num, view_num, axial_pos_num, tang_pos_num));
+              segment[axial_pos_num][view_num][tang_pos_num] =
+                s*s < radius*radius ? 2*std::sqrt(radius*radius - s*s) : 0.F;
+            }
+      proj_data_sptr->set_segment(segment);
+    }
+
+  const std::string output_filename_prefix = "test_FourierRebinning_output";
+  FourierRebinning fore;
+  fore.set_input_proj_data_sptr(proj_data_sptr);
+  fore.set_output_filename_prefix(output_filename_prefix);
+  fore.set_max_segment_num_to_process(max_delta);
+  fore.set_kmin(4);
+  fore.set_wmin(4);
+  fore.set_kc(4);
+  fore.set_deltamin(1);
+
+  check(fore.set_up() == Succeeded::yes, "FORE set_up");
+  check(fore.rebin() == Succeeded::yes, "FORE rebin");
+
+  shared_ptr<ProjData> rebinned_proj_data_sptr = ProjData::read_from_file(output_filename_prefix + ".hs");
+  {
+    const ProjDataInfoCylindrical& rebinned_proj_data_info =
+      dynamic_cast<const ProjDataInfoCylindrical&>(*rebinned_proj_data_sptr->get_proj_data_info_ptr());
+    check_if_equal(rebinned_proj_data_info.get_num_views(), num_views,
+                   "number of views of rebinned data");
+    check_if_equal(rebinned_proj_data_info.get_num_tangential_poss(), proj_data_info_sptr->get_num_tangential_poss(),
+                   "number of tangential positions of rebinned data");
+    check_if_equal(rebinned_proj_data_info.get_min_segment_num(), 0,
+                   "min segment number of rebinned data");
+    check_if_equal(rebinned_proj_data_info.get_max_segment_num(), 0,
+                   "max segment number of rebinned data");
+    check_if_equal(rebinned_proj_data_info.get_num_axial_poss(0), 2*scanner_sptr->get_num_rings()-1,
+                   "number of planes of rebinned data");
+    check_if_equal(rebinned_proj_data_info.get_max_ring_difference(0), max_delta,
+                   "max ring difference of rebinned data");
+  }
+
+  // all planes should contain the original direct sinogram
+  const SegmentBySinogram<float> original_segment = proj_data_sptr->get_segment_by_sinogram(0);
+  const SegmentBySinogram<float> rebinned_segment = rebinned_proj_data_sptr->get_segment_by_sinogram(0);
+  const float max_value = original_segment.find_max();
+  float max_diff = 0.F;
+  for (int axial_pos_num = rebinned_segment.get_min_axial_pos_num(); axial_pos_num <= rebinned_segment.get_max_axial_pos_num(); ++axial_pos_num)
+    {
+      Sinogram<float> diff = rebinned_segment.get_sinogram(axial_pos_num);
+      diff -= original_segment.get_sinogram(0);
+      max_diff = std::max(max_diff, std::max(diff.find_max(), -diff.find_min()));
+    }
+  check(max_diff < .001F*max_value,
+        "comparing rebinned sinograms with the original direct sinogram");
+  if (!is_everything_ok())
+    std::cerr << "Maximum difference " << max_diff << " (maximum in original " << max_value << ")\n";
+
+  std::remove((output_filename_prefix + ".hs").c_str());
+  std::remove((output_filename_prefix + ".s").c_str());
+  std::remove((output_filename_prefix + ".log").c_str());
+}
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main()
+{
+  FourierRebinningTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
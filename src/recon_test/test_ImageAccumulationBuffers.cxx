@@ -0,0 +1,218 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::ImageAccumulationBuffers and the parallel
+  stir::BackProjectorByBin::back_project() of a whole stir::ProjData
+*/
+
+#include "stir/recon_buildblock/ImageAccumulationBuffers.h"
+#include "stir/recon_buildblock/BackProjectorByBinUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/BackProjectorByBinUsingInterpolation.h"
+#include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
+#include "stir/recon_buildblock/find_basic_vs_nums_in_subsets.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/SegmentByView.h"
+#include "stir/RelatedViewgrams.h"
+#include "stir/DataSymmetriesForViewSegmentNumbers.h"
+#include "stir/ExamInfo.h"
+#include "stir/Scanner.h"
+#include "stir/num_threads.h"
+#include "stir/RunTests.h"
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <iostream>
+#include <vector>
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for ImageAccumulationBuffers and BackProjectorByBin::back_project(DiscretisedDensity<3,float>&, const ProjData&)
+
+  Checks the default number of buffers, and that adding to the buffers from
+  several threads gives the same result as adding to a single image.
+
+  The parallel back projection of a whole ProjData is compared with back projecting
+  all related viewgrams one after the other. This is done for a matrix back projector
+  (which adds atomically to the output image) and for the interpolating back projector
+  (which uses ImageAccumulationBuffers).
+*/
+class ImageAccumulationBuffersTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef DiscretisedDensity<3,float> target_type;
+
+  void run_tests_buffers(const target_type& image);
+  //! compare parallel and serial back projection of \a proj_data
+  void run_tests_back_projector(BackProjectorByBin& back_projector,
+                                const ProjData& proj_data,
+                                const shared_ptr<target_type>& image_sptr);
+};
+
+void
+ImageAccumulationBuffersTests::
+run_tests_buffers(const target_type& image)
+{
+  cerr << "\tTesting default number of buffers\n";
+  check_if_equal(ImageAccumulationBuffers::get_default_num_buffers(image, 0), 1,
+                 "number of buffers without extra memory");
+  check_if_equal(ImageAccumulationBuffers::get_default_num_buffers(image, 100000), std::max(get_max_num_threads(), 1),
+                 "number of buffers with a lot of memory");
+  check(ImageAccumulationBuffers::get_default_num_buffers(image) >= 1,
+        "default number of buffers should be at least 1");
+
+  cerr << "\tTesting accumulation with 3 buffers\n";
+  shared_ptr<target_type> output_sptr(image.clone());
+  shared_ptr<target_type> reference_sptr(image.clone());
+  const int num_contributions = 40;
+  {
+    ImageAccumulationBuffers buffers(*output_sptr, 3);
+#ifdef STIR_OPENMP
+    check_if_equal(buffers.get_num_buffers(), 3, "number of buffers");
+#else
+    check_if_equal(buffers.get_num_buffers(), 1, "number of buffers without OpenMP");
+#endif
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i=0; i<num_contributions; ++i)
+      {
+        const int buffer_num = buffers.acquire();
+        target_type& buffer = buffers.get_buffer(buffer_num);
+        // add a different value to a different voxel for every i
+        const int z = buffer.get_min_index() + i % (buffer.get_length());
+        buffer[z][0][0] += static_cast<float>(i+1);
+        buffers.release(buffer_num);
+      }
+    buffers.accumulate();
+  }
+  for (int i=0; i<num_contributions; ++i)
+    {
+      const int z = reference_sptr->get_min_index() + i % (reference_sptr->get_length());
+      (*reference_sptr)[z][0][0] += static_cast<float>(i+1);
+    }
+  check_if_equal(*reference_sptr, *output_sptr, "accumulated buffers");
+}
+
+void
+ImageAccumulationBuffersTests::
+run_tests_back_projector(BackProjectorByBin& back_projector,
+                         const ProjData& proj_data,
+                         const shared_ptr<target_type>& image_sptr)
+{
+  back_projector.set_up(proj_data.get_proj_data_info_sptr(), image_sptr);
+
+  shared_ptr<target_type> reference_sptr(image_sptr->get_empty_copy());
+  shared_ptr<DataSymmetriesForViewSegmentNumbers>
+    symmetries_sptr(back_projector.get_symmetries_used()->clone());
+  const std::vector<ViewSegmentNumbers> vs_nums =
+    detail::find_basic_vs_nums_in_subset(*proj_data.get_proj_data_info_ptr(), *symmetries_sptr,
+                                         proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
+                                         0, 1);
+  for (std::vector<ViewSegmentNumbers>::const_iterator iter = vs_nums.begin(); iter != vs_nums.end(); ++iter)
+    back_projector.back_project(*reference_sptr, proj_data.get_related_viewgrams(*iter, symmetries_sptr));
+
+  shared_ptr<target_type> output_sptr(image_sptr->get_empty_copy());
+  back_projector.back_project(*output_sptr, proj_data);
+  check_if_equal(*reference_sptr, *output_sptr, "parallel back projection of whole projection data");
+
+  // do it again with a memory limit such that only 1 buffer is used
+  back_projector.set_max_memory_for_accumulation_buffers_in_MB(0);
+  output_sptr->fill(0.F);
+  back_projector.back_project(*output_sptr, proj_data);
+  check_if_equal(*reference_sptr, *output_sptr, "parallel back projection with 1 buffer");
+}
+
+void
+ImageAccumulationBuffersTests::run_tests()
+{
+  cerr << "Tests for ImageAccumulationBuffers and parallel back projection\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  scanner_sptr->set_num_rings(5);
+  shared_ptr<ProjDataInfo> proj_data_info_sptr(
+    ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                  /*span=*/3,
+                                  /*max_delta=*/4,
+                                  /*num_views=*/16,
+                                  /*num_tang_poss=*/16));
+  shared_ptr<target_type> image_sptr(new VoxelsOnCartesianGrid<float>(*proj_data_info_sptr, 1.F,
+                                                                      CartesianCoordinate3D<float>(0,0,0)));
+  run_tests_buffers(*image_sptr);
+
+  shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+  ProjDataInMemory proj_data(exam_info_sptr, proj_data_info_sptr);
+  {
+    typedef boost::mt19937 base_generator_type;
+    base_generator_type generator(boost::uint32_t(42));
+    boost::uniform_01<base_generator_type> random01(generator);
+    for (int seg_num=proj_data.get_min_segment_num(); seg_num<=proj_data.get_max_segment_num(); ++seg_num)
+      {
+        SegmentByView<float> segment = proj_data.get_empty_segment_by_view(seg_num);
+        for (SegmentByView<float>::full_iterator iter = segment.begin_all(); iter != segment.end_all(); ++iter)
+          *iter = static_cast<float>(random01());
+        proj_data.set_segment(segment);
+      }
+  }
+  // different threads add in a different order
+  this->set_tolerance(1.E-4);
+
+  {
+    cerr << "\tTesting matrix back projector (atomic accumulation) with cache\n";
+    shared_ptr<ProjMatrixByBin> proj_matrix_sptr(new ProjMatrixByBinUsingRayTracing());
+    BackProjectorByBinUsingProjMatrixByBin back_projector(proj_matrix_sptr);
+    run_tests_back_projector(back_projector, proj_data, image_sptr);
+  }
+  {
+    cerr << "\tTesting matrix back projector (atomic accumulation) without cache\n";
+    shared_ptr<ProjMatrixByBin> proj_matrix_sptr(new ProjMatrixByBinUsingRayTracing());
+    proj_matrix_sptr->enable_cache(false);
+    BackProjectorByBinUsingProjMatrixByBin back_projector(proj_matrix_sptr);
+    run_tests_back_projector(back_projector, proj_data, image_sptr);
+  }
+  {
+    cerr << "\tTesting interpolating back projector (accumulation buffers)\n";
+    BackProjectorByBinUsingInterpolation back_projector;
+    run_tests_back_projector(back_projector, proj_data, image_sptr);
+  }
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  ImageAccumulationBuffersTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -0,0 +1,401 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup recon_test
+  \brief Test program for stir::PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin
+  with subsets
+
+  The list mode data are generated in memory, so this test does not need any input files.
+*/
+
+#include "stir/recon_buildblock/PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin.h"
+#include "stir/OSMAPOSL/OSMAPOSLReconstruction.h"
+#include "stir/listmode/CListModeData.h"
+#include "stir/listmode/CListRecord.h"
+#include "stir/listmode/CListEventCylindricalScannerWithDiscreteDetectors.h"
+#include "stir/ProjDataInfoCylindricalNoArcCorr.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ExamInfo.h"
+#include "stir/DetectionPositionPair.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/Scanner.h"
+#include "stir/Bin.h"
+#include "stir/Succeeded.h"
+#include "stir/RunTests.h"
+#include "stir/is_null_ptr.h"
+#include "stir/num_threads.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+START_NAMESPACE_STIR
+
+//! list mode record for detection position pairs, used by ListModeDataInMemory
+class CListRecordInMemory : public CListRecord, public CListTime, public CListEventCylindricalScannerWithDiscreteDetectors
+{
+public:
+  explicit CListRecordInMemory(const shared_ptr<Scanner>& scanner_sptr)
+    : CListEventCylindricalScannerWithDiscreteDetectors(scanner_sptr),
+      _is_time(true), _time_in_millisecs(0)
+  {}
+
+  virtual bool is_time() const { return _is_time; }
+  virtual bool is_event() const { return !_is_time; }
+  virtual CListEvent& event() { return *this; }
+  virtual const CListEvent& event() const { return *this; }
+  virtual CListTime& time() { return *this; }
+  virtual const CListTime& time() const { return *this; }
+  virtual bool operator==(const CListRecord& e2) const
+  {
+    const CListRecordInMemory* e2_ptr = dynamic_cast<const CListRecordInMemory*>(&e2);
+    return e2_ptr != 0 && _is_time == e2_ptr->_is_time &&
+      (_is_time ? _time_in_millisecs == e2_ptr->_time_in_millisecs : _det_pos_pair == e2_ptr->_det_pos_pair);
+  }
+
+  virtual bool is_prompt() const { return true; }
+
+  virtual void get_detection_position(DetectionPositionPair<>& det_pos_pair) const
+  { det_pos_pair = _det_pos_pair; }
+  virtual void set_detection_position(const DetectionPositionPair<>& det_pos_pair)
+  { _is_time = false; _det_pos_pair = det_pos_pair; }
+
+  virtual unsigned long get_time_in_millisecs() const { return _time_in_millisecs; }
+  virtual Succeeded set_time_in_millisecs(const unsigned long time_in_millisecs)
+  { _is_time = true; _time_in_millisecs = time_in_millisecs; return Succeeded::yes; }
+
+private:
+  bool _is_time;
+  unsigned long _time_in_millisecs;
+  DetectionPositionPair<> _det_pos_pair;
+};
+
+//! list mode data with prompts stored in memory, preceded by a time record at time 0
+/*! If \a num_events_per_second is positive, a time record is inserted after every
+    \a num_events_per_second events, i.e. the events are spread over several seconds.
+*/
+class ListModeDataInMemory : public CListModeData
+{
+public:
+  ListModeDataInMemory(const shared_ptr<Scanner>& scanner_sptr,
+                       const std::vector<DetectionPositionPair<> >& det_pos_pairs,
+                       const int num_events_per_second = 0)
+    : _current_record_num(0), _num_records_read(0)
+  {
+    this->scanner_sptr = scanner_sptr;
+    for (std::size_t i=0; i<det_pos_pairs.size(); ++i)
+      {
+        if (i==0 || (num_events_per_second>0 && i%num_events_per_second == 0))
+          {
+            const unsigned long time_in_millisecs =
+              num_events_per_second>0 ? static_cast<unsigned long>(1000*(i/num_events_per_second)) : 0UL;
+            _records.push_back(std::make_pair(true, DetectionPositionPair<>()));
+            _times_in_millisecs.push_back(time_in_millisecs);
+          }
+        _records.push_back(std::make_pair(false, det_pos_pairs[i]));
+        _times_in_millisecs.push_back(0);
+      }
+  }
+
+  virtual std::string get_name() const { return "ListModeDataInMemory"; }
+  virtual shared_ptr<CListRecord> get_empty_record_sptr() const
+  { return shared_ptr<CListRecord>(new CListRecordInMemory(this->scanner_sptr)); }
+  virtual Succeeded get_next_record(CListRecord& record) const
+  {
+    CListRecordInMemory& record_in_memory = dynamic_cast<CListRecordInMemory&>(record);
+    if (_current_record_num >= _records.size())
+      return Succeeded::no;
+    if (_records[_current_record_num].first)
+      record_in_memory.set_time_in_millisecs(_times_in_millisecs[_current_record_num]);
+    else
+      record_in_memory.set_detection_position(_records[_current_record_num].second);
+    ++_current_record_num;
+    ++_num_records_read;
+    return Succeeded::yes;
+  }
+  virtual Succeeded reset() { _current_record_num = 0; return Succeeded::yes; }
+  virtual SavedPosition save_get_position() { return static_cast<SavedPosition>(_current_record_num); }
+  virtual Succeeded set_get_position(const SavedPosition& pos) { _current_record_num = pos; return Succeeded::yes; }
+  virtual bool has_delayeds() const { return false; }
+
+  //! number of records read since construction
+  std::size_t get_num_records_read() const { return _num_records_read; }
+
+private:
+  //! \c true for a time record, otherwise the detection positions of the event
+  std::vector<std::pair<bool, DetectionPositionPair<> > > _records;
+  std::vector<unsigned long> _times_in_millisecs;
+  mutable std::size_t _current_record_num;
+  mutable std::size_t _num_records_read;
+};
+
+typedef DiscretisedDensity<3,float> target_type;
+
+//! gives access to the projection data info (normally set by parsing)
+class ListModeObjectiveFunction
+  : public PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<target_type>
+{
+public:
+  ListModeObjectiveFunction(const shared_ptr<CListModeData>& lm_data_sptr,
+                            const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+                            const double start_time = 0, const double end_time = 1)
+  {
+    this->set_input_data(lm_data_sptr);
+    this->proj_data_info_cyl_uncompressed_ptr = proj_data_info_sptr;
+    std::vector<std::pair<double, double> > frame_times(1, std::pair<double,double>(start_time,end_time));
+    this->frame_defs = TimeFrameDefinitions(frame_times);
+    this->current_frame_num = 1;
+    this->set_recompute_sensitivity(true);
+  }
+};
+
+/*!
+  \ingroup recon_test
+  \brief Test class for PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin with subsets
+
+  Checks that
+  - set-up computes the sensitivity, and that every subset sensitivity is the total divided by the
+    number of subsets
+  - the sum of the subset gradients is the gradient without subsets
+  - OSMAPOSL with 2 subsets runs and gives the same result as the EM updates computed by hand
+  - for a frame that does not start at the beginning of the list mode data, the subset
+    gradients are the same as for list mode data with only the events in the frame, and
+    the events before the frame are only read once
+*/
+class PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBinTests : public RunTests
+{
+public:
+  void run_tests();
+
+private:
+  double max_abs_difference(const target_type& a, const target_type& b, const target_type& mask) const;
+};
+
+double
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBinTests::
+max_abs_difference(const target_type& a, const target_type& b, const target_type& mask) const
+{
+  const float mask_threshold = mask.find_max()/100;
+  double max_diff = 0;
+  target_type::const_full_iterator a_iter = a.begin_all_const();
+  target_type::const_full_iterator b_iter = b.begin_all_const();
+  target_type::const_full_iterator mask_iter = mask.begin_all_const();
+  for (; a_iter != a.end_all_const(); ++a_iter, ++b_iter, ++mask_iter)
+    if (*mask_iter > mask_threshold)
+      max_diff = std::max(max_diff, static_cast<double>(std::fabs(*a_iter - *b_iter)));
+  return max_diff;
+}
+
+void
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBinTests::
+run_tests()
+{
+  std::cerr << "-------- Testing list mode objective function with subsets --------\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  scanner_sptr->set_num_rings(3);
+  shared_ptr<ProjDataInfo> proj_data_info_sptr
+    (ProjDataInfo::ProjDataInfoCTI(scanner_sptr, /*span*/1, /*max_delta*/1,
+                                   scanner_sptr->get_num_detectors_per_ring()/2, /*num_tang_poss*/32,
+                                   /*arc_corrected*/ false));
+  const ProjDataInfoCylindricalNoArcCorr& proj_data_info =
+    dynamic_cast<const ProjDataInfoCylindricalNoArcCorr&>(*proj_data_info_sptr);
+
+  // generate some events in a deterministic way
+  std::vector<DetectionPositionPair<> > det_pos_pairs;
+  {
+    unsigned int seed = 1;
+    for (int i=0; i<3000; ++i)
+      {
+        seed = seed*1103515245U + 12345U;
+        const unsigned int r = seed >> 8;
+        const int segment_num = static_cast<int>(r % 3) - 1;
+        const int view_num = static_cast<int>((r/3) % proj_data_info.get_num_views());
+        const int axial_pos_num =
+          proj_data_info.get_min_axial_pos_num(segment_num) +
+          static_cast<int>((r/1000) % proj_data_info.get_num_axial_poss(segment_num));
+        // concentrate events in the centre
+        const int tangential_pos_num = static_cast<int>((r/7) % 17) - 8;
+        DetectionPositionPair<> det_pos_pair;
+        proj_data_info.get_det_pos_pair_for_bin(det_pos_pair,
+                                                Bin(segment_num, view_num, axial_pos_num, tangential_pos_num));
+        det_pos_pairs.push_back(det_pos_pair);
+      }
+  }
+  shared_ptr<CListModeData> lm_data_sptr(new ListModeDataInMemory(scanner_sptr, det_pos_pairs));
+
+  shared_ptr<target_type> initial_image_sptr
+    (new VoxelsOnCartesianGrid<float>(*proj_data_info_sptr, 1.F,
+                                      CartesianCoordinate3D<float>(0.F,0.F,0.F),
+                                      CartesianCoordinate3D<int>(-1, 31, 31)));
+  initial_image_sptr->fill(1.F);
+
+  // reference: no subsets
+  ListModeObjectiveFunction objective_function_1(lm_data_sptr, proj_data_info_sptr);
+  objective_function_1.set_num_subsets(1);
+  if (!check(objective_function_1.set_up(initial_image_sptr) == Succeeded::yes,
+             "set-up of objective function without subsets"))
+    return;
+  const target_type& total_sensitivity = objective_function_1.get_sensitivity();
+  check(total_sensitivity.find_max() > 0, "sensitivity should be positive somewhere");
+  shared_ptr<target_type> total_gradient_sptr(initial_image_sptr->get_empty_copy());
+  objective_function_1.compute_sub_gradient_without_penalty_plus_sensitivity(*total_gradient_sptr, *initial_image_sptr, 0);
+
+  // 2 subsets
+  const int num_subsets = 2;
+  ListModeObjectiveFunction objective_function_2(lm_data_sptr, proj_data_info_sptr);
+  objective_function_2.set_num_subsets(num_subsets);
+  check(objective_function_2.get_use_subset_sensitivities(), "test should use subset sensitivities");
+  if (!check(objective_function_2.set_up(initial_image_sptr) == Succeeded::yes,
+             "set-up of objective function with subsets"))
+    return;
+  set_tolerance(1.E-4);
+  {
+    shared_ptr<target_type> sum_sptr(initial_image_sptr->get_empty_copy());
+    for (int subset_num=0; subset_num<num_subsets; ++subset_num)
+      {
+        shared_ptr<target_type> expected_sptr(total_sensitivity.clone());
+        *expected_sptr /= static_cast<float>(num_subsets);
+        check_if_equal(objective_function_2.get_subset_sensitivity(subset_num), *expected_sptr,
+                       "subset sensitivity should be total sensitivity divided by number of subsets");
+        *sum_sptr += objective_function_2.get_subset_sensitivity(subset_num);
+      }
+    check_if_equal(*sum_sptr, total_sensitivity, "sum of subset sensitivities");
+  }
+  shared_ptr<target_type> gradient_0_sptr(initial_image_sptr->get_empty_copy());
+  shared_ptr<target_type> gradient_1_sptr(initial_image_sptr->get_empty_copy());
+  objective_function_2.compute_sub_gradient_without_penalty_plus_sensitivity(*gradient_0_sptr, *initial_image_sptr, 0);
+  objective_function_2.compute_sub_gradient_without_penalty_plus_sensitivity(*gradient_1_sptr, *initial_image_sptr, 1);
+  {
+    check(gradient_0_sptr->find_max() > 0 && gradient_1_sptr->find_max() > 0,
+          "every subset should contain events");
+    *gradient_0_sptr += *gradient_1_sptr;
+    check_if_equal(*gradient_0_sptr, *total_gradient_sptr, "sum of subset gradients");
+  }
+
+  // OSMAPOSL with 2 subsets for 1 full iteration
+  {
+    shared_ptr<ListModeObjectiveFunction>
+      objective_function_sptr(new ListModeObjectiveFunction(lm_data_sptr, proj_data_info_sptr));
+    OSMAPOSLReconstruction<target_type> reconstruction;
+    reconstruction.set_objective_function_sptr(objective_function_sptr);
+    reconstruction.set_num_subsets(num_subsets);
+    reconstruction.set_num_subiterations(num_subsets);
+    reconstruction.set_disable_output(true);
+    shared_ptr<target_type> estimate_sptr(initial_image_sptr->clone());
+    // set_up() is only public in the base class
+    Reconstruction<target_type>& base_reconstruction = reconstruction;
+    if (!check(base_reconstruction.set_up(estimate_sptr) == Succeeded::yes, "set-up of OSMAPOSL with subsets"))
+      return;
+    check(reconstruction.reconstruct(estimate_sptr) == Succeeded::yes, "OSMAPOSL with subsets");
+
+    // compute EM updates by hand
+    shared_ptr<target_type> expected_sptr(initial_image_sptr->clone());
+    for (int subset_num=0; subset_num<num_subsets; ++subset_num)
+      {
+        shared_ptr<target_type> update_sptr(initial_image_sptr->get_empty_copy());
+        objective_function_2.compute_sub_gradient_without_penalty_plus_sensitivity(*update_sptr, *expected_sptr, subset_num);
+        const target_type& subset_sensitivity = objective_function_2.get_subset_sensitivity(subset_num);
+        target_type::full_iterator expected_iter = expected_sptr->begin_all();
+        target_type::const_full_iterator update_iter = update_sptr->begin_all_const();
+        target_type::const_full_iterator sens_iter = subset_sensitivity.begin_all_const();
+        for (; expected_iter != expected_sptr->end_all(); ++expected_iter, ++update_iter, ++sens_iter)
+          *expected_iter = *sens_iter > 0 ? *expected_iter * *update_iter / *sens_iter : 0.F;
+      }
+    check(estimate_sptr->find_min() >= 0, "OSMAPOSL estimate should be non-negative");
+    const double max_diff = max_abs_difference(*estimate_sptr, *expected_sptr, total_sensitivity);
+    check(max_diff <= expected_sptr->find_max()*1.E-3,
+          "OSMAPOSL estimate with subsets should be equal to EM updates computed by hand");
+    if (!is_everything_ok())
+      std::cerr << "Maximum difference " << max_diff << " (max in image " << expected_sptr->find_max() << ")\n";
+  }
+
+  // frame in the middle of the list mode data
+  {
+    std::cerr << "Testing a frame that does not start at the beginning of the list mode data\n";
+    // 1000 events per second, such that the frame from 1 to 2 seconds contains the second 1000 events
+    shared_ptr<ListModeDataInMemory>
+      lm_data_with_time_sptr(new ListModeDataInMemory(scanner_sptr, det_pos_pairs, 1000));
+    ListModeObjectiveFunction objective_function_frame(lm_data_with_time_sptr, proj_data_info_sptr, 1., 2.);
+    objective_function_frame.set_num_subsets(num_subsets);
+    // reference: list mode data with only the events in the frame
+    shared_ptr<CListModeData>
+      lm_data_in_frame_sptr(new ListModeDataInMemory(scanner_sptr,
+                                                     std::vector<DetectionPositionPair<> >(det_pos_pairs.begin()+1000,
+                                                                                           det_pos_pairs.begin()+2000)));
+    ListModeObjectiveFunction objective_function_reference(lm_data_in_frame_sptr, proj_data_info_sptr);
+    objective_function_reference.set_num_subsets(num_subsets);
+    if (!check(objective_function_frame.set_up(initial_image_sptr) == Succeeded::yes,
+               "set-up of objective function for frame") ||
+        !check(objective_function_reference.set_up(initial_image_sptr) == Succeeded::yes,
+               "set-up of reference objective function for frame"))
+      return;
+    std::size_t num_records_read_for_first_subset = 0;
+    for (int subset_num=0; subset_num<num_subsets; ++subset_num)
+      {
+        shared_ptr<target_type> gradient_sptr(initial_image_sptr->get_empty_copy());
+        shared_ptr<target_type> reference_gradient_sptr(initial_image_sptr->get_empty_copy());
+        const std::size_t num_records_read_before = lm_data_with_time_sptr->get_num_records_read();
+        objective_function_frame.compute_sub_gradient_without_penalty_plus_sensitivity(*gradient_sptr, *initial_image_sptr, subset_num);
+        const std::size_t num_records_read = lm_data_with_time_sptr->get_num_records_read() - num_records_read_before;
+        objective_function_reference.compute_sub_gradient_without_penalty_plus_sensitivity(*reference_gradient_sptr, *initial_image_sptr, subset_num);
+        check(reference_gradient_sptr->find_max() > 0, "every subset of the frame should contain events");
+        check_if_equal(*gradient_sptr, *reference_gradient_sptr, "subset gradient for frame");
+        // records are read in blocks of 1000. The first subset reads 3 blocks (the first one only
+        // contains events before the frame), the next ones should start at the block before the frame
+        if (subset_num == 0)
+          {
+            check(num_records_read >= 2000, "first subset should read the events before the frame");
+            num_records_read_for_first_subset = num_records_read;
+          }
+        else
+          check(num_records_read + 1000 <= num_records_read_for_first_subset,
+                "events before the frame should be skipped for next subsets");
+      }
+  }
+
+  // additive sinogram with span 3 cannot be used
+  {
+    std::cerr << "Testing set-up with an incompatible additive sinogram (a warning will be written)\n";
+    shared_ptr<ProjDataInfo> compressed_proj_data_info_sptr
+      (ProjDataInfo::ProjDataInfoCTI(scanner_sptr, /*span*/3, /*max_delta*/1,
+                                     scanner_sptr->get_num_detectors_per_ring()/2, /*num_tang_poss*/32,
+                                     /*arc_corrected*/ false));
+    shared_ptr<ExamData> additive_proj_data_sptr
+      (new ProjDataInMemory(shared_ptr<ExamInfo>(new ExamInfo), compressed_proj_data_info_sptr));
+    ListModeObjectiveFunction objective_function(lm_data_sptr, proj_data_info_sptr);
+    objective_function.set_additive_proj_data_sptr(additive_proj_data_sptr);
+    check(objective_function.set_up(initial_image_sptr) == Succeeded::no,
+          "set-up with an additive sinogram with span 3 should fail");
+  }
+}
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main()
+{
+  set_default_num_threads();
+  PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBinTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
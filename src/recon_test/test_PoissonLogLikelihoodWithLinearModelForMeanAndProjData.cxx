@@ -45,6 +45,8 @@
 #include "stir/recon_buildblock/ProjectorByBinPairUsingProjMatrixByBin.h"
 #include "stir/recon_buildblock/BinNormalisationFromProjData.h"
 #include "stir/recon_buildblock/TrivialBinNormalisation.h"
+#include "stir/recon_buildblock/BinNormalisationFactorsCache.h"
+#include "stir/TimeFrameDefinitions.h"
 //#include "stir/OSMAPOSL/OSMAPOSLReconstruction.h"
 #include "stir/recon_buildblock/distributable_main.h"
 #include "stir/RunTests.h"
@@ -55,6 +57,9 @@
 #include "stir/num_threads.h"
 #include <iostream>
 #include <memory>
+#include <vector>
+#include <utility>
+#include <string>
 #include <boost/random/uniform_01.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/mersenne_twister.hpp>
@@ -65,6 +70,71 @@
 START_NAMESPACE_STIR
 
 
+/*!
+  \ingroup test
+  \brief A BinNormalisation with time-dependent factors that uses BinNormalisationFactorsCache
+
+  Counts how often a factor is computed.
+*/
+class BinNormalisationWithCacheForTesting : public BinNormalisation
+{
+public:
+  BinNormalisationWithCacheForTesting()
+    : num_computations(0)
+  {}
+
+  virtual std::string get_registered_name() const
+  { return "BinNormalisationWithCacheForTesting"; }
+  virtual std::string parameter_info()
+  { return ""; }
+
+  virtual Succeeded set_up(const shared_ptr<ProjDataInfo>& proj_data_info_sptr)
+  {
+    this->cache.set_up(*proj_data_info_sptr, /*enabled=*/true, /*time_dependent=*/true);
+    return BinNormalisation::set_up(proj_data_info_sptr);
+  }
+  virtual void precompute_for_time_frame(const double start_time, const double end_time) const
+  {
+    this->cache.fill_if_necessary(*this, &BinNormalisationWithCacheForTesting::compute_bin_efficiency,
+                                  start_time, end_time);
+  }
+  virtual bool is_thread_safe_for_time_frame(const double start_time, const double end_time) const
+  { return this->cache.is_filled_for(start_time, end_time); }
+
+  virtual float get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const
+  {
+    return this->cache.get_bin_efficiency(*this, &BinNormalisationWithCacheForTesting::compute_bin_efficiency,
+                                          bin, start_time, end_time);
+  }
+  using BinNormalisation::apply;
+  using BinNormalisation::undo;
+  virtual void apply(RelatedViewgrams<float>& viewgrams, const double start_time, const double end_time) const
+  {
+    this->cache.apply(viewgrams, *this, &BinNormalisationWithCacheForTesting::compute_bin_efficiency,
+                      start_time, end_time);
+  }
+  virtual void undo(RelatedViewgrams<float>& viewgrams, const double start_time, const double end_time) const
+  {
+    this->cache.undo(viewgrams, *this, &BinNormalisationWithCacheForTesting::compute_bin_efficiency,
+                     start_time, end_time);
+  }
+
+  //! the function that the cache calls to compute a factor
+  float compute_bin_efficiency(const Bin& bin, const double start_time, const double) const
+  {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+    ++num_computations;
+    return static_cast<float>(1 + bin.view_num()*.1 + bin.tangential_pos_num()*.01 + start_time*.001);
+  }
+
+  mutable int num_computations;
+
+private:
+  mutable BinNormalisationFactorsCache cache;
+};
+
 /*!
   \ingroup test
   \brief Test class for PoissonLogLikelihoodWithLinearModelForMeanAndProjData
@@ -86,6 +156,9 @@ START_NAMESPACE_STIR
   function will become infinite. The numerical gradient then becomes ill-defined
   (even in voxels that do not contribute to these bins).
 
+  In addition, it checks with a time-dependent cached normalisation that the
+  normalisation factors are computed once for the time frame by set_up(), and are
+  not recomputed by the gradient and value computations.
 */
 class PoissonLogLikelihoodWithLinearModelForMeanAndProjDataTests : public RunTests
 {
@@ -112,6 +185,9 @@ protected:
   /*! Note that this function is not specific to PoissonLogLikelihoodWithLinearModelForMeanAndProjData */
   void run_tests_for_objective_function(GeneralisedObjectiveFunction<target_type>& objective_function,
                                         target_type& target);
+
+  //! check that the normalisation factors are precomputed for the time frame
+  void run_tests_for_normalisation_cache(const shared_ptr<target_type>& target_sptr);
 };
 
 PoissonLogLikelihoodWithLinearModelForMeanAndProjDataTests::
@@ -165,6 +241,43 @@ run_tests_for_objective_function(GeneralisedObjectiveFunction<PoissonLogLikeliho
 
 }
 
+void
+PoissonLogLikelihoodWithLinearModelForMeanAndProjDataTests::
+run_tests_for_normalisation_cache(const shared_ptr<target_type>& target_sptr)
+{
+  std::cerr << "\tTesting precomputation of normalisation factors for the time frame\n";
+  PoissonLogLikelihoodWithLinearModelForMeanAndProjData<target_type>& objective_function =
+    dynamic_cast<PoissonLogLikelihoodWithLinearModelForMeanAndProjData<target_type>& >(*objective_function_sptr);
+  shared_ptr<BinNormalisationWithCacheForTesting> norm_sptr(new BinNormalisationWithCacheForTesting);
+  objective_function.set_normalisation_sptr(norm_sptr);
+  const double start_time = 10., end_time = 20.;
+  objective_function.set_frame_definitions(
+    TimeFrameDefinitions(std::vector<std::pair<double, double> >(1, std::make_pair(start_time, end_time))));
+  objective_function.set_frame_num(1);
+  if (!check(objective_function.set_up(target_sptr)==Succeeded::yes, "set-up of objective function with cached normalisation"))
+    return;
+
+  const ProjDataInfo& proj_data_info = *objective_function.get_proj_data().get_proj_data_info_ptr();
+  int num_bins = 0;
+  for (int segment_num = proj_data_info.get_min_segment_num();
+       segment_num <= proj_data_info.get_max_segment_num();
+       ++segment_num)
+    num_bins += proj_data_info.get_num_views() *
+      proj_data_info.get_num_axial_poss(segment_num) *
+      proj_data_info.get_num_tangential_poss();
+  check(norm_sptr->is_thread_safe_for_time_frame(start_time, end_time),
+        "normalisation factors should be stored for the time frame after set_up");
+  check_if_equal(norm_sptr->num_computations, num_bins,
+                 "number of normalisation factors computed by set_up (including sensitivity)");
+
+  norm_sptr->num_computations = 0;
+  shared_ptr<target_type> gradient_sptr(target_sptr->get_empty_copy());
+  objective_function.compute_sub_gradient(*gradient_sptr, *target_sptr, 0);
+  objective_function.compute_objective_function(*target_sptr, 0);
+  check_if_equal(norm_sptr->num_computations, 0,
+                 "number of normalisation factors computed by gradient and value computation");
+}
+
 void
 PoissonLogLikelihoodWithLinearModelForMeanAndProjDataTests::
 construct_input_data(shared_ptr<target_type>& density_sptr)
@@ -321,6 +434,7 @@ run_tests()
   shared_ptr<target_type> density_sptr;
   construct_input_data(density_sptr);
   this->run_tests_for_objective_function(*this->objective_function_sptr, *density_sptr);
+  this->run_tests_for_normalisation_cache(density_sptr);
 #else
   // alternative that gets the objective function from an OSMAPOSL .par file
   // currently disabled
@@ -0,0 +1,318 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for the caching in stir::ProjMatrixByBin and
+  stir::PackedProjMatrixElemsForOneBin
+
+  Uses stir::ProjMatrixByBinUsingRayTracing.
+*/
+
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/Scanner.h"
+#include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
+#include "stir/recon_buildblock/ProjMatrixByBinFromFile.h"
+#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/recon_buildblock/PackedProjMatrixElemsForOneBin.h"
+#include "stir/IO/read_from_file.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#ifndef STIR_NO_NAMESPACES
+using std::stringstream;
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for the cache in ProjMatrixByBin
+
+  Computes all rows of a (small) projection matrix with different cache
+  settings (disabled, unlimited, and with a maximum size which forces
+  evictions) and checks that the results are identical. Also checks
+  the cache statistics.
+
+  Checks that packing and unpacking rows in all formats of
+  PackedProjMatrixElemsForOneBin gives the original row (within tolerance),
+  and that its projection functions give the same results as
+  ProjMatrixElemsForOneBin.
+*/
+class ProjMatrixByBinTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  shared_ptr<DiscretisedDensity<3,float> > density_sptr;
+
+  //! set up a ray tracing matrix with the given cache parameters
+  bool set_up_proj_matrix(ProjMatrixByBinUsingRayTracing& proj_matrix,
+                          const bool disable_caching,
+                          const bool store_only_basic_bins,
+                          const int max_cache_size_in_MB,
+                          const std::string& cache_value_format = "float");
+  //! compare all rows of the 2 matrices (going over all bins twice)
+  void compare_proj_matrices(const ProjMatrixByBin& proj_matrix_ref,
+                             const ProjMatrixByBin& proj_matrix);
+  //! test PackedProjMatrixElemsForOneBin for all rows of the matrix
+  void run_tests_packed_rows(const ProjMatrixByBin& proj_matrix,
+                             const PackedProjMatrixElemsForOneBin::ValueFormat value_format);
+};
+
+bool
+ProjMatrixByBinTests::
+set_up_proj_matrix(ProjMatrixByBinUsingRayTracing& proj_matrix,
+                   const bool disable_caching,
+                   const bool store_only_basic_bins,
+                   const int max_cache_size_in_MB,
+                   const std::string& cache_value_format)
+{
+  stringstream str;
+  str <<
+    "Ray Tracing Matrix Parameters :=\n"
+    "restrict to cylindrical FOV := 1\n"
+    "number of rays in tangential direction to trace for each bin := 1\n"
+    "disable caching := " << disable_caching << "\n"
+    "store only basic bins in cache := " << store_only_basic_bins << "\n"
+    "maximum cache size in MB := " << max_cache_size_in_MB << "\n"
+    "cache value format := " << cache_value_format << "\n"
+    "End Ray Tracing Matrix Parameters :=\n";
+  if (!check(proj_matrix.parse(str),
+             "parsing projection matrix parameters"))
+    return false;
+  proj_matrix.set_up(proj_data_info_sptr, density_sptr);
+  return true;
+}
+
+void
+ProjMatrixByBinTests::
+compare_proj_matrices(const ProjMatrixByBin& proj_matrix_ref,
+                      const ProjMatrixByBin& proj_matrix)
+{
+  ProjMatrixElemsForOneBin elems_ref;
+  ProjMatrixElemsForOneBin elems;
+  for (int pass=0; pass<2; ++pass)
+    for (int s=proj_data_info_sptr->get_min_segment_num(); s<=proj_data_info_sptr->get_max_segment_num(); ++s)
+      for (int v=proj_data_info_sptr->get_min_view_num(); v<=proj_data_info_sptr->get_max_view_num(); ++v)
+        for (int a=proj_data_info_sptr->get_min_axial_pos_num(s); a<=proj_data_info_sptr->get_max_axial_pos_num(s); ++a)
+          for (int t=proj_data_info_sptr->get_min_tangential_pos_num(); t<=proj_data_info_sptr->get_max_tangential_pos_num(); ++t)
+            {
+              const Bin bin(s,v,a,t);
+              proj_matrix_ref.get_proj_matrix_elems_for_one_bin(elems_ref, bin);
+              proj_matrix.get_proj_matrix_elems_for_one_bin(elems, bin);
+              elems_ref.sort();
+              elems.sort();
+              if (!check(elems_ref == elems, "comparing lors"))
+                {
+                  cerr << "Current bin: segment = " << bin.segment_num()
+                       << ", axial pos " << bin.axial_pos_num()
+                       << ", view = " << bin.view_num()
+                       << ", tangential_pos_num = " << bin.tangential_pos_num() << "\n";
+                  return;
+                }
+            }
+}
+
+void
+ProjMatrixByBinTests::
+run_tests_packed_rows(const ProjMatrixByBin& proj_matrix,
+                      const PackedProjMatrixElemsForOneBin::ValueFormat value_format)
+{
+  ProjMatrixElemsForOneBin elems;
+  ProjMatrixElemsForOneBin unpacked_elems;
+  const float tolerance_for_projections =
+    value_format == PackedProjMatrixElemsForOneBin::float_values ? 1.E-4F : 5.E-3F;
+  const double old_tolerance = get_tolerance();
+  set_tolerance(tolerance_for_projections);
+  // use an image with positive values which are not all equal
+  VoxelsOnCartesianGrid<float>& image =
+    dynamic_cast<VoxelsOnCartesianGrid<float>&>(*density_sptr);
+  for (int z=image.get_min_z(); z<=image.get_max_z(); ++z)
+    for (int y=image.get_min_y(); y<=image.get_max_y(); ++y)
+      for (int x=image.get_min_x(); x<=image.get_max_x(); ++x)
+        image[z][y][x] = 1.F + z + (y*y + x)/10.F;
+  shared_ptr<DiscretisedDensity<3,float> > back_projection_sptr(density_sptr->get_empty_copy());
+  shared_ptr<DiscretisedDensity<3,float> > back_projection_packed_sptr(density_sptr->get_empty_copy());
+
+  const int s = proj_data_info_sptr->get_max_segment_num();
+  for (int v=proj_data_info_sptr->get_min_view_num(); v<=proj_data_info_sptr->get_max_view_num(); ++v)
+    for (int a=proj_data_info_sptr->get_min_axial_pos_num(s); a<=proj_data_info_sptr->get_max_axial_pos_num(s); ++a)
+      for (int t=proj_data_info_sptr->get_min_tangential_pos_num(); t<=proj_data_info_sptr->get_max_tangential_pos_num(); ++t)
+        {
+          const Bin bin(s,v,a,t, 1.F);
+          proj_matrix.get_proj_matrix_elems_for_one_bin(elems, bin);
+          const PackedProjMatrixElemsForOneBin packed_elems(elems, value_format);
+          check_if_equal(packed_elems.size(), static_cast<std::size_t>(elems.size()), "number of packed elements");
+          packed_elems.unpack(unpacked_elems);
+          elems.sort();
+          if (!check(elems == unpacked_elems, "comparing unpacked lors"))
+            break;
+
+          Bin fwd_bin = bin;
+          fwd_bin.set_bin_value(0);
+          elems.forward_project(fwd_bin, *density_sptr);
+          Bin packed_fwd_bin = bin;
+          packed_fwd_bin.set_bin_value(0);
+          packed_elems.forward_project(packed_fwd_bin, *density_sptr);
+          if (!check_if_equal(fwd_bin.get_bin_value(), packed_fwd_bin.get_bin_value(), "comparing forward projection"))
+            break;
+
+          elems.back_project(*back_projection_sptr, bin);
+          packed_elems.back_project(*back_projection_packed_sptr, bin);
+        }
+  check_if_equal(*back_projection_sptr, *back_projection_packed_sptr, "comparing back projection");
+  density_sptr->fill(0.F);
+  set_tolerance(old_tolerance);
+}
+
+void
+ProjMatrixByBinTests::run_tests()
+{
+  cerr << "Tests for caching in ProjMatrixByBin\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  proj_data_info_sptr.reset(
+    ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                  /*span=*/3,
+                                  /*max_delta=*/12,
+                                  /*num_views=*/8,
+                                  /*num_tang_poss=*/16));
+  density_sptr.reset(new VoxelsOnCartesianGrid<float>(*proj_data_info_sptr, 1.F,
+                                                      CartesianCoordinate3D<float>(0,0,0)));
+
+  ProjMatrixByBinUsingRayTracing proj_matrix_no_cache;
+  if (!set_up_proj_matrix(proj_matrix_no_cache, true, true, 0))
+    return;
+
+  for (int store_only_basic_bins=1; store_only_basic_bins>=0; --store_only_basic_bins)
+    {
+      {
+        cerr << "\tTesting unlimited cache, store only basic bins: " << store_only_basic_bins << '\n';
+        ProjMatrixByBinUsingRayTracing proj_matrix;
+        if (!set_up_proj_matrix(proj_matrix, false, store_only_basic_bins!=0, 0))
+          return;
+        compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+        check(proj_matrix.get_num_cache_hits() > 0, "cache should have hits");
+        check(proj_matrix.get_num_cache_misses() > 0, "cache should have misses");
+        check_if_equal(proj_matrix.get_num_cache_evictions(), 0UL,
+                       "unlimited cache should not have evictions");
+        check(proj_matrix.get_cache_size() > 0, "cache size should be non-zero");
+        cerr << "\t" << proj_matrix.get_cache_statistics() << '\n';
+
+        proj_matrix.clear_cache();
+        check_if_equal(proj_matrix.get_num_cache_hits(), 0UL,
+                       "number of hits after clear_cache()");
+        compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+      }
+      {
+        cerr << "\tTesting limited cache, store only basic bins: " << store_only_basic_bins << '\n';
+        ProjMatrixByBinUsingRayTracing proj_matrix;
+        if (!set_up_proj_matrix(proj_matrix, false, store_only_basic_bins!=0, 1))
+          return;
+        // use a size which is too small for this matrix (even with basic bins)
+        const std::size_t max_cache_size = 10000;
+        proj_matrix.set_maximum_cache_size(max_cache_size);
+        compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+        check(proj_matrix.get_num_cache_evictions() > 0, "limited cache should have evictions");
+        check(proj_matrix.get_cache_size() <= max_cache_size, "cache size should be smaller than the maximum");
+        cerr << "\t" << proj_matrix.get_cache_statistics() << '\n';
+      }
+      {
+        cerr << "\tTesting cache with half float values, store only basic bins: " << store_only_basic_bins << '\n';
+        ProjMatrixByBinUsingRayTracing proj_matrix;
+        if (!set_up_proj_matrix(proj_matrix, false, store_only_basic_bins!=0, 0, "half float"))
+          return;
+        compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+      }
+    }
+
+  {
+    // basic bins in float format are stored unpacked, all bins are stored packed
+    cerr << "\tTesting changing from storing only basic bins to all bins in the cache\n";
+    ProjMatrixByBinUsingRayTracing proj_matrix;
+    if (!set_up_proj_matrix(proj_matrix, false, true, 0))
+      return;
+    compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+    proj_matrix.store_only_basic_bins_in_cache(false);
+    check_if_equal(proj_matrix.get_cache_size(), std::size_t(0),
+                   "cache should be cleared when changing which bins are stored");
+    compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+    check(proj_matrix.get_cache_size() > 0, "cache size should be non-zero");
+  }
+
+  {
+    cerr << "\tTesting ProjMatrixByBinFromFile (memory mapped)\n";
+    const std::string prefix = "test_ProjMatrixByBin_from_file";
+    if (check(ProjMatrixByBinFromFile::write_to_file(prefix, proj_matrix_no_cache,
+                                                     proj_data_info_sptr, *density_sptr)
+              == Succeeded::yes,
+              "writing projection matrix to file"))
+      {
+        ProjMatrixByBinFromFile proj_matrix;
+        if (check(proj_matrix.parse((prefix + ".hpm").c_str()),
+                  "parsing projection matrix header"))
+          {
+            // use the template image written by write_to_file, as the origin in the
+            // Interfile header is only written with limited precision
+            shared_ptr<DiscretisedDensity<3,float> >
+              template_density_sptr(read_from_file<DiscretisedDensity<3,float> >(prefix + "_template_density.hv"));
+            proj_matrix.set_up(proj_data_info_sptr, template_density_sptr);
+            // use a small cache to check that LORs can be re-read from file
+            proj_matrix.set_maximum_cache_size(10000);
+            compare_proj_matrices(proj_matrix_no_cache, proj_matrix);
+          }
+      }
+    // remove all files written by write_to_file (proj_matrix has closed the mapped file by now)
+    std::remove((prefix + ".hpm").c_str());
+    std::remove((prefix + ".pm").c_str());
+    std::remove((prefix + "_template_density.hv").c_str());
+    std::remove((prefix + "_template_density.ahv").c_str());
+    std::remove((prefix + "_template_density.v").c_str());
+    std::remove((prefix + "_template_proj_data.hs").c_str());
+    std::remove((prefix + "_template_proj_data.s").c_str());
+  }
+
+  cerr << "\tTesting PackedProjMatrixElemsForOneBin with float values\n";
+  run_tests_packed_rows(proj_matrix_no_cache, PackedProjMatrixElemsForOneBin::float_values);
+  cerr << "\tTesting PackedProjMatrixElemsForOneBin with half float values\n";
+  run_tests_packed_rows(proj_matrix_no_cache, PackedProjMatrixElemsForOneBin::half_float_values);
+  cerr << "\tTesting PackedProjMatrixElemsForOneBin with quantised values\n";
+  run_tests_packed_rows(proj_matrix_no_cache, PackedProjMatrixElemsForOneBin::quantised_values);
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  ProjMatrixByBinTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
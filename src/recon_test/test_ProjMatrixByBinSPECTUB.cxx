@@ -0,0 +1,224 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for the weight file of stir::ProjMatrixByBinSPECTUB
+*/
+
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/Scanner.h"
+#include "stir/IndexRange3D.h"
+#include "stir/recon_buildblock/ProjMatrixByBinSPECTUB.h"
+#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#ifndef STIR_NO_NAMESPACES
+using std::stringstream;
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for the weight file of ProjMatrixByBinSPECTUB
+
+  Computes a (small) SPECT matrix in memory, and compares all its rows with
+  the ones of a matrix that writes its weights to file and memory-maps it
+  (with all views in memory, or computing them one at a time), and a matrix
+  that maps the existing file.
+
+  The UB SPECT library uses global variables, so only one matrix can exist at
+  any time. Rows are therefore stored in a vector to compare them.
+*/
+class ProjMatrixByBinSPECTUBTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  shared_ptr<DiscretisedDensity<3,float> > density_sptr;
+
+  //! set up a matrix using \a weight_matrix_cache_directory (if not empty)
+  bool set_up_proj_matrix(ProjMatrixByBinSPECTUB& proj_matrix,
+                          const std::string& weight_matrix_cache_directory,
+                          const bool keep_all_views_in_cache = true);
+  //! get all rows of the matrix (sorted)
+  void get_all_rows(std::vector<ProjMatrixElemsForOneBin>& rows,
+                    const ProjMatrixByBin& proj_matrix);
+  //! compare all rows of the matrix with \a rows_ref
+  void compare_proj_matrices(const std::vector<ProjMatrixElemsForOneBin>& rows_ref,
+                             const ProjMatrixByBin& proj_matrix);
+};
+
+bool
+ProjMatrixByBinSPECTUBTests::
+set_up_proj_matrix(ProjMatrixByBinSPECTUB& proj_matrix,
+                   const std::string& weight_matrix_cache_directory,
+                   const bool keep_all_views_in_cache)
+{
+  stringstream str;
+  str <<
+    "Projection Matrix By Bin SPECT UB Parameters :=\n"
+    "maximum number of sigmas := 2.0\n"
+    "psf type := 2D\n"
+    "collimator slope := 0.0163\n"
+    "collimator sigma 0(cm) := 0.1466\n"
+    "attenuation type := No\n"
+    "mask type := No\n"
+    "keep_all_views_in_cache := " << (keep_all_views_in_cache ? 1 : 0) << "\n"
+    "weight matrix cache directory := " << weight_matrix_cache_directory << "\n"
+    "End Projection Matrix By Bin SPECT UB Parameters :=\n";
+  if (!check(proj_matrix.parse(str),
+             "parsing projection matrix parameters"))
+    return false;
+  proj_matrix.set_up(proj_data_info_sptr, density_sptr);
+  return true;
+}
+
+void
+ProjMatrixByBinSPECTUBTests::
+get_all_rows(std::vector<ProjMatrixElemsForOneBin>& rows,
+             const ProjMatrixByBin& proj_matrix)
+{
+  rows.clear();
+  for (int v=proj_data_info_sptr->get_min_view_num(); v<=proj_data_info_sptr->get_max_view_num(); ++v)
+    for (int a=proj_data_info_sptr->get_min_axial_pos_num(0); a<=proj_data_info_sptr->get_max_axial_pos_num(0); ++a)
+      for (int t=proj_data_info_sptr->get_min_tangential_pos_num(); t<=proj_data_info_sptr->get_max_tangential_pos_num(); ++t)
+        {
+          ProjMatrixElemsForOneBin elems;
+          proj_matrix.get_proj_matrix_elems_for_one_bin(elems, Bin(0,v,a,t));
+          elems.sort();
+          rows.push_back(elems);
+        }
+}
+
+void
+ProjMatrixByBinSPECTUBTests::
+compare_proj_matrices(const std::vector<ProjMatrixElemsForOneBin>& rows_ref,
+                      const ProjMatrixByBin& proj_matrix)
+{
+  std::vector<ProjMatrixElemsForOneBin> rows;
+  get_all_rows(rows, proj_matrix);
+  if (!check_if_equal(rows.size(), rows_ref.size(), "number of lors"))
+    return;
+  for (std::size_t i=0; i<rows.size(); ++i)
+    {
+      if (!check(rows_ref[i] == rows[i], "comparing lors"))
+        {
+          const Bin bin = rows[i].get_bin();
+          cerr << "Current bin: axial pos " << bin.axial_pos_num()
+               << ", view = " << bin.view_num()
+               << ", tangential_pos_num = " << bin.tangential_pos_num() << "\n";
+          return;
+        }
+    }
+}
+
+void
+ProjMatrixByBinSPECTUBTests::
+run_tests()
+{
+  cerr << "-------- Testing ProjMatrixByBinSPECTUB weight file --------\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  proj_data_info_sptr.reset(ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                                          /*span=*/1,
+                                                          /*max_delta=*/0,
+                                                          /*num_views=*/8,
+                                                          /*num_tang_poss=*/16,
+                                                          /*arc_corrected=*/true));
+  const float bin_size = proj_data_info_sptr->get_scanner_ptr()->get_default_bin_size();
+  const float ring_spacing = proj_data_info_sptr->get_scanner_ptr()->get_ring_spacing();
+  const int num_planes = proj_data_info_sptr->get_num_axial_poss(0);
+  density_sptr.reset(new VoxelsOnCartesianGrid<float>(IndexRange3D(0, num_planes-1, -8, 7, -8, 7),
+                                                      CartesianCoordinate3D<float>(0,0,0),
+                                                      CartesianCoordinate3D<float>(ring_spacing, bin_size, bin_size)));
+
+  std::vector<ProjMatrixElemsForOneBin> rows_in_memory;
+  {
+    ProjMatrixByBinSPECTUB proj_matrix;
+    if (!set_up_proj_matrix(proj_matrix, ""))
+      return;
+    check(!proj_matrix.is_using_weight_file(), "weights should be kept in memory without cache directory");
+    check(proj_matrix.get_weight_file_name().empty(), "weight file name without cache directory");
+    get_all_rows(rows_in_memory, proj_matrix);
+  }
+  {
+    std::size_t num_elements = 0;
+    for (std::size_t i=0; i<rows_in_memory.size(); ++i)
+      num_elements += rows_in_memory[i].size();
+    check(num_elements > 0, "matrix should have non-zero elements");
+  }
+
+  std::string weight_filename;
+  {
+    cerr << "\tTesting writing the weight file one view at a time\n";
+    ProjMatrixByBinSPECTUB proj_matrix;
+    if (!set_up_proj_matrix(proj_matrix, ".", /*keep_all_views_in_cache=*/false))
+      return;
+    weight_filename = proj_matrix.get_weight_file_name();
+    check(!weight_filename.empty(), "weight file name with cache directory (one view at a time)");
+    check(proj_matrix.is_using_weight_file(), "weights should be mapped after writing them one view at a time");
+    compare_proj_matrices(rows_in_memory, proj_matrix);
+  }
+  if (!weight_filename.empty())
+    std::remove(weight_filename.c_str());
+  {
+    cerr << "\tTesting writing the weight file\n";
+    ProjMatrixByBinSPECTUB proj_matrix;
+    if (!set_up_proj_matrix(proj_matrix, "."))
+      return;
+    check(proj_matrix.get_weight_file_name() == weight_filename, "weight file name should not depend on keeping views");
+    check(proj_matrix.is_using_weight_file(), "weights should be mapped after writing them");
+    check(std::ifstream(weight_filename.c_str()).good(), "weight file should exist");
+    compare_proj_matrices(rows_in_memory, proj_matrix);
+  }
+  {
+    cerr << "\tTesting mapping an existing weight file\n";
+    ProjMatrixByBinSPECTUB proj_matrix;
+    if (!set_up_proj_matrix(proj_matrix, "."))
+      return;
+    check(proj_matrix.get_weight_file_name() == weight_filename, "weight file name should be the same");
+    check(proj_matrix.is_using_weight_file(), "existing weight file should be mapped");
+    compare_proj_matrices(rows_in_memory, proj_matrix);
+  }
+  if (!weight_filename.empty())
+    std::remove(weight_filename.c_str());
+}
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main()
+{
+  ProjMatrixByBinSPECTUBTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
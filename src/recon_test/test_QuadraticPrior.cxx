@@ -0,0 +1,271 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::QuadraticPrior
+*/
+
+#include "stir/recon_buildblock/QuadraticPrior.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/IndexRange3D.h"
+#include "stir/Coordinate3D.h"
+#include "stir/Succeeded.h"
+#include "stir/RunTests.h"
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <iostream>
+#include <cmath>
+#include <string>
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for QuadraticPrior
+
+  Compares the value, gradient, parabolic surrogate curvature, Hessian (for a few
+  voxels) and multiplication with the approximate Hessian with a straightforward
+  implementation that loops over the 27 (or 9 in 2D) neighbours of every voxel.
+  This is done with and without \f$\kappa\f$ image, and with and without only_2D,
+  on a non-cubic image with non-zero minimum indices and different voxel sizes in
+  all directions.
+  Also checks that compute_value_gradient_and_curvature() and
+  compute_gradient_and_parabolic_surrogate_curvature() give the same results
+  as the separate functions.
+*/
+class QuadraticPriorTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef DiscretisedDensity<3,float> target_type;
+
+  void run_tests_for_one_prior(const bool only_2D, const bool use_kappa);
+
+  shared_ptr<VoxelsOnCartesianGrid<float> > image_sptr;
+  shared_ptr<VoxelsOnCartesianGrid<float> > kappa_sptr;
+
+  //! weights as documented for QuadraticPrior
+  float naive_weight(const int dz, const int dy, const int dx, const bool only_2D) const;
+  //! weight times kappas, or 0 if the neighbour is outside the image
+  float naive_weight(const Coordinate3D<int>& r, const Coordinate3D<int>& dr,
+                     const bool only_2D, const bool use_kappa) const;
+};
+
+float
+QuadraticPriorTests::
+naive_weight(const int dz, const int dy, const int dx, const bool only_2D) const
+{
+  if ((dz==0 && dy==0 && dx==0) || (only_2D && dz!=0))
+    return 0.F;
+  const CartesianCoordinate3D<float> grid_spacing = image_sptr->get_grid_spacing();
+  return static_cast<float>(grid_spacing.x()/
+                            std::sqrt(square(dx*grid_spacing.x()) +
+                                      square(dy*grid_spacing.y()) +
+                                      square(dz*grid_spacing.z())));
+}
+
+float
+QuadraticPriorTests::
+naive_weight(const Coordinate3D<int>& r, const Coordinate3D<int>& dr,
+             const bool only_2D, const bool use_kappa) const
+{
+  const Coordinate3D<int> neighbour = r + dr;
+  if (neighbour[1] < image_sptr->get_min_index() || neighbour[1] > image_sptr->get_max_index() ||
+      neighbour[2] < (*image_sptr)[neighbour[1]].get_min_index() ||
+      neighbour[2] > (*image_sptr)[neighbour[1]].get_max_index() ||
+      neighbour[3] < (*image_sptr)[neighbour[1]][neighbour[2]].get_min_index() ||
+      neighbour[3] > (*image_sptr)[neighbour[1]][neighbour[2]].get_max_index())
+    return 0.F;
+  float weight = naive_weight(dr[1], dr[2], dr[3], only_2D);
+  if (use_kappa)
+    weight *= (*kappa_sptr)[r] * (*kappa_sptr)[neighbour];
+  return weight;
+}
+
+void
+QuadraticPriorTests::
+run_tests_for_one_prior(const bool only_2D, const bool use_kappa)
+{
+  const std::string description =
+    std::string(only_2D ? "2D" : "3D") + (use_kappa ? " with kappa" : " without kappa");
+  cerr << "\tTesting " << description << '\n';
+
+  const float penalisation_factor = 1.3F;
+  QuadraticPrior<float> prior(only_2D, penalisation_factor);
+  if (use_kappa)
+    prior.set_kappa_sptr(kappa_sptr);
+
+  const VoxelsOnCartesianGrid<float>& image = *image_sptr;
+  // the input for the multiplication with the approximate Hessian
+  shared_ptr<target_type> input_sptr(image.clone());
+  *input_sptr *= -.5F;
+  *input_sptr += 2.F;
+
+  // straightforward implementation
+  double naive_value = 0;
+  shared_ptr<target_type> naive_gradient_sptr(image.get_empty_copy());
+  shared_ptr<target_type> naive_curvature_sptr(image.get_empty_copy());
+  shared_ptr<target_type> naive_Hessian_product_sptr(image.get_empty_copy());
+  naive_Hessian_product_sptr->fill(1.F);
+  for (int z=image.get_min_index(); z<=image.get_max_index(); ++z)
+    for (int y=image[z].get_min_index(); y<=image[z].get_max_index(); ++y)
+      for (int x=image[z][y].get_min_index(); x<=image[z][y].get_max_index(); ++x)
+        {
+          const Coordinate3D<int> r(z,y,x);
+          double gradient = 0, curvature = 0, Hessian_product = 0;
+          for (int dz=-1; dz<=1; ++dz)
+            for (int dy=-1; dy<=1; ++dy)
+              for (int dx=-1; dx<=1; ++dx)
+                {
+                  const Coordinate3D<int> dr(dz,dy,dx);
+                  const float weight = naive_weight(r, dr, only_2D, use_kappa);
+                  if (weight == 0)
+                    continue;
+                  const double diff = image[r] - image[r+dr];
+                  naive_value += weight*square(diff)/4;
+                  gradient += weight*diff;
+                  curvature += weight;
+                  Hessian_product += weight*(*input_sptr)[r+dr];
+                }
+          (*naive_gradient_sptr)[r] = static_cast<float>(gradient*penalisation_factor);
+          (*naive_curvature_sptr)[r] = static_cast<float>(curvature*penalisation_factor);
+          (*naive_Hessian_product_sptr)[r] += static_cast<float>(Hessian_product*penalisation_factor);
+        }
+  naive_value *= penalisation_factor;
+
+  check_if_equal(prior.compute_value(image), naive_value, description + ": value");
+
+  shared_ptr<target_type> gradient_sptr(image.get_empty_copy());
+  prior.compute_gradient(*gradient_sptr, image);
+  check_if_equal(*gradient_sptr, *naive_gradient_sptr, description + ": gradient");
+
+  shared_ptr<target_type> curvature_sptr(image.get_empty_copy());
+  prior.parabolic_surrogate_curvature(*curvature_sptr, image);
+  check_if_equal(*curvature_sptr, *naive_curvature_sptr, description + ": parabolic surrogate curvature");
+
+  shared_ptr<target_type> Hessian_product_sptr(image.get_empty_copy());
+  Hessian_product_sptr->fill(1.F);
+  check(prior.add_multiplication_with_approximate_Hessian(*Hessian_product_sptr, *input_sptr) == Succeeded::yes,
+        description + ": add_multiplication_with_approximate_Hessian return value");
+  check_if_equal(*Hessian_product_sptr, *naive_Hessian_product_sptr,
+                 description + ": multiplication with approximate Hessian");
+
+  {
+    // fill with garbage to check that everything is overwritten
+    gradient_sptr->fill(1000.F);
+    curvature_sptr->fill(1000.F);
+    const double value = prior.compute_value_gradient_and_curvature(*gradient_sptr, *curvature_sptr, image);
+    check_if_equal(value, naive_value, description + ": value from compute_value_gradient_and_curvature");
+    check_if_equal(*gradient_sptr, *naive_gradient_sptr,
+                   description + ": gradient from compute_value_gradient_and_curvature");
+    check_if_equal(*curvature_sptr, *naive_curvature_sptr,
+                   description + ": curvature from compute_value_gradient_and_curvature");
+  }
+  {
+    gradient_sptr->fill(1000.F);
+    curvature_sptr->fill(1000.F);
+    PriorWithParabolicSurrogate<target_type>& base_prior = prior;
+    base_prior.compute_gradient_and_parabolic_surrogate_curvature(*gradient_sptr, *curvature_sptr, image);
+    check_if_equal(*gradient_sptr, *naive_gradient_sptr,
+                   description + ": gradient from compute_gradient_and_parabolic_surrogate_curvature");
+    check_if_equal(*curvature_sptr, *naive_curvature_sptr,
+                   description + ": curvature from compute_gradient_and_parabolic_surrogate_curvature");
+  }
+
+  // Hessian for a corner voxel, a voxel on an edge and a voxel in the interior
+  const int min_z = image.get_min_index();
+  const int min_y = image[min_z].get_min_index();
+  const int min_x = image[min_z][min_y].get_min_index();
+  const int max_x = image[min_z][min_y].get_max_index();
+  const Coordinate3D<int> voxels[3] =
+    { Coordinate3D<int>(min_z, min_y, min_x),
+      Coordinate3D<int>(min_z+2, min_y, max_x),
+      Coordinate3D<int>(min_z+3, min_y+2, min_x+4) };
+  for (int i=0; i<3; ++i)
+    {
+      const Coordinate3D<int>& r = voxels[i];
+      shared_ptr<target_type> Hessian_sptr(image.get_empty_copy());
+      prior.compute_Hessian(*Hessian_sptr, r, image);
+      shared_ptr<target_type> naive_Hessian_sptr(image.get_empty_copy());
+      float diagonal = 0;
+      for (int dz=-1; dz<=1; ++dz)
+        for (int dy=-1; dy<=1; ++dy)
+          for (int dx=-1; dx<=1; ++dx)
+            {
+              const Coordinate3D<int> dr(dz,dy,dx);
+              const float weight = naive_weight(r, dr, only_2D, use_kappa);
+              if (weight == 0)
+                continue;
+              diagonal += weight;
+              (*naive_Hessian_sptr)[r+dr] = -weight*penalisation_factor;
+            }
+      (*naive_Hessian_sptr)[r] = diagonal*penalisation_factor;
+      check_if_equal(*Hessian_sptr, *naive_Hessian_sptr, description + ": Hessian");
+    }
+}
+
+void
+QuadraticPriorTests::run_tests()
+{
+  cerr << "Tests for QuadraticPrior\n";
+
+  // non-cubic image with different voxel sizes
+  image_sptr.reset(new VoxelsOnCartesianGrid<float>(IndexRange3D(1,7, -5,4, -3,8),
+                                                    CartesianCoordinate3D<float>(0.F,0.F,0.F),
+                                                    CartesianCoordinate3D<float>(2.F,2.5F,3.F)));
+  kappa_sptr.reset(image_sptr->get_empty_voxels_on_cartesian_grid());
+  {
+    typedef boost::mt19937 base_generator_type;
+    base_generator_type generator(boost::uint32_t(42));
+    boost::uniform_01<base_generator_type> random01(generator);
+    for (VoxelsOnCartesianGrid<float>::full_iterator iter = image_sptr->begin_all();
+         iter != image_sptr->end_all(); ++iter)
+      *iter = static_cast<float>(random01()*10);
+    for (VoxelsOnCartesianGrid<float>::full_iterator iter = kappa_sptr->begin_all();
+         iter != kappa_sptr->end_all(); ++iter)
+      *iter = static_cast<float>(.5 + random01());
+  }
+
+  // different order of summation in float
+  set_tolerance(1.E-4);
+  run_tests_for_one_prior(/*only_2D=*/false, /*use_kappa=*/false);
+  run_tests_for_one_prior(/*only_2D=*/false, /*use_kappa=*/true);
+  run_tests_for_one_prior(/*only_2D=*/true, /*use_kappa=*/false);
+  run_tests_for_one_prior(/*only_2D=*/true, /*use_kappa=*/true);
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  QuadraticPriorTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -0,0 +1,192 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for the version of stir::RayTraceVoxelsOnCartesianGrid
+  that traces several LORs and merges them in one pass
+*/
+
+#include "stir/recon_buildblock/RayTraceVoxelsOnCartesianGrid.h"
+#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/CartesianCoordinate3D.h"
+#include "stir/Bin.h"
+#include "stir/RunTests.h"
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <iostream>
+#include <vector>
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for RayTraceVoxelsOnCartesianGrid with several LORs
+
+  Compares the result of ray tracing several LORs at once with ray tracing every
+  LOR separately and merging the results with ProjMatrixElemsForOneBin::merge().
+  This is done for random LORs (close to each other, as for the LORs of one bin
+  in ProjMatrixByBinUsingRayTracing), LORs parallel to the axes, LORs on
+  planes between voxels, and with and without elements in the LOR on input.
+*/
+class RayTraceVoxelsOnCartesianGridTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef std::vector<CartesianCoordinate3D<float> > points_type;
+
+  //! compare both ways of ray tracing, \a lor_on_input is used as initial value
+  void check_rays(const points_type& start_points, const points_type& end_points,
+                  const ProjMatrixElemsForOneBin& lor_on_input,
+                  const char * const description);
+};
+
+void
+RayTraceVoxelsOnCartesianGridTests::
+check_rays(const points_type& start_points, const points_type& end_points,
+           const ProjMatrixElemsForOneBin& lor_on_input,
+           const char * const description)
+{
+  const CartesianCoordinate3D<float> voxel_size(2.F,3.F,3.F);
+  const float normalisation_constant = 1.5F;
+
+  ProjMatrixElemsForOneBin reference_lor = lor_on_input;
+  for (std::size_t i=0; i<start_points.size(); ++i)
+    {
+      ProjMatrixElemsForOneBin one_lor(lor_on_input.get_bin());
+      RayTraceVoxelsOnCartesianGrid(one_lor, start_points[i], end_points[i],
+                                    voxel_size, normalisation_constant);
+      reference_lor.merge(one_lor);
+    }
+  reference_lor.sort();
+
+  ProjMatrixElemsForOneBin lor = lor_on_input;
+  RayTraceVoxelsOnCartesianGrid(lor, start_points, end_points,
+                                voxel_size, normalisation_constant);
+  lor.sort();
+
+  if (!check_if_equal(lor.size(), reference_lor.size(), std::string(description) + ": number of elements"))
+    return;
+  ProjMatrixElemsForOneBin::const_iterator iter = lor.begin();
+  ProjMatrixElemsForOneBin::const_iterator reference_iter = reference_lor.begin();
+  for (; iter != lor.end(); ++iter, ++reference_iter)
+    {
+      if (!check(ProjMatrixElemsForOneBin::value_type::coordinates_equal(*iter, *reference_iter),
+                 std::string(description) + ": coordinates") ||
+          !check_if_equal(iter->get_value(), reference_iter->get_value(),
+                          std::string(description) + ": value"))
+        {
+          cerr << "Element " << (iter - lor.begin())
+               << " at " << iter->coord1() << ',' << iter->coord2() << ',' << iter->coord3() << '\n';
+          return;
+        }
+    }
+}
+
+void
+RayTraceVoxelsOnCartesianGridTests::run_tests()
+{
+  cerr << "Tests for RayTraceVoxelsOnCartesianGrid with several LORs\n";
+
+  const Bin bin(0,0,0,0);
+  const ProjMatrixElemsForOneBin empty_lor(bin);
+
+  typedef boost::mt19937 base_generator_type;
+  base_generator_type generator(boost::uint32_t(42));
+  boost::uniform_01<base_generator_type> random01(generator);
+
+  {
+    cerr << "\tTesting no LORs\n";
+    check_rays(points_type(), points_type(), empty_lor, "no LORs");
+  }
+  {
+    cerr << "\tTesting random LORs close to each other\n";
+    for (int num_tests=0; num_tests<200; ++num_tests)
+      {
+        const int num_lors = 1 + num_tests%8;
+        const CartesianCoordinate3D<float>
+          start_point(static_cast<float>(random01()*10-5),
+                      static_cast<float>(random01()*40-20),
+                      static_cast<float>(random01()*40-20));
+        const CartesianCoordinate3D<float>
+          end_point(static_cast<float>(random01()*10-5),
+                    static_cast<float>(random01()*40-20),
+                    static_cast<float>(random01()*40-20));
+        // shift the LORs a bit in x and y
+        points_type start_points, end_points;
+        for (int i=0; i<num_lors; ++i)
+          {
+            const CartesianCoordinate3D<float>
+              offset(0.F, static_cast<float>(random01()-.5), static_cast<float>(random01()-.5));
+            start_points.push_back(start_point + offset);
+            end_points.push_back(end_point + offset);
+          }
+        check_rays(start_points, end_points, empty_lor, "random LORs");
+        if (!is_everything_ok())
+          return;
+      }
+  }
+  {
+    cerr << "\tTesting LORs parallel to the axes and on planes between voxels\n";
+    points_type start_points, end_points;
+    // along x, y and z
+    start_points.push_back(CartesianCoordinate3D<float>(0.F,0.F,-10.F));
+    end_points.push_back(CartesianCoordinate3D<float>(0.F,0.F,10.F));
+    start_points.push_back(CartesianCoordinate3D<float>(0.F,-10.F,0.F));
+    end_points.push_back(CartesianCoordinate3D<float>(0.F,10.F,0.F));
+    start_points.push_back(CartesianCoordinate3D<float>(-4.F,1.F,1.F));
+    end_points.push_back(CartesianCoordinate3D<float>(4.F,1.F,1.F));
+    // in the plane between voxels
+    start_points.push_back(CartesianCoordinate3D<float>(0.5F,-10.F,-10.F));
+    end_points.push_back(CartesianCoordinate3D<float>(0.5F,10.F,10.F));
+    start_points.push_back(CartesianCoordinate3D<float>(0.F,-10.5F,.5F));
+    end_points.push_back(CartesianCoordinate3D<float>(0.F,10.5F,.5F));
+    // same LOR twice
+    start_points.push_back(CartesianCoordinate3D<float>(0.F,0.F,-10.F));
+    end_points.push_back(CartesianCoordinate3D<float>(0.F,0.F,10.F));
+    check_rays(start_points, end_points, empty_lor, "LORs parallel to the axes");
+
+    cerr << "\tTesting with elements in the LOR on input\n";
+    ProjMatrixElemsForOneBin lor_on_input(bin);
+    RayTraceVoxelsOnCartesianGrid(lor_on_input,
+                                  CartesianCoordinate3D<float>(-1.F,-8.F,-9.F),
+                                  CartesianCoordinate3D<float>(2.F,7.F,6.F),
+                                  CartesianCoordinate3D<float>(1.F,1.F,1.F));
+    check_rays(start_points, end_points, lor_on_input, "LOR with elements on input");
+  }
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  RayTraceVoxelsOnCartesianGridTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -0,0 +1,279 @@
+//
+//
+/*!
+
+  \file
+  \ingroup recon_test
+
+  \brief Test program for stir::distributable_computation with MPI
+
+  \par Usage
+
+  <pre>
+  mpirun -np 3 test_distributable_computation
+  </pre>
+  Any number of processes larger than 1 can be used.
+  This test is only compiled when STIR_MPI is enabled.
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/recon_buildblock/distributable.h"
+#include "stir/recon_buildblock/distributable_main.h"
+#include "stir/recon_buildblock/distributed_functions.h"
+#include "stir/recon_buildblock/find_basic_vs_nums_in_subsets.h"
+#include "stir/recon_buildblock/PoissonLogLikelihoodWithLinearModelForMeanAndProjData.h" // for RPC functions
+#include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
+#include "stir/recon_buildblock/ProjectorByBinPairUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/BinNormalisationFromProjData.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/SegmentByView.h"
+#include "stir/RelatedViewgrams.h"
+#include "stir/DataSymmetriesForViewSegmentNumbers.h"
+#include "stir/ExamInfo.h"
+#include "stir/Scanner.h"
+#include "stir/HighResWallClockTimer.h"
+#include "stir/RunTests.h"
+#include "stir/info.h"
+#include <boost/format.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <iostream>
+#include <vector>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup test
+  \brief Test class for the MPI version of distributable_computation()
+
+  The gradient and log-likelihood of the Poisson objective function are computed
+  with distributable_computation(), i.e. the work packages are sent to the workers.
+  The result is compared with calling the same RPC functions on the master for all
+  view/segments in the subset.
+
+  Several computations are done after each other, such that the workers have to
+  receive work packages of different subsets and reuse their receive-buffers.
+  The additive and multiplicative viewgrams are included, such that all messages
+  of a work package are tested.
+*/
+class DistributableComputationTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef DiscretisedDensity<3,float> target_type;
+
+  //! fill all bins with random values in [offset, offset+1)
+  static void fill_randomly(ProjData& proj_data, const float offset);
+
+  //! compute on the master what distributable_computation() should compute
+  void compute_reference(target_type* output_image_ptr, double* log_likelihood_ptr,
+                         const target_type& input_image,
+                         const ProjDataInMemory& proj_data,
+                         const ProjDataInMemory& add_proj_data,
+                         const BinNormalisation* normalisation_ptr,
+                         const int subset_num, const int num_subsets,
+                         RPC_process_related_viewgrams_type * RPC_process_related_viewgrams);
+
+  shared_ptr<ProjectorByBinPair> proj_pair_sptr;
+};
+
+void
+DistributableComputationTests::
+fill_randomly(ProjData& proj_data, const float offset)
+{
+  typedef boost::mt19937 base_generator_type;
+  static base_generator_type generator(boost::uint32_t(42));
+  static boost::uniform_01<base_generator_type> random01(generator);
+  for (int seg_num=proj_data.get_min_segment_num(); seg_num<=proj_data.get_max_segment_num(); ++seg_num)
+    {
+      SegmentByView<float> segment = proj_data.get_empty_segment_by_view(seg_num);
+      for (SegmentByView<float>::full_iterator iter = segment.begin_all(); iter != segment.end_all(); ++iter)
+        *iter = offset + static_cast<float>(random01());
+      proj_data.set_segment(segment);
+    }
+}
+
+void
+DistributableComputationTests::
+compute_reference(target_type* output_image_ptr, double* log_likelihood_ptr,
+                  const target_type& input_image,
+                  const ProjDataInMemory& proj_data,
+                  const ProjDataInMemory& add_proj_data,
+                  const BinNormalisation* normalisation_ptr,
+                  const int subset_num, const int num_subsets,
+                  RPC_process_related_viewgrams_type * RPC_process_related_viewgrams)
+{
+  if (output_image_ptr != 0)
+    output_image_ptr->fill(0.F);
+  if (log_likelihood_ptr != 0)
+    *log_likelihood_ptr = 0.;
+  shared_ptr<DataSymmetriesForViewSegmentNumbers>
+    symmetries_sptr(this->proj_pair_sptr->get_symmetries_used()->clone());
+  const std::vector<ViewSegmentNumbers> vs_nums =
+    detail::find_basic_vs_nums_in_subset(*proj_data.get_proj_data_info_ptr(), *symmetries_sptr,
+                                         proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
+                                         subset_num, num_subsets);
+  int count=0, count2=0;
+  for (std::vector<ViewSegmentNumbers>::const_iterator iter = vs_nums.begin(); iter != vs_nums.end(); ++iter)
+    {
+      RelatedViewgrams<float> y = proj_data.get_related_viewgrams(*iter, symmetries_sptr);
+      const RelatedViewgrams<float> add = add_proj_data.get_related_viewgrams(*iter, symmetries_sptr);
+      shared_ptr<RelatedViewgrams<float> > mult_sptr;
+      if (normalisation_ptr != 0)
+        {
+          mult_sptr.reset(new RelatedViewgrams<float>(proj_data.get_empty_related_viewgrams(*iter, symmetries_sptr)));
+          mult_sptr->fill(1.F);
+          normalisation_ptr->undo(*mult_sptr, 0., 0.);
+        }
+      RPC_process_related_viewgrams(this->proj_pair_sptr->get_forward_projector_sptr(),
+                                    this->proj_pair_sptr->get_back_projector_sptr(),
+                                    output_image_ptr, &input_image, &y,
+                                    count, count2, log_likelihood_ptr,
+                                    &add, mult_sptr.get());
+    }
+}
+
+void
+DistributableComputationTests::
+run_tests()
+{
+  std::cerr << "Tests for distributable_computation with " << distributed::num_processors << " processes\n";
+
+  // construct a small scanner and sinograms
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  scanner_sptr->set_num_rings(5);
+  shared_ptr<ProjDataInfo> proj_data_info_sptr(
+    ProjDataInfo::ProjDataInfoCTI(scanner_sptr,
+                                  /*span=*/3,
+                                  /*max_delta=*/4,
+                                  /*num_views=*/16,
+                                  /*num_tang_poss=*/16));
+  shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+  shared_ptr<ProjDataInMemory> proj_data_sptr(new ProjDataInMemory(exam_info_sptr, proj_data_info_sptr));
+  shared_ptr<ProjDataInMemory> add_proj_data_sptr(new ProjDataInMemory(exam_info_sptr, proj_data_info_sptr));
+  shared_ptr<ProjDataInMemory> mult_proj_data_sptr(new ProjDataInMemory(exam_info_sptr, proj_data_info_sptr));
+  fill_randomly(*proj_data_sptr, 1.F);
+  fill_randomly(*add_proj_data_sptr, .1F);
+  fill_randomly(*mult_proj_data_sptr, .5F);
+  shared_ptr<BinNormalisation> normalisation_sptr(new BinNormalisationFromProjData(mult_proj_data_sptr));
+  normalisation_sptr->set_up(proj_data_info_sptr);
+
+  shared_ptr<target_type> image_sptr(new VoxelsOnCartesianGrid<float>(*proj_data_info_sptr, 1.F, CartesianCoordinate3D<float>(0,0,0)));
+  {
+    typedef boost::mt19937 base_generator_type;
+    base_generator_type generator(boost::uint32_t(43));
+    boost::uniform_01<base_generator_type> random01(generator);
+    for (target_type::full_iterator iter=image_sptr->begin_all(); iter!=image_sptr->end_all(); ++iter)
+      *iter = static_cast<float>(random01());
+  }
+
+  shared_ptr<ProjMatrixByBin> proj_matrix_sptr(new ProjMatrixByBinUsingRayTracing());
+  this->proj_pair_sptr.reset(new ProjectorByBinPairUsingProjMatrixByBin(proj_matrix_sptr));
+  if (!check(this->proj_pair_sptr->set_up(proj_data_info_sptr, image_sptr) == Succeeded::yes,
+             "set-up of projectors"))
+    return;
+  shared_ptr<DataSymmetriesForViewSegmentNumbers>
+    symmetries_sptr(this->proj_pair_sptr->get_symmetries_used()->clone());
+
+#ifdef STIR_MPI_TIMINGS
+  // report how long master and workers wait for each other, but not every single message
+  distributed::test_send_receive_times = true;
+  distributed::min_threshold = 1.;
+#endif
+  setup_distributable_computation(this->proj_pair_sptr, exam_info_sptr, proj_data_info_sptr.get(),
+                                  image_sptr, /*zero_seg0_end_planes=*/false, /*distributed_cache_enabled=*/false);
+
+  shared_ptr<target_type> gradient_sptr(image_sptr->get_empty_copy());
+  shared_ptr<target_type> reference_gradient_sptr(image_sptr->get_empty_copy());
+  HighResWallClockTimer timer;
+  // the workers add up their results in a different order than the master
+  this->set_tolerance(1.E-3);
+
+  // (num_subsets, subset_num) pairs. The first 2 use all view/segments.
+  const int subsets[4][2] = { {1,0}, {1,0}, {4,1}, {4,3} };
+  for (int i=0; i<4; ++i)
+    {
+      const int num_subsets = subsets[i][0];
+      const int subset_num = subsets[i][1];
+      std::cerr << "Subset " << subset_num << " of " << num_subsets << '\n';
+
+      // gradient (uses the additive viewgrams)
+      timer.reset(); timer.start();
+      distributable_computation(this->proj_pair_sptr->get_forward_projector_sptr(),
+                                this->proj_pair_sptr->get_back_projector_sptr(),
+                                symmetries_sptr,
+                                gradient_sptr.get(), image_sptr.get(),
+                                proj_data_sptr, /*read_from_proj_data=*/true,
+                                subset_num, num_subsets,
+                                proj_data_sptr->get_min_segment_num(), proj_data_sptr->get_max_segment_num(),
+                                /*zero_seg0_end_planes=*/false,
+                                /*double_out_ptr=*/0,
+                                add_proj_data_sptr,
+                                shared_ptr<BinNormalisation>(),
+                                0., 0.,
+                                &RPC_process_related_viewgrams_gradient,
+                                /*caching_info_ptr=*/0);
+      timer.stop();
+      info(boost::format("distributable_computation of the gradient took %1% seconds") % timer.value());
+      compute_reference(reference_gradient_sptr.get(), 0, *image_sptr,
+                        *proj_data_sptr, *add_proj_data_sptr, 0,
+                        subset_num, num_subsets,
+                        &RPC_process_related_viewgrams_gradient);
+      check_if_equal(*reference_gradient_sptr, *gradient_sptr, "gradient");
+
+      // log-likelihood (uses the additive and multiplicative viewgrams)
+      double log_likelihood = 0.;
+      distributable_computation(this->proj_pair_sptr->get_forward_projector_sptr(),
+                                this->proj_pair_sptr->get_back_projector_sptr(),
+                                symmetries_sptr,
+                                /*output_image_ptr=*/0, image_sptr.get(),
+                                proj_data_sptr, /*read_from_proj_data=*/true,
+                                subset_num, num_subsets,
+                                proj_data_sptr->get_min_segment_num(), proj_data_sptr->get_max_segment_num(),
+                                /*zero_seg0_end_planes=*/false,
+                                &log_likelihood,
+                                add_proj_data_sptr,
+                                normalisation_sptr,
+                                0., 0.,
+                                &RPC_process_related_viewgrams_accumulate_loglikelihood,
+                                /*caching_info_ptr=*/0);
+      double reference_log_likelihood = 0.;
+      compute_reference(0, &reference_log_likelihood, *image_sptr,
+                        *proj_data_sptr, *add_proj_data_sptr, normalisation_sptr.get(),
+                        subset_num, num_subsets,
+                        &RPC_process_related_viewgrams_accumulate_loglikelihood);
+      check_if_equal(reference_log_likelihood, log_likelihood, "log-likelihood");
+    }
+
+  end_distributable_computation();
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+int stir::distributable_main(int argc, char **argv)
+{
+  DistributableComputationTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
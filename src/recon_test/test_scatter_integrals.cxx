@@ -0,0 +1,232 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::ScatterEstimationByBin::integral_between_2_points
+*/
+
+#include "stir/scatter/ScatterEstimationByBin.h"
+#include "stir/recon_buildblock/RayTraceVoxelsOnCartesianGrid.h"
+#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/IndexRange3D.h"
+#include "stir/CartesianCoordinate3D.h"
+#include "stir/RunTests.h"
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <iostream>
+#include <string>
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+#endif
+
+START_NAMESPACE_STIR
+
+//! gives access to the protected ScatterEstimationByBin::integral_between_2_points
+class ScatterEstimationByBinForTesting : public ScatterEstimationByBin
+{
+public:
+  using ScatterEstimationByBin::integral_between_2_points;
+};
+
+/*!
+  \ingroup test
+  \brief Test class for ScatterEstimationByBin::integral_between_2_points
+
+  integral_between_2_points() marches along the line and adds the image values
+  on the fly. This test compares it with the sum over the voxels found by
+  RayTraceVoxelsOnCartesianGrid (which is how it used to be implemented),
+  for random lines, lines parallel to the axes, lines in the planes between voxels,
+  and lines that start or end outside the image.
+*/
+class ScatterIntegralsTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  shared_ptr<VoxelsOnCartesianGrid<float> > image_sptr;
+
+  //! convert from voxel units to the coordinates used by integral_between_2_points
+  CartesianCoordinate3D<float>
+    voxel_to_scatter_coords(const CartesianCoordinate3D<float>& voxel_coords) const;
+  //! sum over the voxels found by RayTraceVoxelsOnCartesianGrid
+  float reference_integral(const CartesianCoordinate3D<float>& point1,
+                           const CartesianCoordinate3D<float>& point2) const;
+  //! compare integral_between_2_points with reference_integral (both directions), points in voxel units
+  bool check_line(const CartesianCoordinate3D<float>& voxel_coords1,
+                  const CartesianCoordinate3D<float>& voxel_coords2,
+                  const std::string& description);
+};
+
+CartesianCoordinate3D<float>
+ScatterIntegralsTests::
+voxel_to_scatter_coords(const CartesianCoordinate3D<float>& voxel_coords) const
+{
+  const VoxelsOnCartesianGrid<float>& image = *image_sptr;
+  const CartesianCoordinate3D<float> voxel_size = image.get_grid_spacing();
+  CartesianCoordinate3D<float> origin = image.get_origin();
+  origin.z() -= (image.get_max_index() + image.get_min_index())*voxel_size.z()/2.F;
+  return voxel_coords*voxel_size + origin;
+}
+
+float
+ScatterIntegralsTests::
+reference_integral(const CartesianCoordinate3D<float>& point1,
+                   const CartesianCoordinate3D<float>& point2) const
+{
+  const VoxelsOnCartesianGrid<float>& image = *image_sptr;
+  const CartesianCoordinate3D<float> voxel_size = image.get_grid_spacing();
+  CartesianCoordinate3D<float> origin = image.get_origin();
+  origin.z() -= (image.get_max_index() + image.get_min_index())*voxel_size.z()/2.F;
+
+  ProjMatrixElemsForOneBin lor;
+  RayTraceVoxelsOnCartesianGrid(lor,
+                                (point1-origin)/voxel_size,
+                                (point2-origin)/voxel_size,
+                                voxel_size,
+#ifdef NEWSCALE
+                                1.F
+#else
+                                1/voxel_size.x()
+#endif
+                                );
+  float sum = 0;
+  for (ProjMatrixElemsForOneBin::const_iterator element_ptr = lor.begin();
+       element_ptr != lor.end();
+       ++element_ptr)
+    {
+      const BasicCoordinate<3,int> coords = element_ptr->get_coords();
+      if (coords[1] >= image.get_min_index() &&
+          coords[1] <= image.get_max_index() &&
+          coords[2] >= image[coords[1]].get_min_index() &&
+          coords[2] <= image[coords[1]].get_max_index() &&
+          coords[3] >= image[coords[1]][coords[2]].get_min_index() &&
+          coords[3] <= image[coords[1]][coords[2]].get_max_index())
+        sum += image[coords] * element_ptr->get_value();
+    }
+  return sum;
+}
+
+bool
+ScatterIntegralsTests::
+check_line(const CartesianCoordinate3D<float>& voxel_coords1,
+           const CartesianCoordinate3D<float>& voxel_coords2,
+           const std::string& description)
+{
+  const CartesianCoordinate3D<float> point1 = voxel_to_scatter_coords(voxel_coords1);
+  const CartesianCoordinate3D<float> point2 = voxel_to_scatter_coords(voxel_coords2);
+  if (!check_if_equal(ScatterEstimationByBinForTesting::integral_between_2_points(*image_sptr, point1, point2),
+                      reference_integral(point1, point2),
+                      description) ||
+      !check_if_equal(ScatterEstimationByBinForTesting::integral_between_2_points(*image_sptr, point2, point1),
+                      reference_integral(point2, point1),
+                      description + " (reversed)"))
+    {
+      cerr << "Line between " << voxel_coords1 << " and " << voxel_coords2 << " (in voxel units)\n";
+      return false;
+    }
+  return true;
+}
+
+void
+ScatterIntegralsTests::run_tests()
+{
+  cerr << "Tests for ScatterEstimationByBin::integral_between_2_points\n";
+
+  // image with different voxel sizes and a non-zero origin
+  image_sptr.reset(new VoxelsOnCartesianGrid<float>(IndexRange3D(0,9, -8,7, -6,9),
+                                                    CartesianCoordinate3D<float>(3.F,-2.F,5.F),
+                                                    CartesianCoordinate3D<float>(2.F,2.5F,3.F)));
+  typedef boost::mt19937 base_generator_type;
+  base_generator_type generator(boost::uint32_t(42));
+  boost::uniform_01<base_generator_type> random01(generator);
+  for (VoxelsOnCartesianGrid<float>::full_iterator iter = image_sptr->begin_all();
+       iter != image_sptr->end_all(); ++iter)
+    *iter = static_cast<float>(random01());
+
+  // sums over many voxels in float
+  set_tolerance(1.E-4);
+
+  {
+    cerr << "\tTesting random lines\n";
+    for (int i=0; i<500; ++i)
+      {
+        // in voxel units, somewhat larger than the image
+        const CartesianCoordinate3D<float>
+          voxel_coords1(static_cast<float>(random01()*14-2),
+                        static_cast<float>(random01()*22-11),
+                        static_cast<float>(random01()*22-8));
+        const CartesianCoordinate3D<float>
+          voxel_coords2(static_cast<float>(random01()*14-2),
+                        static_cast<float>(random01()*22-11),
+                        static_cast<float>(random01()*22-8));
+        if (!check_line(voxel_coords1, voxel_coords2, "random line"))
+          return;
+      }
+  }
+  {
+    cerr << "\tTesting lines parallel to the axes\n";
+    check_line(CartesianCoordinate3D<float>(-3.F,2.F,1.F), CartesianCoordinate3D<float>(12.F,2.F,1.F),
+               "line along z");
+    check_line(CartesianCoordinate3D<float>(4.F,-12.F,3.2F), CartesianCoordinate3D<float>(4.F,10.F,3.2F),
+               "line along y");
+    check_line(CartesianCoordinate3D<float>(6.3F,-1.7F,-9.F), CartesianCoordinate3D<float>(6.3F,-1.7F,13.F),
+               "line along x");
+    check_line(CartesianCoordinate3D<float>(2.F,-12.F,-9.F), CartesianCoordinate3D<float>(2.F,10.F,13.F),
+               "line in a transaxial plane");
+  }
+  {
+    cerr << "\tTesting lines in the planes between voxels\n";
+    check_line(CartesianCoordinate3D<float>(3.5F,-12.F,-9.F), CartesianCoordinate3D<float>(3.5F,10.F,13.F),
+               "line in a plane between voxels in z");
+    check_line(CartesianCoordinate3D<float>(-3.F,.5F,-9.F), CartesianCoordinate3D<float>(12.F,.5F,13.F),
+               "line in a plane between voxels in y");
+    check_line(CartesianCoordinate3D<float>(-3.F,-12.F,-2.5F), CartesianCoordinate3D<float>(12.F,10.F,-2.5F),
+               "line in a plane between voxels in x");
+    check_line(CartesianCoordinate3D<float>(-3.F,1.5F,-2.5F), CartesianCoordinate3D<float>(12.F,1.5F,-2.5F),
+               "line along z between voxels in x and y");
+  }
+  {
+    cerr << "\tTesting lines starting or ending outside the image\n";
+    check_line(CartesianCoordinate3D<float>(-20.F,-30.F,-25.F), CartesianCoordinate3D<float>(4.F,2.F,3.F),
+               "line starting outside the image");
+    check_line(CartesianCoordinate3D<float>(-20.F,-30.F,-25.F), CartesianCoordinate3D<float>(30.F,25.F,28.F),
+               "line crossing the image");
+    check_line(CartesianCoordinate3D<float>(-20.F,-30.F,-25.F), CartesianCoordinate3D<float>(-20.F,30.F,28.F),
+               "line outside the image");
+    check_line(CartesianCoordinate3D<float>(4.F,2.F,3.F), CartesianCoordinate3D<float>(4.F,2.F,3.F),
+               "line of zero length");
+  }
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+
+int main()
+{
+  ScatterIntegralsTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -59,6 +59,7 @@ set_defaults()
   this->density_image_for_scatter_points_filename = "";
   this->template_proj_data_filename = "";
   this->output_proj_data_filename = "";
+  this->all_detection_points_are_found = false;
 
   this->remove_cache_for_integrals_over_activity();
   this->remove_cache_for_integrals_over_attenuation();
@@ -204,7 +205,10 @@ set_template_proj_data_info_sptr(const shared_ptr<ProjDataInfo>& new_sptr)
     this->proj_data_info_ptr->get_scanner_ptr()->get_num_rings()*
     this->proj_data_info_ptr->get_scanner_ptr()->get_num_detectors_per_ring ();
   // reserve space to avoid reallocation, but the actual size will grow dynamically
+  this->detection_points_vector.clear();
   this->detection_points_vector.reserve(total_detectors);
+  this->detection_points_map.clear();
+  this->all_detection_points_are_found = false;
 
   // remove any cached values as they'd be incorrect if the sizes changes
   this->remove_cache_for_integrals_over_attenuation();
@@ -303,6 +307,15 @@ process_data()
   this->shift_detector_coordinates_to_origin =
     CartesianCoordinate3D<float>(this->proj_data_info_ptr->get_m(Bin(0,0,0,0)),0, 0);
 
+  // find all detection points and compute all integrals first, such that the loop
+  // over bins below only reads from detection_points_vector and the caches
+  this->set_up_detection_points();
+  this->fill_cache_for_scattpoint_det_integrals();
+  // exclude this from the estimate of the remaining time
+  wall_clock_timer.stop();
+  previous_timer = wall_clock_timer.value();
+  wall_clock_timer.start();
+
   float total_scatter = 0 ;
 
   for (vs_num.segment_num()=this->proj_data_info_ptr->get_min_segment_num();
@@ -84,114 +84,85 @@ initialise_cache_for_scattpoint_det_integrals_over_activity()
   this->cached_activity_integral_scattpoint_det.fill(cache_init_value);
 }
 
-float 
+void
 ScatterEstimationByBin::
-cached_integral_over_activity_image_between_scattpoint_det(const unsigned scatter_point_num, 
-                                                           const unsigned det_num)
-{                
-  float * location_in_cache = 
-    this->use_cache
-    ? &cached_activity_integral_scattpoint_det[scatter_point_num][det_num]
-    : 0;
+fill_cache_for_scattpoint_det_integrals()
+{
+  if (!this->use_cache)
+    return;
+
+  const int num_scatter_points = static_cast<int>(this->scatt_points_vector.size());
+  const int num_detectors = static_cast<int>(this->detection_points_vector.size());
 
   /* OPENMP note:
-     We use atomic read/write to get at the cache. This should ensure validity.
-     Probably we could have 2 threads computing the same value that will be
-     cached later, but this might be better than locking (and it's simpler to write).
-     Sadly, this is only supported from OpenMP 3.1, so we need to add some extra checks.
+     Every thread fills different rows of the caches, so there is no need for locking.
+     The end of the parallel region makes all values visible to all threads. Afterwards,
+     the caches are only read.
   */
-  float value;
-#if defined(STIR_OPENMP)
-# if _OPENMP >=201012
-#  pragma omp atomic read
-# else
-#  pragma omp critical(STIRSCATTERESTIMATIONREADCACHE)
-  {
-# endif
-#endif
-  value = *location_in_cache;
-#if defined(STIR_OPENMP) && (_OPENMP <201012)
-  }
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
 #endif
-
-  if (this->use_cache && value!=cache_init_value)
+  for (int scatter_point_num=0; scatter_point_num<num_scatter_points; ++scatter_point_num)
     {
-      return value;
-    }
-  else
-    {
-      const float result =
-        integral_over_activity_image_between_scattpoint_det
-        (scatt_points_vector[scatter_point_num].coord,
-         detection_points_vector[det_num]
-         );
-      if (this->use_cache)
-#ifdef STIR_OPENMP
-# if _OPENMP >=201012
-#  pragma omp atomic write
-# else
-#  pragma omp critical(STIRSCATTERESTIMATIONWRITECACHE)
+      const CartesianCoordinate3D<float>& scatter_point = 
+        this->scatt_points_vector[scatter_point_num].coord;
+      Array<1,float>& activity_integrals = 
+        this->cached_activity_integral_scattpoint_det[scatter_point_num];
+      Array<1,float>& attenuation_integrals = 
+        this->cached_attenuation_integral_scattpoint_det[scatter_point_num];
+      for (int det_num=0; det_num<num_detectors; ++det_num)
         {
-# endif
-#endif
-        *location_in_cache=result;
-#if defined(STIR_OPENMP) && (_OPENMP <201012)
+          const CartesianCoordinate3D<float>& detector_coord =
+            this->detection_points_vector[det_num];
+          if (activity_integrals[det_num] == cache_init_value)
+            activity_integrals[det_num] =
+              integral_over_activity_image_between_scattpoint_det(scatter_point, detector_coord);
+          if (attenuation_integrals[det_num] == cache_init_value)
+            attenuation_integrals[det_num] =
+              exp_integral_over_attenuation_image_between_scattpoint_det(scatter_point, detector_coord);
         }
-#endif
-      return result;
     }
 }
 
+/* Note: when the cache is used, all values are normally computed by 
+   fill_cache_for_scattpoint_det_integrals(), so the functions below only read from it.
+   If a value has not been computed yet, we compute it but do not store it, such that
+   these functions can be called from multiple threads.
+*/
+float 
+ScatterEstimationByBin::
+cached_integral_over_activity_image_between_scattpoint_det(const unsigned scatter_point_num, 
+                                                           const unsigned det_num)
+{                
+  if (this->use_cache)
+    {
+      const float value = cached_activity_integral_scattpoint_det[scatter_point_num][det_num];
+      if (value!=cache_init_value)
+        return value;
+    }
+  return
+    integral_over_activity_image_between_scattpoint_det
+    (scatt_points_vector[scatter_point_num].coord,
+     detection_points_vector[det_num]
+     );
+}
+
 float 
 ScatterEstimationByBin::
 cached_exp_integral_over_attenuation_image_between_scattpoint_det(const unsigned scatter_point_num, 
                                                                   const unsigned det_num)
 {
-  float * location_in_cache = 
-    this->use_cache
-    ? &cached_attenuation_integral_scattpoint_det[scatter_point_num][det_num]
-    : 0;
-
-  float value;
-#if defined(STIR_OPENMP)
-# if _OPENMP >=201012
-#  pragma omp atomic read
-# else
-#  pragma omp critical(STIRSCATTERESTIMATIONREADCACHEATTENINT)
-  {
-# endif
-#endif
-  value = *location_in_cache;
-#if defined(STIR_OPENMP) && (_OPENMP <201012)
-  }
-#endif
-
-  if (this->use_cache && value!=cache_init_value)
+  if (this->use_cache)
     {
-      return *location_in_cache;
-    }
-  else
-    {
-      const float result =
-        exp_integral_over_attenuation_image_between_scattpoint_det
-        (scatt_points_vector[scatter_point_num].coord,
-         detection_points_vector[det_num]
-         );
-      if (this->use_cache)
-#ifdef STIR_OPENMP
-# if _OPENMP >=201012
-#  pragma omp atomic write
-# else
-#  pragma omp critical(STIRSCATTERESTIMATIONREADCACHEATTENINT)
-        {
-# endif
-#endif
-        *location_in_cache=result;
-#if defined(STIR_OPENMP) && (_OPENMP <201012)
-        }
-#endif
-      return result;
+      const float value = cached_attenuation_integral_scattpoint_det[scatter_point_num][det_num];
+      if (value!=cache_init_value)
+        return value;
     }
+  return
+    exp_integral_over_attenuation_image_between_scattpoint_det
+    (scatt_points_vector[scatter_point_num].coord,
+     detection_points_vector[det_num]
+     );
 }
         
 END_NAMESPACE_STIR
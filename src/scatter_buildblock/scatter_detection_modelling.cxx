@@ -39,16 +39,24 @@ unsigned
 ScatterEstimationByBin::
 find_in_detection_points_vector(const CartesianCoordinate3D<float>& coord) const
 {
+  if (this->all_detection_points_are_found)
+    {
+      // detection_points_map is not modified anymore, so we do not need to lock
+      const std::map<CartesianCoordinate3D<float>, unsigned>::const_iterator iter =
+        this->detection_points_map.find(coord);
+      if (iter == this->detection_points_map.end())
+        error("ScatterEstimationByBin: detection point not found\n");
+      return iter->second;
+    }
+
   unsigned int ret_value = 0;
 #pragma omp critical(SCATTERESTIMATIONFINDDETECTIONPOINTS)
   {
-  std::vector<CartesianCoordinate3D<float> >::const_iterator iter=
-    std::find(detection_points_vector.begin(),
-              detection_points_vector.end(),
-              coord);
-  if (iter != detection_points_vector.end())
+  std::map<CartesianCoordinate3D<float>, unsigned>::const_iterator iter=
+    this->detection_points_map.find(coord);
+  if (iter != detection_points_map.end())
     {
-      ret_value = iter-detection_points_vector.begin();
+      ret_value = iter->second;
     }
   else
     {
@@ -57,11 +65,40 @@ find_in_detection_points_vector(const CartesianCoordinate3D<float>& coord) const
 
       detection_points_vector.push_back(coord);
       ret_value = detection_points_vector.size()-1;
+      detection_points_map[coord] = ret_value;
     }
   }
   return ret_value;
 }
 
+void
+ScatterEstimationByBin::
+set_up_detection_points()
+{
+  if (this->all_detection_points_are_found)
+    return;
+
+  Bin bin;
+  for (bin.segment_num()=this->proj_data_info_ptr->get_min_segment_num();
+       bin.segment_num()<=this->proj_data_info_ptr->get_max_segment_num();
+       ++bin.segment_num())
+    for (bin.view_num()=this->proj_data_info_ptr->get_min_view_num();
+         bin.view_num()<=this->proj_data_info_ptr->get_max_view_num();
+         ++bin.view_num())
+      for (bin.axial_pos_num()=this->proj_data_info_ptr->get_min_axial_pos_num(bin.segment_num());
+           bin.axial_pos_num()<=this->proj_data_info_ptr->get_max_axial_pos_num(bin.segment_num());
+           ++bin.axial_pos_num())
+        for (bin.tangential_pos_num()=this->proj_data_info_ptr->get_min_tangential_pos_num();
+             bin.tangential_pos_num()<=this->proj_data_info_ptr->get_max_tangential_pos_num();
+             ++bin.tangential_pos_num())
+          {
+            unsigned det_num_A = 0; // initialise to avoid compiler warnings
+            unsigned det_num_B = 0;
+            this->find_detectors(det_num_A, det_num_B, bin);
+          }
+  this->all_detection_points_are_found = true;
+}
+
 void
 ScatterEstimationByBin::
 find_detectors(unsigned& det_num_A, unsigned& det_num_B, const Bin& bin) const
@@ -31,8 +31,9 @@
   */
 #include "stir/scatter/ScatterEstimationByBin.h"
 #include "stir/VoxelsOnCartesianGrid.h"
-#include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
-#include "stir/recon_buildblock/RayTraceVoxelsOnCartesianGrid.h"
+#include "stir/round.h"
+#include <algorithm>
+#include <math.h>
 START_NAMESPACE_STIR
 
 float 
@@ -81,14 +82,126 @@ integral_over_activity_image_between_scattpoint_det (const CartesianCoordinate3D
   }
 }
 
+static inline bool
+is_half_integer(const float a)
+{
+  return
+    fabs(floor(a)+.5F - a)<.0001F;
+}
+
+/* Sums image values along the line between 2 points (in voxel units), weighted with
+   the length of intersection with every voxel.
+
+   This follows the same conventions as RayTraceVoxelsOnCartesianGrid (Siddon's algorithm),
+   but adds the image values while marching along the line, instead of storing
+   all voxels first. In addition, we stop as soon as the line leaves the image, as
+   it cannot enter it again.
+*/
+static float
+sum_along_line(const DiscretisedDensity<3,float>& image,
+               const CartesianCoordinate3D<float>& start_point, 
+               const CartesianCoordinate3D<float>& stop_point, 
+               const CartesianCoordinate3D<float>& voxel_size,
+               const float normalisation_constant)
+{
+  const CartesianCoordinate3D<float> difference = stop_point-start_point;
+
+  if (norm(difference)<=.00001F)
+    return 0.F;
+
+  const float d12 = 
+    static_cast<float>(norm(difference*voxel_size) * normalisation_constant);
+  
+  const int sign_x = difference.x()>=0 ? 1 : -1;
+  const int sign_y = difference.y()>=0 ? 1 : -1;
+  const int sign_z = difference.z()>=0 ? 1 : -1;
+
+  const float small_difference = 1.E-4F;
+  const bool zero_diff_in_x = fabs(difference.x())<=small_difference;
+  const bool zero_diff_in_y = fabs(difference.y())<=small_difference;
+  const bool zero_diff_in_z = fabs(difference.z())<=small_difference;
+
+  // if the line is in one of the planes between voxels, use half of the 2 neighbouring lines
+  {
+    CartesianCoordinate3D<float> inc(0,0,0);
+    if (zero_diff_in_z && is_half_integer(start_point.z()))
+      inc = CartesianCoordinate3D<float> (.5F,0,0);
+    else if (zero_diff_in_y && is_half_integer(start_point.y()))
+      inc = CartesianCoordinate3D<float> (0,.5F,0);
+    else if (zero_diff_in_x && is_half_integer(start_point.x()))
+      inc = CartesianCoordinate3D<float> (0,0,.5F);
+    if (norm(inc)>.1)
+      return
+        sum_along_line(image, start_point - inc, stop_point - inc, voxel_size, normalisation_constant/2) +
+        sum_along_line(image, start_point + inc, stop_point + inc, voxel_size, normalisation_constant/2);
+  }
+
+  const float inc_x = zero_diff_in_x ? d12*1000000.F : d12 / fabs(difference.x());
+  const float inc_y = zero_diff_in_y ? d12*1000000.F : d12 / fabs(difference.y());
+  const float inc_z = zero_diff_in_z ? d12*1000000.F : d12 / fabs(difference.z());
+  
+  const float xmax = round(stop_point.x()) + sign_x*0.5F;
+  const float ymax = round(stop_point.y()) + sign_y*0.5F;  
+  const float zmax = round(stop_point.z()) + sign_z*0.5F;
+
+  // see RayTraceVoxelsOnCartesianGrid for the factor .9999
+  const float axend = zero_diff_in_x ? d12*1000000.F : (xmax - start_point.x()) * inc_x * sign_x *.9999F;
+  const float ayend = zero_diff_in_y ? d12*1000000.F : (ymax - start_point.y()) * inc_y * sign_y *.9999F;
+  const float azend = zero_diff_in_z ? d12*1000000.F : (zmax - start_point.z()) * inc_z * sign_z *.9999F;
+  const float amax = std::min(axend, std::min(ayend, azend));
+
+  CartesianCoordinate3D<int> current_voxel = round(start_point);
+  float az = zero_diff_in_z ? -inc_z : 
+    ((current_voxel.z() - start_point.z()) - sign_z*0.5F) * inc_z * sign_z;
+  float ax = zero_diff_in_x ? -inc_x : 
+    ((current_voxel.x() - start_point.x()) - sign_x*0.5F) * inc_x * sign_x;
+  float ay = zero_diff_in_y ? -inc_y : 
+    ((current_voxel.y() - start_point.y()) - sign_y*0.5F) * inc_y * sign_y;
+  float a = std::max(ax, std::max(ay,az));      
+  if (zero_diff_in_x) ax = axend; else ax += inc_x;
+  if (zero_diff_in_y) ay = ayend; else ay += inc_y;
+  if (zero_diff_in_z) az = azend; else az += inc_z;
+
+  float sum = 0;
+  bool we_have_been_within_the_image = false;
+  while (a < amax)
+    {
+      // find the length in the current voxel, and the next voxel
+      float length;
+      CartesianCoordinate3D<int> next_voxel = current_voxel;
+      if (ax < ay && ax < az)
+        { length = ax - a; a = ax; ax += inc_x; next_voxel.x() += sign_x; }
+      else if (ay < az && !(ax < ay))
+        { length = ay - a; a = ay; ay += inc_y; next_voxel.y() += sign_y; }
+      else
+        { length = az - a; a = az; az += inc_z; next_voxel.z() += sign_z; }
+
+      const int z = current_voxel.z();
+      const int y = current_voxel.y();
+      const int x = current_voxel.x();
+      if (z >= image.get_min_index() && z <= image.get_max_index() &&
+          y >= image[z].get_min_index() && y <= image[z].get_max_index() &&
+          x >= image[z][y].get_min_index() && x <= image[z][y].get_max_index())
+        {
+          we_have_been_within_the_image = true;
+          sum += image[z][y][x] * length;
+        }
+      else if (we_have_been_within_the_image)
+        {
+          // we are now at the other side of the image
+          break;
+        }
+      current_voxel = next_voxel;
+    }
+  return sum;
+}
+
 float 
 ScatterEstimationByBin::
 integral_between_2_points(const DiscretisedDensity<3,float>& density,
                           const CartesianCoordinate3D<float>& scatter_point, 
                           const CartesianCoordinate3D<float>& detector_coord)
 {       
-
-
   const VoxelsOnCartesianGrid<float>& image =
     dynamic_cast<const VoxelsOnCartesianGrid<float>& >
     (density);
@@ -101,45 +214,17 @@ integral_between_2_points(const DiscretisedDensity<3,float>& density,
     (image.get_max_index() + image.get_min_index())*voxel_size.z()/2.F;
   origin.z() -= z_to_middle;
   /* TODO replace with image.get_index_coordinates_for_physical_coordinates */
-  ProjMatrixElemsForOneBin lor;
-  RayTraceVoxelsOnCartesianGrid(lor, 
-                                (scatter_point-origin)/voxel_size,  // should be in voxel units
-                                (detector_coord-origin)/voxel_size, // should be in voxel units
-                                voxel_size, //should be in mm
+  return
+    sum_along_line(image,
+                   (scatter_point-origin)/voxel_size,  // should be in voxel units
+                   (detector_coord-origin)/voxel_size, // should be in voxel units
+                   voxel_size, //should be in mm
 #ifdef NEWSCALE
-                                1.F // normalise to mm
+                   1.F // normalise to mm
 #else
-                                1/voxel_size.x() // normalise to some kind of 'pixel units'
+                   1/voxel_size.x() // normalise to some kind of 'pixel units'
 #endif
-                                );
-  lor.sort();
-  float sum = 0;  // add up values along LOR
-  {     
-    ProjMatrixElemsForOneBin::iterator element_ptr =lor.begin() ;
-    bool we_have_been_within_the_image = false;
-    while (element_ptr != lor.end())
-      {
-        const BasicCoordinate<3,int> coords = element_ptr->get_coords();                                
-        if (coords[1] >= image.get_min_index() && 
-            coords[1] <= image.get_max_index() &&
-            coords[2] >= image[coords[1]].get_min_index() && 
-            coords[2] <= image[coords[1]].get_max_index() &&
-            coords[3] >= image[coords[1]][coords[2]].get_min_index() && 
-            coords[3] <= image[coords[1]][coords[2]].get_max_index())
-          {
-            we_have_been_within_the_image = true;
-            sum += image[coords] * element_ptr->get_value();                            
-          }
-        else if (we_have_been_within_the_image)
-          {
-            // we jump out of the loop as we are now at the other side of 
-            // the image
-            //                                  break; 
-          }
-        ++element_ptr;          
-      }       
-  }             
-  return sum;   
+                   );
 }                                                  
 END_NAMESPACE_STIR
 
@@ -123,6 +123,7 @@ GatedSpatialTransformation::read_from_files(const std::string input_string)
 	
   this->_spatial_transformation_z= spatial_transformation_z; this->_spatial_transformation_y= spatial_transformation_y; this->_spatial_transformation_x= spatial_transformation_x; 
   this->_spatial_transformations_are_stored=true;
+  this->set_up_warps();
 }     
 
 //! Implementation to write the transformation vectors
@@ -148,11 +149,7 @@ GatedSpatialTransformation::warp_image(GatedDiscretisedDensity & new_gated_image
   new_gated_image.fill_with_zero();
   if (this->_spatial_transformations_are_stored)
     for(unsigned int gate_num=1 ; gate_num<=gated_image.get_time_gate_definitions().get_num_gates() ; ++gate_num)
-      new_gated_image[gate_num]=stir::warp_image((gated_image.get_densities())[gate_num-1],
-                                                 (this->_spatial_transformation_x.get_densities())[gate_num-1],
-                                                 (this->_spatial_transformation_y.get_densities())[gate_num-1],
-                                                 (this->_spatial_transformation_z.get_densities())[gate_num-1], 
-                                                 BSpline::linear, false);
+      this->_warps[gate_num-1]->warp(new_gated_image[gate_num], gated_image[gate_num]);
   else
     error("The transformation fields haven't been set properly yet.\n");
 }
@@ -178,6 +175,24 @@ GatedSpatialTransformation::accumulate_warp_image(DiscretisedDensity<3, float> &
   //	new_reference_image /= gated_image.get_time_gate_definitions().get_num_gates();
 }
 
+void
+GatedSpatialTransformation::adjoint_warp_image(DiscretisedDensity<3, float> & new_reference_image,
+                                               const GatedDiscretisedDensity & gated_image) const 
+{
+  new_reference_image.fill(0.F);
+  this->accumulate_adjoint_warp_image(new_reference_image, gated_image);
+}
+
+void
+GatedSpatialTransformation::accumulate_adjoint_warp_image(DiscretisedDensity<3, float> & new_reference_image,
+                                                          const GatedDiscretisedDensity & gated_image) const 
+{
+  if (!this->_spatial_transformations_are_stored)
+    error("The transformation fields haven't been set properly yet.");
+  for(unsigned int gate_num = 1;gate_num<=gated_image.get_time_gate_definitions().get_num_gates() ; ++gate_num)
+    this->_warps[gate_num-1]->accumulate_adjoint_warp(new_reference_image, gated_image[gate_num]);
+}
+
 void 
 GatedSpatialTransformation::warp_image(GatedDiscretisedDensity & gated_image,
                           const DiscretisedDensity<3, float> & reference_image) const 
@@ -190,18 +205,13 @@ GatedSpatialTransformation::warp_image(GatedDiscretisedDensity & gated_image,
     info(boost::format("Number of voxels in one motion vector gated image: %1%") % (this->_spatial_transformation_y.get_densities())[0]->size_all());
     error("GatedSpatialTransformation::warp_image needs the same sizes for motion vectors and input/output images.\n");
   }
-  const shared_ptr<DiscretisedDensity<3,float> > reference_image_sptr( reference_image.clone());
   gated_image.resize_densities(this->_gate_defs);
 	
   if (this->_spatial_transformations_are_stored)
     for(unsigned int gate_num = 1 ; gate_num<=gated_image.get_time_gate_definitions().get_num_gates() ; ++gate_num)
       {
-        const VoxelsOnCartesianGrid<float> density = stir::warp_image(reference_image_sptr,
-                                                                      (this->_spatial_transformation_x.get_densities())[gate_num-1],
-                                                                      (this->_spatial_transformation_y.get_densities())[gate_num-1],
-                                                                      (this->_spatial_transformation_z.get_densities())[gate_num-1], 
-                                                                      BSpline::linear, false);
-        const shared_ptr<DiscretisedDensity<3,float> >  density_sptr(density.clone());
+        const shared_ptr<DiscretisedDensity<3,float> >  density_sptr(reference_image.get_empty_copy());
+        this->_warps[gate_num-1]->warp(*density_sptr, reference_image);
         gated_image.set_density_sptr(density_sptr,gate_num);
       }
   else
@@ -218,6 +228,20 @@ set_spatial_transformations(const GatedDiscretisedDensity & transformation_z,
   this->_spatial_transformation_y=transformation_y;
   this->_spatial_transformation_x=transformation_x;
   this->_spatial_transformations_are_stored=true;
+  this->set_up_warps();
+}
+
+void
+GatedSpatialTransformation::set_up_warps()
+{
+  // Always linear interpolation for the moment, see post_processing()
+  const unsigned int num_gates = 
+    static_cast<unsigned int>(this->_spatial_transformation_x.get_densities().size());
+  this->_warps.resize(num_gates);
+  for (unsigned int gate_num=1; gate_num<=num_gates; ++gate_num)
+    this->_warps[gate_num-1].reset(new PrecomputedLinearWarp(this->_spatial_transformation_x[gate_num],
+                                                             this->_spatial_transformation_y[gate_num],
+                                                             this->_spatial_transformation_z[gate_num]));
 }
 
 void 
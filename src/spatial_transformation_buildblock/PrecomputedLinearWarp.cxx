@@ -0,0 +1,227 @@
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup spatial_transformation
+  \brief Implementation of class stir::PrecomputedLinearWarp
+*/
+
+#include "stir/spatial_transformation/PrecomputedLinearWarp.h"
+#include "stir/DiscretisedDensityOnCartesianGrid.h"
+#include "stir/error.h"
+#include <cstddef>
+#include <math.h>
+
+START_NAMESPACE_STIR
+
+// add value to target, such that different threads can add to the same element
+static inline void
+add_to(float& target, const float value)
+{
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+  target += value;
+}
+
+PrecomputedLinearWarp::
+PrecomputedLinearWarp(const DiscretisedDensity<3,float>& motion_x,
+                      const DiscretisedDensity<3,float>& motion_y,
+                      const DiscretisedDensity<3,float>& motion_z)
+{
+  const DiscretisedDensityOnCartesianGrid<3,float>* const motion_cartesian_ptr =
+    dynamic_cast<const DiscretisedDensityOnCartesianGrid<3,float>*>(&motion_x);
+  if (motion_cartesian_ptr == 0)
+    error("PrecomputedLinearWarp: motion fields need to be on a Cartesian grid");
+  const BasicCoordinate<3,float> grid_spacing = motion_cartesian_ptr->get_grid_spacing();
+  if (!motion_x.get_regular_range(this->_min_indices, this->_max_indices))
+    error("PrecomputedLinearWarp: motion fields need to have a regular index range");
+  this->check_index_range(motion_y, "PrecomputedLinearWarp");
+  this->check_index_range(motion_z, "PrecomputedLinearWarp");
+
+  const BasicCoordinate<3,int>& min = this->_min_indices;
+  const BasicCoordinate<3,int>& max = this->_max_indices;
+  this->_y_stride = max[3]-min[3]+1;
+  this->_z_stride = (max[2]-min[2]+1)*this->_y_stride;
+  const std::size_t num_voxels = static_cast<std::size_t>(max[1]-min[1]+1)*this->_z_stride;
+  this->_offsets.resize(num_voxels);
+  this->_fractions.resize(3*num_voxels);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int z=min[1]; z<=max[1]; ++z)
+    {
+      std::size_t voxel = static_cast<std::size_t>(z-min[1])*this->_z_stride;
+      for (int y=min[2]; y<=max[2]; ++y)
+        for (int x=min[3]; x<=max[3]; ++x, ++voxel)
+          {
+            // position in voxel units, computed as in warp_image()
+            const double d[3] =
+              {
+                static_cast<double>(z) + static_cast<double>(motion_z[z][y][x]/grid_spacing[1]),
+                static_cast<double>(y) + static_cast<double>(motion_y[z][y][x]/grid_spacing[2]),
+                static_cast<double>(x) + static_cast<double>(motion_x[z][y][x]/grid_spacing[3])
+              };
+            // positions on or outside the edges of the image give 0, see warp_image()
+            int lower[3];
+            bool inside = true;
+            for (int i=0; i<3 && inside; ++i)
+              {
+                if (d[i] <= static_cast<double>(min[i+1]) || d[i] >= static_cast<double>(max[i+1]))
+                  inside = false;
+                else
+                  {
+                    lower[i] = static_cast<int>(floor(d[i]));
+                    this->_fractions[3*voxel+i] = static_cast<float>(d[i] - lower[i]);
+                  }
+              }
+            this->_offsets[voxel] =
+              inside
+              ? (lower[0]-min[1])*this->_z_stride + (lower[1]-min[2])*this->_y_stride + (lower[2]-min[3])
+              : -1;
+          }
+    }
+}
+
+void
+PrecomputedLinearWarp::
+check_index_range(const DiscretisedDensity<3,float>& density, const char * const caller) const
+{
+  BasicCoordinate<3,int> min, max;
+  if (!density.get_regular_range(min, max) || !(min == this->_min_indices) || !(max == this->_max_indices))
+    error("%s: images need to have the same index range as the motion fields", caller);
+}
+
+void
+PrecomputedLinearWarp::
+warp(DiscretisedDensity<3,float>& out_density,
+     const DiscretisedDensity<3,float>& in_density) const
+{
+  this->check_index_range(out_density, "PrecomputedLinearWarp::warp");
+  this->check_index_range(in_density, "PrecomputedLinearWarp::warp");
+
+  // we need the input as a contiguous array, so make a copy if necessary
+  Array<3,float> in_copy;
+  const float * in_ptr;
+  if (in_density.is_contiguous())
+    in_ptr = in_density.get_const_full_data_ptr();
+  else
+    {
+      in_copy = Array<3,float>(in_density.get_index_range(), /*contiguous=*/true);
+      in_copy = in_density;
+      in_ptr = in_copy.get_const_full_data_ptr();
+    }
+
+  const BasicCoordinate<3,int>& min = this->_min_indices;
+  const BasicCoordinate<3,int>& max = this->_max_indices;
+  const int y_stride = this->_y_stride;
+  const int z_stride = this->_z_stride;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int z=min[1]; z<=max[1]; ++z)
+    {
+      std::size_t voxel = static_cast<std::size_t>(z-min[1])*z_stride;
+      for (int y=min[2]; y<=max[2]; ++y)
+        {
+          Array<1,float>& out_row = out_density[z][y];
+          for (int x=min[3]; x<=max[3]; ++x, ++voxel)
+            {
+              const int offset = this->_offsets[voxel];
+              if (offset < 0)
+                {
+                  out_row[x] = 0.F;
+                  continue;
+                }
+              const float * const f = &this->_fractions[3*voxel];
+              const float * const p = in_ptr + offset;
+              const float * const p_z = p + z_stride;
+              out_row[x] =
+                (1-f[0]) *
+                ((1-f[1]) * ((1-f[2])*p[0] + f[2]*p[1]) +
+                 f[1] * ((1-f[2])*p[y_stride] + f[2]*p[y_stride+1])) +
+                f[0] *
+                ((1-f[1]) * ((1-f[2])*p_z[0] + f[2]*p_z[1]) +
+                 f[1] * ((1-f[2])*p_z[y_stride] + f[2]*p_z[y_stride+1]));
+            }
+        }
+    }
+}
+
+void
+PrecomputedLinearWarp::
+accumulate_adjoint_warp(DiscretisedDensity<3,float>& out_density,
+                        const DiscretisedDensity<3,float>& in_density) const
+{
+  this->check_index_range(out_density, "PrecomputedLinearWarp::accumulate_adjoint_warp");
+  this->check_index_range(in_density, "PrecomputedLinearWarp::accumulate_adjoint_warp");
+
+  // we need to add to a contiguous array, so use a temporary if necessary
+  const bool out_is_contiguous = out_density.is_contiguous();
+  Array<3,float> out_copy;
+  float * out_ptr;
+  if (out_is_contiguous)
+    out_ptr = out_density.get_full_data_ptr();
+  else
+    {
+      out_copy = Array<3,float>(out_density.get_index_range(), /*contiguous=*/true);
+      out_ptr = out_copy.get_full_data_ptr();
+    }
+
+  const BasicCoordinate<3,int>& min = this->_min_indices;
+  const BasicCoordinate<3,int>& max = this->_max_indices;
+  const int y_stride = this->_y_stride;
+  const int z_stride = this->_z_stride;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int z=min[1]; z<=max[1]; ++z)
+    {
+      std::size_t voxel = static_cast<std::size_t>(z-min[1])*z_stride;
+      for (int y=min[2]; y<=max[2]; ++y)
+        {
+          const Array<1,float>& in_row = in_density[z][y];
+          for (int x=min[3]; x<=max[3]; ++x, ++voxel)
+            {
+              const int offset = this->_offsets[voxel];
+              const float value = in_row[x];
+              if (offset < 0 || value == 0)
+                continue;
+              const float * const f = &this->_fractions[3*voxel];
+              float * const p = out_ptr + offset;
+              float * const p_z = p + z_stride;
+              const float v0 = (1-f[0])*value;
+              const float v1 = f[0]*value;
+              add_to(p[0],              v0*(1-f[1])*(1-f[2]));
+              add_to(p[1],              v0*(1-f[1])*f[2]);
+              add_to(p[y_stride],       v0*f[1]*(1-f[2]));
+              add_to(p[y_stride+1],     v0*f[1]*f[2]);
+              add_to(p_z[0],            v1*(1-f[1])*(1-f[2]));
+              add_to(p_z[1],            v1*(1-f[1])*f[2]);
+              add_to(p_z[y_stride],     v1*f[1]*(1-f[2]));
+              add_to(p_z[y_stride+1],   v1*f[1]*f[2]);
+            }
+        }
+    }
+
+  if (!out_is_contiguous)
+    out_density += out_copy;
+}
+
+END_NAMESPACE_STIR
@@ -32,7 +32,15 @@
 #include "stir/modelling/PlasmaData.h"
 #include "stir/modelling/ParametricDiscretisedDensity.h"
 #include "stir/TimeFrameDefinitions.h"
+#include "stir/DynamicDiscretisedDensity.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/IndexRange2D.h"
+#include "stir/IndexRange3D.h"
+#include "stir/Scanner.h"
+#include "stir/linear_regression.h"
 #include "stir/utilities.h"
+#include <vector>
+#include <math.h>
 #include <boost/shared_array.hpp>
 
 START_NAMESPACE_STIR
@@ -193,6 +201,115 @@ void modellingTests::run_tests()
 	}
   }
 
+  std::cerr << "Testing the Patlak linear regression..." << std::endl;
+  {
+    const unsigned int num_frames=8;
+    const unsigned int starting_frame=4;
+    std::vector<double> start_times(num_frames), durations(num_frames);
+    for (unsigned int frame_num=1; frame_num<=num_frames; ++frame_num)
+      {
+        start_times[frame_num-1]=(frame_num-1)*600.;
+        durations[frame_num-1]=600.;
+      }
+    const TimeFrameDefinitions frame_defs(start_times, durations);
+
+    Array<2,float> model_array(IndexRange2D(1,2,starting_frame,num_frames));
+    for (unsigned int frame_num=starting_frame; frame_num<=num_frames; ++frame_num)
+      {
+        model_array[1][frame_num]=100.F*frame_num*frame_num;
+        model_array[2][frame_num]=10.F+frame_num;
+      }
+    ModelMatrix<2> model_matrix;
+    model_matrix.set_model_array(model_array);
+    model_matrix.set_if_in_correct_scale(true);
+    PatlakPlot patlak_plot;
+    patlak_plot._starting_frame=starting_frame;
+    patlak_plot._frame_defs=frame_defs;
+    patlak_plot._in_correct_scale=true;
+    patlak_plot.set_model_matrix(model_matrix);
+
+    const IndexRange<3> range(IndexRange3D(0,3,-4,4,-5,5));
+    const CartesianCoordinate3D<float> origin(0.F,0.F,0.F);
+    const CartesianCoordinate3D<float> grid_spacing(2.F,3.F,3.F);
+    const shared_ptr<VoxelsOnCartesianGrid<float> >
+      frame_sptr(new VoxelsOnCartesianGrid<float>(range, origin, grid_spacing));
+    DynamicDiscretisedDensity dyn_image(frame_defs, 0., shared_ptr<Scanner>(new Scanner(Scanner::E966)), frame_sptr);
+    // Patlak data with some deterministic "noise"
+    for (unsigned int frame_num=1; frame_num<=num_frames; ++frame_num)
+      for (int k=range.get_min_index(); k<=range.get_max_index(); ++k)
+        for (int j=range[k].get_min_index(); j<=range[k].get_max_index(); ++j)
+          for (int i=range[k][j].get_min_index(); i<=range[k][j].get_max_index(); ++i)
+            dyn_image[frame_num][k][j][i] =
+              frame_num<starting_frame
+              ? 1000.F
+              : 0.01F*(k+1)*model_array[1][frame_num] + (j+i+10)*model_array[2][frame_num]
+                + 50.F*static_cast<float>(sin(1.+frame_num*(k+2*j+3*i)));
+
+    ParametricVoxelsOnCartesianGrid
+      par_image(ParametricVoxelsOnCartesianGridBaseType(range, origin, grid_spacing));
+    patlak_plot.apply_linear_regression(par_image, dyn_image);
+
+    // stream the frames one by one
+    ParametricVoxelsOnCartesianGrid
+      streamed_par_image(ParametricVoxelsOnCartesianGridBaseType(range, origin, grid_spacing));
+    for (unsigned int frame_num=1; frame_num<=num_frames; ++frame_num)
+      patlak_plot.add_frame_to_linear_regression(streamed_par_image, dyn_image[frame_num], frame_num,
+                                                 dyn_image.get_scanner_default_bin_size());
+
+    // compare with linear regression for every voxel
+    VectorWithOffset<float> patlak_x(starting_frame,num_frames);
+    VectorWithOffset<float> patlak_y(starting_frame,num_frames);
+    VectorWithOffset<float> weights(starting_frame,num_frames);
+    for (unsigned int frame_num=starting_frame; frame_num<=num_frames; ++frame_num)
+      {
+        patlak_x[frame_num]=model_array[1][frame_num]/model_array[2][frame_num];
+        weights[frame_num]=1.F;
+      }
+    for (int k=range.get_min_index(); k<=range.get_max_index(); ++k)
+      for (int j=range[k].get_min_index(); j<=range[k].get_max_index(); ++j)
+        for (int i=range[k][j].get_min_index(); i<=range[k][j].get_max_index(); ++i)
+          {
+            for (unsigned int frame_num=starting_frame; frame_num<=num_frames; ++frame_num)
+              patlak_y[frame_num]=dyn_image[frame_num][k][j][i]/model_array[2][frame_num];
+            float slope, y_intersection, chi_square, variance_of_y_intersection,
+              variance_of_slope, covariance_of_y_intersection_with_slope;
+            linear_regression(y_intersection, slope, chi_square,
+                              variance_of_y_intersection, variance_of_slope,
+                              covariance_of_y_intersection_with_slope,
+                              patlak_y, patlak_x, weights);
+            check_if_equal(slope, par_image[k][j][i][1], "Check slope of Patlak linear regression");
+            check_if_equal(y_intersection, par_image[k][j][i][2], "Check intercept of Patlak linear regression");
+            check_if_equal(par_image[k][j][i][1], streamed_par_image[k][j][i][1],
+                           "Check slope of Patlak linear regression when adding frames one by one");
+            check_if_equal(par_image[k][j][i][2], streamed_par_image[k][j][i][2],
+                           "Check intercept of Patlak linear regression when adding frames one by one");
+          }
+
+    // compare multiplication with the model matrix with a straightforward implementation
+    ParametricVoxelsOnCartesianGrid
+      model_times_dyn_image(ParametricVoxelsOnCartesianGridBaseType(range, origin, grid_spacing));
+    patlak_plot.multiply_dynamic_image_with_model_gradient(model_times_dyn_image, dyn_image);
+    DynamicDiscretisedDensity model_times_par_image(dyn_image);
+    patlak_plot.get_dynamic_image_from_parametric_image(model_times_par_image, par_image);
+    for (int k=range.get_min_index(); k<=range.get_max_index(); ++k)
+      for (int j=range[k].get_min_index(); j<=range[k].get_max_index(); ++j)
+        for (int i=range[k][j].get_min_index(); i<=range[k][j].get_max_index(); ++i)
+          {
+            float sum1=0.F, sum2=0.F;
+            for (unsigned int frame_num=starting_frame; frame_num<=num_frames; ++frame_num)
+              {
+                sum1 += model_array[1][frame_num]*dyn_image[frame_num][k][j][i];
+                sum2 += model_array[2][frame_num]*dyn_image[frame_num][k][j][i];
+                check_if_equal(model_array[1][frame_num]*par_image[k][j][i][1] +
+                               model_array[2][frame_num]*par_image[k][j][i][2],
+                               model_times_par_image[frame_num][k][j][i],
+                               "Check multiplication of parametric image with model matrix");
+              }
+            check_if_equal(sum1, model_times_dyn_image[k][j][i][1], "Check multiplication of dynamic image with model matrix");
+            check_if_equal(sum2, model_times_dyn_image[k][j][i][2], "Check multiplication of dynamic image with model matrix");
+          }
+  }
+
 }
 
 
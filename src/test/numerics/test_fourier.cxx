@@ -0,0 +1,352 @@
+//
+//
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup numerics_test
+  \brief tests the DFT functions in stir/numerics/fourier.h and stir::FourierTransformPlan
+
+*/
+
+#include "stir/RunTests.h"
+#include "stir/numerics/fourier.h"
+#include "stir/numerics/FourierTransformPlan.h"
+#include "stir/IndexRange2D.h"
+#include "stir/IndexRange3D.h"
+#include <complex>
+#include <cstdlib>
+#include <sstream>
+#include <math.h>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup numerics_test
+  \brief A simple class to test the DFT functions.
+
+  Results are compared with a straightforward implementation of the DFT,
+  for lengths that are and are not a power of 2.
+*/
+class FourierTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef std::complex<float> complex_t;
+
+  //! straightforward O(n^2) DFT along the outer index
+  template <int num_dimensions>
+  static Array<num_dimensions, complex_t>
+  slow_fourier_1d(const Array<num_dimensions, complex_t>& c, const int sign);
+  static Array<1, complex_t>
+  slow_fourier_1d(const Array<1, complex_t>& c, const int sign);
+  //! straightforward O(n^2) DFT along all dimensions
+  template <int num_dimensions>
+  static Array<num_dimensions, complex_t>
+  slow_fourier(const Array<num_dimensions, complex_t>& c, const int sign);
+  static Array<1, complex_t>
+  slow_fourier(const Array<1, complex_t>& c, const int sign)
+  { return slow_fourier_1d(c, sign); }
+
+  static void set_random(float& v)
+  { v = static_cast<float>(std::rand())/RAND_MAX - .5F; }
+  static void set_random(complex_t& v)
+  {
+    float re, im;
+    set_random(re); set_random(im);
+    v = complex_t(re, im);
+  }
+  template <int num_dimensions, typename elemT>
+  static void fill_random(Array<num_dimensions, elemT>& a);
+
+  //! max norm of the difference, divided by the max norm of \a a
+  template <int num_dimensions, typename elemT>
+  static double relative_difference(const Array<num_dimensions, elemT>& a, const Array<num_dimensions, elemT>& b);
+
+  void test_plan(const int length);
+  void test_plan_contiguous(const int length);
+  void test_fourier_1d(const int length);
+  void test_fourier_3d(const int length1, const int length2, const int length3);
+  void test_fourier_for_real_data(const int length1, const int length2);
+};
+
+template <int num_dimensions>
+Array<num_dimensions, std::complex<float> >
+FourierTests::
+slow_fourier_1d(const Array<num_dimensions, complex_t>& c, const int sign)
+{
+  const int n = c.get_length();
+  Array<num_dimensions, complex_t> result(c.get_index_range());
+  for (int r=0; r<n; ++r)
+    for (int s=0; s<n; ++s)
+      {
+        const double phase = sign*2*_PI*(static_cast<long>(r)*s % n)/n;
+        Array<num_dimensions-1, complex_t> tmp(c[s]);
+        tmp *= complex_t(static_cast<float>(cos(phase)), static_cast<float>(sin(phase)));
+        result[r] += tmp;
+      }
+  return result;
+}
+
+Array<1, std::complex<float> >
+FourierTests::
+slow_fourier_1d(const Array<1, complex_t>& c, const int sign)
+{
+  const int n = c.get_length();
+  Array<1, complex_t> result(c.get_index_range());
+  for (int r=0; r<n; ++r)
+    {
+      std::complex<double> sum = 0;
+      for (int s=0; s<n; ++s)
+        {
+          const double phase = sign*2*_PI*(static_cast<long>(r)*s % n)/n;
+          sum += std::complex<double>(c[s]) * std::complex<double>(cos(phase), sin(phase));
+        }
+      result[r] = complex_t(sum);
+    }
+  return result;
+}
+
+template <int num_dimensions>
+Array<num_dimensions, std::complex<float> >
+FourierTests::
+slow_fourier(const Array<num_dimensions, complex_t>& c, const int sign)
+{
+  Array<num_dimensions, complex_t> result = slow_fourier_1d(c, sign);
+  for (int i=result.get_min_index(); i<=result.get_max_index(); ++i)
+    result[i] = slow_fourier(result[i], sign);
+  return result;
+}
+
+template <int num_dimensions, typename elemT>
+void
+FourierTests::
+fill_random(Array<num_dimensions, elemT>& a)
+{
+  for (typename Array<num_dimensions, elemT>::full_iterator iter = a.begin_all();
+       iter != a.end_all(); ++iter)
+    set_random(*iter);
+}
+
+template <int num_dimensions, typename elemT>
+double
+FourierTests::
+relative_difference(const Array<num_dimensions, elemT>& a, const Array<num_dimensions, elemT>& b)
+{
+  double max_diff = 0;
+  double max_a = 0;
+  typename Array<num_dimensions, elemT>::const_full_iterator iter_b = b.begin_all_const();
+  for (typename Array<num_dimensions, elemT>::const_full_iterator iter_a = a.begin_all_const();
+       iter_a != a.end_all_const(); ++iter_a, ++iter_b)
+    {
+      max_diff = std::max(max_diff, static_cast<double>(std::abs(*iter_a - *iter_b)));
+      max_a = std::max(max_a, static_cast<double>(std::abs(*iter_a)));
+    }
+  return max_a==0 ? max_diff : max_diff/max_a;
+}
+
+void
+FourierTests::
+test_plan(const int length)
+{
+  std::ostringstream str;
+  str << "FourierTransformPlan with length " << length;
+
+  // test a strided transform of a vector in a larger array
+  const int stride = 3;
+  Array<1,complex_t> data(length*stride);
+  fill_random(data);
+  Array<1,complex_t> vec(length);
+  for (int i=0; i<length; ++i)
+    vec[i] = data[i*stride];
+  for (int sign=-1; sign<=1; sign+=2)
+    {
+      Array<1,complex_t> transformed(data);
+      FourierTransformPlan::get_plan(length, sign)->transform(transformed.get_full_data_ptr(), stride);
+      Array<1,complex_t> result(length);
+      for (int i=0; i<length; ++i)
+        {
+          result[i] = transformed[i*stride];
+          // other elements should be unchanged
+          check_if_equal(transformed[i*stride+1], data[i*stride+1], str.str() + ": elements in between");
+        }
+      check(relative_difference(slow_fourier_1d(vec, sign), result) < 1.E-5, str.str());
+    }
+}
+
+/* This tests the code-path used by FFTW for contiguous vectors (in-place transform
+   of the original data, as opposed to the work buffer used for strided vectors),
+   including vectors that do not start at an aligned address, and transform_many().
+*/
+void
+FourierTests::
+test_plan_contiguous(const int length)
+{
+  std::ostringstream str;
+  str << "FourierTransformPlan (" << (FourierTransformPlan::is_using_FFTW() ? "FFTW" : "built-in")
+      << ") on contiguous vectors with length " << length;
+
+  const int num_vectors = 5;
+  // use an offset of 1 element such that odd vectors are not aligned to 16 bytes
+  const int distance = length+1;
+  Array<1,complex_t> data(num_vectors*distance);
+  fill_random(data);
+  for (int sign=-1; sign<=1; sign+=2)
+    {
+      shared_ptr<const FourierTransformPlan> plan_sptr = FourierTransformPlan::get_plan(length, sign);
+      Array<1,complex_t> transformed_one_by_one(data);
+      Array<1,complex_t> transformed_many(data);
+      for (int v=0; v<num_vectors; ++v)
+        plan_sptr->transform(transformed_one_by_one.get_full_data_ptr() + v*distance);
+      plan_sptr->transform_many(transformed_many.get_full_data_ptr(), num_vectors, 1, distance);
+      for (int v=0; v<num_vectors; ++v)
+        {
+          Array<1,complex_t> vec(length);
+          Array<1,complex_t> result(length);
+          Array<1,complex_t> result_many(length);
+          for (int i=0; i<length; ++i)
+            {
+              vec[i] = data[v*distance+i];
+              result[i] = transformed_one_by_one[v*distance+i];
+              result_many[i] = transformed_many[v*distance+i];
+            }
+          // element in between vectors should be unchanged
+          check_if_equal(transformed_one_by_one[v*distance+length], data[v*distance+length],
+                         str.str() + ": elements in between");
+          check_if_equal(transformed_many[v*distance+length], data[v*distance+length],
+                         str.str() + ": elements in between (transform_many)");
+          const Array<1,complex_t> slow_result = slow_fourier_1d(vec, sign);
+          check(relative_difference(slow_result, result) < 1.E-5, str.str());
+          check(relative_difference(slow_result, result_many) < 1.E-5, str.str() + ": transform_many");
+        }
+    }
+}
+
+void
+FourierTests::
+test_fourier_1d(const int length)
+{
+  std::ostringstream str;
+  str << "fourier on 1D array of length " << length;
+  Array<1,complex_t> c(length);
+  fill_random(c);
+  Array<1,complex_t> transformed(c);
+  fourier(transformed);
+  check(relative_difference(slow_fourier(c, 1), transformed) < 1.E-5, str.str());
+  inverse_fourier(transformed);
+  check(relative_difference(c, transformed) < 1.E-5, str.str() + ": inverse");
+}
+
+void
+FourierTests::
+test_fourier_3d(const int length1, const int length2, const int length3)
+{
+  std::ostringstream str;
+  str << "fourier on 3D array with sizes " << length1 << ',' << length2 << ',' << length3;
+  // contiguous, such that both code paths of fourier() are tested below
+  Array<3,complex_t> c(IndexRange3D(length1, length2, length3), /*contiguous=*/true);
+  fill_random(c);
+  {
+    Array<3,complex_t> transformed(c);
+    fourier(transformed, -1);
+    check(relative_difference(slow_fourier(c, -1), transformed) < 1.E-5, str.str());
+    inverse_fourier(transformed, -1);
+    check(relative_difference(c, transformed) < 1.E-5, str.str() + ": inverse");
+  }
+  {
+    Array<3,complex_t> transformed(c);
+    fourier_1d(transformed, 1);
+    check(relative_difference(slow_fourier_1d(c, 1), transformed) < 1.E-5, str.str() + ": fourier_1d");
+  }
+  // non-contiguous array
+  {
+    Array<3,complex_t> transformed(c);
+    // reallocate one row
+    transformed[0][0].resize(0, length3);
+    transformed[0][0].resize(0, length3-1);
+    transformed[0][0] = c[0][0];
+    check(!transformed.is_contiguous() || length1*length2==1, str.str() + ": test should use a non-contiguous array");
+    fourier(transformed, -1);
+    check(relative_difference(slow_fourier(c, -1), transformed) < 1.E-5, str.str() + ": non-contiguous");
+  }
+}
+
+void
+FourierTests::
+test_fourier_for_real_data(const int length1, const int length2)
+{
+  std::ostringstream str;
+  str << "fourier_for_real_data on 2D array with sizes " << length1 << ',' << length2;
+  Array<2,float> v(IndexRange2D(length1, length2));
+  fill_random(v);
+  Array<2,complex_t> c(v.get_index_range());
+  for (int i=0; i<length1; ++i)
+    for (int j=0; j<length2; ++j)
+      c[i][j] = v[i][j];
+  const Array<2,complex_t> all_frequencies = slow_fourier(c, 1);
+
+  const Array<2,complex_t> pos_frequencies = fourier_for_real_data(v);
+  check_if_equal(pos_frequencies.get_index_range(), IndexRange2D(length1, length2/2+1),
+                 str.str() + ": index range");
+  check(relative_difference(all_frequencies, pos_frequencies_to_all(pos_frequencies)) < 1.E-5, str.str());
+  check(relative_difference(v, inverse_fourier_for_real_data(pos_frequencies)) < 1.E-5, str.str() + ": inverse");
+}
+
+void
+FourierTests::run_tests()
+{
+  std::cerr << "Testing DFT functions (using "
+            << (FourierTransformPlan::is_using_FFTW() ? "FFTW" : "built-in FFT") << ")..." << std::endl;
+
+  {
+    const int lengths[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 12, 15, 16, 25, 30, 49, 64, 97, 100, 128, 360};
+    for (unsigned i=0; i<sizeof(lengths)/sizeof(lengths[0]); ++i)
+      {
+        test_plan(lengths[i]);
+        test_plan_contiguous(lengths[i]);
+        test_fourier_1d(lengths[i]);
+      }
+  }
+  test_fourier_3d(4, 8, 16);
+  test_fourier_3d(3, 10, 6);
+  test_fourier_3d(1, 1, 5);
+  test_fourier_for_real_data(8, 16);
+  test_fourier_for_real_data(6, 30);
+  test_fourier_for_real_data(5, 18);
+
+  check_if_equal(find_efficient_fourier_length(1), 2, "find_efficient_fourier_length(1)");
+  check_if_equal(find_efficient_fourier_length(127), 128, "find_efficient_fourier_length(127)");
+  check_if_equal(find_efficient_fourier_length(129), 144, "find_efficient_fourier_length(129)");
+  check_if_equal(find_efficient_fourier_length(129, false), 135, "find_efficient_fourier_length(129, false)");
+  check_if_equal(find_efficient_fourier_length(700), 720, "find_efficient_fourier_length(700)");
+}
+
+END_NAMESPACE_STIR
+USING_NAMESPACE_STIR
+
+int main(int argc, char **argv)
+{
+  if (argc != 1)
+  {
+    std::cerr << "Usage : " << argv[0] << " \n";
+    return EXIT_FAILURE;
+  }
+  FourierTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
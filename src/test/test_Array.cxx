@@ -623,6 +623,66 @@ ArrayTests::run_tests()
         Array<3,float>::const_full_iterator ctiter= titer; // this should compile
       }
     }
+    // contiguous storage
+    {
+      // irregular range
+      IndexRange<3> range(Coordinate3D<int>(0,-1,1),Coordinate3D<int>(2,2,3));
+      range[1][0].resize(-1,5);
+      range[2][1].resize(3,4);
+      {
+        const Array<3,float> non_contiguous(range);
+        check(!non_contiguous.is_contiguous(), "test arrays are not contiguous by default");
+        const Array<3,float> copy(non_contiguous);
+        check(!copy.is_contiguous(), "test is_contiguous() after copying a non-contiguous array");
+        check_if_equal(copy, non_contiguous, "test copy of non-contiguous array");
+      }
+      Array<3,float> test(range, /*contiguous=*/true);
+      check(test.is_contiguous(), "test is_contiguous() after construction");
+      check_if_equal(test.sum(), 0.F, "test elements are initialised to 0 in contiguous array");
+      check_if_equal(reinterpret_cast<std::size_t>(test.get_const_full_data_ptr()) % Array<3,float>::alignment_in_bytes,
+                     std::size_t(0), "test alignment of contiguous array");
+      {
+        float value = 1.2F;
+        for (Array<3,float>::full_iterator iter = test.begin_all();
+             iter != test.end_all();
+             )
+          *iter++ = value++;
+      }
+      {
+        const float * const data_ptr = test.get_const_full_data_ptr();
+        Array<3,float>::const_full_iterator iter = test.begin_all_const();
+        for (size_t i=0; i<test.size_all(); ++i, ++iter)
+          check_if_equal(data_ptr[i], *iter, "test get_const_full_data_ptr() vs. full iterator");
+      }
+      check_if_equal(test.find_max(), 1.2F+test.size_all()-1, "test find_max() on contiguous array");
+      check_if_equal(test.find_min(), 1.2F, "test find_min() on contiguous array");
+
+      Array<3,float> copy(test);
+      check(copy.is_contiguous(), "test is_contiguous() after copy");
+      check(copy.get_const_full_data_ptr() != test.get_const_full_data_ptr(), "test copy does not share data");
+      check_if_equal(copy, test, "test copy of contiguous array");
+      copy = test;
+      check(copy.is_contiguous(), "test is_contiguous() after assignment");
+      {
+        Array<3,float> assigned(IndexRange<3>(Coordinate3D<int>(1,3,5),Coordinate3D<int>(2,4,6)));
+        assigned = test;
+        check(assigned.is_contiguous(), "test is_contiguous() after assigning a contiguous array");
+        check_if_equal(assigned, test, "test assignment of contiguous array");
+      }
+
+      // make it non-contiguous by growing a row
+      copy[1][0].grow(-2,5);
+      check(!copy.is_contiguous(), "test is_contiguous() after resizing a row");
+      copy.fill(2.F);
+      check_if_equal(copy.sum(), 2.F*copy.size_all(), "test fill() on non-contiguous array");
+      const Array<3,float> copy2(copy);
+      check(!copy2.is_contiguous(), "test is_contiguous() after copying an array with a resized row");
+      check_if_equal(copy2, copy, "test copy of array with a resized row");
+
+      test.fill(3.F);
+      check_if_equal(test.find_max(), 3.F, "test fill() on contiguous array");
+      check_if_equal(test.sum(), 3.F*test.size_all(), "test fill() on contiguous array (sum)");
+    }
   }
 
 
@@ -34,6 +34,12 @@
 #include "stir/IndexRange2D.h"
 #include "stir/ArrayFilter3DUsingConvolution.h"
 #include "stir/IndexRange3D.h"
+#include "stir/SeparableArrayFunctionObject.h"
+#include "stir/ArrayFunction.h"
+#include "stir/MedianArrayFilter3D.h"
+#include "stir/MinimalArrayFilter3D.h"
+#include "stir/MaximalArrayFilter3D.h"
+#include "stir/Coordinate3D.h"
 #include "stir/Succeeded.h"
 #include "stir/modulo.h"
 #include "stir/RunTests.h"
@@ -41,15 +47,80 @@
 #include "stir/stream.h"//XXX
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <cstdlib>
 #include <boost/static_assert.hpp>
 
 #ifdef DO_TIMINGS
 #include "stir/CPUTimer.h"
+#include "stir/HighResWallClockTimer.h"
 #endif
 
 START_NAMESPACE_STIR
 
 
+/*!
+  \brief reference implementation of median, minimum and maximum filters
+
+  This extracts and sorts all neighbours for every voxel. Only neighbours within
+  the index range of \a in_array are used (as documented for stir::MedianArrayFilter3D).
+*/
+class RankFilterBySorting3D : public ArrayFunctionObject_2ArgumentImplementation<3,float>
+{
+public:
+  enum rank_type { median, minimum, maximum };
+
+  RankFilterBySorting3D(const Coordinate3D<int>& mask_radius, const rank_type rank)
+    : mask_radius(mask_radius), rank(rank)
+  {}
+
+  bool is_trivial() const { return false; }
+
+private:
+  Coordinate3D<int> mask_radius;
+  rank_type rank;
+
+  virtual void do_it(Array<3,float>& out_array, const Array<3,float>& in_array) const
+  {
+    std::vector<float> neighbours;
+    for (int z=out_array.get_min_index();z<= out_array.get_max_index();++z)
+      for (int y=out_array[z].get_min_index();y <= out_array[z].get_max_index();++y)
+        for (int x=out_array[z][y].get_min_index();x <= out_array[z][y].get_max_index();++x)
+          {
+            neighbours.clear();
+            for (int zi=z-mask_radius[1]; zi<=z+mask_radius[1]; ++zi)
+              {
+                if (zi<in_array.get_min_index() || zi>in_array.get_max_index())
+                  continue;
+                for (int yi=y-mask_radius[2]; yi<=y+mask_radius[2]; ++yi)
+                  {
+                    if (yi<in_array[zi].get_min_index() || yi>in_array[zi].get_max_index())
+                      continue;
+                    for (int xi=x-mask_radius[3]; xi<=x+mask_radius[3]; ++xi)
+                      {
+                        if (xi<in_array[zi][yi].get_min_index() || xi>in_array[zi][yi].get_max_index())
+                          continue;
+                        neighbours.push_back(in_array[zi][yi][xi]);
+                      }
+                  }
+              }
+            if (neighbours.empty())
+              continue;
+            std::sort(neighbours.begin(), neighbours.end());
+            const std::size_t n = neighbours.size();
+            switch (rank)
+              {
+              case minimum: out_array[z][y][x] = neighbours[0]; break;
+              case maximum: out_array[z][y][x] = neighbours[n-1]; break;
+              case median:
+                out_array[z][y][x] = n%2==1 ?
+                  neighbours[n/2] : (neighbours[n/2]+neighbours[n/2-1])/2;
+                break;
+              }
+          }
+  }
+};
+
 /*!
   \brief Tests Array functionality
   \ingroup test
@@ -439,6 +510,134 @@ ArrayFilterTests::run_tests()
     }
   }
 
+
+  std::cerr << "\nTesting separable convolution\n";
+  {
+    // contiguous, as SeparableArrayFunctionObject only uses separable convolution for contiguous arrays
+    Array<3,float> test(IndexRange3D(-1,7,0,12,-3,66), /*contiguous=*/true);
+    for (Array<3,float>::full_iterator iter = test.begin_all(); iter != test.end_all(); ++iter)
+      *iter = static_cast<float>(std::rand())/RAND_MAX;
+
+    VectorWithOffset<float> kernel1(-2,3);
+    for (int i=kernel1.get_min_index(); i<=kernel1.get_max_index(); ++i)
+      kernel1[i] = 1.F+i*i/10.F;
+    VectorWithOffset<float> kernel2(1,2);
+    kernel2[1] = .4F; kernel2[2] = .6F;
+    VectorWithOffset<float> symmetric_kernel(0,3);
+    symmetric_kernel[0] = .4F; symmetric_kernel[1] = .2F; symmetric_kernel[2] = .07F; symmetric_kernel[3] = .03F;
+
+    VectorWithOffset<shared_ptr<ArrayFunctionObject<1,float> > > all_1d_filters(3);
+    all_1d_filters[0].reset(new ArrayFilter1DUsingConvolution<float>(kernel1, BoundaryConditions::constant));
+    all_1d_filters[1].reset(new ArrayFilter1DUsingConvolutionSymmetricKernel<float>(symmetric_kernel));
+    all_1d_filters[2].reset(new ArrayFilter1DUsingConvolution<float>(kernel2));
+
+    set_tolerance(.0001F);
+    for (int trivial_dim=-1; trivial_dim<3; ++trivial_dim)
+      {
+        VectorWithOffset<shared_ptr<ArrayFunctionObject<1,float> > > filters(all_1d_filters);
+        if (trivial_dim>=0)
+          filters[trivial_dim].reset(new ArrayFilter1DUsingConvolution<float>());
+
+        // reference result: filter every line separately
+        Array<3,float> out_ref(test);
+        in_place_apply_array_functions_on_each_index(out_ref, filters.begin(), filters.end());
+
+        Array<3,float> out(test);
+        check(out.is_contiguous(), "separable convolution: copy of contiguous array should be contiguous");
+        SeparableArrayFunctionObject<3,float> separable_filter(filters);
+        separable_filter(out);
+        check_if_equal(out, out_ref, "separable convolution");
+      }
+
+#ifdef DO_TIMINGS
+    {
+      Array<3,float> image(IndexRange3D(47,128,128), /*contiguous=*/true);
+      for (Array<3,float>::full_iterator iter = image.begin_all(); iter != image.end_all(); ++iter)
+        *iter = static_cast<float>(std::rand())/RAND_MAX;
+      VectorWithOffset<shared_ptr<ArrayFunctionObject<1,float> > > filters(3);
+      for (int d=0; d<3; ++d)
+        filters[d].reset(new ArrayFilter1DUsingConvolutionSymmetricKernel<float>(symmetric_kernel));
+      const SeparableArrayFunctionObject<3,float> separable_filter(filters);
+      CPUTimer cpu_timer;
+      HighResWallClockTimer wall_clock_timer;
+      cpu_timer.start(); wall_clock_timer.start();
+      in_place_apply_array_functions_on_each_index(image, filters.begin(), filters.end());
+      cpu_timer.stop(); wall_clock_timer.stop();
+      std::cerr << "Separable convolution with kernel length " << 2*symmetric_kernel.get_length()-1 << ":\n"
+                << "  filtering every line separately: " << cpu_timer.value() << "s CPU, "
+                << wall_clock_timer.value() << "s wall-clock\n";
+      cpu_timer.reset(); wall_clock_timer.reset();
+      cpu_timer.start(); wall_clock_timer.start();
+      separable_filter(image);
+      cpu_timer.stop(); wall_clock_timer.stop();
+      std::cerr << "  SeparableArrayFunctionObject: " << cpu_timer.value() << "s CPU, "
+                << wall_clock_timer.value() << "s wall-clock\n";
+    }
+#endif
+  }
+
+  std::cerr << "\nTesting rank filters\n";
+  {
+    Array<3,float> test(IndexRange3D(-2,6,0,10,-3,8));
+    // initialise to random values, but with some duplicates
+    for (Array<3,float>::full_iterator iter = test.begin_all(); iter != test.end_all(); ++iter)
+      *iter = static_cast<float>(std::rand() % 50);
+    // make one row shorter to check irregular ranges
+    test[1][4].resize(0,5);
+
+    const Coordinate3D<int> mask_radii[] =
+      { Coordinate3D<int>(1,1,1), Coordinate3D<int>(0,2,1), Coordinate3D<int>(2,1,3), Coordinate3D<int>(1,0,0) };
+    for (unsigned i=0; i<sizeof(mask_radii)/sizeof(mask_radii[0]); ++i)
+      {
+        const Coordinate3D<int>& mask_radius = mask_radii[i];
+        std::cerr << "Using mask radius " << mask_radius << '\n';
+        Array<3,float> out_ref(test.get_index_range());
+        Array<3,float> out(test.get_index_range());
+
+        RankFilterBySorting3D(mask_radius, RankFilterBySorting3D::median)(out_ref, test);
+        const MedianArrayFilter3D<float> median_filter(mask_radius);
+        median_filter(out, test);
+        check_if_equal(out, out_ref, "median filter");
+
+        RankFilterBySorting3D(mask_radius, RankFilterBySorting3D::minimum)(out_ref, test);
+        const MinimalArrayFilter3D<float> minimal_filter(mask_radius);
+        minimal_filter(out, test);
+        check_if_equal(out, out_ref, "minimal filter");
+
+        RankFilterBySorting3D(mask_radius, RankFilterBySorting3D::maximum)(out_ref, test);
+        const MaximalArrayFilter3D<float> maximal_filter(mask_radius);
+        maximal_filter(out, test);
+        check_if_equal(out, out_ref, "maximal filter");
+      }
+
+#ifdef DO_TIMINGS
+    {
+      Array<3,float> image(IndexRange3D(47,128,128));
+      for (Array<3,float>::full_iterator iter = image.begin_all(); iter != image.end_all(); ++iter)
+        *iter = static_cast<float>(std::rand())/RAND_MAX;
+      Array<3,float> out(image.get_index_range());
+      for (int radius=1; radius<=2; ++radius)
+        {
+          const Coordinate3D<int> mask_radius(radius,radius,radius);
+          CPUTimer cpu_timer;
+          HighResWallClockTimer wall_clock_timer;
+          cpu_timer.start(); wall_clock_timer.start();
+          RankFilterBySorting3D(mask_radius, RankFilterBySorting3D::median)(out, image);
+          cpu_timer.stop(); wall_clock_timer.stop();
+          std::cerr << "Median filter with radius " << radius << ":\n"
+                    << "  sorting all neighbours: " << cpu_timer.value() << "s CPU, "
+                    << wall_clock_timer.value() << "s wall-clock\n";
+          cpu_timer.reset(); wall_clock_timer.reset();
+          cpu_timer.start(); wall_clock_timer.start();
+          const MedianArrayFilter3D<float> median_filter(mask_radius);
+          median_filter(out, image);
+          cpu_timer.stop(); wall_clock_timer.stop();
+          std::cerr << "  MedianArrayFilter3D: " << cpu_timer.value() << "s CPU, "
+                    << wall_clock_timer.value() << "s wall-clock\n";
+        }
+    }
+#endif
+  }
 }
 
 END_NAMESPACE_STIR
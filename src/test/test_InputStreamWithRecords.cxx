@@ -0,0 +1,206 @@
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for stir::InputStreamWithRecords
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/IO/InputStreamWithRecords.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+using std::endl;
+#endif
+
+START_NAMESPACE_STIR
+
+namespace {
+  //! a record with variable size: the first byte gives the size, followed by a counter
+  class TestRecord
+  {
+  public:
+    std::size_t
+      size_of_record_at_ptr(const char * const buffer, const std::size_t,
+                            const bool) const
+    { return static_cast<std::size_t>(static_cast<unsigned char>(buffer[0])); }
+
+    Succeeded
+      init_from_data_ptr(const char * const buffer,
+                         const std::size_t size_of_record,
+                         const bool)
+    {
+      this->data.assign(buffer, buffer + size_of_record);
+      return Succeeded::yes;
+    }
+
+    std::vector<char> data;
+  };
+
+  const std::size_t max_size_of_record = 20;
+
+  //! construct the data for record \a record_num
+  std::vector<char> construct_record_data(const int record_num)
+  {
+    const std::size_t size = 1 + record_num % max_size_of_record;
+    std::vector<char> data(size, static_cast<char>(record_num % 128));
+    data[0] = static_cast<char>(size);
+    return data;
+  }
+}
+
+/*!
+  \brief Test class for InputStreamWithRecords
+  \ingroup test
+
+  Writes records with different sizes to a stream, such that reading them
+  needs to cross the boundaries of the internal buffer, and reads them back.
+*/
+class InputStreamWithRecordsTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  bool check_record(const TestRecord& record, const int record_num, const char * const str);
+};
+
+bool
+InputStreamWithRecordsTests::
+check_record(const TestRecord& record, const int record_num, const char * const str)
+{
+  if (!check(record.data == construct_record_data(record_num), str))
+    {
+      cerr << "Mismatch for record " << record_num << endl;
+      return false;
+    }
+  return true;
+}
+
+void
+InputStreamWithRecordsTests::run_tests()
+{
+  cerr << "Tests for InputStreamWithRecords\n";
+
+  const int num_records = 300000;
+  shared_ptr<std::stringstream> stream_sptr(new std::stringstream);
+  // write some garbage first to check the starting position
+  *stream_sptr << "garbage";
+  for (int record_num=0; record_num<num_records; ++record_num)
+    {
+      const std::vector<char> data = construct_record_data(record_num);
+      stream_sptr->write(&data[0], data.size());
+    }
+  stream_sptr->seekg(7);
+
+  InputStreamWithRecords<TestRecord, bool> input(stream_sptr, 1, max_size_of_record, false);
+  TestRecord record;
+  const int record_num_to_save = 123457;
+  InputStreamWithRecords<TestRecord, bool>::SavedPosition saved_position = 0;
+  {
+    int record_num = 0;
+    for (; record_num<num_records; ++record_num)
+      {
+        if (record_num == record_num_to_save)
+          saved_position = input.save_get_position();
+        if (!check(input.get_next_record(record) == Succeeded::yes, "reading record"))
+          return;
+        if (!check_record(record, record_num, "comparing records"))
+          return;
+      }
+    check(input.get_next_record(record) == Succeeded::no, "reading past end of data");
+  }
+
+  {
+    cerr << "\tTesting set_get_position\n";
+    check(input.set_get_position(saved_position) == Succeeded::yes, "set_get_position");
+    check(input.get_next_record(record) == Succeeded::yes, "reading after set_get_position");
+    check_record(record, record_num_to_save, "comparing records after set_get_position");
+  }
+
+  {
+    cerr << "\tTesting reset and reading in batches\n";
+    check(input.reset() == Succeeded::yes, "reset");
+    std::vector<TestRecord> records(1000);
+    int record_num = 0;
+    std::size_t num_records_read;
+    while ((num_records_read = input.get_next_records(records)) > 0)
+      {
+        for (std::size_t i=0; i<num_records_read; ++i, ++record_num)
+          if (!check_record(records[i], record_num, "comparing records in batch"))
+            return;
+      }
+    check_if_equal(record_num, num_records, "number of records read in batches");
+  }
+
+  {
+    cerr << "\tTesting reading in batches via pointers and update_saved_get_position\n";
+    check(input.reset() == Succeeded::yes, "reset");
+    std::vector<shared_ptr<TestRecord> > records(777);
+    for (std::size_t i=0; i<records.size(); ++i)
+      records[i].reset(new TestRecord);
+    const std::size_t num_saved_positions = input.get_saved_get_positions().size();
+    const InputStreamWithRecords<TestRecord, bool>::SavedPosition block_start_position =
+      input.save_get_position();
+    int record_num = 0;
+    int block_start_record_num = 0;
+    std::size_t num_records_read;
+    while (true)
+      {
+        check(input.update_saved_get_position(block_start_position) == Succeeded::yes,
+              "update_saved_get_position");
+        block_start_record_num = record_num;
+        num_records_read = input.get_next_records_from_pointers(records.begin(), records.end());
+        if (num_records_read == 0)
+          break;
+        for (std::size_t i=0; i<num_records_read; ++i, ++record_num)
+          if (!check_record(*records[i], record_num, "comparing records in batch via pointers"))
+            return;
+        if (record_num > record_num_to_save && block_start_record_num <= record_num_to_save)
+          {
+            // go back to the start of this block and read it again
+            check(input.set_get_position(block_start_position) == Succeeded::yes,
+                  "set_get_position to updated position");
+            check(input.get_next_record(record) == Succeeded::yes, "reading after set_get_position");
+            check_record(record, block_start_record_num, "comparing records after set_get_position to updated position");
+            num_records_read = input.get_next_records_from_pointers(records.begin(), records.begin() + (record_num - block_start_record_num - 1));
+            check_if_equal(num_records_read, static_cast<std::size_t>(record_num - block_start_record_num - 1),
+                           "number of records read again");
+          }
+      }
+    check_if_equal(record_num, num_records, "number of records read in batches via pointers");
+    check_if_equal(input.get_saved_get_positions().size(), num_saved_positions + 1,
+                   "number of saved positions after update_saved_get_position");
+  }
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+int main()
+{
+  InputStreamWithRecordsTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -0,0 +1,283 @@
+//
+//
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for functions in stir/ML_norm.h
+
+*/
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/ML_norm.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ExamInfo.h"
+#include "stir/ProjDataInfoCylindricalNoArcCorr.h"
+#include "stir/Scanner.h"
+#include "stir/Bin.h"
+#include "stir/Sinogram.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/IndexRange2D.h"
+#include "stir/RunTests.h"
+#include "stir/unique_ptr.h"
+#include <algorithm>
+#include <math.h>
+
+START_NAMESPACE_STIR
+
+
+/*!
+  \ingroup test
+  \brief Test class for functions in ML_norm.h
+*/
+class ML_normTests: public RunTests
+{
+public:
+  void run_tests();
+private:
+  void test_set_randoms_from_efficiencies(const int span, const int max_delta,
+                                          const int view_mashing_factor, const int num_tangential_poss);
+  void test_fan_data();
+  //! loops over all detector pairs as in the original construct_randoms_from_singles
+  void set_randoms_from_efficiencies_ref(ProjData& proj_data, const DetectorEfficiencies& efficiencies);
+};
+
+void
+ML_normTests::
+set_randoms_from_efficiencies_ref(ProjData& proj_data, const DetectorEfficiencies& efficiencies)
+{
+  const ProjDataInfoCylindricalNoArcCorr * const proj_data_info_ptr =
+    dynamic_cast<const ProjDataInfoCylindricalNoArcCorr * const>
+    (proj_data.get_proj_data_info_ptr());
+  const int num_detectors_per_ring =
+    proj_data_info_ptr->get_scanner_ptr()->get_num_detectors_per_ring();
+  const int max_ring_diff =
+    proj_data_info_ptr->get_max_ring_difference(proj_data_info_ptr->get_max_segment_num());
+  const int mashing_factor = proj_data_info_ptr->get_view_mashing_factor();
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(*proj_data_info_ptr->get_scanner_ptr()));
+  unique_ptr<ProjDataInfo> uncompressed_proj_data_info_uptr
+    (ProjDataInfo::construct_proj_data_info(scanner_sptr,
+                                            /*span=*/1, max_ring_diff,
+                                            /*num_views=*/num_detectors_per_ring / 2,
+                                            scanner_sptr->get_max_num_non_arccorrected_bins(),
+                                            /*arccorrection=*/false));
+  const ProjDataInfoCylindricalNoArcCorr * const
+    uncompressed_proj_data_info_ptr =
+    dynamic_cast<const ProjDataInfoCylindricalNoArcCorr * const>
+    (uncompressed_proj_data_info_uptr.get());
+
+  Bin bin;
+  Bin uncompressed_bin;
+  for (bin.segment_num() = proj_data.get_min_segment_num();
+       bin.segment_num() <= proj_data.get_max_segment_num();
+       ++ bin.segment_num())
+    for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
+         bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
+         ++bin.axial_pos_num())
+      {
+        Sinogram<float> sinogram =
+          proj_data_info_ptr->get_empty_sinogram(bin.axial_pos_num(),bin.segment_num());
+        const float out_m = proj_data_info_ptr->get_m(bin);
+        for (uncompressed_bin.segment_num() = proj_data_info_ptr->get_min_ring_difference(bin.segment_num());
+             uncompressed_bin.segment_num() <= proj_data_info_ptr->get_max_ring_difference(bin.segment_num());
+             ++uncompressed_bin.segment_num())
+          for (uncompressed_bin.axial_pos_num() = uncompressed_proj_data_info_ptr->get_min_axial_pos_num(uncompressed_bin.segment_num());
+               uncompressed_bin.axial_pos_num()  <= uncompressed_proj_data_info_ptr->get_max_axial_pos_num(uncompressed_bin.segment_num());
+               ++uncompressed_bin.axial_pos_num() )
+            {
+              const float in_m = uncompressed_proj_data_info_ptr->get_m(uncompressed_bin);
+              if (fabs(out_m - in_m) > 1E-4)
+                continue;
+              for (bin.view_num() = proj_data.get_min_view_num();
+                   bin.view_num() <= proj_data.get_max_view_num();
+                   ++ bin.view_num())
+                for (bin.tangential_pos_num() = proj_data_info_ptr->get_min_tangential_pos_num();
+                     bin.tangential_pos_num() <= proj_data_info_ptr->get_max_tangential_pos_num();
+                     ++bin.tangential_pos_num())
+                  {
+                    uncompressed_bin.tangential_pos_num() = bin.tangential_pos_num();
+                    for (uncompressed_bin.view_num() = bin.view_num()*mashing_factor;
+                         uncompressed_bin.view_num() < (bin.view_num()+1)*mashing_factor;
+                         ++ uncompressed_bin.view_num())
+                      {
+                        int ra = 0, a = 0;
+                        int rb = 0, b = 0;
+                        uncompressed_proj_data_info_ptr->get_det_pair_for_bin(a, ra, b, rb, uncompressed_bin);
+                        sinogram[bin.view_num()][bin.tangential_pos_num()] +=
+                          efficiencies[ra][a]*efficiencies[rb][b%num_detectors_per_ring];
+                      }
+                  }
+            }
+        proj_data.set_sinogram(sinogram);
+      }
+}
+
+void
+ML_normTests::
+test_set_randoms_from_efficiencies(const int span, const int max_delta,
+                                   const int view_mashing_factor, const int num_tangential_poss)
+{
+  std::cerr << "Testing set_randoms_from_efficiencies with span " << span
+            << ", max ring difference " << max_delta
+            << ", view mashing " << view_mashing_factor << '\n';
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  const int num_rings = scanner_sptr->get_num_rings();
+  const int num_detectors_per_ring = scanner_sptr->get_num_detectors_per_ring();
+  shared_ptr<ProjDataInfo> proj_data_info_sptr
+    (ProjDataInfo::ProjDataInfoCTI(scanner_sptr, span, max_delta,
+                                   num_detectors_per_ring/2/view_mashing_factor,
+                                   num_tangential_poss, /*arc_corrected*/ false));
+  shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+
+  DetectorEfficiencies efficiencies(IndexRange2D(num_rings, num_detectors_per_ring));
+  for (int r=0; r<num_rings; ++r)
+    for (int d=0; d<num_detectors_per_ring; ++d)
+      efficiencies[r][d] = 1.F + .5F*static_cast<float>(sin(1. + r + 3.*d));
+
+  ProjDataInMemory proj_data(exam_info_sptr, proj_data_info_sptr);
+  set_randoms_from_efficiencies(proj_data, efficiencies);
+  ProjDataInMemory ref_proj_data(exam_info_sptr, proj_data_info_sptr);
+  set_randoms_from_efficiencies_ref(ref_proj_data, efficiencies);
+
+  for (int segment_num = proj_data.get_min_segment_num();
+       segment_num <= proj_data.get_max_segment_num();
+       ++segment_num)
+    {
+      const SegmentBySinogram<float> segment = proj_data.get_segment_by_sinogram(segment_num);
+      const SegmentBySinogram<float> ref_segment = ref_proj_data.get_segment_by_sinogram(segment_num);
+      check(ref_segment.find_min() > 0, "test that all bins have a contribution");
+      check_if_equal(segment, ref_segment, "test set_randoms_from_efficiencies against loop over all detector pairs");
+    }
+}
+
+void
+ML_normTests::
+test_fan_data()
+{
+  std::cerr << "Testing FanProjData functions\n";
+
+  shared_ptr<Scanner> scanner_sptr(new Scanner(Scanner::E953));
+  const int num_rings = scanner_sptr->get_num_rings();
+  const int num_detectors_per_ring = scanner_sptr->get_num_detectors_per_ring();
+  const int max_ring_diff = 4;
+  const int half_fan_size = 31;
+  shared_ptr<ProjDataInfo> proj_data_info_sptr
+    (ProjDataInfo::ProjDataInfoCTI(scanner_sptr, /*span*/ 1, max_ring_diff,
+                                   num_detectors_per_ring/2,
+                                   2*half_fan_size+1, /*arc_corrected*/ false));
+  shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+
+  ProjDataInMemory proj_data(exam_info_sptr, proj_data_info_sptr);
+  for (int segment_num = proj_data.get_min_segment_num();
+       segment_num <= proj_data.get_max_segment_num();
+       ++segment_num)
+    {
+      SegmentBySinogram<float> segment = proj_data.get_empty_segment_by_sinogram(segment_num);
+      for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num(); ++axial_pos_num)
+        for (int view_num = segment.get_min_view_num(); view_num <= segment.get_max_view_num(); ++view_num)
+          for (int tangential_pos_num = segment.get_min_tangential_pos_num();
+               tangential_pos_num <= segment.get_max_tangential_pos_num();
+               ++tangential_pos_num)
+            segment[axial_pos_num][view_num][tangential_pos_num] =
+              2.F + static_cast<float>(sin(1. + segment_num + 2.*axial_pos_num + 3.*view_num + tangential_pos_num));
+      proj_data.set_segment(segment);
+    }
+
+  FanProjData fan_data;
+  make_fan_data(fan_data, proj_data);
+  {
+    ProjDataInMemory proj_data_from_fan(exam_info_sptr, proj_data_info_sptr);
+    set_fan_data(proj_data_from_fan, fan_data);
+    for (int segment_num = proj_data.get_min_segment_num();
+         segment_num <= proj_data.get_max_segment_num();
+         ++segment_num)
+      check_if_equal(proj_data_from_fan.get_segment_by_sinogram(segment_num),
+                     proj_data.get_segment_by_sinogram(segment_num),
+                     "test set_fan_data(make_fan_data)");
+  }
+  {
+    Array<2,float> data_fan_sums(IndexRange2D(num_rings, num_detectors_per_ring));
+    Array<2,float> data_fan_sums_from_proj_data(IndexRange2D(num_rings, num_detectors_per_ring));
+    make_fan_sum_data(data_fan_sums, fan_data);
+    make_fan_sum_data(data_fan_sums_from_proj_data, proj_data);
+    check_if_equal(data_fan_sums, data_fan_sums_from_proj_data, "test make_fan_sum_data");
+  }
+  check_if_equal(KL(fan_data, fan_data, 0.F), 0.F, "test KL of identical data");
+
+  DetectorEfficiencies efficiencies(IndexRange2D(num_rings, num_detectors_per_ring));
+  for (int r=0; r<num_rings; ++r)
+    for (int d=0; d<num_detectors_per_ring; ++d)
+      efficiencies[r][d] = 1.F + .5F*static_cast<float>(sin(1. + r + 3.*d));
+  {
+    FanProjData eff_fan_data = fan_data;
+    eff_fan_data.fill(1.F);
+    apply_efficiencies(eff_fan_data, efficiencies);
+    Array<2,float> data_fan_sums(IndexRange2D(num_rings, num_detectors_per_ring));
+    Array<2,float> data_fan_sums_from_efficiencies(IndexRange2D(num_rings, num_detectors_per_ring));
+    make_fan_sum_data(data_fan_sums, eff_fan_data);
+    make_fan_sum_data(data_fan_sums_from_efficiencies, efficiencies, max_ring_diff, half_fan_size);
+    check_if_equal(data_fan_sums, data_fan_sums_from_efficiencies, "test apply_efficiencies");
+  }
+  {
+    const int num_axial_blocks = scanner_sptr->get_num_axial_blocks();
+    const int num_transaxial_blocks = scanner_sptr->get_num_transaxial_blocks();
+    const int num_axial_crystals_per_block = num_rings/num_axial_blocks;
+    const int num_transaxial_crystals_per_block = num_detectors_per_ring/num_transaxial_blocks;
+    BlockData3D block_data(num_axial_blocks, num_transaxial_blocks, num_axial_blocks-1, num_transaxial_blocks-1);
+    make_block_data(block_data, fan_data);
+    // serial computation as reference
+    BlockData3D ref_block_data(num_axial_blocks, num_transaxial_blocks, num_axial_blocks-1, num_transaxial_blocks-1);
+    for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
+      for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
+        for (int rb = std::max(ra,fan_data.get_min_rb(ra)); rb <= fan_data.get_max_rb(ra); ++rb)
+          for (int b = fan_data.get_min_b(a); b <= fan_data.get_max_b(a); ++b)
+            ref_block_data(ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block,
+                           rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block) +=
+              fan_data(ra,a,rb,b);
+    for (int ra = block_data.get_min_ra(); ra <= block_data.get_max_ra(); ++ra)
+      for (int a = block_data.get_min_a(); a <= block_data.get_max_a(); ++a)
+        for (int rb = std::max(ra,block_data.get_min_rb(ra)); rb <= block_data.get_max_rb(ra); ++rb)
+          for (int b = block_data.get_min_b(a); b <= block_data.get_max_b(a); ++b)
+            check_if_equal(block_data(ra,a,rb,b), ref_block_data(ra,a,rb,b), "test make_block_data");
+  }
+}
+
+void
+ML_normTests::
+run_tests()
+{
+  std::cerr << "-------- Testing ML_norm functions --------\n";
+  test_set_randoms_from_efficiencies(/*span*/ 1, /*max_delta*/ 4, /*mashing*/ 1, /*num_tangential_poss*/ 64);
+  test_set_randoms_from_efficiencies(/*span*/ 3, /*max_delta*/ 7, /*mashing*/ 2, /*num_tangential_poss*/ 81);
+  test_fan_data();
+}
+
+END_NAMESPACE_STIR
+
+
+USING_NAMESPACE_STIR
+
+int main()
+{
+  ML_normTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -104,6 +104,7 @@ VoxelsOnCartesianGridTests::run_tests()
     VoxelsOnCartesianGrid<float>  ob3(range,origin, grid_spacing);
     
     check( ob3.get_index_range() == range, "test on range");
+    check( ob3.is_contiguous(), "test on contiguous storage");
     check_if_equal( ob3.get_grid_spacing(),grid_spacing, "test on grid_spacing");
     check_if_equal( ob3.get_origin(), origin, "test on origin");
 
@@ -147,6 +148,7 @@ VoxelsOnCartesianGridTests::run_tests()
     IndexRange<3> obtained_range = ob4.get_index_range();
     CartesianCoordinate3D<int> low_bound, high_bound;
     check(obtained_range.get_regular_range(low_bound, high_bound), "test regular range");
+    check(ob4.is_contiguous(), "test on contiguous storage");
     
     // KT 11/09/2001 adapted as this constructor now takes zoom into account
     const bool is_arccorrected =
@@ -32,9 +32,18 @@
 #include "stir/ProjDataInfo.h"
 #include "stir/Sinogram.h"
 #include "stir/Viewgram.h"
+#include "stir/Sinogram.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/SegmentByView.h"
 #include "stir/Succeeded.h"
 #include "stir/RunTests.h"
 #include "stir/Scanner.h"
+#include "stir/ProjDataFromStream.h"
+#include "stir/ProjDataMemoryMapped.h"
+#include "stir/IO/interfile.h"
+#include "stir/is_null_ptr.h"
+#include <cstdio>
+#include <vector>
 
 START_NAMESPACE_STIR
 
@@ -106,6 +115,75 @@ run_tests()
                    "test 1 for copy-constructor and get_viewgram");
   }
 
+  // test reading from memory and file (positional reads) with multiple threads
+  {
+    check(proj_data.has_positional_reads(), "ProjDataInMemory should read directly from memory");
+    {
+      Sinogram<float> sinogram = proj_data.get_empty_sinogram(2,1);
+      for (int view_num=sinogram.get_min_view_num(); view_num<=sinogram.get_max_view_num(); ++view_num)
+        sinogram[view_num].fill(static_cast<float>(view_num));
+      check(proj_data.set_sinogram(sinogram) == Succeeded::yes,
+            "test set_sinogram succeeded");
+    }
+    const std::string filename = "test_proj_data_in_memory_positional_reads.hs";
+    check(proj_data.write_to_file(filename) == Succeeded::yes, "test write_to_file");
+    {
+      shared_ptr<ProjDataFromStream> proj_data_from_file_sptr(read_interfile_PDFS(filename, std::ios::in));
+      check(!is_null_ptr(proj_data_from_file_sptr), "test reading from file");
+      if (!is_null_ptr(proj_data_from_file_sptr))
+        {
+#ifdef __OS_UNIX__
+          check(proj_data_from_file_sptr->has_positional_reads(), "file should use positional reads");
+#endif
+          const ProjDataFromStream& proj_data_from_file = *proj_data_from_file_sptr;
+          const int num_views = proj_data.get_num_views();
+          std::vector<int> num_mismatches(2*num_views, 0);
+#ifdef STIR_OPENMP
+#pragma omp parallel for
+#endif
+          for (int i=0; i<2*num_views; ++i)
+            {
+              const int view_num = proj_data.get_min_view_num() + i/2;
+              const int segment_num = i%2;
+              const Viewgram<float> viewgram = proj_data.get_viewgram(view_num, segment_num);
+              if (viewgram != proj_data_from_file.get_viewgram(view_num, segment_num))
+                ++num_mismatches[i];
+            }
+          for (int i=0; i<2*num_views; ++i)
+            check_if_equal(num_mismatches[i], 0, "test concurrent get_viewgram from memory and file");
+          check_if_equal(proj_data_from_file.get_sinogram(2,1),
+                         proj_data.get_sinogram(2,1),
+                         "test get_sinogram from file");
+          check_if_equal(proj_data_from_file.get_segment_by_sinogram(1),
+                         proj_data.get_segment_by_sinogram(1),
+                         "test get_segment_by_sinogram from file");
+        }
+    }
+    {
+      std::cerr << "\tTesting ProjDataMemoryMapped\n";
+      shared_ptr<ProjData> proj_data_mapped_sptr =
+        ProjData::read_from_file(filename + ",mmap", std::ios::in | std::ios::out);
+      check(!is_null_ptr(dynamic_cast<ProjDataMemoryMapped *>(proj_data_mapped_sptr.get())),
+            "read_from_file with mmap option should return ProjDataMemoryMapped");
+      check_if_equal(proj_data_mapped_sptr->get_sinogram(2,1),
+                     proj_data.get_sinogram(2,1),
+                     "test get_sinogram from memory mapped file");
+      Viewgram<float> viewgram = proj_data.get_empty_viewgram(3,0);
+      viewgram.fill(value*3);
+      check(proj_data_mapped_sptr->set_viewgram(viewgram) == Succeeded::yes,
+            "test set_viewgram for memory mapped file");
+      check_if_equal(proj_data_mapped_sptr->get_viewgram(3,0), viewgram,
+                     "test set/get_viewgram for memory mapped file");
+      proj_data_mapped_sptr.reset();
+      // check that the data were written to file
+      shared_ptr<ProjData> proj_data_from_file_sptr = ProjData::read_from_file(filename);
+      check_if_equal(proj_data_from_file_sptr->get_viewgram(3,0), viewgram,
+                     "test data written via memory mapped file");
+    }
+    std::remove(filename.c_str());
+    std::remove("test_proj_data_in_memory_positional_reads.s");
+  }
+
   // test fill with larger input
   {    
     shared_ptr<ProjDataInfo> proj_data_info_sptr2
@@ -146,6 +224,27 @@ run_tests()
         // ok
       }
   }
+
+  // test contiguous storage of projection data
+  {
+    std::cerr << "\tTesting contiguous storage of projection data\n";
+    check(!Viewgram<float>(proj_data_info_sptr, 1, 1).is_contiguous(),
+          "viewgram should not be contiguous by default");
+    check(Viewgram<float>(proj_data_info_sptr, 1, 1, /*contiguous=*/true).is_contiguous(),
+          "test contiguous viewgram");
+    check(Sinogram<float>(proj_data_info_sptr, 1, 1, /*contiguous=*/true).is_contiguous(),
+          "test contiguous sinogram");
+    SegmentBySinogram<float> segment_by_sino(proj_data_info_sptr, 1, /*contiguous=*/true);
+    check(segment_by_sino.is_contiguous(), "test contiguous segment by sinogram");
+    segment_by_sino[0][1][2] = 3.F;
+    const SegmentByView<float> segment_by_view(segment_by_sino);
+    check(segment_by_view.is_contiguous(), "test conversion of contiguous segment by sinogram");
+    check_if_equal(segment_by_view[1][0][2], 3.F, "test conversion of contiguous segment by sinogram (values)");
+    check(SegmentByView<float>(proj_data_info_sptr, 1, /*contiguous=*/true).is_contiguous(),
+          "test contiguous segment by view");
+    check(!SegmentBySinogram<float>(proj_data_info_sptr, 1).is_contiguous(),
+          "segment should not be contiguous by default");
+  }
 }
 
 END_NAMESPACE_STIR
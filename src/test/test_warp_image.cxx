@@ -32,8 +32,12 @@
 #include "stir/spatial_transformation/warp_image.h"
 #include "stir/RunTests.h"
 #include "stir/spatial_transformation/GatedSpatialTransformation.h"
+#include "stir/spatial_transformation/PrecomputedLinearWarp.h"
+#include "stir/numerics/BSplinesRegularGrid.h"
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
+#include <math.h>
 
 #ifndef STIR_NO_NAMESPACES
 using std::cerr;
@@ -50,8 +54,80 @@ class warp_imageTests : public RunTests
 {
 public:
   void run_tests();
+private:
+  void test_precomputed_linear_warp();
 };
 
+void
+warp_imageTests::test_precomputed_linear_warp()
+{
+  std::cerr << "Tests for PrecomputedLinearWarp" << std::endl;
+
+  const CartesianCoordinate3D<float> origin (0,1,2);  
+  const CartesianCoordinate3D<float> grid_spacing (3,4,5); 
+  const IndexRange<3> 
+    range(CartesianCoordinate3D<int>(-2,-10,-9),
+          CartesianCoordinate3D<int>(12,11,13));
+  
+  VoxelsOnCartesianGrid<float> image(range, origin, grid_spacing);
+  VoxelsOnCartesianGrid<float> other_image(range, origin, grid_spacing);
+  VoxelsOnCartesianGrid<float> motion_x(range, origin, grid_spacing);
+  VoxelsOnCartesianGrid<float> motion_y(range, origin, grid_spacing);
+  VoxelsOnCartesianGrid<float> motion_z(range, origin, grid_spacing);
+  for (int z=range.get_min_index(); z<=range.get_max_index(); ++z)
+    for (int y=range[z].get_min_index(); y<=range[z].get_max_index(); ++y)
+      for (int x=range[z][y].get_min_index(); x<=range[z][y].get_max_index(); ++x)
+        {
+          image[z][y][x] = static_cast<float>(std::rand())/RAND_MAX;
+          other_image[z][y][x] = static_cast<float>(std::rand())/RAND_MAX;
+          // smooth motion of a few voxels, moving some voxels outside the image
+          motion_x[z][y][x] = static_cast<float>(2.3*grid_spacing[3]*sin(.3*z + .2*y));
+          motion_y[z][y][x] = static_cast<float>(1.7*grid_spacing[2]*cos(.1*x - .4*z));
+          motion_z[z][y][x] = static_cast<float>(-1.4*grid_spacing[1]*sin(.2*x + .3*y));
+        }
+
+  const PrecomputedLinearWarp warp(motion_x, motion_y, motion_z);
+  VoxelsOnCartesianGrid<float> warped_image(range, origin, grid_spacing);
+  warp.warp(warped_image, image);
+
+  {
+    // compare with direct evaluation of the linear B-spline
+    const BSpline::BSplinesRegularGrid<3, float> interpolation(image, BSpline::linear);
+    float max_diff = 0.F;
+    for (int z=range.get_min_index(); z<=range.get_max_index(); ++z)
+      for (int y=range[z].get_min_index(); y<=range[z].get_max_index(); ++y)
+        for (int x=range[z][y].get_min_index(); x<=range[z][y].get_max_index(); ++x)
+          {
+            const BasicCoordinate<3,double> d =
+              make_coordinate(z + static_cast<double>(motion_z[z][y][x]/grid_spacing[1]),
+                              y + static_cast<double>(motion_y[z][y][x]/grid_spacing[2]),
+                              x + static_cast<double>(motion_x[z][y][x]/grid_spacing[3]));
+            const bool inside =
+              d[1]>range.get_min_index() && d[1]<range.get_max_index() &&
+              d[2]>range[z].get_min_index() && d[2]<range[z].get_max_index() &&
+              d[3]>range[z][y].get_min_index() && d[3]<range[z][y].get_max_index();
+            const float expected = inside ? interpolation(d) : 0.F;
+            max_diff = std::max(max_diff, static_cast<float>(fabs(expected - warped_image[z][y][x])));
+          }
+    check(max_diff < 1.E-5F, "PrecomputedLinearWarp::warp compared to BSplinesRegularGrid");
+  }
+  {
+    // adjoint test: <W x, y> == <x, W^T y>
+    VoxelsOnCartesianGrid<float> adjoint_image(range, origin, grid_spacing);
+    warp.accumulate_adjoint_warp(adjoint_image, other_image);
+    double inner_product_warp = 0, inner_product_adjoint = 0;
+    for (int z=range.get_min_index(); z<=range.get_max_index(); ++z)
+      for (int y=range[z].get_min_index(); y<=range[z].get_max_index(); ++y)
+        for (int x=range[z][y].get_min_index(); x<=range[z][y].get_max_index(); ++x)
+          {
+            inner_product_warp += static_cast<double>(warped_image[z][y][x])*other_image[z][y][x];
+            inner_product_adjoint += static_cast<double>(image[z][y][x])*adjoint_image[z][y][x];
+          }
+    check_if_equal(inner_product_warp, inner_product_adjoint,
+                   "PrecomputedLinearWarp::accumulate_adjoint_warp is the adjoint of warp");
+  }
+}
+
 void
 warp_imageTests::run_tests()
 {
@@ -168,6 +244,17 @@ warp_imageTests::run_tests()
     check_if_equal(accumulated_image[indices], 2.F, "testing the accumulated image at the original location of non-zero point");
     check_if_equal(accumulated_image[new_indices], 0.F, "testing the accumulated image at the location where the non-zero point had moved");
   }
+  {
+    // the adjoint of a shift is the opposite shift, applied to gate 2
+    VoxelsOnCartesianGrid<float> adjoint_image(range, origin, grid_spacing);
+    mvtest.adjoint_warp_image(adjoint_image,gated_image);
+    const BasicCoordinate<3,int> adjoint_indices = make_coordinate(new_indices[1]-1,new_indices[2]-2,new_indices[3]-3);
+    check_if_equal(adjoint_image[indices], 1.F, "testing the adjoint warped image at the original location of non-zero point");
+    check_if_equal(adjoint_image[new_indices], 0.F, "testing the adjoint warped image at the location of the non-zero point in gate 2");
+    check_if_equal(adjoint_image[adjoint_indices], 1.F, "testing the adjoint warped image at the shifted location of the non-zero point in gate 2");
+  }
+
+  test_precomputed_linear_warp();
 }
 END_NAMESPACE_STIR
 
@@ -0,0 +1,158 @@
+/*
+    Copyright (C) 2026, University College London
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup utilities
+  \brief Measure how fast viewgrams can be read from projection data with multiple threads
+
+  \par Usage
+  \verbatim
+  benchmark_projdata_reading projdata_filename [max_num_threads [num_repeats]]
+  \endverbatim
+  All viewgrams of the projection data are read in an OpenMP parallel loop, using
+  1, 2, 4, ... up to \c max_num_threads threads (defaults to get_max_num_threads()).
+  This is done for the data as read from file, and for a copy in memory
+  (stir::ProjDataInMemory). For each case, the wall-clock time (minimum over
+  \c num_repeats, defaults to 3) and corresponding throughput is reported.
+
+  Note that timings of the file-based reads depend on the operating system's file cache.
+  The first run is therefore discarded.
+*/
+
+#include "stir/ProjDataFromStream.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/Viewgram.h"
+#include "stir/HighResWallClockTimer.h"
+#include "stir/num_threads.h"
+#include "stir/warning.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
+
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::setw;
+#endif
+
+START_NAMESPACE_STIR
+
+//! read all viewgrams with the current number of threads and return the wall-clock time
+static double
+time_reading_all_viewgrams(const ProjData& proj_data)
+{
+  // make a list of all viewgrams to read
+  std::vector<int> view_nums;
+  std::vector<int> segment_nums;
+  for (int segment_num=proj_data.get_min_segment_num(); segment_num<=proj_data.get_max_segment_num(); ++segment_num)
+    for (int view_num=proj_data.get_min_view_num(); view_num<=proj_data.get_max_view_num(); ++view_num)
+      {
+        view_nums.push_back(view_num);
+        segment_nums.push_back(segment_num);
+      }
+  const int num_viewgrams = static_cast<int>(view_nums.size());
+
+  HighResWallClockTimer timer;
+  timer.start();
+  double sum = 0.;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:sum)
+#endif
+  for (int i=0; i<num_viewgrams; ++i)
+    {
+      const Viewgram<float> viewgram = proj_data.get_viewgram(view_nums[i], segment_nums[i]);
+      // use the data such that the compiler cannot optimise the read away
+      sum += viewgram.sum();
+    }
+  timer.stop();
+  if (sum == -1.)
+    cerr << ' ';
+  return timer.value();
+}
+
+static void
+benchmark(const ProjData& proj_data, const char * const description,
+          const int max_num_threads, const int num_repeats)
+{
+  double size_in_MB = 0.;
+  for (int segment_num=proj_data.get_min_segment_num(); segment_num<=proj_data.get_max_segment_num(); ++segment_num)
+    size_in_MB += proj_data.get_num_axial_poss(segment_num);
+  size_in_MB *= proj_data.get_num_views() * proj_data.get_num_tangential_poss() * sizeof(float) / 1048576.;
+
+  cout << "\n" << description << "\n"
+       << setw(12) << "num_threads" << setw(14) << "time (s)" << setw(16) << "MB/s" << setw(12) << "speed-up" << endl;
+  // first run to fill caches
+  set_num_threads(1);
+  time_reading_all_viewgrams(proj_data);
+
+  double time_for_1_thread = 0.;
+  for (int num_threads=1; num_threads<=max_num_threads; num_threads*=2)
+    {
+      set_num_threads(num_threads);
+      double min_time = time_reading_all_viewgrams(proj_data);
+      for (int repeat=1; repeat<num_repeats; ++repeat)
+        min_time = std::min(min_time, time_reading_all_viewgrams(proj_data));
+      if (num_threads == 1)
+        time_for_1_thread = min_time;
+      cout << setw(12) << num_threads
+           << setw(14) << min_time
+           << setw(16) << size_in_MB / min_time
+           << setw(12) << time_for_1_thread / min_time
+           << endl;
+    }
+}
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main(int argc, char * argv[])
+{
+  if (argc<2 || argc>4)
+    {
+      cerr << "Usage: " << argv[0] << " projdata_filename [max_num_threads [num_repeats]]\n";
+      return EXIT_FAILURE;
+    }
+  set_num_threads();
+  const int max_num_threads = argc>2 ? atoi(argv[2]) : get_max_num_threads();
+  const int num_repeats = argc>3 ? atoi(argv[3]) : 3;
+#ifndef STIR_OPENMP
+  warning("benchmark_projdata_reading: STIR was compiled without OpenMP. Only timings for 1 thread will be meaningful.");
+#endif
+
+  shared_ptr<ProjData> proj_data_sptr = ProjData::read_from_file(argv[1]);
+  {
+    const ProjDataFromStream * const proj_data_from_stream_ptr =
+      dynamic_cast<const ProjDataFromStream *>(proj_data_sptr.get());
+    const bool positional_reads =
+      proj_data_from_stream_ptr != 0 && proj_data_from_stream_ptr->has_positional_reads();
+    benchmark(*proj_data_sptr,
+              positional_reads ? "Reading from file (positional reads)" : "Reading from file (via stream)",
+              max_num_threads, num_repeats);
+  }
+  {
+    const ProjDataInMemory proj_data_in_memory(*proj_data_sptr);
+    benchmark(proj_data_in_memory, "Reading from memory", max_num_threads, num_repeats);
+  }
+  return EXIT_SUCCESS;
+}
@@ -5,6 +5,9 @@
 
   \brief Construct randoms as a product of singles estimates
 
+  The singles estimates are read from the "eff" file written by find_ML_singles_from_delayed.
+  See set_randoms_from_efficiencies() for the computation.
+
   \author Kris Thielemans
 
 */
@@ -32,11 +35,8 @@
 
 #include "stir/ProjDataInfoCylindricalNoArcCorr.h"
 #include "stir/Scanner.h"
-#include "stir/Bin.h"
 #include "stir/stream.h"
-#include "stir/Sinogram.h"
 #include "stir/IndexRange2D.h"
-#include "stir/display.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -136,110 +136,7 @@ int main(int argc, char **argv)
 #endif
   }
 
-  {
-    const ProjDataInfoCylindricalNoArcCorr * const proj_data_info_ptr = 
-      dynamic_cast<const ProjDataInfoCylindricalNoArcCorr * const>
-      (proj_data.get_proj_data_info_ptr());
-    if (proj_data_info_ptr == 0)
-      {
-	error("Can only process not arc-corrected data\n");
-      }
-    const int max_ring_diff = 
-      proj_data_info_ptr->get_max_ring_difference
-      (proj_data_info_ptr->get_max_segment_num());
-
-    const int mashing_factor = 
-      proj_data_info_ptr->get_view_mashing_factor();
-
-    shared_ptr<Scanner> scanner_sptr(new Scanner(*proj_data_info_ptr->get_scanner_ptr()));
-    unique_ptr<ProjDataInfo> uncompressed_proj_data_info_uptr
-    (ProjDataInfo::construct_proj_data_info(scanner_sptr,
-      /*span=*/1, max_ring_diff,
-      /*num_views=*/num_detectors_per_ring / 2,
-      scanner_sptr->get_max_num_non_arccorrected_bins(),
-      /*arccorrection=*/false));
-    const ProjDataInfoCylindricalNoArcCorr * const
-      uncompressed_proj_data_info_ptr =
-      dynamic_cast<const ProjDataInfoCylindricalNoArcCorr * const>
-      (uncompressed_proj_data_info_uptr.get());
-
-    
-    Bin bin;
-    Bin uncompressed_bin;
-
-    for (bin.segment_num() = proj_data.get_min_segment_num(); 
-	 bin.segment_num() <= proj_data.get_max_segment_num();  
-	 ++ bin.segment_num())
-      {	
-    
-	for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
-	     bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
-	     ++bin.axial_pos_num())
-	  {
-	    Sinogram<float> sinogram =
-	      proj_data_info_ptr->get_empty_sinogram(bin.axial_pos_num(),bin.segment_num());
-	    const float out_m = proj_data_info_ptr->get_m(bin);
-	    const int in_min_segment_num =
-	      proj_data_info_ptr->get_min_ring_difference(bin.segment_num());
-	    const int in_max_segment_num =
-	      proj_data_info_ptr->get_max_ring_difference(bin.segment_num());
-
-	    // now loop over uncompressed detector-pairs
-	  
-	    {  
-	      for (uncompressed_bin.segment_num() = in_min_segment_num; 
-		   uncompressed_bin.segment_num() <= in_max_segment_num;
-		   ++uncompressed_bin.segment_num())
-		for (uncompressed_bin.axial_pos_num() = uncompressed_proj_data_info_ptr->get_min_axial_pos_num(uncompressed_bin.segment_num()); 
-		     uncompressed_bin.axial_pos_num()  <= uncompressed_proj_data_info_ptr->get_max_axial_pos_num(uncompressed_bin.segment_num());
-		     ++uncompressed_bin.axial_pos_num() )
-		  {
-		    const float in_m = uncompressed_proj_data_info_ptr->get_m(uncompressed_bin);
-		    if (fabs(out_m - in_m) > 1E-4)
-		      continue;
-		
-
-		    // views etc
-		    if (proj_data.get_min_view_num()!=0)
-		      error("Can only handle min_view_num==0\n");
-		    for (bin.view_num() = proj_data.get_min_view_num(); 
-			 bin.view_num() <= proj_data.get_max_view_num();
-			 ++ bin.view_num())
-		      {
-
-			for (bin.tangential_pos_num() = proj_data_info_ptr->get_min_tangential_pos_num();
-			     bin.tangential_pos_num() <= proj_data_info_ptr->get_max_tangential_pos_num();
-			     ++bin.tangential_pos_num())
-			  {
-			    uncompressed_bin.tangential_pos_num() =
-			      bin.tangential_pos_num();
-			    for (uncompressed_bin.view_num() = bin.view_num()*mashing_factor;
-				 uncompressed_bin.view_num() < (bin.view_num()+1)*mashing_factor;
-				 ++ uncompressed_bin.view_num())
-			      {
-
-				int ra = 0, a = 0;
-				int rb = 0, b = 0;
-			      
-				uncompressed_proj_data_info_ptr->get_det_pair_for_bin(a, ra, b, rb, 
-										      uncompressed_bin);
-
-				/*(*segment_ptr)[bin.axial_pos_num()]*/
-				sinogram[bin.view_num()][bin.tangential_pos_num()] +=
-				  efficiencies[ra][a]*efficiencies[rb][b%num_detectors_per_ring];
-			      }
-			  }
-		      }
-		  
-		  
-		  }
-	    }
-	    proj_data.set_sinogram(sinogram);
-	  }
-
-      }
-  }
-
+  set_randoms_from_efficiencies(proj_data, efficiencies);
 
   return EXIT_SUCCESS;
 }
@@ -149,6 +149,35 @@ using std::vector;
 
 USING_NAMESPACE_STIR
 
+//! combine elements of \a data and \a other with a binary function, storing the result in \a data
+template <class DataT, class BinaryFunctionT>
+void in_place_transform(DataT& data, const DataT& other, BinaryFunctionT f)
+{
+  std::transform(data.begin_all(), data.end_all(),
+                 other.begin_all(), 
+                 data.begin_all(),
+                 f);
+}
+
+//! specialisation for images that uses plain pointers when possible, such that the loop can be vectorised
+template <class BinaryFunctionT>
+void in_place_transform(DiscretisedDensity<3,float>& data, const DiscretisedDensity<3,float>& other, BinaryFunctionT f)
+{
+  if (data.is_contiguous() && other.is_contiguous() && data.size_all() == other.size_all())
+    {
+      float * const data_ptr = data.get_full_data_ptr();
+      const float * const other_ptr = other.get_const_full_data_ptr();
+      const size_t size = data.size_all();
+      for (size_t i=0; i<size; ++i)
+        data_ptr[i] = f(data_ptr[i], other_ptr[i]);
+    }
+  else
+    std::transform(data.begin_all(), data.end_all(),
+                   other.begin_all(), 
+                   data.begin_all(),
+                   f);
+}
+
 template <class DataT, class FunctionObjectT>
 void process_data(const string& output_file_name,
 		  const int num_files, char **argv, 
@@ -178,18 +207,12 @@ void process_data(const string& output_file_name,
 	  // TODO the next line doesn't work with some DataT, but its replacement is ugly!
 	  // also, it would be better to be able to call += on each element
 	  //*image_ptr += *current_image_ptr;
-	  std::transform(image_ptr->begin_all(), image_ptr->end_all(),
-			 current_image_ptr->begin_all(), 
-			 image_ptr->begin_all(),
-			 std::plus<float>());
+	  in_place_transform(*image_ptr, *current_image_ptr, std::plus<float>());
 	}
       else
 	{
 	  // *image_ptr *= *current_image_ptr;
-	  std::transform(image_ptr->begin_all(), image_ptr->end_all(),
-			 current_image_ptr->begin_all(), 
-			 image_ptr->begin_all(),
-			 std::multiplies<float>());
+	  in_place_transform(*image_ptr, *current_image_ptr, std::multiplies<float>());
 	}
     }
 
@@ -233,18 +256,12 @@ void process_data(const string& output_file_name,
 	      // TODO the next line doesn't work with some DataT, but its replacement is ugly!
 	      // also, it would be better to be able to call += on each element
 	      //*image_ptr += *current_image_ptr;
-	      std::transform(dyn_image[frame_num].begin_all(), dyn_image[frame_num].end_all(),
-			     dyn_current_image[frame_num].begin_all(), 
-			     dyn_image[frame_num].begin_all(),
-			     std::plus<float>());
+	      in_place_transform(dyn_image[frame_num], dyn_current_image[frame_num], std::plus<float>());
 	    }
 	  else
 	    {
 	      // *image_ptr *= *current_image_ptr;
-	      std::transform(dyn_image[frame_num].begin_all(), dyn_image[frame_num].end_all(),
-			     dyn_current_image[frame_num].begin_all(), 
-			     dyn_image[frame_num].begin_all(),
-			     std::multiplies<float>());
+	      in_place_transform(dyn_image[frame_num], dyn_current_image[frame_num], std::multiplies<float>());
 	    }
 	}
     }